@@ -1,4 +1,10 @@
 #define NDEBUG
+/* Make the mmap interface visible to m-mmap.h and the futex syscall
+   visible to m-mutex.h in strict ISO C mode */
+#define _DEFAULT_SOURCE
+#ifdef __linux__
+#define M_USE_FUTEX 1
+#endif
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -10,7 +16,12 @@
 #include "m-bptree.h"
 #include "m-dict.h"
 #include "m-algo.h"
+#include "m-worker.h"
 #include "m-mempool.h"
+#include "m-mmap.h"
+#include "m-serial-bin.h"
+#include "m-serial-json.h"
+#include "m-tuple.h"
 #include "m-string.h"
 #include "m-buffer.h"
 #include "m-mutex.h"
@@ -220,8 +231,91 @@ test_dict_oa(size_t  n)
   }
 }
 
+/* Same dictionary with its table backed by huge pages */
+DICT_OA_DEF2(dict_oa_mmap_ulong,
+	     unsigned long, MMAP_OPLIST(M_OPEXTEND(M_DEFAULT_OPLIST, OOR_EQUAL(oor_equal_p), OOR_SET(oor_set M_IPTR))),
+	     unsigned long, M_DEFAULT_OPLIST)
+
+static void
+test_dict_oa_mmap(size_t  n)
+{
+  M_LET(dict, DICT_OPLIST(dict_oa_mmap_ulong)) {
+    for (size_t i = 0; i < n; i++) {
+      dict_oa_mmap_ulong_set_at(dict, rand_get(), rand_get() );
+    }
+    rand_init();
+    unsigned int s = 0;
+    for (size_t i = 0; i < n; i++) {
+      unsigned long *p = dict_oa_mmap_ulong_get(dict, rand_get());
+      if (p)
+        s += *p;
+    }
+    g_result = s;
+  }
+}
+
+DICT_SWISS_DEF2(dict_sw_ulong, unsigned long, M_DEFAULT_OPLIST, unsigned long, M_DEFAULT_OPLIST)
+
+static void
+test_dict_swiss(size_t  n)
+{
+  M_LET(dict, DICT_OPLIST(dict_sw_ulong)) {
+    for (size_t i = 0; i < n; i++) {
+      dict_sw_ulong_set_at(dict, rand_get(), rand_get() );
+    }
+    rand_init();
+    unsigned int s = 0;
+    for (size_t i = 0; i < n; i++) {
+      unsigned long *p = dict_sw_ulong_get(dict, rand_get());
+      if (p)
+        s += *p;
+    }
+    g_result = s;
+  }
+}
+
 /********************************************************************************************/
 
+DICT_DEF2(dict_serial, string_t, STRING_OPLIST, int, M_DEFAULT_OPLIST)
+
+/* Serialize a dictionary of n entries into memory and read it back.
+   The result is the number of bytes of the serialized dictionary. */
+static void
+test_serial_bin(size_t n, bool compact)
+{
+  M_LET(dict, dict2, DICT_OPLIST(dict_serial))
+    M_LET(str, key, STRING_OPLIST) {
+    for (size_t i = 0; i < n; i++) {
+      string_printf(key, "%u", rand_get());
+      dict_serial_set_at(dict, key, (int) (rand_get() % 1000));
+    }
+    m_serial_write_t out;
+    m_serial_bin_write_init_str(out, str);
+    if (compact)
+      m_serial_bin_write_set_compact(out);
+    m_serial_return_code_t ret = dict_serial_out_serial(out, dict);
+    m_serial_bin_write_clear(out);
+    m_serial_read_t in;
+    m_serial_bin_read_init_buffer(in, string_get_cstr(str), string_size(str));
+    ret |= dict_serial_in_serial(dict2, in);
+    m_serial_bin_read_clear(in);
+    if (ret == M_SERIAL_OK_DONE && dict_serial_size(dict2) == dict_serial_size(dict))
+      g_result = string_size(str);
+  }
+}
+
+static void
+test_serial_bin_native(size_t n)
+{
+  test_serial_bin(n, false);
+}
+
+static void
+test_serial_bin_compact(size_t n)
+{
+  test_serial_bin(n, true);
+}
+
 typedef char char_array_t[256];
 static void char_init (char_array_t a) { a[0] = 0; }
 static void char_set (char_array_t a, const char_array_t b) { strcpy(a, b); }
@@ -302,8 +396,9 @@ test_dict_str(size_t  n)
 
 /********************************************************************************************/
 
-ARRAY_DEF(array_float, float)
-ALGO_DEF(array_float, ARRAY_OPLIST(array_float))
+ARRAY_DEF(array_float, float, M_OPEXTEND(M_DEFAULT_OPLIST, RADIX_KEY(m_radix_key_float)))
+ALGO_DEF(array_float, ARRAY_OPLIST(array_float, M_OPEXTEND(M_DEFAULT_OPLIST, RADIX_KEY(m_radix_key_float))))
+ALGO_PARALLEL_DEF(array_float, ARRAY_OPLIST(array_float, M_OPEXTEND(M_DEFAULT_OPLIST, RADIX_KEY(m_radix_key_float))))
 
 static void test_sort(size_t n)
 {
@@ -316,17 +411,81 @@ static void test_sort(size_t n)
   }
 }
 
-static void test_stable_sort(size_t n)
+static void test_parallel_sort(size_t n)
+{
+  worker_t w;
+  worker_init(w, 0, 0, NULL, NULL);
+  M_LET(a1, ARRAY_OPLIST(array_float)) {
+    for(size_t i = 0; i < n; i++) {
+      array_float_push_back(a1, rand_get() );
+    }
+    array_float_parallel_sort(a1, w);
+    g_result = *array_float_get(a1, 0);
+  }
+  worker_clear(w);
+}
+
+static void test_radix_sort(size_t n)
+{
+  M_LET(a1, ARRAY_OPLIST(array_float)) {
+    for(size_t i = 0; i < n; i++) {
+      array_float_push_back(a1, rand_get() );
+    }
+    array_float_radix_sort(a1);
+    g_result = *array_float_get(a1, 0);
+  }
+}
+
+static void test_parallel_radix_sort(size_t n)
 {
+  worker_t w;
+  worker_init(w, 0, 0, NULL, NULL);
   M_LET(a1, ARRAY_OPLIST(array_float)) {
     for(size_t i = 0; i < n; i++) {
       array_float_push_back(a1, rand_get() );
     }
+    array_float_parallel_radix_sort(a1, w);
+    g_result = *array_float_get(a1, 0);
+  }
+  worker_clear(w);
+}
+
+/* Input of the stable sort: 0=random, 1=presorted, 2=reversed,
+   3=presorted with 1% of random noise */
+static void stable_sort_run(size_t n, int kind)
+{
+  M_LET(a1, ARRAY_OPLIST(array_float)) {
+    for(size_t i = 0; i < n; i++) {
+      float x = kind == 0 ? rand_get() : kind == 2 ? n - i : i;
+      if (kind == 3 && rand_get() % 100 == 0)
+        x = rand_get() % n;
+      array_float_push_back(a1, x);
+    }
     array_float_special_stable_sort(a1);
     g_result = *array_float_get(a1, 0);
   }
 }
 
+static void test_stable_sort(size_t n)
+{
+  stable_sort_run(n, 0);
+}
+
+static void test_stable_sort_sorted(size_t n)
+{
+  stable_sort_run(n, 1);
+}
+
+static void test_stable_sort_reversed(size_t n)
+{
+  stable_sort_run(n, 2);
+}
+
+static void test_stable_sort_noise(size_t n)
+{
+  stable_sort_run(n, 3);
+}
+
 /********************************************************************************************/
 
 #define SIZE_LIMIT (UINT_MAX/2)
@@ -373,18 +532,38 @@ static void prod_lock(void *arg)
   }
 }
 
-static void test_buffer(size_t n)
+BUFFER_DEF(buffer_fx, unsigned int, 0, BUFFER_QUEUE|BUFFER_BLOCKING|BUFFER_FUTEX_WAIT)
+buffer_fx_t g_buff_fx;
+
+static void conso_fx(void *arg)
+{
+  unsigned int j;
+  size_t *p_n = arg;
+  size_t n = *p_n;
+  unsigned long long s = 0;
+  for(int i = 0; i < n;i++) {
+    buffer_fx_pop(&j, g_buff_fx);
+    s += j;
+  }
+  buffer_ull_push(g_final_lock, s);
+}
+
+static void prod_fx(void *arg)
+{
+  size_t *p_n = arg;
+  size_t n = *p_n;
+  size_t r = n;
+  for(unsigned int i = 0; i < n;i++) {
+    buffer_fx_push(g_buff_fx, r );
+    r = r * 31421U + 6927U;
+  }
+}
+
+static void run_buffer(size_t n, int cpu_count,
+                       void (*prod)(void *), void (*conso)(void *))
 {
-  const int cpu_count   = n > SIZE_LIMIT ? 2 : get_cpu_count();
   const int prod_count  = cpu_count/2;
   const int conso_count = cpu_count - prod_count;
-  if (cpu_count < 2) {
-    fprintf(stderr, "WARNING: Can not measure Buffer performance.\n");
-    return;
-  }
-  n = n > SIZE_LIMIT ? n - SIZE_LIMIT : n;
-  // Init
-  buffer_uint_init(g_buff_lock, 64*cpu_count);
   buffer_ull_init (g_final_lock, 64*cpu_count);
 
   // Create thread
@@ -392,10 +571,10 @@ static void test_buffer(size_t n)
   m_thread_t idx_c[conso_count];
   m_thread_t idx_final;
   for(int i = 0; i < prod_count; i++) {
-    m_thread_create (idx_p[i], prod_lock, &n);
+    m_thread_create (idx_p[i], prod, &n);
   }
   for(int i = 0; i < conso_count; i++) {
-    m_thread_create (idx_c[i], conso_lock, &n);
+    m_thread_create (idx_c[i], conso, &n);
   }
   size_t n2 = conso_count;
   m_thread_create(idx_final, final_lock, &n2);
@@ -409,11 +588,35 @@ static void test_buffer(size_t n)
   }
   m_thread_join(idx_final);
 
-  // Clear & quit
   buffer_ull_clear(g_final_lock);
+}
+
+static void test_buffer(size_t n)
+{
+  const int cpu_count   = n > SIZE_LIMIT ? 2 : get_cpu_count();
+  if (cpu_count < 2) {
+    fprintf(stderr, "WARNING: Can not measure Buffer performance.\n");
+    return;
+  }
+  n = n > SIZE_LIMIT ? n - SIZE_LIMIT : n;
+  buffer_uint_init(g_buff_lock, 64*cpu_count);
+  run_buffer(n, cpu_count, prod_lock, conso_lock);
   buffer_uint_clear(g_buff_lock);
 }
 
+static void test_buffer_futex(size_t n)
+{
+  const int cpu_count   = n > SIZE_LIMIT ? 2 : get_cpu_count();
+  if (cpu_count < 2) {
+    fprintf(stderr, "WARNING: Can not measure Buffer performance.\n");
+    return;
+  }
+  n = n > SIZE_LIMIT ? n - SIZE_LIMIT : n;
+  buffer_fx_init(g_buff_fx, 64*cpu_count);
+  run_buffer(n, cpu_count, prod_fx, conso_fx);
+  buffer_fx_clear(g_buff_fx);
+}
+
 /********************************************************************************************/
 
 QUEUE_MPMC_DEF(queue_uint, unsigned int, BUFFER_QUEUE)
@@ -671,6 +874,87 @@ static void test_queue_single_bulk(size_t n)
 
 /********************************************************************************************/
 
+static void conso_mpmc_bulk(void *arg)
+{
+  size_t *p_n = arg;
+  size_t n = *p_n;
+  unsigned long long s = 0;
+  unsigned tab[BULK_SIZE];
+  for(int i = 0; i < n;i+= BULK_SIZE) {
+    unsigned k = queue_uint_pop_bulk(BULK_SIZE, tab, g_buff_mpmc);
+    while (k != BULK_SIZE) {
+      m_thread_yield();
+      k += queue_uint_pop_bulk(BULK_SIZE-k, tab+k, g_buff_mpmc);
+    }
+    for(k = 0; k < BULK_SIZE;k++)
+      s += tab[k];
+  }
+  while (!queue_ull_push(g_final_mpmc, s));
+}
+
+static void prod_mpmc_bulk(void *arg)
+{
+  size_t *p_n = arg;
+  size_t n = *p_n;
+  if ((n % BULK_SIZE) != 0) abort();
+  size_t r = n;
+  unsigned tab[BULK_SIZE];
+  for(unsigned int i = 0; i < n;i+= BULK_SIZE) {
+    for(unsigned k = 0; k < BULK_SIZE; k++) {
+      tab[k] = r;
+      r = r * 31421U + 6927U;
+    }
+    unsigned k = queue_uint_push_bulk(g_buff_mpmc, BULK_SIZE, tab);
+    while (k != BULK_SIZE) {
+      m_thread_yield();
+      k += queue_uint_push_bulk(g_buff_mpmc, BULK_SIZE-k, tab+k);
+    }
+  }
+}
+
+static void test_queue_bulk(size_t n)
+{
+  const int cpu_count   = n > SIZE_LIMIT ? 2 : get_cpu_count();
+  const int prod_count  = cpu_count/2;
+  const int conso_count = cpu_count - prod_count;
+  if (cpu_count < 2 || prod_count != conso_count) {
+    fprintf(stderr, "WARNING: Can not measure Queue BULK performance.\n");
+    return;
+  }
+  n = n > SIZE_LIMIT ? n - SIZE_LIMIT : n;
+  // Init
+  queue_uint_init(g_buff_mpmc, 64*cpu_count);
+  queue_ull_init (g_final_mpmc, 64*cpu_count);
+
+  // Create thread
+  m_thread_t idx_p[prod_count];
+  m_thread_t idx_c[conso_count];
+  m_thread_t idx_final;
+  for(int i = 0; i < prod_count; i++) {
+    m_thread_create (idx_p[i], prod_mpmc_bulk, &n);
+  }
+  for(int i = 0; i < conso_count; i++) {
+    m_thread_create (idx_c[i], conso_mpmc_bulk, &n);
+  }
+  size_t n2 = conso_count;
+  m_thread_create(idx_final, final_mpmc, &n2);
+
+  // Wait for jobs to be done.
+  for(int i = 0; i < prod_count; i++) {
+    m_thread_join(idx_p[i]);
+  }
+  for(int i = 0; i < conso_count; i++) {
+    m_thread_join(idx_c[i]);
+  }
+  m_thread_join(idx_final);
+
+  // Clear & quit
+  queue_ull_clear(g_final_mpmc);
+  queue_uint_clear(g_buff_mpmc);
+}
+
+/********************************************************************************************/
+
 DEQUE_DEF(deque_uint, unsigned int)
 CONCURRENT_DEF(cdeque_uint, deque_uint_t, M_OPEXTEND(DEQUE_OPLIST(deque_uint, M_DEFAULT_OPLIST), PUSH(deque_uint_push_front)))
 
@@ -759,8 +1043,171 @@ static void test_queue_concurrent(size_t n)
 
 /********************************************************************************************/
 
+CONCURRENT_DEF(cdict_oa_ulong, dict_oa_ulong_t, DICT_OPLIST(dict_oa_ulong))
+CONCURRENT_DICT_SHARDED_DEF(sdict_oa_ulong, dict_oa_ulong_t, 64, DICT_OPLIST(dict_oa_ulong))
+
+#define DICT_CONC_KEYS 65536
+
+cdict_oa_ulong_t g_cdict;
+sdict_oa_ulong_t g_sdict;
+
+typedef struct {
+  size_t        n;
+  unsigned int  seed;
+  bool          sharded;
+  unsigned long sum;
+} dict_conc_arg_t;
+
+/* Mix of 80% of reads, 10% of insertions & 10% of deletions */
+static void dict_conc(void *arg)
+{
+  dict_conc_arg_t *p = arg;
+  unsigned int r = p->seed;
+  unsigned long s = 0, v;
+  for(size_t i = 0; i < p->n; i++) {
+    r = r * 31421U + 6927U;
+    unsigned long key = 2 + (r >> 8) % DICT_CONC_KEYS;
+    unsigned int op = (r >> 24) % 10;
+    if (p->sharded) {
+      if (op == 0)
+        sdict_oa_ulong_set_at(g_sdict, key, r);
+      else if (op == 1)
+        sdict_oa_ulong_erase(g_sdict, key);
+      else if (sdict_oa_ulong_get_copy(&v, g_sdict, key))
+        s += v;
+    } else {
+      if (op == 0)
+        cdict_oa_ulong_set_at(g_cdict, key, r);
+      else if (op == 1)
+        cdict_oa_ulong_erase(g_cdict, key);
+      else if (cdict_oa_ulong_get_copy(&v, g_cdict, key))
+        s += v;
+    }
+  }
+  p->sum = s;
+}
+
+/* Measure the scaling of the global lock and of the sharded dictionaries
+   from 1 to 64 threads for the same total number of operations */
+static void test_dict_concurrent(size_t n)
+{
+  unsigned long s = 0;
+  for(int sharded = 0; sharded < 2; sharded++) {
+    for(int thread_count = 1; thread_count <= 64; thread_count *= 2) {
+      cdict_oa_ulong_init(g_cdict);
+      sdict_oa_ulong_init(g_sdict);
+      for(unsigned long k = 2; k < 2 + DICT_CONC_KEYS; k += 2) {
+        cdict_oa_ulong_set_at(g_cdict, k, k);
+        sdict_oa_ulong_set_at(g_sdict, k, k);
+      }
+      m_thread_t idx[thread_count];
+      dict_conc_arg_t arg[thread_count];
+      unsigned long long start = cputime();
+      for(int i = 0; i < thread_count; i++) {
+        arg[i].n       = n / thread_count;
+        arg[i].seed    = 1 + i;
+        arg[i].sharded = sharded;
+        m_thread_create (idx[i], dict_conc, &arg[i]);
+      }
+      for(int i = 0; i < thread_count; i++) {
+        m_thread_join(idx[i]);
+        s += arg[i].sum;
+      }
+      unsigned long long end = cputime();
+      double dt = (double) (end - start + 1) / 1000000.0;
+      printf ("  %s %2d threads: %10.0f ops/sec\n",
+              sharded ? "SHARDED   " : "CONCURRENT", thread_count,
+              (double) (n / thread_count * thread_count) / dt);
+      sdict_oa_ulong_clear(g_sdict);
+      cdict_oa_ulong_clear(g_cdict);
+    }
+  }
+  g_result = s;
+}
+
+/********************************************************************************************/
+
 static unsigned long *g_p;
 
+/********************************************************************************************/
+
+TUPLE_DEF2(json_rec, (id, int), (value, double), (valid, bool), (name, string_t))
+#define M_OPL_json_rec_t() TUPLE_OPLIST(json_rec, M_DEFAULT_OPLIST, M_DEFAULT_OPLIST, M_DEFAULT_OPLIST, STRING_OPLIST)
+ARRAY_DEF(array_json, json_rec_t)
+
+static string_t g_json;
+
+/* Generate the JSON of an array of n records (about 60 bytes per record) */
+static void test_json_prepare(size_t n)
+{
+  array_json_t a;
+  json_rec_t r;
+  array_json_init(a);
+  json_rec_init(r);
+  for(size_t i = 0; i < n; i++) {
+    r->id = (int) rand_get();
+    r->value = (rand_get() % 100000) / 100.0;
+    r->valid = rand_get() & 1;
+    string_printf(r->name, "record %u", rand_get() % 10000);
+    array_json_push_back(a, r);
+  }
+  m_serial_write_t out;
+  string_init(g_json);
+  m_serial_json_write_init_str(out, g_json);
+  array_json_out_serial(out, a);
+  m_serial_json_write_clear(out);
+  json_rec_clear(r);
+  array_json_clear(a);
+}
+
+static void test_json_final(void)
+{
+  string_clear(g_json);
+}
+
+static void test_json_file(size_t n)
+{
+  FILE *f = tmpfile();
+  if (f == NULL) abort();
+  fwrite(string_get_cstr(g_json), string_size(g_json), 1, f);
+  rewind(f);
+  M_LET(a, ARRAY_OPLIST(array_json, M_OPL_json_rec_t())) {
+    m_serial_read_t in;
+    m_serial_json_read_init(in, f);
+    if (array_json_in_serial(a, in) == M_SERIAL_OK_DONE)
+      g_result = array_json_size(a);
+    m_serial_json_read_clear(in);
+  }
+  fclose(f);
+  (void) n;
+}
+
+static void test_json_buffer(size_t n)
+{
+  M_LET(a, ARRAY_OPLIST(array_json, M_OPL_json_rec_t())) {
+    m_serial_read_t in;
+    m_serial_json_read_init_buffer(in, string_get_cstr(g_json), string_size(g_json));
+    if (array_json_in_serial(a, in) == M_SERIAL_OK_DONE)
+      g_result = array_json_size(a);
+    m_serial_json_read_clear(in);
+  }
+  (void) n;
+}
+
+static void test_json_index(size_t n)
+{
+  M_LET(a, ARRAY_OPLIST(array_json, M_OPL_json_rec_t())) {
+    m_serial_read_t in;
+    m_serial_json_read_init_index(in, string_get_cstr(g_json), string_size(g_json));
+    if (array_json_in_serial(a, in) == M_SERIAL_OK_DONE)
+      g_result = array_json_size(a);
+    m_serial_json_read_clear(in);
+  }
+  (void) n;
+}
+
+/********************************************************************************************/
+
 static void test_hash_prepare(size_t n)
 {
   g_p = malloc (n * sizeof(unsigned long));
@@ -809,6 +1256,18 @@ int main(int argc, const char *argv[])
     test_function("Dict   time", 1000000, test_dict);
   if (n == 42)
     test_function("DictOA time", 1000000, test_dict_oa);
+  if (n == 44)
+    test_function("DictSW time", 1000000, test_dict_swiss);
+  if (n == 45)
+    test_function("DictOA mmap time", 1000000, test_dict_oa_mmap);
+  if (n == 46)
+    test_function("DictOA time (big)", 16000000, test_dict_oa);
+  if (n == 47)
+    test_function("DictOA mmap time (big)", 16000000, test_dict_oa_mmap);
+  if (n == 48)
+    test_function("Serial BIN time", 1000000, test_serial_bin_native);
+  if (n == 49)
+    test_function("Serial BIN compact time", 1000000, test_serial_bin_compact);
   if (n == 41)
     test_function("DictB  time", 1000000, test_dict_big);
   if (n == 43)
@@ -817,6 +1276,18 @@ int main(int argc, const char *argv[])
     test_function("Sort   time", 10000000, test_sort);
   if (n == 51)
     test_function("Stable Sort time", 10000000, test_stable_sort);
+  if (n == 55)
+    test_function("Stable Sort presorted time", 10000000, test_stable_sort_sorted);
+  if (n == 56)
+    test_function("Stable Sort reversed time", 10000000, test_stable_sort_reversed);
+  if (n == 57)
+    test_function("Stable Sort noise time", 10000000, test_stable_sort_noise);
+  if (n == 52)
+    test_function("Parallel Sort time", 10000000, test_parallel_sort);
+  if (n == 53)
+    test_function("Radix Sort time", 10000000, test_radix_sort);
+  if (n == 54)
+    test_function("Parallel Radix Sort time", 10000000, test_parallel_radix_sort);
   if (n == 60)
     test_function("Buffer time", 1000000, test_buffer);
   if (n == 61)
@@ -831,6 +1302,28 @@ int main(int argc, const char *argv[])
     test_function("Queue CONCURRENT time", 1000000, test_queue_concurrent);
   if (n == 66)
     test_function("Queue SPSC BULK time", 1000000, test_queue_single_bulk);
+  if (n == 68)
+    test_function("Queue MPMC BULK time", 1000000, test_queue_bulk);
+  if (n == 69)
+    test_function("Queue MPMC BULK time (P2)", SIZE_LIMIT+1000000, test_queue_bulk);
+  if (n == 67)
+    test_function("Dict CONCURRENT scaling time", 4000000, test_dict_concurrent);
+  if (n == 70)
+    test_function("Buffer FUTEX time", 1000000, test_buffer_futex);
+  if (n == 71)
+    test_function("Buffer FUTEX time (P2)", SIZE_LIMIT+1000000, test_buffer_futex);
+  if (n == 80 || n == 81 || n == 82) {
+    /* The number of records can be given: 16000000 gives about 1 GB of JSON */
+    int m = (argc > 2) ? atoi(argv[2]) : 1000000;
+    test_json_prepare(m);
+    if (n == 80)
+      test_function("JSON FILE read time", m, test_json_file);
+    if (n == 81)
+      test_function("JSON buffer read time", m, test_json_buffer);
+    if (n == 82)
+      test_function("JSON index read time", m, test_json_index);
+    test_json_final();
+  }
   if (n == 70) {
     n = (argc > 2) ? atoi(argv[2]) : 100000000;
     test_hash_prepare(n);
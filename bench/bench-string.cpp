@@ -136,6 +136,11 @@ int timeTest (double &res, int (*testfn) (int count), int count) {
 
 #define TESTSTRING1 ("<sometag name=\"John Doe\" position=\"Executive VP Marketing\"/>")
 
+/* A long line of log (searched like a grep does) */
+#define LOGLINE1 ("2019-03-01 12:00:00 INFO worker[42]: request served in 12 ms; ")
+#define LOGLINE2 ("ERROR disk full")
+#define LOGREPEAT 16
+
 #if defined (BENCH_CAN_USE_STL)
 int testSTL_emptyCtor (int count) {
   int i, c = 0;
@@ -205,6 +210,23 @@ int i, c = 0;
  return c;
 }
 
+int testSTL_longscan (int count) {
+  int i, c = 0;
+  std::string b;
+  for (i=0; i < LOGREPEAT; i++) b += LOGLINE1;
+  b += LOGLINE2;
+
+  for (i=0; i < count; i++) {
+    c += b.find ("ERROR");
+    c += b.find ('!');
+    c += b.find_first_of ("!?");
+    c += b.find_first_not_of ("0123456789-: ");
+    c += b.find_first_of ("[;") ^i;
+    BARRIER(&b);
+  }
+  return c;
+}
+
 int testSTL_concat (int count) {
   int i, j, c = 0;
   std::string a (TESTSTRING1);
@@ -515,6 +537,26 @@ int testMLIB_scan (int count) {
   return c;
 }
 
+int testMLIB_longscan (int count) {
+  int i, c = 0;
+  char line[LOGREPEAT * sizeof LOGLINE1 + sizeof LOGLINE2] = "";
+  for (i=0; i < LOGREPEAT; i++) strcat(line, LOGLINE1);
+  strcat(line, LOGLINE2);
+  string_t b;
+  string_init_set_str(b, line);
+
+  for (c=i=0; i < count; i++) {
+    c += string_search_str (b, "ERROR");
+    c += string_search_char (b, '!');
+    c += string_search_pbrk (b, "!?");
+    c += string_spn (b, "0123456789-: ");
+    c += string_cspn (b, "[;") ^i;
+    BARRIER(&b);
+  }
+  string_clear(b);
+  return c;
+}
+
 int testMLIB_concat (int count) {
   int i, j, c = 0;
   string_t a, accum;
@@ -895,7 +937,7 @@ int testGLIB_concat (int count) {
 #endif
 
 
-#define NTESTS 8
+#define NTESTS 9
 struct flags {
   int runtest[NTESTS];
 };
@@ -950,6 +992,10 @@ int benchTest (const struct flags * runflags) {
     c += timeTest (cps, testSTL_replace, 10000);
     print ("std::string", "replace", cps);
   }
+  if (runflags->runtest[8]) {
+    c += timeTest (cps, testSTL_longscan, 100000);
+    print ("std::string", "long scan", cps);
+  }
 #endif
   
 #ifdef BENCH_CAN_USE_BSTRLIB
@@ -1051,6 +1097,10 @@ int benchTest (const struct flags * runflags) {
     c += timeTest (cps, testMLIB_replace, 10000);
     print ("M*LIB", "replace", cps);
   }
+  if (runflags->runtest[8]) {
+    c += timeTest (cps, testMLIB_longscan, 100000);
+    print ("M*LIB", "long scan", cps);
+  }
 #endif
 
 #ifdef BENCH_CAN_USE_SDS
@@ -799,6 +799,9 @@ benchmark_tfw_pool_create_and_destroy()
 MEMPOOL_DEF(mempool_small, Small)
 MEMPOOL_DEF(mempool_big, Big)
 MEMPOOL_DEF(mempool_huge, Huge)
+MEMPOOL_TCACHE_DEF(tcache_small, Small)
+MEMPOOL_TCACHE_DEF(tcache_big, Big)
+MEMPOOL_TCACHE_DEF(tcache_huge, Huge)
 
 void
 benchmark_mempool_small()
@@ -873,6 +876,45 @@ benchmark_mempool_mix_free()
   mempool_huge_clear (h);
 }
 
+void
+benchmark_mempool_tcache_mix_free()
+{
+  tcache_small_t s, *ptr_s = &s;
+  tcache_big_t   b, *ptr_b = &b;
+  tcache_huge_t  h, *ptr_h = &h;
+  
+  tcache_small_init (s);
+  tcache_big_init (b);
+  tcache_huge_init (h);
+  
+  benchmark(std::move(std::string("M*LIB tcache mempool w/ free (Mix)")), [=]() {
+      for (size_t i = 0; i < N; ++i) {
+        if (__builtin_expect(!(i & 0xfff), 0)) {
+          Huge *o = tcache_huge_alloc (*ptr_h);
+          touch_obj(o);
+          if (!(i & 1))
+            tcache_huge_free (*ptr_h, o);
+        }
+        else if (__builtin_expect(!(i & 3), 0)) {
+          Big *o = tcache_big_alloc(*ptr_b);
+          touch_obj(o);
+          if (!(i & 1))
+            tcache_big_free (*ptr_b, o);
+        }
+        else {
+          Small *o = tcache_small_alloc (*ptr_s);
+          touch_obj(o);
+          if (!(i & 1))
+            tcache_small_free (*ptr_s, o);
+        }
+      }
+    });
+  
+  tcache_small_clear (s);
+  tcache_big_clear (b);
+  tcache_huge_clear (h);
+}
+
 /*
  * ------------------------------------------------------------------------
  *	Main part of the benchmark
@@ -927,6 +969,7 @@ main()
 	benchmark_mempool_small();
 	benchmark_mempool_big();
         benchmark_mempool_mix_free();
+        benchmark_mempool_tcache_mix_free();
 	std::cout << std::endl;
 
 	benchmark_tfw_pool<Small>();
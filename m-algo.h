@@ -27,6 +27,50 @@
 
 #include "m-core.h"
 
+/* Size of a range below which the parallel algorithms
+   don't split anymore the work and run sequentially */
+#ifndef M_ALGO_PARALLEL_THRESHOLD
+#define M_ALGO_PARALLEL_THRESHOLD 8192
+#endif
+
+/* Predefined keys for the RADIX_KEY operator of the standard C types.
+   The order of the keys is the order of the values.
+   Usage: M_OPEXTEND(M_DEFAULT_OPLIST, RADIX_KEY(m_radix_key_u32)) */
+static inline uint64_t m_radix_key_u32(uint32_t x)
+{
+  return x;
+}
+
+static inline uint64_t m_radix_key_u64(uint64_t x)
+{
+  return x;
+}
+
+static inline uint64_t m_radix_key_i32(int32_t x)
+{
+  return (uint32_t) x ^ UINT32_C(0x80000000);
+}
+
+static inline uint64_t m_radix_key_i64(int64_t x)
+{
+  return (uint64_t) x ^ UINT64_C(0x8000000000000000);
+}
+
+/* Negative floats have their bits reversed, positive ones their sign set */
+static inline uint64_t m_radix_key_float(float x)
+{
+  uint32_t u;
+  memcpy(&u, &x, sizeof u);
+  return (u & UINT32_C(0x80000000)) ? (uint32_t) ~u : u | UINT32_C(0x80000000);
+}
+
+static inline uint64_t m_radix_key_double(double x)
+{
+  uint64_t u;
+  memcpy(&u, &x, sizeof u);
+  return (u & UINT64_C(0x8000000000000000)) ? ~u : u | UINT64_C(0x8000000000000000);
+}
+
 /* Define different kind of basic algorithms named 'name' over the container
    which oplist is 'contOp' as static inline functions.
    USAGE:
@@ -34,6 +78,14 @@
 #define ALGO_DEF(name, cont_oplist)             \
   ALGOI_DEF_P1(name, M_GLOBAL_OPLIST(cont_oplist))
 
+/* Define the parallel algorithms of a random access container
+   (parallel sort, for each, map reduce and radix sort) executed
+   by a pool of workers. ALGO_DEF shall have been called with the same
+   name and container oplist, and m-worker.h shall be included.
+   USAGE: ALGO_PARALLEL_DEF(name, container_oplist) */
+#define ALGO_PARALLEL_DEF(name, cont_oplist)                            \
+  ALGOI_PARALLEL_DEF_P1(name, M_GLOBAL_OPLIST(cont_oplist))
+
 
 /* Map a function or a macro to all elements of a container.
    USAGE:
@@ -512,6 +564,433 @@
   }                                                                     \
   , /* NO_DIV METHOD */ )                                               \
                                                                         \
+  /* Radix sort is only defined for random access containers */        \
+  M_IF_METHOD2(GET_KEY, GET_SIZE, cont_oplist)(                         \
+  M_IF_METHOD(IT_PREVIOUS, cont_oplist)(                                \
+  ALGOI_BASE_DEF(name, container_t, cont_oplist, type_t)                \
+  M_IF_METHOD2(RADIX_KEY, CMP, type_oplist)(                            \
+  ALGOI_RADIX_DEF(name, container_t, cont_oplist, type_t, type_oplist)  \
+  , )                                                                   \
+  , ), )                                                                \
+
+#define ALGOI_PARALLEL_DEF_P1(name, cont_oplist)                        \
+  ALGOI_PARALLEL_DEF_P2(name, M_GET_TYPE cont_oplist, cont_oplist,      \
+                        M_GET_SUBTYPE cont_oplist, M_GET_OPLIST cont_oplist)
+
+/* Parallel algorithms are only defined for random access containers */
+#define ALGOI_PARALLEL_DEF_P2(name, container_t, cont_oplist, type_t, type_oplist) \
+  M_IF_METHOD2(GET_KEY, GET_SIZE, cont_oplist)(                         \
+  M_IF_METHOD(IT_PREVIOUS, cont_oplist)(                                \
+  ALGOI_PARALLEL_DEF(name, container_t, cont_oplist, type_t, type_oplist) \
+  M_IF_METHOD2(RADIX_KEY, CMP, type_oplist)(                            \
+  ALGOI_PARALLEL_RADIX_DEF(name, container_t, cont_oplist, type_t, type_oplist) \
+  , )                                                                   \
+  , ), )
+
+/* Define the access to the raw storage of a random access container */
+#define ALGOI_BASE_DEF(name, container_t, cont_oplist, type_t)          \
+                                                                        \
+  /* Return the base of the storage of the container if it is contiguous */ \
+  static inline type_t *                                                \
+  M_C(name, _int_base)(const container_t l, size_t n)                   \
+  {                                                                     \
+    if (n == 0)                                                         \
+      return NULL;                                                      \
+    type_t *base = M_CALL_GET_KEY(cont_oplist, l, 0);                   \
+    return M_CALL_GET_KEY(cont_oplist, l, n-1) == base + n - 1 ? base : NULL; \
+  }                                                                     \
+
+/* Define the parallel algorithms over a random access container.
+   The work is split by index range over the raw storage of the container
+   and dispatched to the given worker pool. */
+#define ALGOI_PARALLEL_DEF(name, container_t, cont_oplist, type_t, type_oplist) \
+                                                                        \
+  struct M_C(name, _parallel_for_each_s) {                              \
+    type_t *base;                                                       \
+    size_t n;                                                           \
+    void (*f)(type_t);                                                  \
+    struct worker_s *workers;                                           \
+  };                                                                    \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _parallel_for_each_rec)(void *data)                         \
+  {                                                                     \
+    struct M_C(name, _parallel_for_each_s) *p =                         \
+      (struct M_C(name, _parallel_for_each_s) *) data;                  \
+    if (p->n <= M_ALGO_PARALLEL_THRESHOLD) {                            \
+      for(size_t i = 0; i < p->n; i++)                                  \
+        p->f(p->base[i]);                                               \
+      return;                                                           \
+    }                                                                   \
+    size_t h = p->n / 2;                                                \
+    struct M_C(name, _parallel_for_each_s) left = *p;                   \
+    struct M_C(name, _parallel_for_each_s) right = *p;                  \
+    left.n = h;                                                         \
+    right.base += h;                                                    \
+    right.n -= h;                                                       \
+    worker_sync_t block;                                                \
+    worker_start(block, p->workers);                                    \
+    worker_spawn(block, M_C(name, _parallel_for_each_rec), &left);      \
+    M_C(name, _parallel_for_each_rec)(&right);                          \
+    worker_sync(block);                                                 \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _parallel_for_each)(container_t l, void (*f)(type_t),       \
+                                worker_t workers)                       \
+  {                                                                     \
+    size_t n = M_CALL_GET_SIZE(cont_oplist, l);                         \
+    type_t *base = M_C(name, _int_base)(l, n);                          \
+    if (n <= M_ALGO_PARALLEL_THRESHOLD || base == NULL                  \
+        || worker_count(workers) <= 1) {                                \
+      M_C(name, _for_each)(l, f);                                       \
+      return;                                                           \
+    }                                                                   \
+    struct M_C(name, _parallel_for_each_s) p;                           \
+    p.base = base;                                                      \
+    p.n = n;                                                            \
+    p.f = f;                                                            \
+    p.workers = workers;                                                \
+    M_C(name, _parallel_for_each_rec)(&p);                              \
+  }                                                                     \
+                                                                        \
+  M_IF_METHOD(INIT, type_oplist)(                                       \
+  struct M_C(name, _parallel_map_reduce_s) {                            \
+    type_t *dest;                                                       \
+    type_t *base;                                                       \
+    size_t n;                                                           \
+    void (*redFunc)(type_t*, type_t const);                             \
+    void (*mapFunc)(type_t*, type_t const);                             \
+    struct worker_s *workers;                                           \
+  };                                                                    \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _parallel_map_reduce_rec)(void *data)                       \
+  {                                                                     \
+    struct M_C(name, _parallel_map_reduce_s) *p =                       \
+      (struct M_C(name, _parallel_map_reduce_s) *) data;                \
+    type_t tmp;                                                         \
+    M_CALL_INIT(type_oplist, tmp);                                      \
+    if (p->n <= M_ALGO_PARALLEL_THRESHOLD) {                            \
+      p->mapFunc(p->dest, p->base[0]);                                  \
+      for(size_t i = 1; i < p->n; i++) {                                \
+        p->mapFunc(&tmp, p->base[i]);                                   \
+        p->redFunc(p->dest, tmp);                                       \
+      }                                                                 \
+    } else {                                                            \
+      /* The left half is reduced in dest, the right one in tmp */      \
+      size_t h = p->n / 2;                                              \
+      struct M_C(name, _parallel_map_reduce_s) left = *p;               \
+      struct M_C(name, _parallel_map_reduce_s) right = *p;              \
+      left.n = h;                                                       \
+      right.dest = &tmp;                                                \
+      right.base += h;                                                  \
+      right.n -= h;                                                     \
+      worker_sync_t block;                                              \
+      worker_start(block, p->workers);                                  \
+      worker_spawn(block, M_C(name, _parallel_map_reduce_rec), &left);  \
+      M_C(name, _parallel_map_reduce_rec)(&right);                      \
+      worker_sync(block);                                               \
+      p->redFunc(p->dest, tmp);                                         \
+    }                                                                   \
+    M_CALL_CLEAR(type_oplist, tmp);                                     \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _parallel_map_reduce)(type_t *dest, const container_t l,    \
+                                  void (*redFunc)(type_t*, type_t const), \
+                                  void (*mapFunc)(type_t*, type_t const), \
+                                  worker_t workers)                     \
+  {                                                                     \
+    size_t n = M_CALL_GET_SIZE(cont_oplist, l);                         \
+    type_t *base = M_C(name, _int_base)(l, n);                          \
+    if (n <= M_ALGO_PARALLEL_THRESHOLD || base == NULL                  \
+        || worker_count(workers) <= 1) {                                \
+      M_C(name, _map_reduce)(dest, l, redFunc, mapFunc);                \
+      return;                                                           \
+    }                                                                   \
+    struct M_C(name, _parallel_map_reduce_s) p;                         \
+    p.dest = dest;                                                      \
+    p.base = base;                                                      \
+    p.n = n;                                                            \
+    p.redFunc = redFunc;                                                \
+    p.mapFunc = mapFunc;                                                \
+    p.workers = workers;                                                \
+    M_C(name, _parallel_map_reduce_rec)(&p);                            \
+  }                                                                     \
+  , /* No INIT method */)                                               \
+                                                                        \
+  M_IF_METHOD(CMP, type_oplist)(                                        \
+  /* PARALLEL MERGE SORT (unstable) */                                  \
+  struct M_C(name, _parallel_merge_s) {                                 \
+    type_t *a;                                                          \
+    size_t na;                                                          \
+    type_t *b;                                                          \
+    size_t nb;                                                          \
+    type_t *out;                                                        \
+    struct worker_s *workers;                                           \
+  };                                                                    \
+                                                                        \
+  /* Merge the sorted ranges 'a' and 'b' into 'out' (moving the objects) */ \
+  static inline void                                                    \
+  M_C(name, _parallel_merge)(void *data)                                \
+  {                                                                     \
+    struct M_C(name, _parallel_merge_s) *p =                            \
+      (struct M_C(name, _parallel_merge_s) *) data;                     \
+    type_t *a = p->a;                                                   \
+    type_t *b = p->b;                                                   \
+    size_t na = p->na;                                                  \
+    size_t nb = p->nb;                                                  \
+    type_t *out = p->out;                                               \
+    if (na < nb) {                                                      \
+      /* Always split the biggest range */                              \
+      M_SWAP(type_t *, a, b);                                           \
+      M_SWAP(size_t, na, nb);                                           \
+    }                                                                   \
+    if (na + nb <= M_ALGO_PARALLEL_THRESHOLD) {                         \
+      size_t i = 0;                                                     \
+      size_t j = 0;                                                     \
+      while (i < na && j < nb) {                                        \
+        if (M_C(name, _sort_cmp)(M_CONST_CAST(type_t, &b[j]), M_CONST_CAST(type_t, &a[i])) < 0) \
+          memcpy(out++, &b[j++], sizeof (type_t));                      \
+        else                                                            \
+          memcpy(out++, &a[i++], sizeof (type_t));                      \
+      }                                                                 \
+      memcpy(out, &a[i], (na - i) * sizeof (type_t));                   \
+      memcpy(out + na - i, &b[j], (nb - j) * sizeof (type_t));          \
+      return;                                                           \
+    }                                                                   \
+    /* Split 'a' at its middle and 'b' at the first element which is    \
+       not lower than the middle of 'a' */                              \
+    size_t ma = na / 2;                                                 \
+    size_t lo = 0;                                                      \
+    size_t hi = nb;                                                     \
+    while (lo < hi) {                                                   \
+      size_t mid = lo + (hi - lo) / 2;                                  \
+      if (M_C(name, _sort_cmp)(M_CONST_CAST(type_t, &b[mid]), M_CONST_CAST(type_t, &a[ma])) < 0) \
+        lo = mid + 1;                                                   \
+      else                                                              \
+        hi = mid;                                                       \
+    }                                                                   \
+    memcpy(&out[ma + lo], &a[ma], sizeof (type_t));                     \
+    struct M_C(name, _parallel_merge_s) left = *p;                      \
+    struct M_C(name, _parallel_merge_s) right = *p;                     \
+    left.a = a;                                                         \
+    left.na = ma;                                                       \
+    left.b = b;                                                         \
+    left.nb = lo;                                                       \
+    right.a = a + ma + 1;                                               \
+    right.na = na - ma - 1;                                             \
+    right.b = b + lo;                                                   \
+    right.nb = nb - lo;                                                 \
+    right.out = out + ma + lo + 1;                                      \
+    worker_sync_t block;                                                \
+    worker_start(block, p->workers);                                    \
+    worker_spawn(block, M_C(name, _parallel_merge), &left);             \
+    M_C(name, _parallel_merge)(&right);                                 \
+    worker_sync(block);                                                 \
+  }                                                                     \
+                                                                        \
+  struct M_C(name, _parallel_sort_s) {                                  \
+    type_t *src;                                                        \
+    type_t *tmp;                                                        \
+    size_t n;                                                           \
+    bool in_tmp;  /* Shall the sorted range end in 'tmp' ? */           \
+    struct worker_s *workers;                                           \
+  };                                                                    \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _parallel_sort_rec)(void *data)                             \
+  {                                                                     \
+    struct M_C(name, _parallel_sort_s) *p =                             \
+      (struct M_C(name, _parallel_sort_s) *) data;                      \
+    if (p->n <= M_ALGO_PARALLEL_THRESHOLD) {                            \
+      int (*func_void)(const void*, const void*);                       \
+      func_void = (int (*)(const void*, const void*))M_C(name, _sort_cmp); \
+      qsort(p->src, p->n, sizeof (type_t), func_void);                  \
+      if (p->in_tmp)                                                    \
+        memcpy(p->tmp, p->src, p->n * sizeof (type_t));                 \
+      return;                                                           \
+    }                                                                   \
+    /* Sort both halves in the other buffer, then merge them back */    \
+    size_t h = p->n / 2;                                                \
+    struct M_C(name, _parallel_sort_s) left = *p;                       \
+    struct M_C(name, _parallel_sort_s) right = *p;                      \
+    left.n = h;                                                         \
+    left.in_tmp = !p->in_tmp;                                           \
+    right.src += h;                                                     \
+    right.tmp += h;                                                     \
+    right.n -= h;                                                       \
+    right.in_tmp = !p->in_tmp;                                          \
+    worker_sync_t block;                                                \
+    worker_start(block, p->workers);                                    \
+    worker_spawn(block, M_C(name, _parallel_sort_rec), &left);          \
+    M_C(name, _parallel_sort_rec)(&right);                              \
+    worker_sync(block);                                                 \
+    struct M_C(name, _parallel_merge_s) m;                              \
+    m.a = p->in_tmp ? p->src : p->tmp;                                  \
+    m.na = h;                                                           \
+    m.b = m.a + h;                                                      \
+    m.nb = p->n - h;                                                    \
+    m.out = p->in_tmp ? p->tmp : p->src;                                \
+    m.workers = p->workers;                                             \
+    M_C(name, _parallel_merge)(&m);                                     \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _parallel_sort)(container_t l, worker_t workers)            \
+  {                                                                     \
+    size_t n = M_CALL_GET_SIZE(cont_oplist, l);                         \
+    type_t *base = M_C(name, _int_base)(l, n);                          \
+    if (n <= M_ALGO_PARALLEL_THRESHOLD || base == NULL                  \
+        || worker_count(workers) <= 1) {                                \
+      M_C(name, _sort)(l);                                              \
+      return;                                                           \
+    }                                                                   \
+    type_t *tmp = M_CALL_REALLOC(type_oplist, type_t, NULL, n);         \
+    if (tmp == NULL) {                                                  \
+      M_MEMORY_FULL(sizeof (type_t) * n);                               \
+      return;                                                           \
+    }                                                                   \
+    struct M_C(name, _parallel_sort_s) p;                               \
+    p.src = base;                                                       \
+    p.tmp = tmp;                                                        \
+    p.n = n;                                                            \
+    p.in_tmp = false;                                                   \
+    p.workers = workers;                                                \
+    M_C(name, _parallel_sort_rec)(&p);                                  \
+    M_CALL_FREE(type_oplist, tmp);                                      \
+  }                                                                     \
+  , /* No CMP method */)
+
+/* Define the radix sort over a random access container
+   which objects provide an unsigned integer key (RADIX_KEY operator). */
+#define ALGOI_RADIX_DEF(name, container_t, cont_oplist, type_t, type_oplist) \
+                                                                        \
+  /* Histogram of each byte of the keys of tab[0..n[ */                 \
+  static inline void                                                    \
+  M_C(name, _radix_histogram)(size_t count[8][256], const type_t *tab, size_t n) \
+  {                                                                     \
+    memset(count, 0, 8 * sizeof count[0]);                              \
+    for(size_t i = 0; i < n; i++) {                                     \
+      uint64_t key = M_CALL_RADIX_KEY(type_oplist, tab[i]);             \
+      for(int d = 0; d < 8; d++)                                        \
+        count[d][(key >> (8*d)) & 0xFF] ++;                             \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  /* LSD radix sort (stable) from the histogram of the keys.            \
+     A pass on a byte which is the same for all the keys is skipped,    \
+     so that only 4 passes are done for 32 bits keys. */                \
+  static inline void                                                    \
+  M_C(name, _radix_sort_passes)(type_t *tab, size_t n, size_t count[8][256]) \
+  {                                                                     \
+    type_t *src = tab;                                                  \
+    type_t *dst = NULL;                                                 \
+    type_t *tmp = NULL;                                                 \
+    for(int d = 0; d < 8; d++) {                                        \
+      uint64_t key = M_CALL_RADIX_KEY(type_oplist, src[0]);             \
+      if (count[d][(key >> (8*d)) & 0xFF] == n)                         \
+        continue;                                                       \
+      if (tmp == NULL) {                                                \
+        tmp = M_CALL_REALLOC(type_oplist, type_t, NULL, n);             \
+        if (tmp == NULL) {                                              \
+          M_MEMORY_FULL(sizeof (type_t) * n);                           \
+          return;                                                       \
+        }                                                               \
+        dst = tmp;                                                      \
+      }                                                                 \
+      size_t offset[256];                                               \
+      size_t sum = 0;                                                   \
+      for(int b = 0; b < 256; b++) {                                    \
+        offset[b] = sum;                                                \
+        sum += count[d][b];                                             \
+      }                                                                 \
+      for(size_t i = 0; i < n; i++) {                                   \
+        key = M_CALL_RADIX_KEY(type_oplist, src[i]);                    \
+        memcpy(&dst[offset[(key >> (8*d)) & 0xFF]++], &src[i], sizeof (type_t)); \
+      }                                                                 \
+      M_SWAP(type_t *, src, dst);                                       \
+    }                                                                   \
+    if (src != tab)                                                     \
+      memcpy(tab, src, n * sizeof (type_t));                            \
+    if (tmp != NULL)                                                    \
+      M_CALL_FREE(type_oplist, tmp);                                    \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _radix_sort)(container_t l)                                 \
+  {                                                                     \
+    size_t n = M_CALL_GET_SIZE(cont_oplist, l);                         \
+    if (n < 2)                                                          \
+      return;                                                           \
+    type_t *base = M_C(name, _int_base)(l, n);                          \
+    if (M_UNLIKELY (base == NULL)) {                                    \
+      /* Not a contiguous storage: use the comparison sort */           \
+      M_C(name, _sort)(l);                                              \
+      return;                                                           \
+    }                                                                   \
+    size_t count[8][256];                                               \
+    M_C(name, _radix_histogram)(count, base, n);                        \
+    M_C(name, _radix_sort_passes)(base, n, count);                      \
+  }                                                                     \
+
+/* Define the parallel radix sort over a random access container */
+#define ALGOI_PARALLEL_RADIX_DEF(name, container_t, cont_oplist, type_t, type_oplist) \
+                                                                        \
+  struct M_C(name, _radix_histogram_s) {                                \
+    size_t count[8][256];                                               \
+    const type_t *tab;                                                  \
+    size_t n;                                                           \
+  };                                                                    \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _radix_histogram_task)(void *data)                          \
+  {                                                                     \
+    struct M_C(name, _radix_histogram_s) *p =                           \
+      (struct M_C(name, _radix_histogram_s) *) data;                    \
+    M_C(name, _radix_histogram)(p->count, p->tab, p->n);                \
+  }                                                                     \
+                                                                        \
+  /* Same as radix sort, but the histogram is computed by the workers */ \
+  static inline void                                                    \
+  M_C(name, _parallel_radix_sort)(container_t l, worker_t workers)      \
+  {                                                                     \
+    size_t n = M_CALL_GET_SIZE(cont_oplist, l);                         \
+    size_t k = worker_count(workers);                                   \
+    if (n <= M_ALGO_PARALLEL_THRESHOLD || k <= 1) {                     \
+      M_C(name, _radix_sort)(l);                                        \
+      return;                                                           \
+    }                                                                   \
+    type_t *base = M_C(name, _int_base)(l, n);                          \
+    if (M_UNLIKELY (base == NULL)) {                                    \
+      M_C(name, _radix_sort)(l);                                        \
+      return;                                                           \
+    }                                                                   \
+    struct M_C(name, _radix_histogram_s) *h =                           \
+      M_MEMORY_REALLOC(struct M_C(name, _radix_histogram_s), NULL, k);  \
+    if (h == NULL) {                                                    \
+      M_MEMORY_FULL(sizeof (struct M_C(name, _radix_histogram_s)) * k); \
+      return;                                                           \
+    }                                                                   \
+    worker_sync_t block;                                                \
+    worker_start(block, workers);                                       \
+    for(size_t i = 0; i < k; i++) {                                     \
+      h[i].tab = base + n / k * i;                                      \
+      h[i].n = i == k - 1 ? n - n / k * i : n / k;                      \
+      if (i < k - 1)                                                    \
+        worker_spawn(block, M_C(name, _radix_histogram_task), &h[i]);   \
+    }                                                                   \
+    M_C(name, _radix_histogram_task)(&h[k-1]);                          \
+    worker_sync(block);                                                 \
+    /* Merge the histograms in the first one */                         \
+    for(size_t i = 1; i < k; i++)                                       \
+      for(int d = 0; d < 8; d++)                                        \
+        for(int b = 0; b < 256; b++)                                    \
+          h[0].count[d][b] += h[i].count[d][b];                         \
+    M_C(name, _radix_sort_passes)(base, n, h[0].count);                 \
+    M_MEMORY_FREE(h);                                                   \
+  }
 
 #define ALGOI_SORT_DEF(name, container_t, cont_oplist, type_t, type_oplist, it_t, order, sort_name) \
                                                                         \
@@ -643,7 +1122,7 @@
     it_t it2;                                                           \
     it_t it21;                                                          \
     for(M_CALL_IT_FIRST(cont_oplist, it1, l);                           \
-        !M_CALL_IT_LAST_P(cont_oplist, it1);                            \
+        !M_CALL_IT_END_P(cont_oplist, it1);                             \
         M_CALL_IT_NEXT(cont_oplist, it1))  {                            \
       type_t x; /* Do not use SET, as it is a MOVE operation */         \
       memcpy (&x, M_CALL_IT_CREF(cont_oplist, it1), sizeof (type_t));   \
@@ -0,0 +1,317 @@
+/*
+ * M*LIB - ARENA module
+ *
+ * Copyright (c) 2017-2019, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef MSTARLIB_ARENA_H
+#define MSTARLIB_ARENA_H
+
+#include "m-core.h"
+#include "m-mutex.h"
+
+/* Thread unsafe region allocator (also known as bump allocator).
+   Objects are allocated by incrementing a pointer within big chunks
+   of memory. They are not freed individually, but all at once
+   by resetting (or clearing) the arena.
+   USAGE:
+     arena_t a;
+     arena_init(a);
+     int *p = arena_alloc(a, sizeof (int));
+     ...
+     arena_reset(a); // All allocated objects are released at once
+     ...
+     arena_clear(a); // Give back memory to system
+
+   The current arena of the threads has to be defined once
+   in the program (in only one translation unit):
+     M_ARENA_DEF_CURRENT()
+   The oplist returned by ARENA_OPLIST routes the NEW, DEL, REALLOC
+   & FREE methods of an oplist to an arena so that all the containers
+   defined with this oplist allocate their nodes / tables in the arena:
+     LIST_DEF(list_uint, unsigned int, ARENA_OPLIST(M_DEFAULT_OPLIST))
+     ...
+     arena_set_current(a);
+     list_uint_t l;
+     list_uint_init(l);
+     list_uint_push_back(l, 17);
+     ...
+     arena_reset(a); // The list is no longer usable.
+*/
+
+/* Size of the first chunk of memory allocated by an arena.
+   The size of the following chunks is doubled each time
+   up to ARENA_MAX_CHUNK_SIZE. */
+#ifndef ARENA_CHUNK_SIZE
+#define ARENA_CHUNK_SIZE (16*1024)
+#endif
+
+#ifndef ARENA_MAX_CHUNK_SIZE
+#define ARENA_MAX_CHUNK_SIZE (16*1024*1024)
+#endif
+
+/* Type used to get the maximum alignment needed by any object
+   (C99 has no max_align_t). It also stores the size of the blocks
+   allocated by arena_realloc. */
+typedef union arenai_align_u {
+  long long   ll;
+  long double ld;
+  void       *ptr;
+  void      (*func)(void);
+  size_t      size;
+} arenai_align_t;
+
+#define ARENAI_ALIGN sizeof (arenai_align_t)
+
+/* Header of a chunk of memory. The memory usable for the objects
+   is just after this header. */
+typedef union arenai_chunk_u {
+  struct {
+    union arenai_chunk_u *next;
+    size_t                size;
+  } s;
+  arenai_align_t align;
+} arenai_chunk_t;
+
+typedef struct arena_s {
+  char           *ptr;         // First free byte of the current chunk
+  char           *end;         // End of the current chunk
+  arenai_chunk_t *chunk;       // Current chunk (linked to the previous ones)
+  size_t          chunk_size;  // Size of the next chunk to allocate
+} arena_t[1];
+
+/* Current arena of the thread used by ARENA_OPLIST (NULL if none).
+   It is a global variable of the program so that the current arena
+   set in one translation unit is the one used by the containers
+   of the other translation units. It has to be defined once,
+   in one translation unit, with M_ARENA_DEF_CURRENT() if the current
+   arena is used (arena_set_current, arena_get_current or ARENA_OPLIST). */
+extern M_THREAD_ATTR struct arena_s *arenai_current;
+
+#define M_ARENA_DEF_CURRENT()                                           \
+  M_THREAD_ATTR struct arena_s *arenai_current = NULL;
+
+#define ARENAI_CONTRACT(a) do {                                         \
+    assert((a) != NULL);                                                \
+    assert((a)->ptr <= (a)->end);                                       \
+    assert((a)->chunk != NULL || (a)->ptr == NULL);                     \
+    assert(((uintptr_t) (a)->ptr) % ARENAI_ALIGN == 0);                 \
+  } while (0)
+
+/* Round the size to the next multiple of the alignment.
+   The size shall have been checked against overflow. */
+#define ARENAI_ROUND(size)                                              \
+  (((size) + ARENAI_ALIGN - 1) / ARENAI_ALIGN * ARENAI_ALIGN)
+
+static inline void
+arena_init(arena_t a)
+{
+  assert (a != NULL);
+  a->ptr = NULL;
+  a->end = NULL;
+  a->chunk = NULL;
+  a->chunk_size = ARENA_CHUNK_SIZE;
+  ARENAI_CONTRACT(a);
+}
+
+static inline void
+arenai_free_chunks(arenai_chunk_t *chunk)
+{
+  while (chunk != NULL) {
+    arenai_chunk_t *next = chunk->s.next;
+    M_MEMORY_FREE(chunk);
+    chunk = next;
+  }
+}
+
+static inline void
+arena_clear(arena_t a)
+{
+  ARENAI_CONTRACT(a);
+  arenai_free_chunks(a->chunk);
+  /* Clean pointers to be safer */
+  a->ptr = NULL;
+  a->end = NULL;
+  a->chunk = NULL;
+}
+
+/* Release all the objects allocated by the arena at once.
+   Only the last (and biggest) chunk is kept for the next allocations. */
+static inline void
+arena_reset(arena_t a)
+{
+  ARENAI_CONTRACT(a);
+  if (a->chunk == NULL)
+    return;
+  arenai_free_chunks(a->chunk->s.next);
+  a->chunk->s.next = NULL;
+  a->ptr = (char *) (a->chunk + 1);
+  ARENAI_CONTRACT(a);
+}
+
+/* Allocate a new chunk able to hold at least 'size' bytes
+   and make it the current chunk. 'size' is already rounded. */
+static inline void *
+arenai_alloc_chunk(arena_t a, size_t size)
+{
+  size_t n = M_MAX(a->chunk_size, size);
+  if (M_UNLIKELY (n > SIZE_MAX - sizeof (arenai_chunk_t))) {
+    M_MEMORY_FULL(n);
+    return NULL;
+  }
+  arenai_chunk_t *chunk = (arenai_chunk_t *)
+    M_MEMORY_REALLOC(char, NULL, sizeof (arenai_chunk_t) + n);
+  if (M_UNLIKELY (chunk == NULL)) {
+    M_MEMORY_FULL(sizeof (arenai_chunk_t) + n);
+    return NULL;
+  }
+  chunk->s.next = a->chunk;
+  chunk->s.size = n;
+  a->chunk = chunk;
+  a->ptr = (char *) (chunk + 1) + size;
+  a->end = (char *) (chunk + 1) + n;
+  if (a->chunk_size < ARENA_MAX_CHUNK_SIZE)
+    a->chunk_size *= 2;
+  ARENAI_CONTRACT(a);
+  return chunk + 1;
+}
+
+/* Allocate 'size' bytes suitably aligned for any kind of object */
+static inline void *
+arena_alloc(arena_t a, size_t size)
+{
+  ARENAI_CONTRACT(a);
+  if (M_UNLIKELY (size > SIZE_MAX - 2 * ARENAI_ALIGN)) {
+    M_MEMORY_FULL(size);
+    return NULL;
+  }
+  /* Zero-sized objects still get an unique address */
+  size = ARENAI_ROUND(M_MAX(size, 1));
+  char *p = a->ptr;
+  if (M_UNLIKELY (size > (size_t) (a->end - p)))
+    return arenai_alloc_chunk(a, size);
+  a->ptr = p + size;
+  return p;
+}
+
+/* Reallocate the block 'ptr' (which has to be allocated by arena_realloc
+   or NULL) to 'size' bytes. The block is extended in place if it is
+   the last allocated block of the arena and it fits in the current chunk.
+   Otherwise the block is copied into a new block (the old block
+   is only released with the arena). */
+static inline void *
+arena_realloc(arena_t a, void *ptr, size_t size)
+{
+  ARENAI_CONTRACT(a);
+  if (M_UNLIKELY (size > SIZE_MAX - 3 * ARENAI_ALIGN))
+    return NULL;
+  size_t rounded = ARENAI_ROUND(size);
+  size_t old_size = 0;
+  if (ptr != NULL) {
+    arenai_align_t *h = (arenai_align_t *) ptr - 1;
+    old_size = h->size;
+    char *p = (char *) ptr;
+    if (p + ARENAI_ROUND(old_size) == a->ptr
+        && rounded <= (size_t) (a->end - p)) {
+      /* Last allocated block: grow (or shrink) it in place */
+      h->size = size;
+      a->ptr = p + rounded;
+      ARENAI_CONTRACT(a);
+      return ptr;
+    }
+  }
+  arenai_align_t *h = (arenai_align_t *) arena_alloc(a, ARENAI_ALIGN + rounded);
+  if (M_UNLIKELY (h == NULL))
+    return NULL;
+  h->size = size;
+  if (ptr != NULL)
+    memcpy(h + 1, ptr, M_MIN(old_size, size));
+  return h + 1;
+}
+
+/* Free the block 'ptr' allocated by arena_realloc.
+   The memory is given back only if it is the last allocated block. */
+static inline void
+arena_free(arena_t a, void *ptr)
+{
+  ARENAI_CONTRACT(a);
+  if (ptr == NULL)
+    return;
+  arenai_align_t *h = (arenai_align_t *) ptr - 1;
+  if ((char *) ptr + ARENAI_ROUND(h->size) == a->ptr)
+    a->ptr = (char *) h;
+  ARENAI_CONTRACT(a);
+}
+
+/* Return the number of bytes reserved by the arena from the system */
+static inline size_t
+arena_capacity(const arena_t a)
+{
+  ARENAI_CONTRACT(a);
+  size_t s = 0;
+  for(const arenai_chunk_t *chunk = a->chunk; chunk != NULL; chunk = chunk->s.next)
+    s += chunk->s.size;
+  return s;
+}
+
+/* Set the current arena of the thread used by the oplists
+   created by ARENA_OPLIST.
+   Return the previous current arena (or NULL) so that it can be restored. */
+static inline struct arena_s *
+arena_set_current(arena_t a)
+{
+  struct arena_s *old = arenai_current;
+  arenai_current = a;
+  return old;
+}
+
+static inline struct arena_s *
+arena_get_current(void)
+{
+  assert (arenai_current != NULL);
+  return arenai_current;
+}
+
+/* Extend the given oplist so that the memory methods (NEW, DEL, REALLOC
+   and FREE) allocate in the current arena of the thread.
+   The methods are plain macros so that they remain valid when they
+   are inherited by the oplists of the containers built on top of it. */
+#define ARENA_OPLIST(oplist)                                            \
+  M_OPEXTEND(oplist, NEW(ARENAI_NEW), DEL(ARENAI_DEL),                  \
+             REALLOC(ARENAI_REALLOC), FREE(ARENAI_FREE))
+
+
+/********************************** INTERNAL ************************************/
+
+#define ARENAI_NEW(type)                                                \
+  ((type *) arena_alloc(arena_get_current(), sizeof (type)))
+
+/* Objects allocated by NEW are only released with the arena */
+#define ARENAI_DEL(ptr)  ((void) (ptr))
+
+#define ARENAI_REALLOC(type, ptr, n)                                    \
+  ((type *) (M_UNLIKELY ((n) > SIZE_MAX / sizeof (type)) ? NULL         \
+             : arena_realloc(arena_get_current(), (ptr), (n) * sizeof (type))))
+
+#define ARENAI_FREE(ptr)                                                \
+  arena_free(arena_get_current(), (ptr))
+
+#endif
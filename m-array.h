@@ -107,9 +107,29 @@
    ,M_IF_METHOD(HASH, oplist)(HASH(M_C(name, _hash)),)			\
    ,M_IF_METHOD(NEW, oplist)(NEW(M_GET_NEW oplist),)                    \
    ,M_IF_METHOD(REALLOC, oplist)(REALLOC(M_GET_REALLOC oplist),)        \
+   ,M_IF_METHOD(FREE, oplist)(FREE(M_GET_FREE oplist),)                 \
    ,M_IF_METHOD(DEL, oplist)(DEL(M_GET_DEL oplist),)                    \
    )
 
+/* Parameters of the sort algorithm:
+   - size of a range below which an insertion sort is used,
+   - size of a range above which the pivot is the median of 3 medians,
+   - maximum number of moved objects before a partial insertion sort gives up */
+#define ARRAYI_SORT_INSERTION_THRESHOLD 24
+#define ARRAYI_SORT_NINTHER_THRESHOLD 128
+#define ARRAYI_SORT_PARTIAL_INSERTION_LIMIT 8
+
+/* Parameters of the stable sort algorithm:
+   - minimum length of a run (half of the maximum one),
+   - number of consecutive wins of a range before galloping,
+   - maximum number of pending runs (enough for any size),
+   - test if 'x' is before 'key' (or equal if 'right') */
+#define ARRAYI_STABLE_SORT_MIN_RUN 32
+#define ARRAYI_STABLE_SORT_MIN_GALLOP 7
+#define ARRAYI_STABLE_SORT_MAX_RUNS 128
+#define ARRAYI_STABLE_BEFORE(oplist, x, key, right)                     \
+  ((right) ? M_CALL_CMP(oplist, x, key) <= 0 : M_CALL_CMP(oplist, x, key) < 0)
+
 /* Define the internal contract of an array */
 #define ARRAYI_CONTRACT(a) do {                 \
     assert (a != NULL);                         \
@@ -713,104 +733,505 @@
   									\
   M_IF_METHOD(CMP, oplist)                                              \
   (                                                                     \
-   static inline void M_C(name, _special_sort)(array_t l,		\
-	      int (*func_type) (type const *a, type const *b))	        \
+  /* Pattern-defeating quicksort: an introsort which detects already    \
+     partitioned or sorted ranges and breaks adversarial patterns.      \
+     The objects are moved bitwise like everywhere else in the array.   \
+     The comparison is given as a parameter of all the functions so that \
+     the compiler can specialize them for a constant function. */       \
+  static inline void                                                    \
+  M_C(name, _int_sort_insertion)(type tab[], size_t n,                  \
+                                 int (*func_type) (type const *, type const *)) \
+  {                                                                     \
+    for(size_t i = 1; i < n; i++) {                                     \
+      if (func_type(M_CONST_CAST(type, &tab[i-1]), M_CONST_CAST(type, &tab[i])) <= 0) \
+        continue;                                                       \
+      type x;                                                           \
+      size_t j = i;                                                     \
+      memcpy(&x, &tab[i], sizeof (type));                               \
+      do {                                                              \
+        memcpy(&tab[j], &tab[j-1], sizeof (type));                      \
+        j--;                                                            \
+      } while (j > 0 && func_type(M_CONST_CAST(type, &tab[j-1]), M_CONST_CAST(type, &x)) > 0); \
+      memcpy(&tab[j], &x, sizeof (type));                               \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  /* Insertion sort which gives up if too many objects have to be moved */ \
+  static inline bool                                                    \
+  M_C(name, _int_sort_partial_insertion)(type tab[], size_t n,          \
+                                         int (*func_type) (type const *, type const *)) \
   {                                                                     \
-    /* Using qsort is more compact but slower than a full templated     \
-       version which can be twice faster */                             \
-    int (*func_void)(const void*, const void*);                         \
-    /* There is no way (?) to avoid the cast */                         \
-    func_void = (int (*)(const void*, const void*))func_type;           \
-    qsort (l->ptr, l->size, sizeof(type), func_void);                   \
+    size_t moved = 0;                                                   \
+    for(size_t i = 1; i < n; i++) {                                     \
+      if (moved > ARRAYI_SORT_PARTIAL_INSERTION_LIMIT)                  \
+        return false;                                                   \
+      if (func_type(M_CONST_CAST(type, &tab[i-1]), M_CONST_CAST(type, &tab[i])) <= 0) \
+        continue;                                                       \
+      type x;                                                           \
+      size_t j = i;                                                     \
+      memcpy(&x, &tab[i], sizeof (type));                               \
+      do {                                                              \
+        memcpy(&tab[j], &tab[j-1], sizeof (type));                      \
+        j--;                                                            \
+      } while (j > 0 && func_type(M_CONST_CAST(type, &tab[j-1]), M_CONST_CAST(type, &x)) > 0); \
+      memcpy(&tab[j], &x, sizeof (type));                               \
+      moved += i - j;                                                   \
+    }                                                                   \
+    return true;                                                        \
   }                                                                     \
                                                                         \
-  M_IF_METHOD(SWAP, oplist)(                                            \
   static inline void                                                    \
-  M_C(name, _special_stable_sort_noalloc) (type tab[], size_t size, type tmp[]) \
+  M_C(name, _int_sort_sift_down)(type tab[], size_t root, size_t n,     \
+                                 int (*func_type) (type const *, type const *)) \
+  {                                                                     \
+    type x;                                                             \
+    memcpy(&x, &tab[root], sizeof (type));                              \
+    while (2*root+1 < n) {                                              \
+      size_t child = 2*root+1;                                          \
+      if (child+1 < n && func_type(M_CONST_CAST(type, &tab[child]), M_CONST_CAST(type, &tab[child+1])) < 0) \
+        child++;                                                        \
+      if (func_type(M_CONST_CAST(type, &x), M_CONST_CAST(type, &tab[child])) >= 0) \
+        break;                                                          \
+      memcpy(&tab[root], &tab[child], sizeof (type));                   \
+      root = child;                                                     \
+    }                                                                   \
+    memcpy(&tab[root], &x, sizeof (type));                              \
+  }                                                                     \
+                                                                        \
+  /* Fallback in case of too many bad partitions (O(n log n) guarantee) */ \
+  static inline void                                                    \
+  M_C(name, _int_sort_heap)(type tab[], size_t n,                       \
+                            int (*func_type) (type const *, type const *)) \
   {                                                                     \
-    size_t th = 4;                                                      \
-    M_IF_DEBUG(type *org_tab = tab;)                                    \
-    assert (size > 1);                                                  \
-    /* Let's select the threshold of the pass 1 to be sure              \
-       the final result is in tab.*/                                    \
-    if (m_core_clz64(size-1) & 1)					\
-      th += th;                                                         \
-                                                                        \
-    /* Pass 1: insertion sort (stable) */                               \
-    for(size_t k = 0 ; k < size; ) {                                    \
-      size_t max = size - k < 2*th ? size - k : th;                     \
-      M_ASSUME(max >= th);                                              \
-      for(size_t i = 1; i < max; i++) {                                 \
-        size_t j = i;                                                   \
-        while (j > 0 && M_CALL_CMP(oplist, tab[k+j-1], tab[k+j]) > 0) { \
-          M_CALL_SWAP(oplist, tab[k+j-1], tab[k+j]);                    \
-          j = j - 1;                                                    \
+    for(size_t i = n / 2; i-- > 0; )                                    \
+      M_C(name, _int_sort_sift_down)(tab, i, n, func_type);             \
+    for(size_t i = n; i-- > 1; ) {                                      \
+      M_SWAP_DEFAULT(tab[0], tab[i]);                                   \
+      M_C(name, _int_sort_sift_down)(tab, 0, i, func_type);             \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _int_sort2)(type tab[], size_t a, size_t b,                 \
+                        int (*func_type) (type const *, type const *))  \
+  {                                                                     \
+    if (func_type(M_CONST_CAST(type, &tab[b]), M_CONST_CAST(type, &tab[a])) < 0) \
+      M_SWAP_DEFAULT(tab[a], tab[b]);                                   \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _int_sort3)(type tab[], size_t a, size_t b, size_t c,       \
+                        int (*func_type) (type const *, type const *))  \
+  {                                                                     \
+    M_C(name, _int_sort2)(tab, a, b, func_type);                        \
+    M_C(name, _int_sort2)(tab, b, c, func_type);                        \
+    M_C(name, _int_sort2)(tab, a, b, func_type);                        \
+  }                                                                     \
+                                                                        \
+  /* Partition around the pivot tab[0]: the objects equal to the pivot  \
+     go on the right. Return the final position of the pivot.           \
+     It needs an object not lower than the pivot at the end of the range */ \
+  static inline size_t                                                  \
+  M_C(name, _int_sort_partition_right)(type tab[], size_t n, bool *already_p, \
+                                       int (*func_type) (type const *, type const *)) \
+  {                                                                     \
+    type pivot;                                                         \
+    size_t first = 0;                                                   \
+    size_t last = n;                                                    \
+    memcpy(&pivot, &tab[0], sizeof (type));                             \
+    while (func_type(M_CONST_CAST(type, &tab[++first]), M_CONST_CAST(type, &pivot)) < 0); \
+    if (first == 1) {                                                   \
+      while (first < last && func_type(M_CONST_CAST(type, &tab[--last]), M_CONST_CAST(type, &pivot)) >= 0); \
+    } else {                                                            \
+      while (func_type(M_CONST_CAST(type, &tab[--last]), M_CONST_CAST(type, &pivot)) >= 0); \
+    }                                                                   \
+    /* No swap needed: the range was already partitioned */             \
+    *already_p = first >= last;                                         \
+    while (first < last) {                                              \
+      M_SWAP_DEFAULT(tab[first], tab[last]);                            \
+      while (func_type(M_CONST_CAST(type, &tab[++first]), M_CONST_CAST(type, &pivot)) < 0); \
+      while (func_type(M_CONST_CAST(type, &tab[--last]), M_CONST_CAST(type, &pivot)) >= 0); \
+    }                                                                   \
+    size_t pos = first - 1;                                             \
+    memcpy(&tab[0], &tab[pos], sizeof (type));                          \
+    memcpy(&tab[pos], &pivot, sizeof (type));                           \
+    return pos;                                                         \
+  }                                                                     \
+                                                                        \
+  /* Partition around the pivot tab[0]: the objects equal to the pivot  \
+     go on the left. Used when the pivot is equal to the object before  \
+     the range so that many equal objects are handled in linear time */ \
+  static inline size_t                                                  \
+  M_C(name, _int_sort_partition_left)(type tab[], size_t n,             \
+                                      int (*func_type) (type const *, type const *)) \
+  {                                                                     \
+    type pivot;                                                         \
+    size_t first = 0;                                                   \
+    size_t last = n;                                                    \
+    memcpy(&pivot, &tab[0], sizeof (type));                             \
+    while (func_type(M_CONST_CAST(type, &pivot), M_CONST_CAST(type, &tab[--last])) < 0); \
+    if (last + 1 == n) {                                                \
+      while (first < last && func_type(M_CONST_CAST(type, &pivot), M_CONST_CAST(type, &tab[++first])) >= 0); \
+    } else {                                                            \
+      while (func_type(M_CONST_CAST(type, &pivot), M_CONST_CAST(type, &tab[++first])) >= 0); \
+    }                                                                   \
+    while (first < last) {                                              \
+      M_SWAP_DEFAULT(tab[first], tab[last]);                            \
+      while (func_type(M_CONST_CAST(type, &pivot), M_CONST_CAST(type, &tab[--last])) < 0); \
+      while (func_type(M_CONST_CAST(type, &pivot), M_CONST_CAST(type, &tab[++first])) >= 0); \
+    }                                                                   \
+    memcpy(&tab[0], &tab[last], sizeof (type));                         \
+    memcpy(&tab[last], &pivot, sizeof (type));                          \
+    return last;                                                        \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _int_sort_rec)(type tab[], size_t n, int bad_allowed, bool leftmost, \
+                           int (*func_type) (type const *, type const *)) \
+  {                                                                     \
+    while (true) {                                                      \
+      if (n <= ARRAYI_SORT_INSERTION_THRESHOLD) {                       \
+        M_C(name, _int_sort_insertion)(tab, n, func_type);              \
+        return;                                                         \
+      }                                                                 \
+      /* Select the pivot and move it in tab[0] */                      \
+      size_t h = n / 2;                                                 \
+      if (n > ARRAYI_SORT_NINTHER_THRESHOLD) {                          \
+        M_C(name, _int_sort3)(tab, 0, h, n-1, func_type);               \
+        M_C(name, _int_sort3)(tab, 1, h-1, n-2, func_type);             \
+        M_C(name, _int_sort3)(tab, 2, h+1, n-3, func_type);             \
+        M_C(name, _int_sort3)(tab, h-1, h, h+1, func_type);             \
+        M_SWAP_DEFAULT(tab[0], tab[h]);                                 \
+      } else {                                                          \
+        M_C(name, _int_sort3)(tab, h, 0, n-1, func_type);               \
+      }                                                                 \
+      /* If the object before the range (the pivot of a previous        \
+         partition) is equal to the pivot, all the objects equal to     \
+         the pivot can be skipped */                                    \
+      if (!leftmost && func_type(M_CONST_CAST(type, &tab[-1]), M_CONST_CAST(type, &tab[0])) >= 0) { \
+        size_t pos = M_C(name, _int_sort_partition_left)(tab, n, func_type); \
+        tab += pos + 1;                                                 \
+        n -= pos + 1;                                                   \
+        continue;                                                       \
+      }                                                                 \
+      bool already;                                                     \
+      size_t pos = M_C(name, _int_sort_partition_right)(tab, n, &already, func_type); \
+      size_t ls = pos;                                                  \
+      size_t rs = n - pos - 1;                                          \
+      if (ls < n / 8 || rs < n / 8) {                                   \
+        /* Bad partition: shuffle some objects to break the pattern */  \
+        if (--bad_allowed == 0) {                                       \
+          M_C(name, _int_sort_heap)(tab, n, func_type);                 \
+          return;                                                       \
+        }                                                               \
+        if (ls >= ARRAYI_SORT_INSERTION_THRESHOLD) {                    \
+          M_SWAP_DEFAULT(tab[0], tab[ls/4]);                            \
+          M_SWAP_DEFAULT(tab[pos-1], tab[pos-ls/4]);                    \
+        }                                                               \
+        if (rs >= ARRAYI_SORT_INSERTION_THRESHOLD) {                    \
+          M_SWAP_DEFAULT(tab[pos+1], tab[pos+1+rs/4]);                  \
+          M_SWAP_DEFAULT(tab[n-1], tab[n-rs/4]);                        \
         }                                                               \
+      } else if (already                                                \
+                 && M_C(name, _int_sort_partial_insertion)(tab, ls, func_type) \
+                 && M_C(name, _int_sort_partial_insertion)(tab+pos+1, rs, func_type)) { \
+        return;                                                         \
+      }                                                                 \
+      /* Recurse on the smallest range, loop on the biggest */          \
+      if (ls < rs) {                                                    \
+        M_C(name, _int_sort_rec)(tab, ls, bad_allowed, leftmost, func_type); \
+        tab += pos + 1;                                                 \
+        n = rs;                                                         \
+        leftmost = false;                                               \
+      } else {                                                          \
+        M_C(name, _int_sort_rec)(tab+pos+1, rs, bad_allowed, false, func_type); \
+        n = ls;                                                         \
       }                                                                 \
-      k += max;                                                         \
-    }                                                                   \
-                                                                        \
-    /* N Pass of merge */                                               \
-    while (th < size) {                                                 \
-      type *dest = tmp;                                                 \
-      /* Pass n: Merge */                                               \
-      for(size_t k = 0 ; k < size; ) {                                  \
-        type *el1 = &tab[k];                                            \
-        type *el2 = &tab[k+th];                                         \
-        size_t n1 = th;                                                 \
-        size_t n2 = size-k <= 3*th ? size-k-th : th;                    \
-        assert (size-k > th);                                           \
-        assert (0 < n1 && n1 <= size);                                  \
-        assert (0 < n2 && n2 <= size);                                  \
-        k += n1+n2;                                                     \
-        for (;;) {                                                      \
-          if (M_CALL_CMP(oplist, *el1, *el2) <= 0) {                    \
-            M_CALL_SET(oplist, *dest, *el1);                            \
-            dest++;                                                     \
-            el1++;                                                      \
-            if (-- n1 == 0) {                                           \
-              if (n2 > 0) {                                             \
-                memcpy (dest, el2, n2 * sizeof (type));                 \
-                dest += n2;                                             \
-              }                                                         \
-              break;                                                    \
-            }                                                           \
-          } else {                                                      \
-            M_CALL_SET(oplist, *dest, *el2);                            \
-            dest++;                                                     \
-            el2++;                                                      \
-            if (-- n2 == 0) {                                           \
-              if (n1 > 0) {                                             \
-                memcpy (dest, el1, n1 * sizeof (type));                 \
-                dest += n1;                                             \
-              }                                                         \
-              break;                                                    \
-            }                                                           \
-          }                                                             \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+   static inline void M_C(name, _special_sort)(array_t l,               \
+	      int (*func_type) (type const *a, type const *b))                 \
+  {                                                                     \
+    ARRAYI_CONTRACT(l);                                                 \
+    if (M_UNLIKELY (l->size < 2))                                       \
+      return;                                                           \
+    /* Number of bad partitions allowed before switching to heap sort */ \
+    int bad_allowed = 64 - m_core_clz64(l->size);                       \
+    M_C(name, _int_sort_rec)(l->ptr, l->size, bad_allowed, true, func_type); \
+  }                                                                     \
+                                                                        \
+  /* Adaptive stable merge sort (like timsort): it detects the natural  \
+     runs, extends the short ones with a binary insertion sort, and     \
+     merges them with galloping so that a nearly sorted input is sorted \
+     in nearly linear time. The objects are moved bitwise. */           \
+                                                                        \
+  /* Return the number of objects of a[0..n[ which are lower than 'key' \
+     (or lower or equal if 'right'), with an exponential search starting \
+     from the beginning (or from the end if 'from_end') of the range */ \
+  static inline size_t                                                  \
+  M_C(name, _int_stable_gallop)(type const *key, type a[], size_t n,    \
+                                bool right, bool from_end)              \
+  {                                                                     \
+    size_t lo;                                                          \
+    size_t hi;                                                          \
+    size_t last = 0;                                                    \
+    size_t ofs = 1;                                                     \
+    if (n == 0)                                                         \
+      return 0;                                                         \
+    if (!from_end) {                                                    \
+      if (!ARRAYI_STABLE_BEFORE(oplist, a[0], *key, right))             \
+        return 0;                                                       \
+      while (ofs < n && ARRAYI_STABLE_BEFORE(oplist, a[ofs], *key, right)) { \
+        last = ofs;                                                     \
+        ofs = 2 * ofs + 1;                                              \
+      }                                                                 \
+      lo = last + 1;                                                    \
+      hi = ofs < n ? ofs : n;                                           \
+    } else {                                                            \
+      if (ARRAYI_STABLE_BEFORE(oplist, a[n-1], *key, right))            \
+        return n;                                                       \
+      while (ofs < n && !ARRAYI_STABLE_BEFORE(oplist, a[n-1-ofs], *key, right)) { \
+        last = ofs;                                                     \
+        ofs = 2 * ofs + 1;                                              \
+      }                                                                 \
+      lo = ofs < n ? n - ofs : 0;                                       \
+      hi = n - 1 - last;                                                \
+    }                                                                   \
+    while (lo < hi) {                                                   \
+      size_t mid = lo + (hi - lo) / 2;                                  \
+      if (ARRAYI_STABLE_BEFORE(oplist, a[mid], *key, right))            \
+        lo = mid + 1;                                                   \
+      else                                                              \
+        hi = mid;                                                       \
+    }                                                                   \
+    return lo;                                                          \
+  }                                                                     \
+                                                                        \
+  /* Sort tab[0..n[ knowing that tab[0..sorted[ is already sorted */    \
+  static inline void                                                    \
+  M_C(name, _int_stable_insertion)(type tab[], size_t n, size_t sorted) \
+  {                                                                     \
+    for(size_t i = sorted; i < n; i++) {                                \
+      size_t pos = M_C(name, _int_stable_gallop)(M_CONST_CAST(type, &tab[i]), tab, i, true, true); \
+      if (pos == i)                                                     \
+        continue;                                                       \
+      type x;                                                           \
+      memcpy(&x, &tab[i], sizeof (type));                               \
+      memmove(&tab[pos+1], &tab[pos], (i - pos) * sizeof (type));       \
+      memcpy(&tab[pos], &x, sizeof (type));                             \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  /* Return the length of the run starting at tab[0].                   \
+     A strictly descending run is reversed (keeping the stability). */  \
+  static inline size_t                                                  \
+  M_C(name, _int_stable_run)(type tab[], size_t n)                      \
+  {                                                                     \
+    size_t hi = 1;                                                      \
+    if (n == 1)                                                         \
+      return 1;                                                         \
+    if (M_CALL_CMP(oplist, tab[1], tab[0]) < 0) {                       \
+      while (hi + 1 < n && M_CALL_CMP(oplist, tab[hi+1], tab[hi]) < 0)  \
+        hi++;                                                           \
+      size_t i = 0;                                                     \
+      size_t j = hi;                                                    \
+      while (i < j) {                                                   \
+        M_SWAP_DEFAULT(tab[i], tab[j]);                                 \
+        i++;                                                            \
+        j--;                                                            \
+      }                                                                 \
+    } else {                                                            \
+      while (hi + 1 < n && M_CALL_CMP(oplist, tab[hi+1], tab[hi]) >= 0) \
+        hi++;                                                           \
+    }                                                                   \
+    return hi + 1;                                                      \
+  }                                                                     \
+                                                                        \
+  /* Merge a[0..na[ & a[na..na+nb[ with na <= nb, using tmp[0..na[ */   \
+  static inline void                                                    \
+  M_C(name, _int_stable_merge_lo)(type a[], size_t na, size_t nb, type tmp[]) \
+  {                                                                     \
+    type *pa = tmp;                                                     \
+    type *pb = a + na;                                                  \
+    type *dest = a;                                                     \
+    memcpy(tmp, a, na * sizeof (type));                                 \
+    while (na > 0 && nb > 0) {                                          \
+      size_t ca = 0;                                                    \
+      size_t cb = 0;                                                    \
+      /* One object at a time until a range wins too often */           \
+      do {                                                              \
+        if (M_CALL_CMP(oplist, *pb, *pa) < 0) {                         \
+          memcpy(dest++, pb++, sizeof (type));                          \
+          nb--;                                                         \
+          cb++;                                                         \
+          ca = 0;                                                       \
+        } else {                                                        \
+          memcpy(dest++, pa++, sizeof (type));                          \
+          na--;                                                         \
+          ca++;                                                         \
+          cb = 0;                                                       \
+        }                                                               \
+      } while (na > 0 && nb > 0                                         \
+               && ca < ARRAYI_STABLE_SORT_MIN_GALLOP                    \
+               && cb < ARRAYI_STABLE_SORT_MIN_GALLOP);                  \
+      /* Galloping: move blocks of objects while it is worth it */      \
+      while (na > 0 && nb > 0) {                                        \
+        size_t ka = M_C(name, _int_stable_gallop)(M_CONST_CAST(type, pb), pa, na, true, false); \
+        memcpy(dest, pa, ka * sizeof (type));                           \
+        dest += ka;                                                     \
+        pa += ka;                                                       \
+        na -= ka;                                                       \
+        if (na == 0)                                                    \
+          break;                                                        \
+        size_t kb = M_C(name, _int_stable_gallop)(M_CONST_CAST(type, pa), pb, nb, false, false); \
+        memmove(dest, pb, kb * sizeof (type));                          \
+        dest += kb;                                                     \
+        pb += kb;                                                       \
+        nb -= kb;                                                       \
+        if (ka < ARRAYI_STABLE_SORT_MIN_GALLOP                          \
+            && kb < ARRAYI_STABLE_SORT_MIN_GALLOP)                      \
+          break;                                                        \
+      }                                                                 \
+    }                                                                   \
+    /* The remaining objects of b are already in place */               \
+    memcpy(dest, pa, na * sizeof (type));                               \
+  }                                                                     \
+                                                                        \
+  /* Merge a[0..na[ & a[na..na+nb[ with na > nb, using tmp[0..nb[,      \
+     from the end of the ranges */                                      \
+  static inline void                                                    \
+  M_C(name, _int_stable_merge_hi)(type a[], size_t na, size_t nb, type tmp[]) \
+  {                                                                     \
+    size_t dest = na + nb;                                              \
+    memcpy(tmp, a + na, nb * sizeof (type));                            \
+    while (na > 0 && nb > 0) {                                          \
+      size_t ca = 0;                                                    \
+      size_t cb = 0;                                                    \
+      do {                                                              \
+        if (M_CALL_CMP(oplist, tmp[nb-1], a[na-1]) < 0) {               \
+          memcpy(&a[--dest], &a[--na], sizeof (type));                  \
+          ca++;                                                         \
+          cb = 0;                                                       \
+        } else {                                                        \
+          memcpy(&a[--dest], &tmp[--nb], sizeof (type));                \
+          cb++;                                                         \
+          ca = 0;                                                       \
         }                                                               \
+      } while (na > 0 && nb > 0                                         \
+               && ca < ARRAYI_STABLE_SORT_MIN_GALLOP                    \
+               && cb < ARRAYI_STABLE_SORT_MIN_GALLOP);                  \
+      while (na > 0 && nb > 0) {                                        \
+        size_t ka = na - M_C(name, _int_stable_gallop)(M_CONST_CAST(type, &tmp[nb-1]), a, na, true, true); \
+        dest -= ka;                                                     \
+        na -= ka;                                                       \
+        memmove(&a[dest], &a[na], ka * sizeof (type));                  \
+        if (na == 0)                                                    \
+          break;                                                        \
+        size_t kb = nb - M_C(name, _int_stable_gallop)(M_CONST_CAST(type, &a[na-1]), tmp, nb, false, true); \
+        dest -= kb;                                                     \
+        nb -= kb;                                                       \
+        memcpy(&a[dest], &tmp[nb], kb * sizeof (type));                 \
+        if (ka < ARRAYI_STABLE_SORT_MIN_GALLOP                          \
+            && kb < ARRAYI_STABLE_SORT_MIN_GALLOP)                      \
+          break;                                                        \
+      }                                                                 \
+    }                                                                   \
+    /* The remaining objects of a are already in place */               \
+    memcpy(a, tmp, nb * sizeof (type));                                 \
+  }                                                                     \
+                                                                        \
+  /* Merge the adjacent runs a[0..na[ & a[na..na+nb[ */                 \
+  static inline void                                                    \
+  M_C(name, _int_stable_merge)(type a[], size_t na, size_t nb, type tmp[]) \
+  {                                                                     \
+    /* Skip the objects of a and b which are already in place */        \
+    size_t k = M_C(name, _int_stable_gallop)(M_CONST_CAST(type, &a[na]), a, na, true, false); \
+    a += k;                                                             \
+    na -= k;                                                            \
+    if (na == 0)                                                        \
+      return;                                                           \
+    nb = M_C(name, _int_stable_gallop)(M_CONST_CAST(type, &a[na-1]), a + na, nb, false, true); \
+    if (nb == 0)                                                        \
+      return;                                                           \
+    if (na <= nb)                                                       \
+      M_C(name, _int_stable_merge_lo)(a, na, nb, tmp);                  \
+    else                                                                \
+      M_C(name, _int_stable_merge_hi)(a, na, nb, tmp);                  \
+  }                                                                     \
+                                                                        \
+  /* Sort tab[0..size[ using tmp as a buffer of at least size/2 objects. \
+     The buffer can be reused across calls by the caller. */            \
+  static inline void                                                    \
+  M_C(name, _special_stable_sort_noalloc) (type tab[], size_t size, type tmp[]) \
+  {                                                                     \
+    size_t base[ARRAYI_STABLE_SORT_MAX_RUNS];                           \
+    size_t len[ARRAYI_STABLE_SORT_MAX_RUNS];                            \
+    size_t nruns = 0;                                                   \
+    /* Compute the minimum length of a run so that the number of runs   \
+       is equal to or slightly less than a power of 2 */                \
+    size_t minrun = size;                                               \
+    bool r = false;                                                     \
+    while (minrun >= 2*ARRAYI_STABLE_SORT_MIN_RUN) {                    \
+      r |= (minrun & 1) != 0;                                           \
+      minrun >>= 1;                                                     \
+    }                                                                   \
+    minrun += r;                                                        \
+                                                                        \
+    for(size_t lo = 0; lo < size; ) {                                   \
+      size_t n = M_C(name, _int_stable_run)(&tab[lo], size - lo);       \
+      if (n < minrun) {                                                 \
+        size_t force = size - lo < minrun ? size - lo : minrun;         \
+        M_C(name, _int_stable_insertion)(&tab[lo], force, n);           \
+        n = force;                                                      \
+      }                                                                 \
+      assert (nruns < ARRAYI_STABLE_SORT_MAX_RUNS);                     \
+      base[nruns] = lo;                                                 \
+      len[nruns] = n;                                                   \
+      nruns++;                                                          \
+      lo += n;                                                          \
+      /* Merge the runs until the invariants of the stack are restored: \
+         len[i-2] > len[i-1] + len[i] and len[i-1] > len[i]             \
+         (or until the end when all the runs are found) */              \
+      while (nruns > 1) {                                               \
+        size_t i = nruns - 2;                                           \
+        if (lo == size) {                                               \
+          if (i > 0 && len[i-1] < len[i+1])                             \
+            i--;                                                        \
+        } else if ((i > 0 && len[i-1] <= len[i] + len[i+1])             \
+                   || (i > 1 && len[i-2] <= len[i-1] + len[i])) {       \
+          if (len[i-1] < len[i+1])                                      \
+            i--;                                                        \
+        } else if (len[i] > len[i+1]) {                                 \
+          break;                                                        \
+        }                                                               \
+        M_C(name, _int_stable_merge)(&tab[base[i]], len[i], len[i+1], tmp); \
+        len[i] += len[i+1];                                             \
+        if (i + 2 < nruns) {                                            \
+          base[i+1] = base[i+2];                                        \
+          len[i+1] = len[i+2];                                          \
+        }                                                               \
+        nruns--;                                                        \
       }                                                                 \
-      /* Swap t & tab */                                                \
-      M_SWAP(type *, tab, tmp);                                         \
-      /* Increase th for next pass */                                   \
-      th += th;                                                         \
     }                                                                   \
-    assert (org_tab == tab);                                            \
   }                                                                     \
                                                                         \
   static inline void                                                    \
   M_C(name, _special_stable_sort)(array_t l)                            \
   {                                                                     \
+    ARRAYI_CONTRACT(l);                                                 \
     if (M_UNLIKELY (l->size < 2))                                       \
       return;                                                           \
-    type *temp = M_CALL_REALLOC(oplist, type, NULL, l->size);           \
+    /* The merges need at most half of the array */                     \
+    size_t n = l->size / 2;                                             \
+    type *temp = M_CALL_REALLOC(oplist, type, NULL, n);                 \
     if (temp == NULL) {                                                 \
-      M_MEMORY_FULL(sizeof (type) * l->size);                           \
+      M_MEMORY_FULL(sizeof (type) * n);                                 \
       return ;                                                          \
     }                                                                   \
     M_C(name, _special_stable_sort_noalloc)(l->ptr, l->size, temp);     \
     M_CALL_FREE(oplist, temp);                                          \
   }                                                                     \
-  ,) /* IF SWAP method */                                               \
                                                                         \
   ,) /* IF CMP oplist */                                                \
   									\
@@ -837,6 +1258,30 @@
   }                                                                     \
   , /* no GET_STR */ )                                                  \
 			      						\
+  M_IF_STDIO(                                                           \
+  static inline bool                                                    \
+  M_C(name, _out_mmap)(FILE *file, const array_t array)                 \
+  {                                                                     \
+    ARRAYI_CONTRACT(array);                                             \
+    return m_core_mmap_write(file, M_CORE_MMAP_ARRAY, sizeof (type),    \
+                             array->size, array->size, 0, array->ptr);  \
+  }                                                                     \
+  )                                                                     \
+                                                                        \
+  static inline bool                                                    \
+  M_C(name, _init_mmap)(array_t array, void *mem, size_t size)          \
+  {                                                                     \
+    size_t count, capacity;                                             \
+    void *table = m_core_mmap_table(mem, size, M_CORE_MMAP_ARRAY,       \
+                                    sizeof (type), 0, &count, &capacity); \
+    if (table == NULL)                                                  \
+      return false;                                                     \
+    array->size = array->alloc = count;                                 \
+    array->ptr = count == 0 ? NULL : (type *) table;                    \
+    ARRAYI_CONTRACT(array);                                             \
+    return true;                                                        \
+  }                                                                     \
+                                                                        \
   M_IF_METHOD(OUT_STR, oplist)(                                         \
   static inline void                                                    \
   M_C(name, _out_str)(FILE *file, const array_t array)			\
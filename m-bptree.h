@@ -123,6 +123,7 @@
    M_IF_METHOD_BOTH(HASH, key_oplist, value_oplist)(HASH(M_C(name, _hash)),) \
    ,M_IF_METHOD(NEW, key_oplist)(NEW(M_GET_NEW oplist),)                \
    ,M_IF_METHOD(REALLOC, key_oplist)(REALLOC(M_GET_REALLOC oplist),)    \
+   ,M_IF_METHOD(FREE, key_oplist)(FREE(M_GET_FREE oplist),)             \
    ,M_IF_METHOD(DEL, key_oplist)(DEL(M_GET_DEL oplist),)                \
    )
   
@@ -168,6 +169,7 @@
    M_IF_METHOD(HASH, oplist)(HASH(M_C(name, _hash)),)			\
    ,M_IF_METHOD(NEW, oplist)(NEW(M_GET_NEW oplist),)                    \
    ,M_IF_METHOD(REALLOC, oplist)(REALLOC(M_GET_REALLOC oplist),)        \
+   ,M_IF_METHOD(FREE, oplist)(FREE(M_GET_FREE oplist),)                 \
    ,M_IF_METHOD(DEL, oplist)(DEL(M_GET_DEL oplist),)                    \
    )
 
@@ -275,10 +277,29 @@
     int    idx;                                                         \
   } it_t[1];                                                            \
                                                                         \
+  /* Allocation of the nodes. If MEMPOOL, we need to define it */      \
+  M_IF_METHOD(MEMPOOL, key_oplist)(                                     \
+    M_MEMPOOL_DEF_SELECT(key_oplist)(M_C(name, _mempool), struct M_C(name, _node_s)) \
+    M_GET_MEMPOOL_LINKAGE key_oplist M_C(name, _mempool_t) M_GET_MEMPOOL key_oplist; \
+    static inline node_t M_C(name, _int_new)(void) {                    \
+      return M_C(name, _mempool_alloc)(M_GET_MEMPOOL key_oplist);       \
+    }                                                                   \
+    static inline void M_C(name, _int_del)(node_t ptr) {                \
+      M_C(name, _mempool_free)(M_GET_MEMPOOL key_oplist, ptr);          \
+    }                                                                   \
+    ,                                                                   \
+    static inline node_t M_C(name, _int_new)(void) {                    \
+      return M_CALL_NEW(key_oplist, struct M_C(name, _node_s));         \
+    }                                                                   \
+    static inline void M_C(name, _int_del)(node_t ptr) {                \
+      M_CALL_DEL(key_oplist, ptr);                                      \
+    }                                                                   \
+                                                                      ) \
+                                                                        \
   /* TODO: Can be optimized to alloc for leaf or for node */            \
   static inline node_t M_C(name, _new_node)(void)                       \
   {                                                                     \
-    node_t n = M_CALL_NEW(key_oplist, struct M_C(name, _node_s));       \
+    node_t n = M_C(name, _int_new)();                                   \
     if (M_UNLIKELY (n == NULL)) {                                       \
       M_MEMORY_FULL(sizeof (node_t));                                   \
       assert (0);                                                       \
@@ -339,7 +360,7 @@
         /* Next node of the same height */                              \
         next = n->next;                                                 \
         if (i != 0) {                                                   \
-          M_CALL_DEL(key_oplist, n);                                    \
+          M_C(name, _int_del)(n);                                       \
         }                                                               \
         n = next;                                                       \
       }                                                                 \
@@ -355,7 +376,7 @@
     BPTREEI_CONTRACT(N, isMulti, key_oplist, b);                        \
     M_C(name, _clean)(b);                                               \
     /* Once the tree is clean, only the root remains */                 \
-    M_CALL_DEL(key_oplist, b->root);                                    \
+    M_C(name, _int_del)(b->root);                                       \
     b->root = NULL;                                                     \
   }                                                                     \
                                                                         \
@@ -722,7 +743,7 @@
       left->num = num_left + 1 + num_right;                             \
     }                                                                   \
     left->next = right->next;                                           \
-    M_CALL_DEL(key_oplist, right);                                      \
+    M_C(name, _int_del)(right);                                         \
     /* remove k'th key from the parent */                               \
     M_CALL_CLEAR(key_oplist, parent->key[k]);                           \
     memmove(&parent->key[k], &parent->key[k+1], sizeof(key_t)*(num_parent - k - 1)); \
@@ -791,7 +812,7 @@
         if (M_C(name, _get_num)(parent) == 0) {                         \
           /* Update root (deleted) */                                   \
           b->root = parent->kind.node[0];                               \
-          M_CALL_DEL(key_oplist, parent);                               \
+          M_C(name, _int_del)(parent);                                  \
         }                                                               \
         return true;                                                    \
       }                                                                 \
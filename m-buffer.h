@@ -38,6 +38,8 @@
  * - if the buffer has to be init with empty elements, or if it shall init an element when it is pushed (and moved when popped),
  * - if the buffer has to overwrite the last element if the buffer is full,
  * - if the pop of an element is not complete until the call to pop_release (preventing push until this call).
+ * - if the blocking calls shall wait by spinning then parking the thread on a futex instead of using a condition variable
+ *   (only if M_USE_FUTEX is defined to 1: otherwise the policy is ignored and the condition variables are used).
  */
 typedef enum {
   BUFFER_QUEUE = 0,    BUFFER_STACK = 1,
@@ -47,9 +49,16 @@ typedef enum {
   BUFFER_THREAD_SAFE = 0, BUFFER_THREAD_UNSAFE = 8,
   BUFFER_PUSH_INIT_POP_MOVE = 16,
   BUFFER_PUSH_OVERWRITE = 32,
-  BUFFER_DEFERRED_POP = 64
+  BUFFER_DEFERRED_POP = 64,
+  BUFFER_FUTEX_WAIT = 128
 } buffer_policy_e;
 
+/* Number of active waits performed by a blocking call of a buffer
+   with BUFFER_FUTEX_WAIT policy before parking the thread */
+#ifndef M_BUFFER_SPIN_COUNT
+#define M_BUFFER_SPIN_COUNT 16
+#endif
+
 /* Define a lock based buffer.
    USAGE: BUFFER_DEF(name, type, size_of_buffer_or_0, policy[, oplist]) */
 #define BUFFER_DEF(name, type, m_size, ... )                            \
@@ -90,9 +99,23 @@ typedef enum {
 #define BUFFERI_IF_CTE_SIZE(m_size)  M_IF(M_BOOL(m_size))
 #define BUFFERI_SIZE(m_size)         BUFFERI_IF_CTE_SIZE(m_size) (m_size, v->size)
 
+/* Parking place of the threads of a buffer with the BUFFER_FUTEX_WAIT
+   policy: the futex key (incremented on each push / pop) and the number
+   of threads parked on it. It shares the place of the condition variable,
+   which is not used by this policy. */
+typedef struct bufferi_futex_s {
+  atomic_uint seq;
+  atomic_uint waiting;
+} bufferi_futex_t;
+
 #define BUFFERI_POLICY_P(policy, val)                                   \
   (((policy) & (val)) != 0)
 
+/* The BUFFER_FUTEX_WAIT policy is only honored if the futex are enabled
+   (see M_USE_FUTEX): otherwise, the condition variables are used */
+#define BUFFERI_FUTEX_P(policy)                                         \
+  (M_USE_FUTEX && BUFFERI_POLICY_P((policy), BUFFER_FUTEX_WAIT))
+
 #define BUFFERI_CONTRACT(buffer, size)	do {		\
     assert (buffer != NULL);				\
     assert (buffer->data != NULL);			\
@@ -112,8 +135,10 @@ typedef enum {
     m_mutex_t mutexPush;    /* MUTEX used for pushing elements */       \
     size_t    idx_prod;     /* Index of the production threads  */      \
     size_t    overwrite;    /* Number of overwritten values */          \
-    m_cond_t there_is_data; /* condition raised when there is data */   \
-    m_cond_t there_is_room_for_data; /* Cond. raised when there is room */ \
+    /* condition raised when there is data (or its futex) */            \
+    union { m_cond_t cond; bufferi_futex_t futex; } there_is_data;      \
+    /* Cond. raised when there is room (or its futex) */                \
+    union { m_cond_t cond; bufferi_futex_t futex; } there_is_room_for_data; \
     m_mutex_t mutexPop;     /* MUTEX used for popping elements */       \
     size_t    idx_cons;     /* Index of the consumption threads */      \
     BUFFERI_IF_CTE_SIZE(m_size)( ,size_t size;) /* Size of the buffer */ \
@@ -140,8 +165,15 @@ M_C(name, _init)(buffer_t v, size_t size)                               \
   if (!BUFFERI_POLICY_P((policy), BUFFER_THREAD_UNSAFE)) {              \
     m_mutex_init(v->mutexPush);                                         \
     m_mutex_init(v->mutexPop);                                          \
-    m_cond_init(v->there_is_data);                                      \
-    m_cond_init(v->there_is_room_for_data);                             \
+    if (BUFFERI_FUTEX_P(policy)) {                                      \
+      atomic_init (&v->there_is_data.futex.seq, 0U);                    \
+      atomic_init (&v->there_is_data.futex.waiting, 0U);                \
+      atomic_init (&v->there_is_room_for_data.futex.seq, 0U);           \
+      atomic_init (&v->there_is_room_for_data.futex.waiting, 0U);       \
+    } else {                                                            \
+      m_cond_init(v->there_is_data.cond);                               \
+      m_cond_init(v->there_is_room_for_data.cond);                      \
+    }                                                                   \
   } else                                                                \
     assert(BUFFERI_POLICY_P((policy), BUFFER_UNBLOCKING));              \
   BUFFERI_IF_CTE_SIZE(m_size)( ,                                        \
@@ -191,6 +223,19 @@ M_C(name, _init)(buffer_t v, size_t size)                               \
    BUFFERI_CONTRACT(v,m_size);						\
  }                                                                      \
  									\
+ /* Update the futex key and wake up at most n threads parked on it.    \
+    The key is updated before reading the number of parked threads:     \
+    a thread which registers itself after this read has read the key    \
+    before, so that it cannot sleep on the old key. */                  \
+ static inline void                                                     \
+ M_C(name, _int_wake)(bufferi_futex_t *f, int n)                        \
+ {                                                                      \
+   atomic_fetch_add(&f->seq, 1U);                                       \
+   /* Avoid the system call if no thread is parked */                   \
+   if (atomic_load(&f->waiting) != 0)                                   \
+     m_futexi_wake(&f->seq, n);                                         \
+ }                                                                      \
+ 									\
  static inline void                                                     \
  M_C(name, _clear)(buffer_t v)						\
  {                                                                      \
@@ -204,8 +249,10 @@ M_C(name, _init)(buffer_t v, size_t size)                               \
    if (!BUFFERI_POLICY_P((policy), BUFFER_THREAD_UNSAFE)) {             \
      m_mutex_clear(v->mutexPush);                                       \
      m_mutex_clear(v->mutexPop);                                        \
-     m_cond_clear(v->there_is_data);                                    \
-     m_cond_clear(v->there_is_room_for_data);                           \
+     if (!BUFFERI_FUTEX_P(policy)) {                                    \
+       m_cond_clear(v->there_is_data.cond);                             \
+       m_cond_clear(v->there_is_room_for_data.cond);                    \
+     }                                                                  \
    }                                                                    \
  }                                                                      \
  									\
@@ -225,7 +272,10 @@ M_C(name, _init)(buffer_t v, size_t size)                               \
    if (BUFFERI_POLICY_P(policy, BUFFER_DEFERRED_POP))                   \
      atomic_store_explicit(&v->number[1], 0UL, memory_order_relaxed);	\
    if (!BUFFERI_POLICY_P((policy), BUFFER_THREAD_UNSAFE)) {             \
-     m_cond_broadcast(v->there_is_room_for_data);                       \
+     if (BUFFERI_FUTEX_P(policy))                                       \
+       M_C(name, _int_wake)(&v->there_is_room_for_data.futex, INT_MAX); \
+     else                                                               \
+       m_cond_broadcast(v->there_is_room_for_data.cond);                \
      m_mutex_unlock(v->mutexPop);                                       \
      m_mutex_unlock(v->mutexPush);                                      \
    }                                                                    \
@@ -328,8 +378,13 @@ M_C(name, _init)(buffer_t v, size_t size)                               \
                                                                         \
    if (!BUFFERI_POLICY_P((policy), BUFFER_THREAD_UNSAFE)) {             \
      /* It may be false, but it is not wrong! */                        \
-     m_cond_broadcast(v->there_is_room_for_data);                       \
-     m_cond_broadcast(v->there_is_data);                                \
+     if (BUFFERI_FUTEX_P(policy)) {                                     \
+       M_C(name, _int_wake)(&dest->there_is_room_for_data.futex, INT_MAX); \
+       M_C(name, _int_wake)(&dest->there_is_data.futex, INT_MAX);       \
+     } else {                                                           \
+       m_cond_broadcast(v->there_is_room_for_data.cond);                \
+       m_cond_broadcast(v->there_is_data.cond);                         \
+     }                                                                  \
      if (dest < v) {                                                    \
        m_mutex_unlock(v->mutexPop);                                     \
        m_mutex_unlock(v->mutexPush);                                    \
@@ -375,6 +430,37 @@ M_C(name, _init)(buffer_t v, size_t size)                               \
    return atomic_load_explicit (&v->number[0], memory_order_relaxed);	\
  }                                                                      \
  									\
+ /* Wait for some data (or some room) to be available in the buffer:    \
+    spin a few times, then park the thread on the futex key.            \
+    The key is read before checking the condition, so that a push       \
+    (or a pop) performed in between makes the parking fail. */          \
+ static inline void                                                     \
+ M_C(name, _int_wait)(buffer_t v, bool for_data)                        \
+ {                                                                      \
+   bufferi_futex_t *f = for_data ? &v->there_is_data.futex              \
+     : &v->there_is_room_for_data.futex;                                \
+   const unsigned int key = atomic_load(&f->seq);                       \
+   m_backoff_t bkoff;                                                   \
+   m_backoff_init(bkoff);                                               \
+   /* Active wait */                                                    \
+   unsigned int i = 0;                                                  \
+   while (i < M_BUFFER_SPIN_COUNT                                       \
+          && (for_data ? M_C(name, _empty_p)(v) : M_C(name, _full_p)(v))) { \
+     m_backoff_wait(bkoff);                                             \
+     i++;                                                               \
+   }                                                                    \
+   /* Passive wait */                                                   \
+   if (i == M_BUFFER_SPIN_COUNT) {                                      \
+     /* Register before checking the condition again: either the        \
+        waker sees this thread, or this thread sees its update */       \
+     atomic_fetch_add(&f->waiting, 1U);                                 \
+     if (for_data ? M_C(name, _empty_p)(v) : M_C(name, _full_p)(v))     \
+       m_futexi_wait(&f->seq, key);                                     \
+     atomic_fetch_sub(&f->waiting, 1U);                                 \
+   }                                                                    \
+   m_backoff_clear(bkoff);                                              \
+ }                                                                      \
+                                                                        \
  static inline bool                                                     \
  M_C(name, _push_blocking)(buffer_t v, type const data, bool blocking)  \
  {                                                                      \
@@ -389,7 +475,12 @@ M_C(name, _init)(buffer_t v, size_t size)                               \
          m_mutex_unlock(v->mutexPush);                                  \
          return false;                                                  \
        }                                                                \
-       m_cond_wait(v->there_is_room_for_data, v->mutexPush);            \
+       if (BUFFERI_FUTEX_P(policy)) {                                   \
+         m_mutex_unlock(v->mutexPush);                                  \
+         M_C(name, _int_wait)(v, false);                                \
+         m_mutex_lock(v->mutexPush);                                    \
+       } else                                                           \
+         m_cond_wait(v->there_is_room_for_data.cond, v->mutexPush);     \
      }                                                                  \
    } else if (!BUFFERI_POLICY_P((policy), BUFFER_PUSH_OVERWRITE)        \
               && M_C(name, _full_p)(v))					\
@@ -442,12 +533,16 @@ M_C(name, _init)(buffer_t v, size_t size)                               \
   /* BUFFER unlock */							\
    if (!BUFFERI_POLICY_P((policy), BUFFER_THREAD_UNSAFE)) {             \
      m_mutex_unlock(v->mutexPush);                                      \
+     if (BUFFERI_FUTEX_P(policy)) {                                     \
+       /* Wake up one parked consumer per pushed item */                \
+       M_C(name, _int_wake)(&v->there_is_data.futex, 1);                \
+     }                                                                  \
      /* If the number of items in the buffer was 0, some consummer      \
         may be waiting. Signal to them the availibility of the data     \
         We cannot only signal one thread. */                            \
-     if (previousSize == 0) {                                           \
+     else if (previousSize == 0) {                                      \
        m_mutex_lock(v->mutexPop);                                       \
-       m_cond_broadcast(v->there_is_data);                              \
+       m_cond_broadcast(v->there_is_data.cond);                         \
        m_mutex_unlock(v->mutexPop);                                     \
      }                                                                  \
    }                                                                    \
@@ -470,7 +565,12 @@ M_C(name, _init)(buffer_t v, size_t size)                               \
          m_mutex_unlock(v->mutexPop);                                   \
          return false;                                                  \
        }                                                                \
-       m_cond_wait(v->there_is_data, v->mutexPop);                      \
+       if (BUFFERI_FUTEX_P(policy)) {                                   \
+         m_mutex_unlock(v->mutexPop);                                   \
+         M_C(name, _int_wait)(v, true);                                 \
+         m_mutex_lock(v->mutexPop);                                     \
+       } else                                                           \
+         m_cond_wait(v->there_is_data.cond, v->mutexPop);               \
      }                                                                  \
    } else if (M_C(name, _empty_p)(v))					\
      return false;                                                      \
@@ -510,13 +610,18 @@ M_C(name, _init)(buffer_t v, size_t size)                               \
    /* BUFFER unlock */							\
    if (!BUFFERI_POLICY_P((policy), BUFFER_THREAD_UNSAFE)) {             \
      m_mutex_unlock(v->mutexPop);                                       \
+     if (BUFFERI_POLICY_P((policy), BUFFER_DEFERRED_POP)) {             \
+       /* Room is only given back by pop_release */                     \
+     } else if (BUFFERI_FUTEX_P(policy)) {                              \
+       /* Wake up one parked producer per popped item */                \
+       M_C(name, _int_wake)(&v->there_is_room_for_data.futex, 1);       \
+     }                                                                  \
      /* If the number of items in the buffer was the max, some producer \
         may be waiting. Signal to them the availibility of the free room \
         We cannot only signal one thread. */                            \
-     if ((!BUFFERI_POLICY_P((policy), BUFFER_DEFERRED_POP))             \
-         && previousSize == BUFFERI_SIZE(m_size)) {                     \
+     else if (previousSize == BUFFERI_SIZE(m_size)) {                   \
        m_mutex_lock(v->mutexPush);                                      \
-       m_cond_broadcast(v->there_is_room_for_data);                     \
+       m_cond_broadcast(v->there_is_room_for_data.cond);                \
        m_mutex_unlock(v->mutexPush);                                    \
      }                                                                  \
    }                                                                    \
@@ -559,9 +664,11 @@ M_C(name, _init)(buffer_t v, size_t size)                               \
    /* Decrement the effective number of elements in the buffer */       \
    if (BUFFERI_POLICY_P((policy), BUFFER_DEFERRED_POP)) {               \
      size_t previousSize = atomic_fetch_sub (&v->number[0], 1UL);	\
-     if (previousSize == BUFFERI_SIZE(m_size)) {                        \
+     if (BUFFERI_FUTEX_P(policy)) {                                     \
+       M_C(name, _int_wake)(&v->there_is_room_for_data.futex, 1);       \
+     } else if (previousSize == BUFFERI_SIZE(m_size)) {                 \
        m_mutex_lock(v->mutexPush);                                      \
-       m_cond_broadcast(v->there_is_room_for_data);                     \
+       m_cond_broadcast(v->there_is_room_for_data.cond);                \
        m_mutex_unlock(v->mutexPush);                                    \
      }                                                                  \
    }                                                                    \
@@ -680,6 +787,85 @@ M_C(name, _init)(buffer_t v, size_t size)                               \
     atomic_store_explicit(&table->Tab[i].seq, 2*iC + 1, memory_order_release); \
     QUEUEI_MPMC_CONTRACT(table);                                        \
     return true;                                                        \
+  }                                                                     \
+                                                                        \
+  /* Claim up to n consecutive free slots with only one CAS,            \
+     then fill them. Return the number of pushed elements. */           \
+  static inline unsigned                                                \
+  M_C(name, _push_bulk)(buffer_t table, unsigned n, type const x[])     \
+  {                                                                     \
+    QUEUEI_MPMC_CONTRACT(table);                                        \
+    assert (x != NULL);                                                 \
+    assert (n <= table->size);                                          \
+    unsigned int idx = atomic_load_explicit(&table->ProdIdx,            \
+                                            memory_order_relaxed);      \
+    unsigned int max;                                                   \
+    do {                                                                \
+      /* Count the number of consecutive free slots from idx */         \
+      for(max = 0; max < n; max++) {                                    \
+        const unsigned int i = (idx + max) & (table->size -1);          \
+        const unsigned int seq = atomic_load_explicit(&table->Tab[i].seq, \
+                                                      memory_order_acquire); \
+        if (2*(idx + max - table->size) + 1 != seq)                     \
+          break;                                                        \
+      }                                                                 \
+      if (max == 0) {                                                   \
+        /* Buffer full (or unlikely preemption). Can not push */        \
+        return 0;                                                       \
+      }                                                                 \
+      /* If another thread has pushed in the meantime, idx is updated: retry */ \
+    } while (!atomic_compare_exchange_weak_explicit(&table->ProdIdx,    \
+               &idx, idx+max, memory_order_relaxed, memory_order_relaxed)); \
+    for(unsigned int k = 0; k < max; k++) {                             \
+      const unsigned int i = (idx + k) & (table->size -1);              \
+      if (!BUFFERI_POLICY_P((policy), BUFFER_PUSH_INIT_POP_MOVE)) {     \
+        M_CALL_SET(oplist, table->Tab[i].x, x[k]);                      \
+      } else {                                                          \
+        M_CALL_INIT_SET(oplist, table->Tab[i].x, x[k]);                 \
+      }                                                                 \
+      atomic_store_explicit(&table->Tab[i].seq, 2*(idx + k), memory_order_release); \
+    }                                                                   \
+    QUEUEI_MPMC_CONTRACT(table);                                        \
+    return max;                                                         \
+  }                                                                     \
+                                                                        \
+  /* Claim up to n consecutive filled slots with only one CAS,          \
+     then drain them. Return the number of popped elements. */          \
+  static inline unsigned                                                \
+  M_C(name, _pop_bulk)(unsigned int n, type ptr[], buffer_t table)      \
+  {                                                                     \
+    QUEUEI_MPMC_CONTRACT(table);                                        \
+    assert (ptr != NULL);                                               \
+    assert (n <= table->size);                                          \
+    unsigned int iC = atomic_load_explicit(&table->ConsoIdx,            \
+                                           memory_order_relaxed);       \
+    unsigned int max;                                                   \
+    do {                                                                \
+      /* Count the number of consecutive filled slots from iC */        \
+      for(max = 0; max < n; max++) {                                    \
+        const unsigned int i = (iC + max) & (table->size -1);           \
+        const unsigned int seq = atomic_load_explicit(&table->Tab[i].seq, \
+                                                      memory_order_acquire); \
+        if (seq != 2 * (iC + max))                                      \
+          break;                                                        \
+      }                                                                 \
+      if (max == 0) {                                                   \
+        /* Nothing in buffer to consumme (or unlikely preemption) */    \
+        return 0;                                                       \
+      }                                                                 \
+    } while (!atomic_compare_exchange_weak_explicit(&table->ConsoIdx,   \
+               &iC, iC+max, memory_order_relaxed, memory_order_relaxed)); \
+    for(unsigned int k = 0; k < max; k++) {                             \
+      const unsigned int i = (iC + k) & (table->size -1);               \
+      if (!BUFFERI_POLICY_P((policy), BUFFER_PUSH_INIT_POP_MOVE)) {     \
+        M_CALL_SET(oplist, ptr[k], table->Tab[i].x);                    \
+      } else {                                                          \
+        M_DO_INIT_MOVE (oplist, ptr[k], table->Tab[i].x);               \
+      }                                                                 \
+      atomic_store_explicit(&table->Tab[i].seq, 2*(iC + k) + 1, memory_order_release); \
+    }                                                                   \
+    QUEUEI_MPMC_CONTRACT(table);                                        \
+    return max;                                                         \
   }									\
 									\
   static inline void							\
@@ -0,0 +1,287 @@
+/*
+ * M*LIB - Lock Free dictionary
+ *
+ * Copyright (c) 2017-2019, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef MSTARLIB_CONCURRENT_DICT_H
+#define MSTARLIB_CONCURRENT_DICT_H
+
+#include "m-core.h"
+#include "m-atomic.h"
+#include "m-c-mempool.h"
+
+/* Define a Lock Free dictionary from key_type to value_type.
+   Readers never take any lock: they shall only be awake in the
+   garbage collector associated to the dictionary.
+   USAGE: C_DICT_DEF2(name, key_type[, key_oplist], value_type[, value_oplist]) */
+#define C_DICT_DEF2(name, key_type, ...)                                \
+  C_DICTI_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                            \
+                 ((name, key_type, M_GLOBAL_OPLIST_OR_DEF(key_type)(), __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), M_C(name, _t) ), \
+                  (name, key_type, __VA_ARGS__, M_C(name, _t) )))
+
+
+/********************************** INTERNAL ************************************/
+
+/* Minimum number of buckets of the dictionary */
+#define C_DICTI_MIN_BUCKET 16
+
+/* Internal contract */
+#define C_DICTI_CONTRACT(d) do {                                        \
+    assert ((d) != NULL);                                               \
+    assert ((d)->gc_mem != NULL);                                       \
+    assert (M_POWEROF2_P((d)->mask + 1));                               \
+    assert ((d)->bucket != NULL);                                       \
+  } while (0)
+
+/* Deferred evaluation for the definition,
+   so that all arguments are evaluated before further expansion */
+#define C_DICTI_DEF_P1(arg) C_DICTI_DEF_P2 arg
+
+/* Internal definition
+   - name: prefix to be used
+   - key_type / key_oplist: type & oplist of the key
+   - value_type / value_oplist: type & oplist of the value
+   - dict_t: alias for M_C(name, _t) [ type of the dictionary ]
+
+   The dictionary is a fixed array of buckets, each bucket being the head
+   of a singly linked list of nodes. Once published, a node is never
+   modified: a writer builds a new version of the beginning of the list
+   up to the modified node (path copying), shares the end of the list,
+   and publishes it with a CAS on the bucket head. If the CAS fails,
+   another writer has modified the bucket: the unpublished nodes are
+   discarded and the operation is restarted. The replaced nodes are
+   retired through the mempool: they remain readable until all threads
+   awake at the time of the retirement have gone to sleep.
+   As retired nodes are recycled by the mempool without calling their
+   destructor, key_type and value_type shall be plain data types.
+*/
+#define C_DICTI_DEF_P2(name, key_type, key_oplist, value_type, value_oplist, dict_t) \
+                                                                        \
+  typedef struct M_C(name, _node_s) {                                   \
+    struct M_C(name, _node_s) *next;                                    \
+    key_type   key;                                                     \
+    value_type value;                                                   \
+  } M_C(name, _node_t);                                                 \
+                                                                        \
+  M_ATTR_EXTENSION typedef _Atomic(M_C(name, _node_t) *) M_C(name, _atomic_node_ptr_t); \
+                                                                        \
+  C_MEMPOOL_DEF(M_C(name, _mempool), M_C(name, _node_t))                \
+                                                                        \
+  typedef struct M_C(name, _s) {                                        \
+    size_t                   mask;                                      \
+    M_C(name, _atomic_node_ptr_t) *bucket;                              \
+    char                     align1[M_ALIGN_FOR_CACHELINE_EXCLUSION];   \
+    atomic_size_t            count;                                     \
+    char                     align2[M_ALIGN_FOR_CACHELINE_EXCLUSION];   \
+    M_C(name, _mempool_t)    mempool;                                   \
+    struct m_gc_s           *gc_mem;                                    \
+  } dict_t[1];                                                          \
+                                                                        \
+  typedef struct M_C(name, _s) *M_C(name, _ptr);                        \
+  typedef const struct M_C(name, _s) *M_C(name, _srcptr);               \
+                                                                        \
+  typedef key_type   M_C(name, _key_type_t);                            \
+  typedef value_type M_C(name, _value_type_t);                          \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _init)(dict_t dict, m_gc_t gc_mem, size_t bucket_count)     \
+  {                                                                     \
+    assert (dict != NULL && gc_mem != NULL);                            \
+    size_t n = m_core_roundpow2(M_MAX(bucket_count, C_DICTI_MIN_BUCKET)); \
+    dict->bucket = M_MEMORY_REALLOC(M_C(name, _atomic_node_ptr_t), NULL, n); \
+    if (M_UNLIKELY (dict->bucket == NULL)) {                            \
+      M_MEMORY_FULL(n * sizeof(M_C(name, _atomic_node_ptr_t)));         \
+      return;                                                           \
+    }                                                                   \
+    for(size_t i = 0; i < n; i++) {                                     \
+      atomic_init(&dict->bucket[i], (M_C(name, _node_t) *) 0);          \
+    }                                                                   \
+    dict->mask = n - 1;                                                 \
+    atomic_init(&dict->count, (size_t) 0);                              \
+    M_C(name, _mempool_init)(dict->mempool, gc_mem,                     \
+                             C_MEMPOOL_MIN_NODE_PER_GROUP * 16, gc_mem->max_thread); \
+    dict->gc_mem = gc_mem;                                              \
+    C_DICTI_CONTRACT(dict);                                             \
+  }                                                                     \
+                                                                        \
+  /* No other thread shall use the dictionary, and all the threads      \
+     shall have been put to sleep (so that the mempool has reclaimed    \
+     all the retired nodes) */                                          \
+  static inline void                                                    \
+  M_C(name, _clear)(dict_t dict)                                        \
+  {                                                                     \
+    C_DICTI_CONTRACT(dict);                                             \
+    for(size_t i = 0; i <= dict->mask; i++) {                           \
+      M_C(name, _node_t) *it = atomic_load_explicit(&dict->bucket[i], memory_order_relaxed); \
+      while (it != NULL) {                                              \
+        M_C(name, _node_t) *next = it->next;                            \
+        /* Give back the node to the free list of the first thread,     \
+           so that the mempool frees it */                              \
+        M_C(name, _mempool_slist_node_t) *snode =                       \
+          M_TYPE_FROM_FIELD(M_C(name, _mempool_slist_node_t), it, M_C(name, _node_t), data); \
+        M_C(name, _mempool_slist_push)(dict->mempool->thread_data[0].free, snode); \
+        it = next;                                                      \
+      }                                                                 \
+    }                                                                   \
+    M_C(name, _mempool_clear)(dict->mempool);                           \
+    M_MEMORY_FREE(dict->bucket);                                        \
+    dict->bucket = NULL;                                                \
+    dict->gc_mem = NULL;                                                \
+  }                                                                     \
+                                                                        \
+  static inline size_t                                                  \
+  M_C(name, _size)(const dict_t dict)                                   \
+  {                                                                     \
+    C_DICTI_CONTRACT(dict);                                             \
+    return atomic_load(&dict->count);                                   \
+  }                                                                     \
+                                                                        \
+  static inline bool                                                    \
+  M_C(name, _empty_p)(const dict_t dict)                                \
+  {                                                                     \
+    return M_C(name, _size)(dict) == 0;                                 \
+  }                                                                     \
+                                                                        \
+  /* The returned pointer remains valid until the thread goes to sleep */ \
+  static inline value_type *                                            \
+  M_C(name, _get)(const dict_t dict, key_type const key)                \
+  {                                                                     \
+    C_DICTI_CONTRACT(dict);                                             \
+    size_t hash = M_CALL_HASH(key_oplist, key);                         \
+    M_C(name, _node_t) *it =                                            \
+      atomic_load_explicit(&dict->bucket[hash & dict->mask], memory_order_acquire); \
+    while (it != NULL) {                                                \
+      if (M_CALL_EQUAL(key_oplist, it->key, key))                       \
+        return &it->value;                                              \
+      it = it->next;                                                    \
+    }                                                                   \
+    return NULL;                                                        \
+  }                                                                     \
+                                                                        \
+  static inline bool                                                    \
+  M_C(name, _get_copy)(value_type *out_data, const dict_t dict, key_type const key) \
+  {                                                                     \
+    assert (out_data != NULL);                                          \
+    value_type *p = M_C(name, _get)(dict, key);                         \
+    if (p != NULL) {                                                    \
+      M_CALL_SET(value_oplist, *out_data, *p);                          \
+    }                                                                   \
+    return p != NULL;                                                   \
+  }                                                                     \
+                                                                        \
+  /* Duplicate the nodes from 'it' until 'stop' (excluded) and link     \
+     the last copy to 'tail'. Return the first node of the new list */  \
+  static inline M_C(name, _node_t) *                                    \
+  M_C(name, _int_copy)(dict_t dict, M_C(name, _node_t) *it,             \
+                       M_C(name, _node_t) *stop, M_C(name, _node_t) *tail, \
+                       m_gc_tid_t id)                                   \
+  {                                                                     \
+    M_C(name, _node_t) *first = tail, **last = &first;                  \
+    while (it != stop) {                                                \
+      M_C(name, _node_t) *n = M_C(name, _mempool_new)(dict->mempool, id); \
+      M_CALL_INIT_SET(key_oplist, n->key, it->key);                     \
+      M_CALL_INIT_SET(value_oplist, n->value, it->value);               \
+      *last = n;                                                        \
+      last = &n->next;                                                  \
+      it = it->next;                                                    \
+    }                                                                   \
+    *last = tail;                                                       \
+    return first;                                                       \
+  }                                                                     \
+                                                                        \
+  /* Retire the nodes from 'it' until 'stop' (excluded) */              \
+  static inline void                                                    \
+  M_C(name, _int_retire)(dict_t dict, M_C(name, _node_t) *it,           \
+                         M_C(name, _node_t) *stop, m_gc_tid_t id)       \
+  {                                                                     \
+    while (it != stop) {                                                \
+      M_C(name, _node_t) *next = it->next;                              \
+      M_C(name, _mempool_del)(dict->mempool, it, id);                   \
+      it = next;                                                        \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _set_at)(dict_t dict, key_type const key, value_type const value, m_gc_tid_t id) \
+  {                                                                     \
+    C_DICTI_CONTRACT(dict);                                             \
+    assert (id >= 0 && id < dict->gc_mem->max_thread);                  \
+    size_t hash = M_CALL_HASH(key_oplist, key);                         \
+    M_C(name, _atomic_node_ptr_t) *b = &dict->bucket[hash & dict->mask]; \
+    struct m_backoff_s *bkoff = dict->gc_mem->thread_data[id].bkoff;    \
+    m_backoff_reset(bkoff);                                             \
+    while (true) {                                                      \
+      M_C(name, _node_t) *head = atomic_load_explicit(b, memory_order_acquire); \
+      M_C(name, _node_t) *it = head;                                    \
+      while (it != NULL && !M_CALL_EQUAL(key_oplist, it->key, key))     \
+        it = it->next;                                                  \
+      M_C(name, _node_t) *n = M_C(name, _mempool_new)(dict->mempool, id); \
+      M_CALL_INIT_SET(key_oplist, n->key, key);                         \
+      M_CALL_INIT_SET(value_oplist, n->value, value);                   \
+      /* New key: push it in front. Otherwise replace the old node */   \
+      n->next = (it == NULL) ? head : it->next;                         \
+      M_C(name, _node_t) *first = (it == NULL) ? n : M_C(name, _int_copy)(dict, head, it, n, id); \
+      if (atomic_compare_exchange_strong_explicit(b, &head, first,      \
+                                                  memory_order_release, \
+                                                  memory_order_relaxed)) { \
+        if (it == NULL)                                                 \
+          atomic_fetch_add(&dict->count, 1);                            \
+        else                                                            \
+          M_C(name, _int_retire)(dict, head, n->next, id);              \
+        return;                                                         \
+      }                                                                 \
+      /* Someone else has modified the bucket. Discard & retry */       \
+      M_C(name, _int_retire)(dict, first, n->next, id);                 \
+      m_backoff_wait(bkoff);                                            \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  static inline bool                                                    \
+  M_C(name, _erase)(dict_t dict, key_type const key, m_gc_tid_t id)     \
+  {                                                                     \
+    C_DICTI_CONTRACT(dict);                                             \
+    assert (id >= 0 && id < dict->gc_mem->max_thread);                  \
+    size_t hash = M_CALL_HASH(key_oplist, key);                         \
+    M_C(name, _atomic_node_ptr_t) *b = &dict->bucket[hash & dict->mask]; \
+    struct m_backoff_s *bkoff = dict->gc_mem->thread_data[id].bkoff;    \
+    m_backoff_reset(bkoff);                                             \
+    while (true) {                                                      \
+      M_C(name, _node_t) *head = atomic_load_explicit(b, memory_order_acquire); \
+      M_C(name, _node_t) *it = head;                                    \
+      while (it != NULL && !M_CALL_EQUAL(key_oplist, it->key, key))     \
+        it = it->next;                                                  \
+      if (it == NULL)                                                   \
+        return false;                                                   \
+      M_C(name, _node_t) *first = M_C(name, _int_copy)(dict, head, it, it->next, id); \
+      if (atomic_compare_exchange_strong_explicit(b, &head, first,      \
+                                                  memory_order_release, \
+                                                  memory_order_relaxed)) { \
+        atomic_fetch_sub(&dict->count, 1);                              \
+        M_C(name, _int_retire)(dict, head, it->next, id);               \
+        return true;                                                    \
+      }                                                                 \
+      M_C(name, _int_retire)(dict, first, it->next, id);                \
+      m_backoff_wait(bkoff);                                            \
+    }                                                                   \
+  }
+
+#endif
@@ -0,0 +1,289 @@
+/*
+ * M*LIB - Lock Free unbounded queue
+ *
+ * Copyright (c) 2017-2019, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef MSTARLIB_CONCURRENT_QUEUE_H
+#define MSTARLIB_CONCURRENT_QUEUE_H
+
+#include "m-core.h"
+#include "m-atomic.h"
+#include "m-c-mempool.h"
+
+/* Define an unbounded Lock Free queue for Multiple Producers /
+   Multiple Consumers, made of a linked list of segments of
+   'segment_size' elements.
+   The threads shall be awake in the garbage collector associated
+   to the queue when they push or pop.
+   USAGE: C_QUEUE_DEF(name, type, segment_size[, oplist]) */
+#define C_QUEUE_DEF(name, type, ...)                                    \
+  C_QUEUEI_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                           \
+                  ((name, type, __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(type)(), M_C(name, _t) ), \
+                   (name, type, __VA_ARGS__, M_C(name, _t) )))
+
+
+/********************************** INTERNAL ************************************/
+
+/* State of a slot of a segment */
+#define C_QUEUEI_EMPTY   0U /* Not used yet */
+#define C_QUEUEI_WRITING 1U /* Reserved by a producer, being written */
+#define C_QUEUEI_FULL    2U /* Written, ready to be popped */
+#define C_QUEUEI_TAKEN   3U /* Abandoned by a consumer before any producer wrote it */
+
+/* Internal contract */
+#define C_QUEUEI_CONTRACT(q) do {                                       \
+    assert ((q) != NULL);                                               \
+    assert ((q)->gc_mem != NULL);                                       \
+    assert (atomic_load(&(q)->head) != NULL);                           \
+    assert (atomic_load(&(q)->tail) != NULL);                           \
+  } while (0)
+
+/* Deferred evaluation for the definition,
+   so that all arguments are evaluated before further expansion */
+#define C_QUEUEI_DEF_P1(arg) C_QUEUEI_DEF_P2 arg
+
+/* Internal definition
+   - name: prefix to be used
+   - type: type of the elements
+   - seg_size: number of elements per segment
+   - oplist: oplist of the type
+   - queue_t: alias for M_C(name, _t) [ type of the queue ]
+
+   Each segment is an array of slots with a producer index and a consumer
+   index, both only increased with a fetch-add. A producer reserves a slot
+   of the tail segment, and if the segment is full, links a new segment
+   (allocated from the mempool) after it. A consumer reserves a slot of
+   the head segment and waits for it to be written. If no producer has
+   reserved the slot yet, the consumer marks it as TAKEN so that the late
+   producer reserves another slot. Once all the slots of the head segment
+   have been consumed, the head moves to the next segment and the previous
+   one is retired to the mempool: it is reused only once all the threads
+   that may still access it have gone to sleep.
+*/
+#define C_QUEUEI_DEF_P2(name, type, seg_size, oplist, queue_t)          \
+                                                                        \
+  typedef struct M_C(name, _slot_s) {                                   \
+    atomic_uint state;                                                  \
+    type        x;                                                      \
+  } M_C(name, _slot_t);                                                 \
+                                                                        \
+  typedef struct M_C(name, _segment_s) {                                \
+    atomic_uint prodIdx; /* Can increase past the segment size */       \
+    M_CACHELINE_ALIGN(align1, atomic_uint);                             \
+    atomic_uint consoIdx; /* Can increase past the segment size */      \
+    M_CACHELINE_ALIGN(align2, atomic_uint);                             \
+    M_ATTR_EXTENSION _Atomic(struct M_C(name, _segment_s) *) next;      \
+    M_C(name, _slot_t) tab[seg_size];                                   \
+  } M_C(name, _segment_t);                                              \
+                                                                        \
+  C_MEMPOOL_DEF(M_C(name, _segment_mempool), M_C(name, _segment_t))     \
+                                                                        \
+  typedef struct M_C(name, _s) {                                        \
+    M_ATTR_EXTENSION _Atomic(M_C(name, _segment_t) *) head;             \
+    char          align1[M_ALIGN_FOR_CACHELINE_EXCLUSION];              \
+    M_ATTR_EXTENSION _Atomic(M_C(name, _segment_t) *) tail;             \
+    char          align2[M_ALIGN_FOR_CACHELINE_EXCLUSION];              \
+    atomic_ulong  segment_count;                                        \
+    atomic_ulong  segment_max;                                          \
+    M_C(name, _segment_mempool_t) mempool;                              \
+    struct m_gc_s *gc_mem;                                              \
+  } queue_t[1];                                                         \
+                                                                        \
+  typedef struct M_C(name, _s) *M_C(name, _ptr);                        \
+  typedef const struct M_C(name, _s) *M_C(name, _srcptr);               \
+                                                                        \
+  typedef type M_C(name, _type_t);                                      \
+                                                                        \
+  static inline M_C(name, _segment_t) *                                 \
+  M_C(name, _int_new_segment)(queue_t q, m_gc_tid_t id)                 \
+  {                                                                     \
+    M_C(name, _segment_t) *s = M_C(name, _segment_mempool_new)(q->mempool, id); \
+    atomic_init(&s->prodIdx, 0U);                                       \
+    atomic_init(&s->consoIdx, 0U);                                      \
+    atomic_init(&s->next, (M_C(name, _segment_t) *) 0);                 \
+    for(unsigned int i = 0; i < (seg_size); i++) {                      \
+      atomic_init(&s->tab[i].state, C_QUEUEI_EMPTY);                    \
+    }                                                                   \
+    return s;                                                           \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _init)(queue_t q, m_gc_t gc_mem)                            \
+  {                                                                     \
+    assert (q != NULL && gc_mem != NULL);                               \
+    M_C(name, _segment_mempool_init)(q->mempool, gc_mem, 4, 1);         \
+    q->gc_mem = gc_mem;                                                 \
+    /* No other thread can access the mempool yet */                    \
+    M_C(name, _segment_t) *s = M_C(name, _int_new_segment)(q, 0);       \
+    atomic_init(&q->head, s);                                           \
+    atomic_init(&q->tail, s);                                           \
+    atomic_init(&q->segment_count, 1UL);                                \
+    atomic_init(&q->segment_max, 1UL);                                  \
+    C_QUEUEI_CONTRACT(q);                                               \
+  }                                                                     \
+                                                                        \
+  /* No other thread shall use the queue, and all the threads           \
+     shall have been put to sleep */                                    \
+  static inline void                                                    \
+  M_C(name, _clear)(queue_t q)                                          \
+  {                                                                     \
+    C_QUEUEI_CONTRACT(q);                                               \
+    M_C(name, _segment_t) *s = atomic_load(&q->head);                   \
+    while (s != NULL) {                                                 \
+      M_C(name, _segment_t) *next = atomic_load(&s->next);              \
+      unsigned int e = M_MIN(atomic_load(&s->prodIdx), (unsigned) (seg_size)); \
+      for(unsigned int i = atomic_load(&s->consoIdx); i < e; i++) {     \
+        if (atomic_load(&s->tab[i].state) == C_QUEUEI_FULL)             \
+          M_CALL_CLEAR(oplist, s->tab[i].x);                            \
+      }                                                                 \
+      /* Give back the segment to the free list of the first thread,    \
+         so that the mempool frees it */                                \
+      M_C(name, _segment_mempool_slist_push)(q->mempool->thread_data[0].free, \
+         M_TYPE_FROM_FIELD(M_C(name, _segment_mempool_slist_node_t), s, M_C(name, _segment_t), data)); \
+      s = next;                                                         \
+    }                                                                   \
+    M_C(name, _segment_mempool_clear)(q->mempool);                      \
+    q->gc_mem = NULL;                                                   \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _push)(queue_t q, type const x, m_gc_tid_t id)              \
+  {                                                                     \
+    C_QUEUEI_CONTRACT(q);                                               \
+    assert (id >= 0 && id < q->gc_mem->max_thread);                     \
+    while (true) {                                                      \
+      M_C(name, _segment_t) *t = atomic_load_explicit(&q->tail, memory_order_acquire); \
+      unsigned int i = atomic_fetch_add_explicit(&t->prodIdx, 1U, memory_order_relaxed); \
+      if (M_LIKELY (i < (seg_size))) {                                  \
+        /* Fast path: reserve the slot in the tail segment */           \
+        unsigned int state = C_QUEUEI_EMPTY;                            \
+        if (M_LIKELY (atomic_compare_exchange_strong_explicit(&t->tab[i].state, \
+                         &state, C_QUEUEI_WRITING,                      \
+                         memory_order_acquire, memory_order_relaxed))) { \
+          M_CALL_INIT_SET(oplist, t->tab[i].x, x);                      \
+          atomic_store_explicit(&t->tab[i].state, C_QUEUEI_FULL, memory_order_release); \
+          return;                                                       \
+        }                                                               \
+        /* The slot was abandoned by a consumer. Retry */               \
+        continue;                                                       \
+      }                                                                 \
+      /* The tail segment is full */                                    \
+      M_C(name, _segment_t) *next = atomic_load_explicit(&t->next, memory_order_acquire); \
+      if (next != NULL) {                                               \
+        /* Help to move the tail */                                     \
+        atomic_compare_exchange_strong_explicit(&q->tail, &t, next,     \
+                                                memory_order_release, memory_order_relaxed); \
+        continue;                                                       \
+      }                                                                 \
+      /* Link a new segment with the element already in it */           \
+      M_C(name, _segment_t) *s = M_C(name, _int_new_segment)(q, id);    \
+      atomic_store_explicit(&s->prodIdx, 1U, memory_order_relaxed);     \
+      M_CALL_INIT_SET(oplist, s->tab[0].x, x);                          \
+      atomic_store_explicit(&s->tab[0].state, C_QUEUEI_FULL, memory_order_relaxed); \
+      if (atomic_compare_exchange_strong_explicit(&t->next, &next, s,   \
+                                                  memory_order_release, memory_order_relaxed)) { \
+        atomic_compare_exchange_strong_explicit(&q->tail, &t, s,        \
+                                                memory_order_release, memory_order_relaxed); \
+        unsigned long count = atomic_fetch_add(&q->segment_count, 1UL) + 1; \
+        unsigned long max = atomic_load(&q->segment_max);               \
+        while (count > max                                              \
+               && !atomic_compare_exchange_weak(&q->segment_max, &max, count)); \
+        return;                                                         \
+      }                                                                 \
+      /* Another producer has linked a segment first. Retry */          \
+      M_CALL_CLEAR(oplist, s->tab[0].x);                                \
+      M_C(name, _segment_mempool_del)(q->mempool, s, id);               \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  static inline bool                                                    \
+  M_C(name, _pop)(type *ptr, queue_t q, m_gc_tid_t id)                  \
+  {                                                                     \
+    C_QUEUEI_CONTRACT(q);                                               \
+    assert (ptr != NULL);                                               \
+    assert (id >= 0 && id < q->gc_mem->max_thread);                     \
+    while (true) {                                                      \
+      M_C(name, _segment_t) *h = atomic_load_explicit(&q->head, memory_order_acquire); \
+      unsigned int c = atomic_load_explicit(&h->consoIdx, memory_order_relaxed); \
+      unsigned int p = atomic_load_explicit(&h->prodIdx, memory_order_relaxed); \
+      if (c >= p                                                        \
+          && atomic_load_explicit(&h->next, memory_order_acquire) == NULL) { \
+        /* Nothing to pop: don't waste a slot */                        \
+        return false;                                                   \
+      }                                                                 \
+      unsigned int i = atomic_fetch_add_explicit(&h->consoIdx, 1U, memory_order_relaxed); \
+      if (M_UNLIKELY (i >= (seg_size))) {                               \
+        /* The head segment is fully consumed. Move to the next one */  \
+        M_C(name, _segment_t) *next = atomic_load_explicit(&h->next, memory_order_acquire); \
+        if (next == NULL)                                               \
+          return false;                                                 \
+        if (atomic_compare_exchange_strong_explicit(&q->head, &h, next, \
+                                                    memory_order_release, memory_order_relaxed)) { \
+          atomic_fetch_sub(&q->segment_count, 1UL);                     \
+          M_C(name, _segment_mempool_del)(q->mempool, h, id);           \
+        }                                                               \
+        continue;                                                       \
+      }                                                                 \
+      unsigned int state = C_QUEUEI_EMPTY;                              \
+      if (atomic_compare_exchange_strong_explicit(&h->tab[i].state,     \
+                         &state, C_QUEUEI_TAKEN,                        \
+                         memory_order_acquire, memory_order_acquire)) { \
+        /* No producer has reserved this slot yet. Try the next one */  \
+        continue;                                                       \
+      }                                                                 \
+      /* The producer which has reserved the slot may still be writing it */ \
+      if (M_UNLIKELY (state != C_QUEUEI_FULL)) {                        \
+        struct m_backoff_s *bkoff = q->gc_mem->thread_data[id].bkoff;   \
+        m_backoff_reset(bkoff);                                         \
+        while (atomic_load_explicit(&h->tab[i].state, memory_order_acquire) != C_QUEUEI_FULL) \
+          m_backoff_wait(bkoff);                                        \
+      }                                                                 \
+      M_DO_MOVE(oplist, *ptr, h->tab[i].x);                             \
+      return true;                                                      \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  /* Approximate, as the queue may be modified concurrently */          \
+  static inline bool                                                    \
+  M_C(name, _empty_p)(queue_t q)                                        \
+  {                                                                     \
+    C_QUEUEI_CONTRACT(q);                                               \
+    M_C(name, _segment_t) *h = atomic_load(&q->head);                   \
+    return atomic_load(&h->consoIdx) >= atomic_load(&h->prodIdx)        \
+      && atomic_load(&h->next) == NULL;                                 \
+  }                                                                     \
+                                                                        \
+  static inline size_t                                                  \
+  M_C(name, _segment_count)(queue_t q)                                  \
+  {                                                                     \
+    C_QUEUEI_CONTRACT(q);                                               \
+    return atomic_load(&q->segment_count);                              \
+  }                                                                     \
+                                                                        \
+  static inline size_t                                                  \
+  M_C(name, _segment_max)(queue_t q)                                    \
+  {                                                                     \
+    C_QUEUEI_CONTRACT(q);                                               \
+    return atomic_load(&q->segment_max);                                \
+  }
+
+#endif
@@ -56,6 +56,16 @@
                 (name, __VA_ARGS__,                                        M_C(name,_t) )))
 
 
+/* Define a concurrent dictionary based on the given dictionary type,
+   partitioning the keys by hash across 'shard_count' independent
+   dictionaries, each one protected by its own lock.
+   USAGE: CONCURRENT_DICT_SHARDED_DEF(name, type, shard_count [, oplist_of_the_type]) */
+#define CONCURRENT_DICT_SHARDED_DEF(name, ...)                          \
+  CONCURRENTI_SHARDED_DEF_P1(M_IF_NARGS_EQ2(__VA_ARGS__)                \
+               ((name, __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(M_RET_ARG1(__VA_ARGS__,))(), M_C(name,_t) ), \
+                (name, __VA_ARGS__,                                        M_C(name,_t) )))
+
+
 /********************************** INTERNAL ************************************/
 
 /* Deferred evaluation for the oplist definition,
@@ -101,6 +111,7 @@
    ,M_IF_METHOD(HASH, oplist)(HASH(M_C(name, _hash)),)			\
    ,M_IF_METHOD(NEW, oplist)(NEW(M_GET_NEW oplist),)                    \
    ,M_IF_METHOD(REALLOC, oplist)(REALLOC(M_GET_REALLOC oplist),)        \
+   ,M_IF_METHOD(FREE, oplist)(FREE(M_GET_FREE oplist),)                 \
    ,M_IF_METHOD(DEL, oplist)(DEL(M_GET_DEL oplist),)                    \
    )
 
@@ -781,4 +792,194 @@
   CONCURRENTI_DEF_FUNC_P3(name, type, oplist, concurrent_t)
 
 
+
+/* Deferred evaluation for the sharded concurrent dictionary definition,
+   so that all arguments are evaluated before further expansion */
+#define CONCURRENTI_SHARDED_DEF_P1(arg) CONCURRENTI_SHARDED_DEF_P2 arg
+
+/* Internal contract of a sharded concurrent dictionary */
+#define CONCURRENTI_SHARDED_CONTRACT(c) do {    \
+    assert ((c) != NULL);                       \
+    assert ((c)->self == (c));                  \
+  } while (0)
+
+/* Internal sharded concurrent dictionary definition
+   - name: prefix to be used
+   - type: type of the sub dictionary
+   - shard_count: number of independent sub dictionaries
+   - oplist: oplist of the type of the sub dictionary
+   - concurrent_t: alias for M_C(name, _t) [ type of the container ]
+   Each shard has its own lock & condition, and is separated from its
+   neighbors by a full cache line so that two threads working on different
+   shards don't fight for the same cache line.
+ */
+#define CONCURRENTI_SHARDED_DEF_P2(name, type, shard_count, oplist, concurrent_t) \
+                                                                        \
+  typedef struct M_C(name, _shard_s) {                                  \
+    m_mutex_t lock;                                                     \
+    m_cond_t  there_is_data; /* condition raised when there is data */  \
+    type      data;                                                     \
+    char      align[M_ALIGN_FOR_CACHELINE_EXCLUSION];                   \
+  } M_C(name, _shard_t);                                                \
+                                                                        \
+  typedef struct M_C(name, _s) {                                        \
+    struct M_C(name, _s) *self;                                         \
+    char      align[M_ALIGN_FOR_CACHELINE_EXCLUSION];                   \
+    M_C(name, _shard_t) shard[shard_count];                             \
+  } concurrent_t[1];                                                    \
+                                                                        \
+  typedef struct M_C(name, _s) *M_C(name, _ptr);                        \
+  typedef const struct M_C(name, _s) *M_C(name, _srcptr);               \
+                                                                        \
+  typedef type M_C(name, _type_t);                                      \
+                                                                        \
+  /* Select the shard of a key. The dictionaries use the low bits of    \
+     the hash to select the bucket: use the high bits of a mixed hash   \
+     so that each shard still sees well distributed hashes. */          \
+  static inline size_t                                                  \
+  M_C(name, _shard_index)(M_GET_KEY_TYPE oplist const key)              \
+  {                                                                     \
+    uint64_t h = (uint64_t) M_CALL_HASH(M_GET_KEY_OPLIST oplist, key);  \
+    h *= 0x9E3779B97F4A7C15ULL;                                         \
+    return (size_t) (h >> 32) % (shard_count);                          \
+  }                                                                     \
+                                                                        \
+  static inline M_C(name, _shard_t) *                                   \
+  M_C(name, _shard_lock)(const concurrent_t out, M_GET_KEY_TYPE oplist const key) \
+  {                                                                     \
+    M_C(name, _shard_t) *s = &out->self->shard[M_C(name, _shard_index)(key)]; \
+    m_mutex_lock (s->lock);                                             \
+    return s;                                                           \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _init)(concurrent_t out)                                    \
+  {                                                                     \
+    assert (out != NULL);                                               \
+    for(size_t i = 0; i < (shard_count); i++) {                         \
+      m_mutex_init(out->shard[i].lock);                                 \
+      m_cond_init(out->shard[i].there_is_data);                         \
+      M_CALL_INIT(oplist, out->shard[i].data);                          \
+    }                                                                   \
+    out->self = out;                                                    \
+    CONCURRENTI_SHARDED_CONTRACT(out);                                  \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _clear)(concurrent_t out)                                   \
+  {                                                                     \
+    CONCURRENTI_SHARDED_CONTRACT(out);                                  \
+    /* No need to lock */                                               \
+    for(size_t i = 0; i < (shard_count); i++) {                         \
+      M_CALL_CLEAR(oplist, out->shard[i].data);                         \
+      m_mutex_clear(out->shard[i].lock);                                \
+      m_cond_clear(out->shard[i].there_is_data);                        \
+    }                                                                   \
+    out->self = NULL;                                                   \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _clean)(concurrent_t out)                                   \
+  {                                                                     \
+    CONCURRENTI_SHARDED_CONTRACT(out);                                  \
+    for(size_t i = 0; i < (shard_count); i++) {                         \
+      m_mutex_lock (out->shard[i].lock);                                \
+      M_CALL_CLEAN(oplist, out->shard[i].data);                         \
+      m_mutex_unlock (out->shard[i].lock);                              \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  /* The size is computed shard by shard: it is only a snapshot if no   \
+     other thread modifies the container at the same time. */           \
+  static inline size_t                                                  \
+  M_C(name, _size)(const concurrent_t out)                              \
+  {                                                                     \
+    CONCURRENTI_SHARDED_CONTRACT(out);                                  \
+    size_t r = 0;                                                       \
+    for(size_t i = 0; i < (shard_count); i++) {                         \
+      M_C(name, _shard_t) *s = &out->self->shard[i];                    \
+      m_mutex_lock (s->lock);                                           \
+      r += M_CALL_GET_SIZE(oplist, s->data);                            \
+      m_mutex_unlock (s->lock);                                         \
+    }                                                                   \
+    return r;                                                           \
+  }                                                                     \
+                                                                        \
+  static inline bool                                                    \
+  M_C(name, _empty_p)(const concurrent_t out)                           \
+  {                                                                     \
+    return M_C(name, _size)(out) == 0;                                  \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _set_at)(concurrent_t out, M_GET_KEY_TYPE oplist const key, M_GET_VALUE_TYPE oplist const data) \
+  {                                                                     \
+    CONCURRENTI_SHARDED_CONTRACT(out);                                  \
+    M_C(name, _shard_t) *s = M_C(name, _shard_lock)(out, key);          \
+    M_CALL_SET_KEY(oplist, s->data, key, data);                         \
+    m_cond_broadcast(s->there_is_data);                                 \
+    m_mutex_unlock (s->lock);                                           \
+  }                                                                     \
+                                                                        \
+  static inline bool                                                    \
+  M_C(name, _get_copy)(M_GET_VALUE_TYPE oplist *out_data, const concurrent_t out, M_GET_KEY_TYPE oplist const key) \
+  {                                                                     \
+    CONCURRENTI_SHARDED_CONTRACT(out);                                  \
+    assert (out_data != NULL);                                          \
+    M_C(name, _shard_t) *s = M_C(name, _shard_lock)(out, key);          \
+    M_GET_VALUE_TYPE oplist *p = M_CALL_GET_KEY(oplist, s->data, key);  \
+    if (p != NULL) {                                                    \
+      M_CALL_SET(M_GET_VALUE_OPLIST oplist, *out_data, *p);             \
+    }                                                                   \
+    m_mutex_unlock (s->lock);                                           \
+    return p != NULL;                                                   \
+  }                                                                     \
+                                                                        \
+  M_IF_METHOD(GET_SET_KEY, oplist)(                                     \
+  static inline void                                                    \
+  M_C(name, _get_at_copy)(M_GET_VALUE_TYPE oplist *out_data, concurrent_t out, M_GET_KEY_TYPE oplist const key) \
+  {                                                                     \
+    CONCURRENTI_SHARDED_CONTRACT(out);                                  \
+    assert (out_data != NULL);                                          \
+    M_C(name, _shard_t) *s = M_C(name, _shard_lock)(out, key);          \
+    M_GET_VALUE_TYPE oplist *p = M_CALL_GET_SET_KEY(oplist, s->data, key); \
+    assert (p != NULL);                                                 \
+    M_CALL_SET(M_GET_VALUE_OPLIST oplist, *out_data, *p);               \
+    m_mutex_unlock (s->lock);                                           \
+  }                                                                     \
+  ,)                                                                    \
+                                                                        \
+  static inline bool                                                    \
+  M_C(name, _erase)(concurrent_t out, M_GET_KEY_TYPE oplist const key)  \
+  {                                                                     \
+    CONCURRENTI_SHARDED_CONTRACT(out);                                  \
+    M_C(name, _shard_t) *s = M_C(name, _shard_lock)(out, key);          \
+    bool b = M_CALL_ERASE_KEY(oplist, s->data, key);                    \
+    m_mutex_unlock (s->lock);                                           \
+    return b;                                                           \
+  }                                                                     \
+                                                                        \
+  static inline bool                                                    \
+  M_C(name, _get_blocking)(M_GET_VALUE_TYPE oplist *out_data, const concurrent_t out, M_GET_KEY_TYPE oplist const key, bool blocking) \
+  {                                                                     \
+    CONCURRENTI_SHARDED_CONTRACT(out);                                  \
+    assert (out_data != NULL);                                          \
+    bool ret = false;                                                   \
+    M_C(name, _shard_t) *s = M_C(name, _shard_lock)(out, key);          \
+    while (true) {                                                      \
+      M_GET_VALUE_TYPE oplist *p = M_CALL_GET_KEY(oplist, s->data, key); \
+      if (p != NULL) {                                                  \
+        M_CALL_SET(M_GET_VALUE_OPLIST oplist, *out_data, *p);           \
+        ret = true;                                                     \
+        break;                                                          \
+      }                                                                 \
+      if (blocking == false) break;                                     \
+      /* Only a set_at on the same shard can provide the key */         \
+      m_cond_wait(s->there_is_data, s->lock);                           \
+    }                                                                   \
+    m_mutex_unlock (s->lock);                                           \
+    return ret;                                                         \
+  }
+
+
 #endif
@@ -44,6 +44,21 @@
 # include <stdio.h>
 #endif
 
+/* Expand to its arguments only if stdio is used: wrap the generated
+   methods needing FILE (which cannot use an #if) */
+#if M_USE_STDIO
+# define M_IF_STDIO(...) __VA_ARGS__
+#else
+# define M_IF_STDIO(...)
+#endif
+
+/* By default, use the SIMD instructions of the target if they are available
+   (SSE2 or AVX2). Can be turned off to get the portable code by defining
+   M_USE_SIMD to 0 */
+#ifndef M_USE_SIMD
+# define M_USE_SIMD 1
+#endif
+
 
 /***************************************************************/
 /************************ Compiler Macro ***********************/
@@ -1773,6 +1788,28 @@ static inline unsigned int m_core_clz64(uint64_t limb)
 }
 #endif
 
+/* Return the count trailing zero of the argument */
+#if defined(__GNUC__) && (__GNUC__*100 + __GNUC_MINOR__) >= 304
+static inline unsigned int m_core_ctz32(uint32_t limb)
+{
+  return M_UNLIKELY (limb == 0) ? sizeof(uint32_t)*CHAR_BIT : (unsigned int) __builtin_ctzl(limb);
+}
+static inline unsigned int m_core_ctz64(uint64_t limb)
+{
+  return M_UNLIKELY (limb == 0ULL) ? sizeof (uint64_t)*CHAR_BIT : (unsigned int) __builtin_ctzll(limb);
+}
+#else
+/* Isolate the lowest bit set and count the leading zero */
+static inline unsigned int m_core_ctz32(uint32_t limb)
+{
+  return M_UNLIKELY (limb == 0) ? sizeof(uint32_t)*CHAR_BIT : sizeof(uint32_t)*CHAR_BIT - 1 - m_core_clz32(limb & (~limb + 1));
+}
+static inline unsigned int m_core_ctz64(uint64_t limb)
+{
+  return M_UNLIKELY (limb == 0ULL) ? sizeof(uint64_t)*CHAR_BIT : sizeof(uint64_t)*CHAR_BIT - 1 - m_core_clz64(limb & (~limb + 1));
+}
+#endif
+
 /* Implement a kind of FNV1A Hash.
    Inspired by http://www.sanmayce.com/Fastest_Hash/ Jesteress and port to 64 bits.
    See https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function#FNV-1a_hash
@@ -1895,6 +1932,7 @@ m_core_hash (const void *str, size_t length)
 #define M_FREE_FREE(a)           ,a,
 #define M_MEMPOOL_MEMPOOL(a)     ,a,
 #define M_MEMPOOL_LINKAGE_MEMPOOL_LINKAGE(a)     ,a,
+#define M_MEMPOOL_TCACHE_MEMPOOL_TCACHE(a)     ,a,
 #define M_HASH_HASH(a)           ,a,
 #define M_EQUAL_EQUAL(a)         ,a,
 #define M_CMP_CMP(a)             ,a,
@@ -1951,6 +1989,7 @@ m_core_hash (const void *str, size_t length)
 #define M_INC_ALLOC_INC_ALLOC(a) ,a,
 #define M_OOR_SET_OOR_SET(a)     ,a,
 #define M_OOR_EQUAL_OOR_EQUAL(a) ,a,
+#define M_RADIX_KEY_RADIX_KEY(a) ,a,
 
 /* From an oplist - an unorded list of methods : like "INIT(mpz_init),CLEAR(mpz_clear),SET(mpz_set)" -
    Return the given method in the oplist or the default method.
@@ -1975,6 +2014,7 @@ m_core_hash (const void *str, size_t length)
 #define M_GET_FREE(...)      M_GET_METHOD(FREE,        M_FREE_DEFAULT,     __VA_ARGS__)
 #define M_GET_MEMPOOL(...)   M_GET_METHOD(MEMPOOL,     M_NO_DEFAULT,       __VA_ARGS__)
 #define M_GET_MEMPOOL_LINKAGE(...)   M_GET_METHOD(MEMPOOL_LINKAGE, ,       __VA_ARGS__)
+#define M_GET_MEMPOOL_TCACHE(...)    M_GET_METHOD(MEMPOOL_TCACHE, M_NO_DEFAULT, __VA_ARGS__)
 #define M_GET_HASH(...)      M_GET_METHOD(HASH,        M_NO_DEFAULT,       __VA_ARGS__)
 #define M_GET_EQUAL(...)     M_GET_METHOD(EQUAL,       M_EQUAL_DEFAULT,    __VA_ARGS__)
 #define M_GET_CMP(...)       M_GET_METHOD(CMP,         M_CMP_DEFAULT,      __VA_ARGS__)
@@ -2032,6 +2072,7 @@ m_core_hash (const void *str, size_t length)
 #define M_GET_INC_ALLOC(...) M_GET_METHOD(INC_ALLOC,   M_INC_ALLOC_DEFAULT, __VA_ARGS__)
 #define M_GET_OOR_SET(...)   M_GET_METHOD(OOR_SET,     M_NO_DEFAULT,       __VA_ARGS__)
 #define M_GET_OOR_EQUAL(...) M_GET_METHOD(OOR_EQUAL,   M_NO_DEFAULT,       __VA_ARGS__)
+#define M_GET_RADIX_KEY(...) M_GET_METHOD(RADIX_KEY,   M_NO_DEFAULT,       __VA_ARGS__)
 
 // Calling method with support of defined transformation API
 #define M_CALL_INIT(oplist, ...) M_APPLY_API(M_GET_INIT oplist, oplist, __VA_ARGS__)
@@ -2048,6 +2089,7 @@ m_core_hash (const void *str, size_t length)
 #define M_CALL_FREE(oplist, ...) M_APPLY_API(M_GET_FREE oplist, oplist, __VA_ARGS__)
 #define M_CALL_MEMPOOL(oplist, ...) M_APPLY_API(M_GET_MEMPOOL oplist, oplist, __VA_ARGS__)
 #define M_CALL_MEMPOOL_LINKAGE(oplist, ...) M_APPLY_API(M_GET_MEMPOOL_LINKAGE oplist, oplist, __VA_ARGS__)
+#define M_CALL_MEMPOOL_TCACHE(oplist, ...) M_APPLY_API(M_GET_MEMPOOL_TCACHE oplist, oplist, __VA_ARGS__)
 #define M_CALL_HASH(oplist, ...) M_APPLY_API(M_GET_HASH oplist, oplist, __VA_ARGS__)
 #define M_CALL_EQUAL(oplist, ...) M_APPLY_API(M_GET_EQUAL oplist, oplist, __VA_ARGS__)
 #define M_CALL_CMP(oplist, ...) M_APPLY_API(M_GET_CMP oplist, oplist, __VA_ARGS__)
@@ -2099,6 +2141,7 @@ m_core_hash (const void *str, size_t length)
 #define M_CALL_INC_ALLOC(oplist, ...) M_APPLY_API(M_GET_INC_ALLOC oplist, oplist, __VA_ARGS__)
 #define M_CALL_OOR_SET(oplist, ...) M_APPLY_API(M_GET_OOR_SET oplist, oplist, __VA_ARGS__)
 #define M_CALL_OOR_EQUAL(oplist, ...) M_APPLY_API(M_GET_OOR_EQUAL oplist, oplist, __VA_ARGS__)
+#define M_CALL_RADIX_KEY(oplist, ...) M_APPLY_API(M_GET_RADIX_KEY oplist, oplist, __VA_ARGS__)
 
 /* API transformation support:
    transform the call to the method into the supported API by the method.
@@ -2314,6 +2357,13 @@ m_core_hash (const void *str, size_t length)
 #define M_TEST_METHOD2_P(method_pair, oplist)                           \
   M_AND(M_TEST_METHOD_P(M_PAIR_1 method_pair, oplist), M_TEST_METHOD_P(M_PAIR_2 method_pair, oplist))
 
+/* Return the macro to use to define the mempool of a container
+   which oplist has the MEMPOOL method: the thread caching mempool
+   if the oplist has also the MEMPOOL_TCACHE method.
+   Example: M_MEMPOOL_DEF_SELECT(oplist)(name, type) */
+#define M_MEMPOOL_DEF_SELECT(oplist)                                    \
+  M_IF_METHOD(MEMPOOL_TCACHE, oplist)(MEMPOOL_TCACHE_DEF, MEMPOOL_DEF)
+
 /* By putting this after a method in an oplist, we transform the argument list
    so that the first argument becomes a pointer to the destination. */
 #define M_IPTR(...) ( & __VA_ARGS__ )
@@ -2687,6 +2737,9 @@ typedef struct m_serial_write_interface_s {
   m_serial_return_code_t (*write_tuple_end)(m_serial_local_t, m_serial_write_t);
   m_serial_return_code_t (*write_variant_start)(m_serial_local_t, m_serial_write_t, const char * const field_name[], const int max, const int index);
   m_serial_return_code_t (*write_variant_end)(m_serial_local_t, m_serial_write_t);
+  /* true if write_array_start & write_map_start need the real number of
+     elements of a non empty array (false if 0 can be given if unknown) */
+  bool need_count;
 } m_serial_write_interface_t;
 
 /* Convert a C default variale (bool, integer, float) to a Serialized data.
@@ -2767,4 +2820,227 @@ M_IN_SERIAL_DEFAULT_TYPE_DEF(m_core_in_serial_float, float, read_float, long dou
 M_IN_SERIAL_DEFAULT_TYPE_DEF(m_core_in_serial_double, double, read_float, long double)
 M_IN_SERIAL_DEFAULT_TYPE_DEF(m_core_in_serial_ldouble, long double, read_float, long double)
 
+/* Object to stream a sequence of elements through a serial object
+   a few elements at a time, without building the container holding them.
+   The sequence is seen as an array (or a map for pairs of key / value)
+   by the format, so that it can be read back by the _in_serial method
+   of a container (and a container can be read as a stream).
+   USAGE (writing):
+     m_serial_stream_write_start(stream, serial, n, false);
+     for each element, as it is produced:
+       M_SERIAL_STREAM_WRITE(stream, serial, oplist, element);
+     m_serial_stream_write_end(stream, serial);
+   USAGE (reading):
+     ret = m_serial_stream_read_start(stream, serial, false);
+     while (ret == M_SERIAL_OK_CONTINUE) {
+       ret = M_SERIAL_STREAM_READ(stream, serial, oplist, element);
+       if (ret == M_SERIAL_FAIL) break;
+       use element;
+     }
+*/
+typedef struct m_serial_stream_s {
+  m_serial_local_t local;
+  size_t           size;        // Number of elements announced by the stream (0 if unknown)
+  size_t           count;       // Number of elements written / read so far
+  bool             map;         // The elements are pairs of key / value
+} m_serial_stream_t[1];
+
+/* Start writing a stream of 'n' elements into 'serial'
+   (0 if the number of elements is not known: not supported by all
+   formats for non empty streams, see the format: the binary format
+   fails when an element is written into a stream announced empty).
+   Return M_SERIAL_OK_CONTINUE if it succeeds, M_SERIAL_FAIL otherwise */
+static inline m_serial_return_code_t
+m_serial_stream_write_start(m_serial_stream_t stream, m_serial_write_t serial, size_t n, bool map)
+{
+  assert (stream != NULL && serial != NULL && serial->interface != NULL);
+  stream->size  = n;
+  stream->count = 0;
+  stream->map   = map;
+  m_serial_return_code_t ret = map
+    ? serial->interface->write_map_start(stream->local, serial, n)
+    : serial->interface->write_array_start(stream->local, serial, n);
+  return ret == M_SERIAL_FAIL ? M_SERIAL_FAIL : M_SERIAL_OK_CONTINUE;
+}
+
+/* Write the separator needed before the next element of the stream */
+static inline m_serial_return_code_t
+m_serial_stream_write_next(m_serial_stream_t stream, m_serial_write_t serial)
+{
+  assert (stream != NULL && serial != NULL && serial->interface != NULL);
+  assert (stream->size == 0 || stream->count < stream->size);
+  if (stream->count++ == 0)
+    return M_SERIAL_OK_CONTINUE;
+  return stream->map
+    ? serial->interface->write_map_next(stream->local, serial)
+    : serial->interface->write_array_next(stream->local, serial);
+}
+
+/* End writing the stream.
+   Return M_SERIAL_OK_DONE if it succeeds, M_SERIAL_FAIL otherwise */
+static inline m_serial_return_code_t
+m_serial_stream_write_end(m_serial_stream_t stream, m_serial_write_t serial)
+{
+  assert (stream != NULL && serial != NULL && serial->interface != NULL);
+  assert (stream->size == 0 || stream->count == stream->size);
+  m_serial_return_code_t ret = stream->map
+    ? serial->interface->write_map_end(stream->local, serial)
+    : serial->interface->write_array_end(stream->local, serial);
+  return ret == M_SERIAL_FAIL ? M_SERIAL_FAIL : M_SERIAL_OK_DONE;
+}
+
+/* Write the object 'obj' of oplist 'oplist' as the next element of the stream.
+   Return M_SERIAL_OK_CONTINUE if it succeeds, M_SERIAL_FAIL otherwise */
+#define M_SERIAL_STREAM_WRITE(stream, serial, oplist, obj)              \
+  ((m_serial_stream_write_next(stream, serial) == M_SERIAL_FAIL         \
+    || M_CALL_OUT_SERIAL(oplist, serial, obj) == M_SERIAL_FAIL)         \
+   ? M_SERIAL_FAIL : M_SERIAL_OK_CONTINUE)
+
+/* Write the pair ('key', 'value') as the next element of a stream of pairs.
+   Return M_SERIAL_OK_CONTINUE if it succeeds, M_SERIAL_FAIL otherwise */
+#define M_SERIAL_STREAM_WRITE_PAIR(stream, serial, key_oplist, key, value_oplist, value) \
+  ((m_serial_stream_write_next(stream, serial) == M_SERIAL_FAIL         \
+    || M_CALL_OUT_SERIAL(key_oplist, serial, key) == M_SERIAL_FAIL      \
+    || (serial)->interface->write_map_value((stream)->local, serial) == M_SERIAL_FAIL \
+    || M_CALL_OUT_SERIAL(value_oplist, serial, value) == M_SERIAL_FAIL) \
+   ? M_SERIAL_FAIL : M_SERIAL_OK_CONTINUE)
+
+/* Start reading a stream of elements (or of pairs if 'map') from 'serial'.
+   The number of elements announced by the stream (or 0) is set in stream->size.
+   Return M_SERIAL_OK_CONTINUE if some elements follow,
+   M_SERIAL_OK_DONE if the stream is empty, M_SERIAL_FAIL otherwise */
+static inline m_serial_return_code_t
+m_serial_stream_read_start(m_serial_stream_t stream, m_serial_read_t serial, bool map)
+{
+  assert (stream != NULL && serial != NULL && serial->interface != NULL);
+  stream->size  = 0;
+  stream->count = 0;
+  stream->map   = map;
+  return map
+    ? serial->interface->read_map_start(stream->local, serial, &stream->size)
+    : serial->interface->read_array_start(stream->local, serial, &stream->size);
+}
+
+/* Read the separator following an element which reading returned 'ret' */
+static inline m_serial_return_code_t
+m_serial_stream_read_next(m_serial_stream_t stream, m_serial_read_t serial, m_serial_return_code_t ret)
+{
+  assert (stream != NULL && serial != NULL && serial->interface != NULL);
+  if (ret != M_SERIAL_OK_DONE)
+    return M_SERIAL_FAIL;
+  stream->count++;
+  return stream->map
+    ? serial->interface->read_map_next(stream->local, serial)
+    : serial->interface->read_array_next(stream->local, serial);
+}
+
+/* Read the separator between the key (which reading returned 'ret')
+   and the value of a pair */
+static inline m_serial_return_code_t
+m_serial_stream_read_value(m_serial_stream_t stream, m_serial_read_t serial, m_serial_return_code_t ret)
+{
+  assert (stream != NULL && serial != NULL && serial->interface != NULL);
+  assert (stream->map);
+  if (ret != M_SERIAL_OK_DONE)
+    return M_SERIAL_FAIL;
+  return serial->interface->read_map_value(stream->local, serial);
+}
+
+/* Read the next element of the stream into the initialized object 'obj'.
+   Return M_SERIAL_OK_CONTINUE if it succeeds and other elements follow,
+   M_SERIAL_OK_DONE if it succeeds and it was the last element,
+   M_SERIAL_FAIL otherwise */
+#define M_SERIAL_STREAM_READ(stream, serial, oplist, obj)               \
+  m_serial_stream_read_next(stream, serial, M_CALL_IN_SERIAL(oplist, obj, serial))
+
+/* Read the next pair of the stream into the initialized objects 'key' & 'value'.
+   Same return code as M_SERIAL_STREAM_READ */
+#define M_SERIAL_STREAM_READ_PAIR(stream, serial, key_oplist, key, value_oplist, value) \
+  m_serial_stream_read_next(stream, serial,                             \
+     m_serial_stream_read_value(stream, serial,                         \
+                                M_CALL_IN_SERIAL(key_oplist, key, serial)) \
+     == M_SERIAL_OK_CONTINUE                                            \
+     ? M_CALL_IN_SERIAL(value_oplist, value, serial) : M_SERIAL_FAIL)
+
+
+/************************************************************/
+/*********************** Raw images ************************/
+/************************************************************/
+
+/* A container of POD types (without pointers) can write its internal
+   table as is after a small header (the raw image, _out_mmap method)
+   so that this image can later be mapped in memory and used in place
+   without any parsing (_init_mmap method).
+   The image is only valid for the same types, the same architecture
+   (size & byte order) and the same hash function (for the dictionaries). */
+#define M_CORE_MMAP_MAGIC   "M*LIBIMG"
+#define M_CORE_MMAP_VERSION 1U
+#define M_CORE_MMAP_ENDIAN  0x01020304U
+
+/* Kind of container stored in the image */
+#define M_CORE_MMAP_ARRAY   1U
+#define M_CORE_MMAP_DICT_OA 2U
+
+/* The table of the image is aligned on 64 bytes from the start of the image */
+typedef union m_core_mmap_header_u {
+  struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t kind;
+    uint32_t endian;    // M_CORE_MMAP_ENDIAN in the byte order of the writer
+    uint32_t reserved;
+    uint64_t elt_size;  // Size of one slot of the table
+    uint64_t count;     // Number of elements of the container
+    uint64_t capacity;  // Number of slots of the table
+    uint64_t seed;      // Hash seed used to fill the table (0 if none)
+  } s;
+  char align[64];
+} m_core_mmap_header_t;
+
+#if M_USE_STDIO
+/* Write the image of a container of the given kind to 'f'.
+   Return true in case of success. */
+static inline bool
+m_core_mmap_write(FILE *f, uint32_t kind, size_t elt_size, size_t count,
+                  size_t capacity, uint64_t seed, const void *table)
+{
+  m_core_mmap_header_t h;
+  memset(&h, 0, sizeof h);
+  memcpy(h.s.magic, M_CORE_MMAP_MAGIC, sizeof h.s.magic);
+  h.s.version = M_CORE_MMAP_VERSION;
+  h.s.kind = kind;
+  h.s.endian = M_CORE_MMAP_ENDIAN;
+  h.s.elt_size = elt_size;
+  h.s.count = count;
+  h.s.capacity = capacity;
+  h.s.seed = seed;
+  if (fwrite(&h, sizeof h, 1, f) != 1)
+    return false;
+  return capacity == 0 || fwrite(table, elt_size, capacity, f) == capacity;
+}
+#endif
+
+/* Check the image 'mem' of 'size' bytes against the given kind,
+   size of slot and seed. Return its table and set 'count'
+   and 'capacity', or NULL if the image is invalid. */
+static inline void *
+m_core_mmap_table(void *mem, size_t size, uint32_t kind, size_t elt_size,
+                  uint64_t seed, size_t *count, size_t *capacity)
+{
+  const m_core_mmap_header_t *h = (const m_core_mmap_header_t *) mem;
+  if (mem == NULL || size < sizeof *h
+      || memcmp(h->s.magic, M_CORE_MMAP_MAGIC, sizeof h->s.magic) != 0
+      || h->s.version != M_CORE_MMAP_VERSION
+      || h->s.endian != M_CORE_MMAP_ENDIAN
+      || h->s.kind != kind
+      || h->s.elt_size != elt_size
+      || h->s.seed != seed
+      || h->s.count > h->s.capacity
+      || h->s.capacity > (size - sizeof *h) / elt_size)
+    return NULL;
+  *count = (size_t) h->s.count;
+  *capacity = (size_t) h->s.capacity;
+  return (char *) mem + sizeof *h;
+}
+
 #endif
@@ -583,7 +583,7 @@
 	return;								\
       }									\
       it->node = n;							\
-      it->index = 0;							\
+      it->index = n->size - 1;						\
     }									\
   }									\
 									\
@@ -703,7 +703,7 @@
   }									\
 									\
   static inline type*							\
-  M_C(name, _get)(deque_t d, size_t key)				\
+  M_C(name, _get)(const deque_t d, size_t key)			\
   {									\
     DEQUEI_CONTRACT(d);							\
     assert (key < d->count);						\
@@ -724,7 +724,7 @@
   }									\
 									\
   static inline type const *						\
-  M_C(name, _cget)(deque_t d, size_t key)				\
+  M_C(name, _cget)(const deque_t d, size_t key)			\
   {									\
     return M_CONST_CAST(type, M_C(name, _get)(d, key));			\
   }									\
@@ -983,6 +983,7 @@
    ,M_IF_METHOD(HASH, oplist)(HASH(M_C(name, _hash)),)			\
    ,M_IF_METHOD(NEW, oplist)(NEW(M_GET_NEW oplist),)                    \
    ,M_IF_METHOD(REALLOC, oplist)(REALLOC(M_GET_REALLOC oplist),)        \
+   ,M_IF_METHOD(FREE, oplist)(FREE(M_GET_FREE oplist),)                 \
    ,M_IF_METHOD(DEL, oplist)(DEL(M_GET_DEL oplist),)                    \
    )
 
@@ -79,7 +79,23 @@
                    (name, key_type, __VA_ARGS__)))
 
 
-/* Define the oplist of a dictionnary (DICT_DEF2, DICT_STOREHASH_DEF2 or DICT_OA_DEF2).
+/*  Define a dictionary with the key key_type to the value value_type
+    with an Open Addressing implementation using control bytes
+    (scanned by group of slots using SIMD instructions if available)
+    and its associated functions.
+    KEY_OPLIST doesn't need the operators OOR_EQUAL & OOR_SET.
+   USAGE:
+     DICT_SWISS_DEF2(name, key_type, key_oplist, value_type, value_oplist)
+   OR
+     DICT_SWISS_DEF2(name, key_type, value_type)
+*/
+#define DICT_SWISS_DEF2(name, key_type, ...)                            \
+  DICTI_SWISS_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                        \
+                     ((name, key_type, M_GLOBAL_OPLIST_OR_DEF(key_type)(), __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)() ), \
+                      (name, key_type, __VA_ARGS__)))
+
+
+/* Define the oplist of a dictionnary (DICT_DEF2, DICT_STOREHASH_DEF2, DICT_OA_DEF2 or DICT_SWISS_DEF2).
    USAGE:
      DICT_OPLIST(name, oplist of the key type, oplist of the value type)
    OR
@@ -117,7 +133,8 @@
   (									\
    LIST_DEF(M_C(name, _list_pair), M_C(name, _pair_t),			\
 	    M_OPEXTEND(TUPLE_OPLIST(M_C(name, _pair), key_oplist, value_oplist), \
-		       MEMPOOL(M_GET_MEMPOOL key_oplist), MEMPOOL_LINKAGE(M_GET_MEMPOOL_LINKAGE key_oplist))) \
+		       MEMPOOL(M_GET_MEMPOOL key_oplist), MEMPOOL_LINKAGE(M_GET_MEMPOOL_LINKAGE key_oplist), \
+		       M_IF_METHOD(MEMPOOL_TCACHE, key_oplist)(MEMPOOL_TCACHE(M_GET_MEMPOOL_TCACHE key_oplist),))) \
    ,									\
    LIST_DEF(M_C(name, _list_pair), M_C(name, _pair_t),			\
 	    TUPLE_OPLIST(M_C(name, _pair), key_oplist, value_oplist))	\
@@ -144,7 +161,8 @@
   (									\
    LIST_DEF(M_C(name, _list_pair), M_C(name, _pair_t),			\
 	    M_OPEXTEND(TUPLE_OPLIST(M_C(name, _pair), key_oplist, value_oplist), \
-		       MEMPOOL(M_GET_MEMPOOL key_oplist), MEMPOOL_LINKAGE(M_GET_MEMPOOL_LINKAGE key_oplist))) \
+		       MEMPOOL(M_GET_MEMPOOL key_oplist), MEMPOOL_LINKAGE(M_GET_MEMPOOL_LINKAGE key_oplist), \
+		       M_IF_METHOD(MEMPOOL_TCACHE, key_oplist)(MEMPOOL_TCACHE(M_GET_MEMPOOL_TCACHE key_oplist),))) \
    ,									\
    LIST_DEF(M_C(name, _list_pair), M_C(name, _pair_t),			\
              TUPLE_OPLIST(M_C(name, _pair), M_DEFAULT_OPLIST, key_oplist, value_oplist)) \
@@ -169,7 +187,8 @@
   (									\
    LIST_DEF(M_C(name, _list_pair), M_C(name, _pair_t),			\
 	    M_OPEXTEND(TUPLE_OPLIST(M_C(name, _pair), key_oplist),	\
-		       MEMPOOL(M_GET_MEMPOOL key_oplist), MEMPOOL_LINKAGE(M_GET_MEMPOOL_LINKAGE key_oplist))) \
+		       MEMPOOL(M_GET_MEMPOOL key_oplist), MEMPOOL_LINKAGE(M_GET_MEMPOOL_LINKAGE key_oplist), \
+		       M_IF_METHOD(MEMPOOL_TCACHE, key_oplist)(MEMPOOL_TCACHE(M_GET_MEMPOOL_TCACHE key_oplist),))) \
    ,									\
    LIST_DEF(M_C(name, _list_pair), M_C(name, _pair_t), TUPLE_OPLIST(M_C(name, _pair), key_oplist)) \
   )                                                                     \
@@ -192,6 +211,12 @@
                                                                         \
   typedef struct M_C(name, _s) {					\
     size_t used, lower_limit, upper_limit;                              \
+    /* Incremental rehash: the buckets of index greater or equal to     \
+       rehash_limit are not split yet (their items are still in         \
+       the bucket of the lower half of the table).                      \
+       rehash_budget is the number of buckets to split per update       \
+       (0 to split all the buckets at once) */                          \
+    size_t rehash_limit, rehash_budget;                                 \
     M_C(name, _array_list_pair_t) table;				\
   } dict_t[1];                                                          \
                                                                         \
@@ -220,6 +245,8 @@
     M_C(name, _array_list_pair_resize)(map->table, DICTI_INITIAL_SIZE); \
     map->lower_limit = DICTI_LOWER_BOUND(DICTI_INITIAL_SIZE);           \
     map->upper_limit = DICTI_UPPER_BOUND(DICTI_INITIAL_SIZE);           \
+    map->rehash_limit = DICTI_INITIAL_SIZE;                             \
+    map->rehash_budget = 0;                                             \
     DICTI_CONTRACT(name, map);                                          \
   }                                                                     \
                                                                         \
@@ -231,6 +258,8 @@
     map->used = org->used;                                              \
     map->lower_limit = org->lower_limit;                                \
     map->upper_limit = org->upper_limit;                                \
+    map->rehash_limit = org->rehash_limit;                              \
+    map->rehash_budget = org->rehash_budget;                            \
     M_C(name, _array_list_pair_init_set)(map->table, org->table);	\
     DICTI_CONTRACT(name, map);                                          \
   }                                                                     \
@@ -243,6 +272,8 @@
     map->used = org->used;                                              \
     map->lower_limit = org->lower_limit;                                \
     map->upper_limit = org->upper_limit;                                \
+    map->rehash_limit = org->rehash_limit;                              \
+    map->rehash_budget = org->rehash_budget;                            \
     M_C(name, _array_list_pair_set)(map->table, org->table);		\
     DICTI_CONTRACT(name, map);                                          \
   }                                                                     \
@@ -261,6 +292,8 @@
     map->used = org->used;                                              \
     map->lower_limit = org->lower_limit;                                \
     map->upper_limit = org->upper_limit;                                \
+    map->rehash_limit = org->rehash_limit;                              \
+    map->rehash_budget = org->rehash_budget;                            \
     M_C(name, _array_list_pair_init_move)(map->table, org->table);	\
     DICTI_CONTRACT(name, map);                                          \
   }                                                                     \
@@ -273,6 +306,8 @@
     M_SWAP (size_t, d1->used, d2->used);                                \
     M_SWAP (size_t, d1->lower_limit, d2->lower_limit);                  \
     M_SWAP (size_t, d1->upper_limit, d2->upper_limit);                  \
+    M_SWAP (size_t, d1->rehash_limit, d2->rehash_limit);                \
+    M_SWAP (size_t, d1->rehash_budget, d2->rehash_budget);              \
     M_C(name, _array_list_pair_swap)(d1->table, d2->table);		\
     DICTI_CONTRACT(name, d1);                                           \
     DICTI_CONTRACT(name, d2);                                           \
@@ -296,6 +331,7 @@
     M_C(name, _array_list_pair_resize)(map->table, DICTI_INITIAL_SIZE); \
     map->lower_limit = DICTI_LOWER_BOUND(DICTI_INITIAL_SIZE);           \
     map->upper_limit = DICTI_UPPER_BOUND(DICTI_INITIAL_SIZE);           \
+    map->rehash_limit = DICTI_INITIAL_SIZE;                             \
     map->used = 0;                                                      \
     DICTI_CONTRACT(name, map);                                          \
   }                                                                     \
@@ -314,12 +350,26 @@
     return map->used;                                                   \
   }                                                                     \
                                                                         \
+  /* Return the index of the bucket of the given hash */                \
+  static inline size_t                                                  \
+  M_C(name, _int_index)(const dict_t map, size_t hash)                  \
+  {                                                                     \
+    const size_t size = M_C(name, _array_list_pair_size)(map->table);   \
+    size_t i = hash & (size - 1);                                       \
+    /* During an incremental rehash, the items of the buckets           \
+       which are not split yet are still in the lower half */           \
+    if (M_UNLIKELY (i >= map->rehash_limit)) {                          \
+      i -= size / 2;                                                    \
+    }                                                                   \
+    return i;                                                           \
+  }                                                                     \
+                                                                        \
   static inline value_type *                                            \
   M_C(name, _get)(const dict_t map, key_type const key)			\
   {                                                                     \
     DICTI_CONTRACT(name, map);                                          \
     size_t hash = M_CALL_HASH(key_oplist, key);                         \
-    size_t i = hash & (M_C(name, _array_list_pair_size)(map->table) - 1); \
+    size_t i = M_C(name, _int_index)(map, hash);                        \
     const M_C(name, _list_pair_t) *list_ptr =				\
       M_C(name, _array_list_pair_cget)(map->table, i);                  \
     M_C(name, _list_pair_it_t) it;					\
@@ -341,9 +391,52 @@
   }                                                                     \
                                                                         \
   static inline void                                                    \
+  M_C(name, _int_split)(dict_t map, size_t i, size_t old_size)          \
+  {                                                                     \
+    const size_t new_size = 2 * old_size;                               \
+    M_C(name, _list_pair_t) *list =                                     \
+      M_C(name, _array_list_pair_get)(map->table, i);                   \
+    if (M_C(name, _list_pair_empty_p)(*list))                           \
+      return;                                                           \
+    /* We need to scan each item and recompute its hash to know         \
+       if it remains inplace or shall be moved to the upper part.*/     \
+    M_C(name, _list_pair_it_t) it;                                      \
+    M_C(name, _list_pair_it)(it, *list);                                \
+    while (!M_C(name, _list_pair_end_p)(it)) {                          \
+      M_C(name, _pair_ptr) pair = *M_C(name, _list_pair_ref)(it);       \
+      size_t hash = M_IF(isStoreHash)(pair->hash, M_CALL_HASH(key_oplist, pair->key)); \
+      if ((hash & (new_size-1)) >= old_size) {                          \
+        assert( (hash & (new_size-1)) == (i + old_size));               \
+        M_C(name, _list_pair_t) *new_list =                             \
+          M_C(name, _array_list_pair_get)(map->table, i + old_size);    \
+        M_C(name, _list_pair_splice_back)(*new_list, *list, it);        \
+        /* Splice_back has updated the iterator to the next one */      \
+      } else {                                                          \
+        M_C(name, _list_pair_next)(it);                                 \
+      }                                                                 \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  static inline bool                                                    \
+  M_C(name, _int_rehash_step)(dict_t map, size_t budget)                \
+  {                                                                     \
+    /* NOTE: Contract may not be fullfilled here */                     \
+    const size_t size = M_C(name, _array_list_pair_size)(map->table);   \
+    const size_t old_size = size / 2;                                   \
+    while (map->rehash_limit < size && budget > 0) {                    \
+      M_C(name, _int_split)(map, map->rehash_limit - old_size, old_size); \
+      map->rehash_limit ++;                                             \
+      budget --;                                                        \
+    }                                                                   \
+    return map->rehash_limit == size;                                   \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
   M_C(name, _int_resize_up)(dict_t map)					\
   {                                                                     \
     /* NOTE: Contract may not be fullfilled here */                     \
+    /* First finish the pending rehash */                               \
+    M_C(name, _int_rehash_step)(map, SIZE_MAX);                         \
     size_t old_size = M_C(name, _array_list_pair_size)(map->table);	\
     size_t new_size = old_size * 2;                                     \
     if (M_UNLIKELY (new_size <= old_size)) {				\
@@ -351,38 +444,39 @@
     }									\
     /* Resize the table of the dictionnary */				\
     M_C(name, _array_list_pair_resize)(map->table, new_size);		\
-    /* Move the items to the new upper part */                          \
-    for(size_t i = 0; i < old_size; i++) {                              \
-      M_C(name, _list_pair_t) *list =					\
-        M_C(name, _array_list_pair_get)(map->table, i);			\
-      if (M_C(name, _list_pair_empty_p)(*list))				\
-        continue;                                                       \
-      /* We need to scan each item and recompute its hash to know       \
-         if it remains inplace or shall be moved to the upper part.*/   \
-      M_C(name, _list_pair_it_t) it;					\
-      M_C(name, _list_pair_it)(it, *list);				\
-      while (!M_C(name, _list_pair_end_p)(it)) {			\
-        M_C(name, _pair_ptr) pair = *M_C(name, _list_pair_ref)(it);	\
-        size_t hash = M_IF(isStoreHash)(pair->hash, M_CALL_HASH(key_oplist, pair->key)); \
-        if ((hash & (new_size-1)) >= old_size) {                        \
-          assert( (hash & (new_size-1)) == (i + old_size));             \
-          M_C(name, _list_pair_t) *new_list =				\
-            M_C(name, _array_list_pair_get)(map->table, i + old_size);	\
-          M_C(name, _list_pair_splice_back)(*new_list, *list, it);	\
-          /* Splice_back has updated the iterator to the next one */    \
-        } else {                                                        \
-          M_C(name, _list_pair_next)(it);				\
-        }                                                               \
-      }                                                                 \
-    }                                                                   \
+    /* Move the items to the new upper part:                            \
+       either now or incrementally by the next updates */               \
+    map->rehash_limit = old_size;                                       \
+    M_C(name, _int_rehash_step)(map, map->rehash_budget == 0 ? old_size : map->rehash_budget); \
     map->upper_limit = DICTI_UPPER_BOUND(new_size);                     \
     map->lower_limit = DICTI_LOWER_BOUND(new_size);                     \
   }                                                                     \
                                                                         \
+  static inline bool                                                    \
+  M_C(name, _rehash_step)(dict_t map, size_t budget)                    \
+  {                                                                     \
+    DICTI_CONTRACT(name, map);                                          \
+    return M_C(name, _int_rehash_step)(map, budget);                    \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _incremental_rehash)(dict_t map, size_t budget)             \
+  {                                                                     \
+    DICTI_CONTRACT(name, map);                                          \
+    if (budget == 0) {                                                  \
+      /* Back to the default mode: finish the pending rehash */         \
+      M_C(name, _int_rehash_step)(map, SIZE_MAX);                       \
+    }                                                                   \
+    map->rehash_budget = budget;                                        \
+    DICTI_CONTRACT(name, map);                                          \
+  }                                                                     \
+                                                                        \
   static inline void                                                    \
   M_C(name, _int_resize_down)(dict_t map)				\
   {                                                                     \
     /* NOTE: Contract may not be fullfilled here */                     \
+    /* First finish the pending rehash */                               \
+    M_C(name, _int_rehash_step)(map, SIZE_MAX);                         \
     size_t old_size = M_C(name, _array_list_pair_size)(map->table);	\
     assert ((old_size % 2) == 0);                                       \
     size_t new_size = old_size / 2;                                     \
@@ -400,6 +494,7 @@
     }                                                                   \
     /* Resize the table of the dictionary */                            \
     M_C(name, _array_list_pair_resize)(map->table, new_size);		\
+    map->rehash_limit = new_size;                                       \
     map->upper_limit = DICTI_UPPER_BOUND(new_size);                     \
     map->lower_limit = DICTI_LOWER_BOUND(new_size);                     \
   }                                                                     \
@@ -410,9 +505,10 @@
         M_IF(isSet)(, M_DEFERRED_COMMA value_type const value))         \
   {                                                                     \
     DICTI_CONTRACT(name, map);                                          \
+    M_C(name, _int_rehash_step)(map, map->rehash_budget);               \
 									\
     size_t hash = M_CALL_HASH(key_oplist, key);                         \
-    size_t i = hash & (M_C(name, _array_list_pair_size)(map->table) - 1); \
+    size_t i = M_C(name, _int_index)(map, hash);                        \
     M_C(name, _list_pair_t) *list_ptr =					\
       M_C(name, _array_list_pair_get)(map->table, i);                   \
     M_C(name, _list_pair_it_t) it;					\
@@ -440,9 +536,10 @@
   M_C(name, _get_at)(dict_t map, key_type const key)                    \
   {                                                                     \
     DICTI_CONTRACT(name, map);                                          \
+    M_C(name, _int_rehash_step)(map, map->rehash_budget);               \
 									\
     size_t hash = M_CALL_HASH(key_oplist, key);                         \
-    size_t i = hash & (M_C(name, _array_list_pair_size)(map->table) - 1); \
+    size_t i = M_C(name, _int_index)(map, hash);                        \
     M_C(name, _list_pair_t) *list_ptr =					\
       M_C(name, _array_list_pair_get)(map->table, i);                   \
     M_C(name, _list_pair_it_t) it;					\
@@ -473,10 +570,11 @@
   M_C(name, _erase)(dict_t map, key_type const key)			\
   {                                                                     \
     DICTI_CONTRACT(name, map);                                          \
+    M_C(name, _int_rehash_step)(map, map->rehash_budget);               \
                                                                         \
     bool ret = false;                                                   \
     size_t hash = M_CALL_HASH(key_oplist, key);                         \
-    size_t i = hash & (M_C(name, _array_list_pair_size)(map->table) - 1); \
+    size_t i = M_C(name, _int_index)(map, hash);                        \
     M_C(name, _list_pair_t) *list_ptr =					\
       M_C(name, _array_list_pair_get)(map->table, i);                   \
     M_C(name, _list_pair_it_t) it;					\
@@ -953,6 +1051,7 @@
    ,M_IF_METHOD(EQUAL, value_oplist)(EQUAL(M_C(name, _equal_p)),)	\
    ,M_IF_METHOD(NEW, oplist)(NEW(M_GET_NEW key_oplist),)                \
    ,M_IF_METHOD(REALLOC, oplist)(REALLOC(M_GET_REALLOC key_oplist),)    \
+   ,M_IF_METHOD(FREE, oplist)(FREE(M_GET_FREE key_oplist),)             \
    ,M_IF_METHOD(DEL, oplist)(DEL(M_GET_DEL key_oplist),)                \
    )
 
@@ -1002,6 +1101,7 @@
    ,EQUAL(M_C(name, _equal_p)),                                         \
    ,M_IF_METHOD(NEW, oplist)(NEW(M_GET_NEW oplist),)                    \
    ,M_IF_METHOD(REALLOC, oplist)(REALLOC(M_GET_REALLOC oplist),)        \
+   ,M_IF_METHOD(FREE, oplist)(FREE(M_GET_FREE oplist),)                 \
    ,M_IF_METHOD(DEL, oplist)(DEL(M_GET_DEL oplist),)                    \
    )
 
@@ -1015,6 +1115,8 @@
     assert(map->upper_limit >= DICTI_UPPER_BOUND(DICTI_INITIAL_SIZE));  \
     assert(map->used >= map->lower_limit);                              \
     assert(M_POWEROF2_P(M_C(name, _array_list_pair_size)(map->table))); \
+    assert(map->rehash_limit <= M_C(name, _array_list_pair_size)(map->table)); \
+    assert(2*map->rehash_limit >= M_C(name, _array_list_pair_size)(map->table)); \
   } while (0)
 
 
@@ -1022,14 +1124,19 @@
 /* Open Addressing implementation */
 /****************************************************************************************/
 
+/* NOTE: The container doesn't use the DELETED representation anymore
+   (erasing an item doesn't leave any tombstone), but the keys still
+   can't be equal to it. */
 typedef enum {
   DICTI_OA_EMPTY = 0, DICTI_OA_DELETED = 1
 } dicti_oa_element_t;
 
-/* Performing Quadratic probing
-   Replace it by '1' to perform linear probing */
-#ifndef DICTI_OA_PROBING
-#define DICTI_OA_PROBING(s) ((s)++)
+/* The table performs linear probing: the backward shift deletion
+   of the items relies on it. The probing sequence used to be
+   configurable with DICTI_OA_PROBING (quadratic by default):
+   this is no longer possible. */
+#ifdef DICTI_OA_PROBING
+# error "DICTI_OA_PROBING is no longer supported: DICT_OA_DEF2 always performs linear probing (needed by the tombstone free deletion). Remove its definition."
 #endif
 
 #define DICTI_OA_CONTRACT(dict) do {					\
@@ -1062,7 +1169,7 @@ typedef enum {
              INIT_SET(M_MEMCPY_DEFAULT), CLEAR(M_NOTHING_DEFAULT)))     \
                                                                         \
   typedef struct M_C(name,_s) {						\
-    size_t mask, count, count_delete;                                   \
+    size_t mask, count;                                                 \
     size_t upper_limit, lower_limit;                                    \
     M_C(name, _pair_t) *data;						\
   } dict_t[1];                                                          \
@@ -1088,7 +1195,6 @@ typedef enum {
     assert(0 <= (coeff_down) && (coeff_down)*2 < (coeff_up) && (coeff_up) < 1); \
     dict->mask = DICTI_INITIAL_SIZE-1;                                  \
     dict->count = 0;                                                    \
-    dict->count_delete = 0;                                             \
     M_C(name,_int_limit)(dict, DICTI_INITIAL_SIZE);			\
     dict->data = M_CALL_REALLOC(key_oplist, M_C(name, _pair_t), NULL, DICTI_INITIAL_SIZE); \
     if (dict->data == NULL) {                                           \
@@ -1106,8 +1212,7 @@ typedef enum {
   {                                                                     \
     DICTI_OA_CONTRACT(dict);                                            \
     for(size_t i = 0; i <= dict->mask; i++) {                           \
-      if (!M_CALL_OOR_EQUAL(key_oplist, dict->data[i].key, DICTI_OA_EMPTY) \
-          && !M_CALL_OOR_EQUAL(key_oplist, dict->data[i].key, DICTI_OA_DELETED)) { \
+      if (!M_CALL_OOR_EQUAL(key_oplist, dict->data[i].key, DICTI_OA_EMPTY)) { \
         M_CALL_CLEAR(key_oplist, dict->data[i].key);                    \
         M_CALL_CLEAR(value_oplist, dict->data[i].value);                \
       }                                                                 \
@@ -1118,6 +1223,37 @@ typedef enum {
     dict->data = NULL;                                                  \
   }                                                                     \
   									\
+  M_IF_STDIO(                                                           \
+  static inline bool                                                    \
+  M_C(name, _out_mmap)(FILE *file, const dict_t dict)                   \
+  {                                                                     \
+    DICTI_OA_CONTRACT(dict);                                            \
+    return m_core_mmap_write(file, M_CORE_MMAP_DICT_OA,                 \
+                             sizeof (M_C(name, _pair_t)), dict->count,  \
+                             dict->mask + 1, (uint64_t) M_HASH_SEED, dict->data); \
+  }                                                                     \
+  )                                                                     \
+                                                                        \
+  static inline bool                                                    \
+  M_C(name, _init_mmap)(dict_t dict, void *mem, size_t size)            \
+  {                                                                     \
+    size_t count, capacity;                                             \
+    void *table = m_core_mmap_table(mem, size, M_CORE_MMAP_DICT_OA,     \
+                                    sizeof (M_C(name, _pair_t)),        \
+                                    (uint64_t) M_HASH_SEED, &count, &capacity); \
+    if (table == NULL || !M_POWEROF2_P(capacity)                        \
+        || capacity < DICTI_INITIAL_SIZE)                               \
+      return false;                                                     \
+    M_C(name,_int_limit)(dict, capacity);                               \
+    if (count < dict->lower_limit || count > dict->upper_limit)         \
+      return false;                                                     \
+    dict->mask = capacity - 1;                                          \
+    dict->count = count;                                                \
+    dict->data = (M_C(name, _pair_t) *) table;                          \
+    DICTI_OA_CONTRACT(dict);                                            \
+    return true;                                                        \
+  }                                                                     \
+                                                                        \
   static inline value_type *                                            \
   M_C(name, _get)(const dict_t dict, key_type const key)		\
   {                                                                     \
@@ -1139,7 +1275,8 @@ typedef enum {
     /* Unlikely case */                                                 \
     size_t s = 1;                                                       \
     do {                                                                \
-      p = (p + DICTI_OA_PROBING(s)) & mask;                             \
+      p = (p + 1) & mask;                                               \
+      s++;                                                              \
       if (M_CALL_EQUAL(key_oplist, data[p].key, key))                   \
         return &data[p].value;                                          \
       assert (s <= dict->mask);                                         \
@@ -1161,12 +1298,9 @@ typedef enum {
     /* This function checks if the reshashing of the dict is ok */	\
     M_C(name, _pair_t) *data = h->data;					\
     size_t empty = 0;                                                   \
-    size_t del = 0;                                                     \
     for(size_t i = 0 ; i <= h->mask ; i++) {                            \
       empty += M_CALL_OOR_EQUAL(key_oplist, data[i].key, DICTI_OA_EMPTY); \
-      del   += M_CALL_OOR_EQUAL(key_oplist, data[i].key, DICTI_OA_DELETED); \
     }                                                                   \
-    assert(del == 0);                                                   \
     assert(empty + h->count == h->mask + 1);                            \
     return true;                                                        \
   }                                                                     \
@@ -1179,7 +1313,7 @@ typedef enum {
     assert (newSize >= oldSize);                                        \
     assert (M_POWEROF2_P(newSize));                                     \
     M_C(name, _pair_t) *data = h->data;					\
-    /* resize can be called just to delete the items */			\
+    /* resize can be called just to rehash the items in place */        \
     if (newSize > oldSize) {                                            \
       data = M_CALL_REALLOC(key_oplist, M_C(name, _pair_t), data, newSize); \
       if (M_UNLIKELY (data == NULL) ) {                                 \
@@ -1202,10 +1336,10 @@ typedef enum {
     const size_t mask = (newSize -1);                                   \
                                                                         \
     for(size_t i = 0 ; i < oldSize; i++) {                              \
-      if (!M_CALL_OOR_EQUAL(key_oplist, data[i].key, DICTI_OA_DELETED) && !M_CALL_OOR_EQUAL(key_oplist, data[i].key, DICTI_OA_EMPTY)) { \
+      if (!M_CALL_OOR_EQUAL(key_oplist, data[i].key, DICTI_OA_EMPTY)) { \
         size_t p = M_CALL_HASH(key_oplist, data[i].key) & mask;         \
         if (p != i) {                                                   \
-          if (M_LIKELY (M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_EMPTY) || M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_DELETED))) { \
+          if (M_LIKELY (M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_EMPTY))) { \
             M_DO_INIT_MOVE(key_oplist, data[p].key, data[i].key);       \
             M_DO_INIT_MOVE(value_oplist, data[p].value, data[i].value); \
           } else {                                                      \
@@ -1215,8 +1349,6 @@ typedef enum {
           }                                                             \
           M_CALL_OOR_SET(key_oplist, data[i].key, DICTI_OA_EMPTY);      \
         }                                                               \
-      } else {                                                          \
-        M_CALL_OOR_SET(key_oplist, data[i].key, DICTI_OA_EMPTY);        \
       }                                                                 \
     }                                                                   \
                                                                         \
@@ -1230,7 +1362,8 @@ typedef enum {
       if (!M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_EMPTY)) { \
         size_t s = 1;                                                   \
         do {                                                            \
-          p = (p + DICTI_OA_PROBING(s)) & mask;                         \
+          p = (p + 1) & mask;                                           \
+          s++;                                                          \
           assert (s <= h->mask);                                        \
         } while (!M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_EMPTY) ); \
       }                                                                 \
@@ -1241,7 +1374,6 @@ typedef enum {
                                                                         \
     M_C(name, _array_pair_clear) (tmp);					\
     h->mask = newSize-1;                                                \
-    h->count_delete = h->count;                                         \
     if (updateLimit == true) {						\
       M_C(name,_int_limit)(h, newSize);					\
     }									\
@@ -1269,36 +1401,27 @@ typedef enum {
       return;                                                           \
     }                                                                   \
     if (M_UNLIKELY (!M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_EMPTY) ) ) { \
-      size_t delPos = -1;                                               \
-      if (M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_DELETED)) delPos = p; \
       size_t s = 1;                                                     \
       do {                                                              \
-        p = (p + DICTI_OA_PROBING(s)) & mask;                           \
+        p = (p + 1) & mask;                                             \
+        s++;                                                            \
         if (M_CALL_EQUAL(key_oplist, data[p].key, key)) {               \
           M_CALL_SET(value_oplist, data[p].value, value);               \
           return;                                                       \
         }                                                               \
         assert (s <= dict->mask);                                       \
-        if (M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_DELETED) && delPos == (size_t)-1) delPos = p; \
       } while (!M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_EMPTY) ); \
-      if (delPos != (size_t) -1) {					\
-	p = delPos;							\
-	dict->count_delete --;						\
-      }									\
     }                                                                   \
                                                                         \
     M_CALL_INIT_SET(key_oplist, data[p].key, key);                      \
     M_CALL_INIT_SET(value_oplist, data[p].value, value);                \
     dict->count++;                                                      \
-    dict->count_delete ++;                                              \
                                                                         \
-    if (M_UNLIKELY (dict->count_delete >= dict->upper_limit)) {         \
-      size_t newSize = dict->mask+1;                                    \
-      if (dict->count > (dict->mask / 2)) {				\
-	newSize += newSize;						\
-	if (M_UNLIKELY (newSize <= dict->mask+1)) {			\
-	  M_MEMORY_FULL((size_t)-1);					\
-	}								\
+    if (M_UNLIKELY (dict->count >= dict->upper_limit)) {                \
+      /* Without tombstones, the table only needs a rehash when it is full */ \
+      size_t newSize = 2*(dict->mask+1);                                \
+      if (M_UNLIKELY (newSize <= dict->mask+1)) {                       \
+        M_MEMORY_FULL((size_t)-1);                                      \
       }									\
       M_C(name,_int_resize_up)(dict, newSize, true);			\
     }                                                                   \
@@ -1321,35 +1444,26 @@ typedef enum {
       return &data[p].value;                                            \
     }                                                                   \
     if (M_UNLIKELY (!M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_EMPTY) ) ) { \
-      size_t delPos = -1;                                               \
-      if (M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_DELETED)) delPos = p; \
       size_t s = 1;                                                     \
       do {                                                              \
-        p = (p + DICTI_OA_PROBING(s)) & mask;                           \
+        p = (p + 1) & mask;                                             \
+        s++;                                                            \
         if (M_CALL_EQUAL(key_oplist, data[p].key, key)) {               \
           return &data[p].value;                                        \
         }                                                               \
         assert (s <= dict->mask);                                       \
-        if (M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_DELETED) && delPos == (size_t)-1) delPos = p; \
       } while (!M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_EMPTY) ); \
-      if (delPos != (size_t) -1) {					\
-	p = delPos;							\
-	dict->count_delete --;						\
-      }									\
     }                                                                   \
                                                                         \
     M_CALL_INIT_SET(key_oplist, data[p].key, key);                      \
     M_CALL_INIT(value_oplist, data[p].value);                           \
     dict->count++;                                                      \
-    dict->count_delete ++;                                              \
                                                                         \
-    if (M_UNLIKELY (dict->count_delete >= dict->upper_limit)) {         \
-      size_t newSize = dict->mask+1;                                    \
-      if (dict->count > (dict->mask / 2)) {				\
-	newSize += newSize;						\
-	if (M_UNLIKELY (newSize <= dict->mask+1)) {			\
-	  M_MEMORY_FULL((size_t)-1);					\
-	}								\
+    if (M_UNLIKELY (dict->count >= dict->upper_limit)) {                \
+      /* Without tombstones, the table only needs a rehash when it is full */ \
+      size_t newSize = 2*(dict->mask+1);                                \
+      if (M_UNLIKELY (newSize <= dict->mask+1)) {                       \
+        M_MEMORY_FULL((size_t)-1);                                      \
       }									\
       M_C(name,_int_resize_up)(dict, newSize, true);			\
       /* data is now invalid */						\
@@ -1375,13 +1489,9 @@ typedef enum {
     for(size_t i = 0; i < newSize; i++) {                               \
       if (M_CALL_OOR_EQUAL(key_oplist, data[i].key, DICTI_OA_EMPTY))    \
         continue;                                                       \
-      if (M_CALL_OOR_EQUAL(key_oplist, data[i].key, DICTI_OA_DELETED)) { \
-        M_CALL_OOR_SET(key_oplist, data[i].key, DICTI_OA_EMPTY);        \
-        continue;                                                       \
-      }                                                                 \
       size_t p = M_CALL_HASH(key_oplist, data[i].key) & mask;           \
       if (p != i) {                                                     \
-        if (M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_EMPTY) || M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_DELETED)) { \
+        if (M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_EMPTY)) { \
           M_DO_INIT_MOVE(key_oplist, data[p].key, data[i].key);         \
           M_DO_INIT_MOVE(value_oplist, data[p].value, data[i].value);   \
         } else {                                                        \
@@ -1394,14 +1504,14 @@ typedef enum {
     }                                                                   \
     /* Pass 2: scan upper entries and move them back */                 \
     for(size_t i = newSize; i < oldSize; i++) {                         \
-      if (!M_CALL_OOR_EQUAL(key_oplist, data[i].key, DICTI_OA_DELETED)  \
-          && !M_CALL_OOR_EQUAL(key_oplist, data[i].key, DICTI_OA_EMPTY)) { \
+      if (!M_CALL_OOR_EQUAL(key_oplist, data[i].key, DICTI_OA_EMPTY)) { \
         size_t p = M_CALL_HASH(key_oplist, data[i].key) & mask;         \
         assert (p < i);                                                 \
         if (!M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_EMPTY)) { \
           size_t s = 1;                                                 \
           do {                                                          \
-            p = (p + DICTI_OA_PROBING(s)) & mask;                       \
+            p = (p + 1) & mask;                                         \
+            s++;                                                        \
             assert (s <= h->mask);                                      \
           } while (!M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_EMPTY) ); \
         }                                                               \
@@ -1416,7 +1526,8 @@ typedef enum {
       if (!M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_EMPTY)) { \
         size_t s = 1;                                                   \
         do {                                                            \
-          p = (p + DICTI_OA_PROBING(s)) & mask;                         \
+          p = (p + 1) & mask;                                           \
+          s++;                                                          \
           assert (s <= h->mask);                                        \
         } while (!M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_EMPTY) ); \
       }                                                                 \
@@ -1425,7 +1536,6 @@ typedef enum {
     }                                                                   \
     									\
     M_C(name, _array_pair_clear) (tmp);					\
-    h->count_delete = h->count;                                         \
     if (newSize != oldSize) {                                           \
       h->mask = newSize-1;                                              \
       M_C(name,_int_limit)(h, newSize);					\
@@ -1455,7 +1565,8 @@ typedef enum {
         return false;                                                   \
       size_t s = 1;                                                     \
       do {                                                              \
-        p = (p + DICTI_OA_PROBING(s)) & mask;                           \
+        p = (p + 1) & mask;                                             \
+        s++;                                                            \
         if (M_CALL_OOR_EQUAL(key_oplist, data[p].key, DICTI_OA_EMPTY) ) \
           return false;                                                 \
         assert (s <= dict->mask);                                       \
@@ -1463,7 +1574,23 @@ typedef enum {
     }                                                                   \
     M_CALL_CLEAR(key_oplist, data[p].key);                              \
     M_CALL_CLEAR(value_oplist, data[p].value);                          \
-    M_CALL_OOR_SET(key_oplist, data[p].key, DICTI_OA_DELETED);          \
+    /* Backward shift deletion: move back the following items of the    \
+       cluster which can fill the hole, so that no tombstone is needed */ \
+    size_t q = p;                                                       \
+    while (true) {                                                      \
+      q = (q + 1) & mask;                                               \
+      if (M_CALL_OOR_EQUAL(key_oplist, data[q].key, DICTI_OA_EMPTY))    \
+        break;                                                          \
+      size_t h = M_CALL_HASH(key_oplist, data[q].key) & mask;           \
+      /* The item can fill the hole if its probing sequence             \
+         goes through it, ie. if it is not between the hole and the item */ \
+      if (((q - h) & mask) >= ((q - p) & mask)) {                       \
+        M_DO_INIT_MOVE(key_oplist, data[p].key, data[q].key);           \
+        M_DO_INIT_MOVE(value_oplist, data[p].value, data[q].value);     \
+        p = q;                                                          \
+      }                                                                 \
+    }                                                                   \
+    M_CALL_OOR_SET(key_oplist, data[p].key, DICTI_OA_EMPTY);            \
     assert (dict->count >= 1);                                          \
     dict->count--;                                                      \
     if (M_UNLIKELY (dict->count < dict->lower_limit)) {                 \
@@ -1494,7 +1621,6 @@ typedef enum {
     assert (map != org);                                                \
     map->mask         = org->mask;                                      \
     map->count        = org->count;                                     \
-    map->count_delete = org->count_delete;                              \
     map->upper_limit  = org->upper_limit;                               \
     map->lower_limit  = org->lower_limit;                               \
     map->data = M_CALL_REALLOC(key_oplist, M_C(name, _pair_t), NULL, map->mask+1); \
@@ -1505,8 +1631,6 @@ typedef enum {
     for(size_t i = 0; i <= org->mask; i++) {                            \
       if (M_CALL_OOR_EQUAL(key_oplist, org->data[i].key, DICTI_OA_EMPTY)) { \
         M_CALL_OOR_SET(key_oplist, map->data[i].key, DICTI_OA_EMPTY);   \
-      } else if (M_CALL_OOR_EQUAL(key_oplist, org->data[i].key, DICTI_OA_DELETED)) { \
-        M_CALL_OOR_SET(key_oplist, map->data[i].key, DICTI_OA_DELETED); \
       } else {                                                          \
         M_CALL_INIT_SET(key_oplist, map->data[i].key, org->data[i].key); \
         M_CALL_INIT_SET(value_oplist, map->data[i].value, org->data[i].value); \
@@ -1534,7 +1658,6 @@ typedef enum {
     assert (map != org);                                                \
     map->mask         = org->mask;                                      \
     map->count        = org->count;                                     \
-    map->count_delete = org->count_delete;                              \
     map->upper_limit  = org->upper_limit;                               \
     map->lower_limit  = org->lower_limit;                               \
     map->data         = org->data;                                      \
@@ -1563,7 +1686,6 @@ typedef enum {
     DICTI_OA_CONTRACT(d2);                                              \
     M_SWAP (size_t, d1->mask,         d2->mask);                        \
     M_SWAP (size_t, d1->count,        d2->count);                       \
-    M_SWAP (size_t, d1->count_delete, d2->count_delete);                \
     M_SWAP (size_t, d1->upper_limit,  d2->upper_limit);                 \
     M_SWAP (size_t, d1->lower_limit,  d2->lower_limit);                 \
     M_SWAP (M_C(name, _pair_t) *, d1->data, d2->data);			\
@@ -1576,14 +1698,12 @@ typedef enum {
   {                                                                     \
     DICTI_OA_CONTRACT(d);                                               \
     for(size_t i = 0; i <= d->mask; i++) {                              \
-      if (!M_CALL_OOR_EQUAL(key_oplist, d->data[i].key, DICTI_OA_EMPTY) \
-          && !M_CALL_OOR_EQUAL(key_oplist, d->data[i].key, DICTI_OA_DELETED)) { \
+      if (!M_CALL_OOR_EQUAL(key_oplist, d->data[i].key, DICTI_OA_EMPTY)) { \
         M_CALL_CLEAR(key_oplist, d->data[i].key);                       \
         M_CALL_CLEAR(value_oplist, d->data[i].value);                   \
       }                                                                 \
     }                                                                   \
     d->count = 0;                                                       \
-    d->count_delete = 0;                                                \
     d->mask = DICTI_INITIAL_SIZE-1;                                     \
     M_C(name,_int_limit)(d, DICTI_INITIAL_SIZE);			\
     d->data = M_CALL_REALLOC(key_oplist, M_C(name, _pair_t),		\
@@ -1602,9 +1722,8 @@ typedef enum {
     assert (it != NULL);                                                \
     it->dict = d;                                                       \
     size_t i = 0;                                                       \
-    while ((M_CALL_OOR_EQUAL(key_oplist, d->data[i].key, DICTI_OA_EMPTY) \
-            || M_CALL_OOR_EQUAL(key_oplist, d->data[i].key, DICTI_OA_DELETED)) \
-           && i <= d->mask) {                                           \
+    while (i <= d->mask                                                 \
+           && M_CALL_OOR_EQUAL(key_oplist, d->data[i].key, DICTI_OA_EMPTY)) { \
       i++;                                                              \
     }                                                                   \
     it->index = i;                                                      \
@@ -1627,9 +1746,8 @@ typedef enum {
     assert (it != NULL);                                                \
     it->dict = d;                                                       \
     size_t i = d->mask;                                                 \
-    while ((M_CALL_OOR_EQUAL(key_oplist, d->data[i].key, DICTI_OA_EMPTY) \
-            || M_CALL_OOR_EQUAL(key_oplist, d->data[i].key, DICTI_OA_DELETED)) \
-           && i <= d->mask) {                                           \
+    while (i <= d->mask                                                 \
+           && M_CALL_OOR_EQUAL(key_oplist, d->data[i].key, DICTI_OA_EMPTY)) { \
       i--;                                                              \
     }                                                                   \
     it->index = i;                                                      \
@@ -1659,8 +1777,7 @@ typedef enum {
     DICTI_OA_CONTRACT (it->dict);                                       \
     size_t i = it->index + 1;                                           \
     while (i <= it->dict->mask &&                                       \
-           (M_CALL_OOR_EQUAL(key_oplist, it->dict->data[i].key, DICTI_OA_EMPTY) \
-            || M_CALL_OOR_EQUAL(key_oplist, it->dict->data[i].key, DICTI_OA_DELETED))) { \
+           M_CALL_OOR_EQUAL(key_oplist, it->dict->data[i].key, DICTI_OA_EMPTY)) { \
       i++;                                                              \
     }                                                                   \
     it->index = i;                                                      \
@@ -1674,8 +1791,7 @@ typedef enum {
     /* if index was 0, the operation will overflow, and stops the loop */ \
     size_t i = it->index - 1;                                           \
     while (i <= it->dict->mask &&                                       \
-           (M_CALL_OOR_EQUAL(key_oplist, it->dict->data[i].key, DICTI_OA_EMPTY) \
-            || M_CALL_OOR_EQUAL(key_oplist, it->dict->data[i].key, DICTI_OA_DELETED))) { \
+           M_CALL_OOR_EQUAL(key_oplist, it->dict->data[i].key, DICTI_OA_EMPTY)) { \
       i--;                                                              \
     }                                                                   \
     it->index = i;                                                      \
@@ -1708,7 +1824,6 @@ typedef enum {
     const size_t i = it->index;                                         \
     assert (i <= it->dict->mask);                                       \
     assert (!M_CALL_OOR_EQUAL(key_oplist, it->dict->data[i].key, DICTI_OA_EMPTY)); \
-    assert (!M_CALL_OOR_EQUAL(key_oplist, it->dict->data[i].key, DICTI_OA_DELETED)); \
     return &it->dict->data[i];                                          \
   }                                                                     \
   									\
@@ -1735,6 +1850,28 @@ typedef enum {
       M_C(name,_int_resize_up)(dict, size, false);			\
     }									\
     DICTI_OA_CONTRACT(dict);						\
+  }                                                                     \
+                                                                        \
+  /* Compute the histogram of the probe lengths of the items:           \
+     histo[i] is the number of items stored i slots after their home slot \
+     (the last entry of the histogram gets all the greater lengths).    \
+     Return the maximum probe length. */                                \
+  static inline size_t                                                  \
+  M_C(name, _probe_histogram)(const dict_t dict, size_t n, size_t histo[]) \
+  {                                                                     \
+    DICTI_OA_CONTRACT(dict);                                            \
+    assert (n >= 1 && histo != NULL);                                   \
+    const size_t mask = dict->mask;                                     \
+    size_t max = 0;                                                     \
+    memset(histo, 0, n * sizeof (size_t));                              \
+    for(size_t i = 0; i <= mask; i++) {                                 \
+      if (!M_CALL_OOR_EQUAL(key_oplist, dict->data[i].key, DICTI_OA_EMPTY)) { \
+        size_t d = (i - M_CALL_HASH(key_oplist, dict->data[i].key)) & mask; \
+        max = M_MAX(max, d);                                            \
+        histo[M_MIN(d, n-1)]++;                                         \
+      }                                                                 \
+    }                                                                   \
+    return max;                                                         \
   }									\
   									\
   M_IF_METHOD(EQUAL, value_oplist)(					\
@@ -1769,5 +1906,697 @@ typedef enum {
                                                                         \
   DICTI_FUNC_ADDITIONAL_DEF2(name, key_type, key_oplist, value_type, value_oplist, 0, dict_t, dict_it_t)
 
+/****************************************************************************************/
+/* Open Addressing implementation with control bytes (SWISS) */
+/****************************************************************************************/
+
+/* Each slot of the table has an associated control byte stored
+   in a separate array:
+   - EMPTY   : the slot has never been used since the last rehash,
+   - DELETED : the slot has been used, but its item was erased,
+   - 0..127  : the slot is used, and it stores the 7 lower bits of the hash.
+   The control bytes are scanned per group of DICTI_SWISS_GROUP_SIZE bytes
+   (using SIMD instructions if available), and the keys are only
+   compared if their control byte matches. */
+#define DICTI_SWISS_EMPTY   ((uint8_t) 0x80)
+#define DICTI_SWISS_DELETED ((uint8_t) 0xFE)
+#define DICTI_SWISS_H1(hash) ((hash) >> 7)
+#define DICTI_SWISS_H2(hash) ((uint8_t) ((hash) & 0x7F))
+
+/* Bitmask of the slots of a group matching a condition:
+   the first matching slot is dicti_swiss_first(mask),
+   and dicti_swiss_next(mask) removes it from the mask */
+typedef uint32_t dicti_swiss_mask_t;
+
+#if M_USE_SIMD && defined(__AVX2__)
+#include <immintrin.h>
+#define DICTI_SWISS_GROUP_SIZE 32
+
+static inline dicti_swiss_mask_t
+dicti_swiss_match(const uint8_t *ctrl, uint8_t h2)
+{
+  __m256i g = _mm256_loadu_si256((const __m256i *)(const void *) ctrl);
+  return (dicti_swiss_mask_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(g, _mm256_set1_epi8((char) h2)));
+}
+
+static inline dicti_swiss_mask_t
+dicti_swiss_match_empty(const uint8_t *ctrl)
+{
+  __m256i g = _mm256_loadu_si256((const __m256i *)(const void *) ctrl);
+  return (dicti_swiss_mask_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(g, _mm256_set1_epi8((char) DICTI_SWISS_EMPTY)));
+}
+
+static inline dicti_swiss_mask_t
+dicti_swiss_match_free(const uint8_t *ctrl)
+{
+  /* EMPTY and DELETED are the only control bytes with the highest bit set */
+  __m256i g = _mm256_loadu_si256((const __m256i *)(const void *) ctrl);
+  return (dicti_swiss_mask_t) _mm256_movemask_epi8(g);
+}
+
+#elif M_USE_SIMD && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define DICTI_SWISS_GROUP_SIZE 16
+
+static inline dicti_swiss_mask_t
+dicti_swiss_match(const uint8_t *ctrl, uint8_t h2)
+{
+  __m128i g = _mm_loadu_si128((const __m128i *)(const void *) ctrl);
+  return (dicti_swiss_mask_t) _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char) h2)));
+}
+
+static inline dicti_swiss_mask_t
+dicti_swiss_match_empty(const uint8_t *ctrl)
+{
+  __m128i g = _mm_loadu_si128((const __m128i *)(const void *) ctrl);
+  return (dicti_swiss_mask_t) _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char) DICTI_SWISS_EMPTY)));
+}
+
+static inline dicti_swiss_mask_t
+dicti_swiss_match_free(const uint8_t *ctrl)
+{
+  /* EMPTY and DELETED are the only control bytes with the highest bit set */
+  __m128i g = _mm_loadu_si128((const __m128i *)(const void *) ctrl);
+  return (dicti_swiss_mask_t) _mm_movemask_epi8(g);
+}
+
+#else
+/* Portable version: the compiler is expected to vectorize theses loops */
+#define DICTI_SWISS_GROUP_SIZE 8
+
+static inline dicti_swiss_mask_t
+dicti_swiss_match(const uint8_t *ctrl, uint8_t h2)
+{
+  dicti_swiss_mask_t m = 0;
+  for(unsigned int i = 0; i < DICTI_SWISS_GROUP_SIZE; i++)
+    m |= (dicti_swiss_mask_t) (ctrl[i] == h2) << i;
+  return m;
+}
+
+static inline dicti_swiss_mask_t
+dicti_swiss_match_empty(const uint8_t *ctrl)
+{
+  dicti_swiss_mask_t m = 0;
+  for(unsigned int i = 0; i < DICTI_SWISS_GROUP_SIZE; i++)
+    m |= (dicti_swiss_mask_t) (ctrl[i] == DICTI_SWISS_EMPTY) << i;
+  return m;
+}
+
+static inline dicti_swiss_mask_t
+dicti_swiss_match_free(const uint8_t *ctrl)
+{
+  dicti_swiss_mask_t m = 0;
+  for(unsigned int i = 0; i < DICTI_SWISS_GROUP_SIZE; i++)
+    m |= (dicti_swiss_mask_t) (ctrl[i] >> 7) << i;
+  return m;
+}
+#endif
+
+static inline unsigned int
+dicti_swiss_first(dicti_swiss_mask_t m)
+{
+  assert (m != 0);
+  return m_core_ctz32(m);
+}
+
+static inline dicti_swiss_mask_t
+dicti_swiss_next(dicti_swiss_mask_t m)
+{
+  return m & (m - 1);
+}
+
+/* The table shall contain at least one group */
+#define DICTI_SWISS_INITIAL_SIZE M_MAX(DICTI_INITIAL_SIZE, DICTI_SWISS_GROUP_SIZE)
+
+#define DICTI_SWISS_CONTRACT(dict) do {                                 \
+    assert ( (dict) != NULL);						\
+    assert( (dict)->lower_limit <= (dict)->count && (dict)->count <= (dict)->upper_limit ); \
+    assert( (dict)->count <= (dict)->count_delete);                     \
+    assert( (dict)->count_delete < (dict)->mask+1);                     \
+    assert( (dict)->data != NULL && (dict)->ctrl != NULL);              \
+    assert( M_POWEROF2_P((dict)->mask+1));				\
+    assert( (dict)->mask+1 >= DICTI_SWISS_INITIAL_SIZE);                \
+  } while (0)
+
+#define DICTI_SWISS_DEF_P1(args) DICTI_SWISS_DEF_P2 args
+#define DICTI_SWISS_DEF_P2(name, key_type, key_oplist, value_type, value_oplist) \
+  DICTI_SWISS_DEF_P3(name, key_type, key_oplist, value_type, value_oplist, \
+                     0.2, 0.875, M_C(name,_t), M_C(name, _it_t) )
+
+#define DICTI_SWISS_DEF_P3(name, key_type, key_oplist, value_type, value_oplist, coeff_down, coeff_up, dict_t, dict_it_t) \
+                                                                        \
+  typedef struct M_C(name, _pair_s) {                                   \
+    key_type   key;                                                     \
+    value_type value;                                                   \
+  } M_C(name, _pair_t);                                                 \
+                                                                        \
+  typedef key_type M_C(name, _key_type_t);                              \
+  typedef value_type M_C(name, _value_type_t);                          \
+                                                                        \
+  typedef struct M_C(name,_s) {                                         \
+    size_t mask, count, count_delete;                                   \
+    size_t upper_limit, lower_limit;                                    \
+    uint8_t *ctrl;                                                      \
+    M_C(name, _pair_t) *data;                                           \
+  } dict_t[1];                                                          \
+  typedef struct M_C(name, _s) *M_C(name, _ptr);                        \
+  typedef const struct M_C(name, _s) *M_C(name, _srcptr);               \
+  typedef struct M_C(name, _pair_s) M_C(name, _type_t);                 \
+                                                                        \
+  typedef struct M_C(name, _it_s) {                                     \
+    const struct M_C(name,_s) *dict;                                    \
+    size_t index;                                                       \
+  } dict_it_t[1];                                                       \
+                                                                        \
+  static inline void                                                    \
+  M_C(name,_int_limit)(dict_t dict, size_t size)                        \
+  {                                                                     \
+    dict->upper_limit = (size_t) (size * coeff_up) - 1;                 \
+    dict->lower_limit = (size <= DICTI_SWISS_INITIAL_SIZE) ? 0 : (size_t) (size * coeff_down) ; \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name,_int_alloc)(dict_t dict, size_t size)                        \
+  {                                                                     \
+    dict->data = M_CALL_REALLOC(key_oplist, M_C(name, _pair_t), NULL, size); \
+    dict->ctrl = M_CALL_REALLOC(key_oplist, uint8_t, NULL, size);       \
+    if (M_UNLIKELY (dict->data == NULL || dict->ctrl == NULL)) {        \
+      M_MEMORY_FULL((sizeof (M_C(name, _pair_t)) + 1) * size);          \
+      return ;                                                          \
+    }                                                                   \
+    memset(dict->ctrl, DICTI_SWISS_EMPTY, size);                        \
+    dict->mask = size - 1;                                              \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _init)(dict_t dict)                                         \
+  {                                                                     \
+    assert(0 <= (coeff_down) && (coeff_down)*2 < (coeff_up) && (coeff_up) < 1); \
+    M_C(name,_int_alloc)(dict, DICTI_SWISS_INITIAL_SIZE);               \
+    dict->count = 0;                                                    \
+    dict->count_delete = 0;                                             \
+    M_C(name,_int_limit)(dict, DICTI_SWISS_INITIAL_SIZE);               \
+    DICTI_SWISS_CONTRACT(dict);                                         \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _int_clear_items)(dict_t dict)                              \
+  {                                                                     \
+    for(size_t i = 0; i <= dict->mask; i++) {                           \
+      if (dict->ctrl[i] < DICTI_SWISS_EMPTY) {                          \
+        M_CALL_CLEAR(key_oplist, dict->data[i].key);                    \
+        M_CALL_CLEAR(value_oplist, dict->data[i].value);                \
+      }                                                                 \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _clear)(dict_t dict)                                        \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(dict);                                         \
+    M_C(name, _int_clear_items)(dict);                                  \
+    M_CALL_FREE(key_oplist, dict->data);                                \
+    M_CALL_FREE(key_oplist, dict->ctrl);                                \
+    /* Not really needed, but safer */                                  \
+    dict->mask = 0;                                                     \
+    dict->data = NULL;                                                  \
+    dict->ctrl = NULL;                                                  \
+  }                                                                     \
+                                                                        \
+  /* Return the index of the key in the table, or -1 if not found */    \
+  static inline size_t                                                  \
+  M_C(name, _int_find)(const dict_t dict, key_type const key, size_t hash) \
+  {                                                                     \
+    const uint8_t h2 = DICTI_SWISS_H2(hash);                            \
+    const size_t gmask = dict->mask / DICTI_SWISS_GROUP_SIZE;           \
+    size_t g = DICTI_SWISS_H1(hash) & gmask;                            \
+    size_t s = 0;                                                       \
+    while (true) {                                                      \
+      const uint8_t *ctrl = &dict->ctrl[g * DICTI_SWISS_GROUP_SIZE];    \
+      dicti_swiss_mask_t m = dicti_swiss_match(ctrl, h2);               \
+      while (m != 0) {                                                  \
+        const size_t i = g * DICTI_SWISS_GROUP_SIZE + dicti_swiss_first(m); \
+        if (M_LIKELY (M_CALL_EQUAL(key_oplist, dict->data[i].key, key))) \
+          return i;                                                     \
+        m = dicti_swiss_next(m);                                        \
+      }                                                                 \
+      /* A probing sequence never goes beyond a group with an EMPTY slot */ \
+      if (M_LIKELY (dicti_swiss_match_empty(ctrl) != 0))                \
+        return (size_t) -1;                                             \
+      /* Triangular probing over the groups: visit all groups */        \
+      g = (g + (++s)) & gmask;                                          \
+      assert (s <= gmask);                                              \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  /* Return the index of the first free slot (EMPTY or DELETED)         \
+     in the probing sequence of the hash */                             \
+  static inline size_t                                                  \
+  M_C(name, _int_find_free)(const dict_t dict, size_t hash)             \
+  {                                                                     \
+    const size_t gmask = dict->mask / DICTI_SWISS_GROUP_SIZE;           \
+    size_t g = DICTI_SWISS_H1(hash) & gmask;                            \
+    size_t s = 0;                                                       \
+    while (true) {                                                      \
+      const uint8_t *ctrl = &dict->ctrl[g * DICTI_SWISS_GROUP_SIZE];    \
+      dicti_swiss_mask_t m = dicti_swiss_match_free(ctrl);              \
+      if (M_LIKELY (m != 0))                                            \
+        return g * DICTI_SWISS_GROUP_SIZE + dicti_swiss_first(m);       \
+      g = (g + (++s)) & gmask;                                          \
+      assert (s <= gmask);                                              \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  static inline value_type *                                            \
+  M_C(name, _get)(const dict_t dict, key_type const key)                \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(dict);                                         \
+    size_t i = M_C(name, _int_find)(dict, key, M_CALL_HASH(key_oplist, key)); \
+    return M_LIKELY (i != (size_t) -1) ? &dict->data[i].value : NULL;   \
+  }                                                                     \
+                                                                        \
+  static inline value_type const *                                      \
+  M_C(name, _cget)(const dict_t map, key_type const key)                \
+  {                                                                     \
+    return M_CONST_CAST(value_type, M_C(name,_get)(map,key));           \
+  }                                                                     \
+                                                                        \
+  M_IF_DEBUG(                                                           \
+  static inline bool                                                    \
+  M_C(name,_int_control_after_resize)(const dict_t h)                   \
+  {                                                                     \
+    /* This function checks if the reshashing of the dict is ok */      \
+    size_t full = 0;                                                    \
+    size_t del = 0;                                                     \
+    for(size_t i = 0 ; i <= h->mask ; i++) {                            \
+      full += h->ctrl[i] < DICTI_SWISS_EMPTY;                           \
+      del  += h->ctrl[i] == DICTI_SWISS_DELETED;                        \
+    }                                                                   \
+    assert(del == 0);                                                   \
+    assert(full == h->count);                                           \
+    assert(h->count_delete == h->count);                                \
+    return true;                                                        \
+  }                                                                     \
+  )                                                                     \
+                                                                        \
+  /* Rehash all the items into new tables of size 'newSize'.            \
+     All DELETED slots are removed by this operation */                 \
+  static inline void                                                    \
+  M_C(name,_int_resize)(dict_t h, size_t newSize, bool updateLimit)     \
+  {                                                                     \
+    assert (M_POWEROF2_P(newSize));                                     \
+    assert (newSize >= DICTI_SWISS_INITIAL_SIZE);                       \
+    assert (newSize > h->count);                                        \
+    const size_t oldSize = h->mask+1;                                   \
+    uint8_t *oldCtrl = h->ctrl;                                         \
+    M_C(name, _pair_t) *oldData = h->data;                              \
+    M_C(name,_int_alloc)(h, newSize);                                   \
+    for(size_t i = 0 ; i < oldSize; i++) {                              \
+      if (oldCtrl[i] < DICTI_SWISS_EMPTY) {                             \
+        size_t hash = M_CALL_HASH(key_oplist, oldData[i].key);          \
+        /* All the free slots of the new table are EMPTY */             \
+        size_t p = M_C(name, _int_find_free)(h, hash);                  \
+        M_DO_INIT_MOVE(key_oplist, h->data[p].key, oldData[i].key);     \
+        M_DO_INIT_MOVE(value_oplist, h->data[p].value, oldData[i].value); \
+        h->ctrl[p] = DICTI_SWISS_H2(hash);                              \
+      }                                                                 \
+    }                                                                   \
+    M_CALL_FREE(key_oplist, oldData);                                   \
+    M_CALL_FREE(key_oplist, oldCtrl);                                   \
+    h->count_delete = h->count;                                         \
+    if (updateLimit == true) {                                          \
+      M_C(name,_int_limit)(h, newSize);                                 \
+    }                                                                   \
+    M_IF_DEBUG (assert (M_C(name,_int_control_after_resize)(h));)       \
+    DICTI_SWISS_CONTRACT(h);                                            \
+  }                                                                     \
+                                                                        \
+  /* Ensure there is room for a new item: either grow the table,        \
+     or only remove the DELETED slots if there are enough of them. */   \
+  static inline void                                                    \
+  M_C(name,_int_reserve_one)(dict_t dict)                               \
+  {                                                                     \
+    if (M_UNLIKELY (dict->count_delete >= dict->upper_limit)) {         \
+      size_t newSize = dict->mask+1;                                    \
+      if (dict->count > (dict->mask / 2)) {                             \
+        newSize += newSize;                                             \
+        if (M_UNLIKELY (newSize <= dict->mask+1)) {                     \
+          M_MEMORY_FULL((size_t)-1);                                    \
+        }                                                               \
+      }                                                                 \
+      M_C(name,_int_resize)(dict, newSize, true);                       \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  /* Record the insertion of a new item in the given slot */            \
+  static inline void                                                    \
+  M_C(name,_int_set_ctrl)(dict_t dict, size_t p, size_t hash)           \
+  {                                                                     \
+    dict->count_delete += (dict->ctrl[p] == DICTI_SWISS_EMPTY);         \
+    dict->ctrl[p] = DICTI_SWISS_H2(hash);                               \
+    dict->count++;                                                      \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name,_set_at)(dict_t dict, key_type const key,                    \
+                    value_type const value)                             \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(dict);                                         \
+    size_t hash = M_CALL_HASH(key_oplist, key);                         \
+    size_t p = M_C(name, _int_find)(dict, key, hash);                   \
+    if (M_UNLIKELY (p != (size_t) -1)) {                                \
+      M_CALL_SET(value_oplist, dict->data[p].value, value);             \
+      return;                                                           \
+    }                                                                   \
+    M_C(name,_int_reserve_one)(dict);                                   \
+    p = M_C(name, _int_find_free)(dict, hash);                          \
+    M_CALL_INIT_SET(key_oplist, dict->data[p].key, key);                \
+    M_CALL_INIT_SET(value_oplist, dict->data[p].value, value);          \
+    M_C(name,_int_set_ctrl)(dict, p, hash);                             \
+    DICTI_SWISS_CONTRACT(dict);                                         \
+  }                                                                     \
+                                                                        \
+  static inline value_type *                                            \
+  M_C(name,_get_at)(dict_t dict, key_type const key)                    \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(dict);                                         \
+    size_t hash = M_CALL_HASH(key_oplist, key);                         \
+    size_t p = M_C(name, _int_find)(dict, key, hash);                   \
+    if (M_LIKELY (p != (size_t) -1)) {                                  \
+      return &dict->data[p].value;                                      \
+    }                                                                   \
+    M_C(name,_int_reserve_one)(dict);                                   \
+    p = M_C(name, _int_find_free)(dict, hash);                          \
+    M_CALL_INIT_SET(key_oplist, dict->data[p].key, key);                \
+    M_CALL_INIT(value_oplist, dict->data[p].value);                     \
+    M_C(name,_int_set_ctrl)(dict, p, hash);                             \
+    DICTI_SWISS_CONTRACT(dict);                                         \
+    return &dict->data[p].value;                                        \
+  }                                                                     \
+                                                                        \
+  static inline bool                                                    \
+  M_C(name,_erase)(dict_t dict, const key_type key)                     \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(dict);                                         \
+    size_t p = M_C(name, _int_find)(dict, key, M_CALL_HASH(key_oplist, key)); \
+    if (p == (size_t) -1)                                               \
+      return false;                                                     \
+    M_CALL_CLEAR(key_oplist, dict->data[p].key);                        \
+    M_CALL_CLEAR(value_oplist, dict->data[p].value);                    \
+    /* If the group of the slot still has an EMPTY slot, it has never   \
+       been full, so no probing sequence has gone beyond it:            \
+       the slot can be marked as EMPTY instead of DELETED */            \
+    const size_t g = p & ~(size_t) (DICTI_SWISS_GROUP_SIZE-1);          \
+    if (dicti_swiss_match_empty(&dict->ctrl[g]) != 0) {                 \
+      dict->ctrl[p] = DICTI_SWISS_EMPTY;                                \
+      dict->count_delete --;                                            \
+    } else {                                                            \
+      dict->ctrl[p] = DICTI_SWISS_DELETED;                              \
+    }                                                                   \
+    assert (dict->count >= 1);                                          \
+    dict->count--;                                                      \
+    if (M_UNLIKELY (dict->count < dict->lower_limit)) {                 \
+      size_t newSize = M_MAX((dict->mask+1) >> 1, DICTI_SWISS_INITIAL_SIZE); \
+      M_C(name,_int_resize)(dict, newSize, true);                       \
+    }                                                                   \
+    DICTI_SWISS_CONTRACT(dict);                                         \
+    return true;                                                        \
+  }                                                                     \
+                                                                        \
+  static inline bool                                                    \
+  M_C(name,_empty_p)(const  dict_t dict)                                \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(dict);                                         \
+    return dict->count == 0;                                            \
+  }                                                                     \
+                                                                        \
+  static inline size_t                                                  \
+  M_C(name,_size)(const  dict_t dict)                                   \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(dict);                                         \
+    return dict->count;                                                 \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _init_set)(dict_t map, const dict_t org)                    \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(org);                                          \
+    assert (map != org);                                                \
+    M_C(name,_int_alloc)(map, org->mask+1);                             \
+    map->count        = org->count;                                     \
+    map->count_delete = org->count_delete;                              \
+    map->upper_limit  = org->upper_limit;                               \
+    map->lower_limit  = org->lower_limit;                               \
+    memcpy(map->ctrl, org->ctrl, org->mask+1);                          \
+    for(size_t i = 0; i <= org->mask; i++) {                            \
+      if (org->ctrl[i] < DICTI_SWISS_EMPTY) {                           \
+        M_CALL_INIT_SET(key_oplist, map->data[i].key, org->data[i].key); \
+        M_CALL_INIT_SET(value_oplist, map->data[i].value, org->data[i].value); \
+      }                                                                 \
+    }                                                                   \
+    DICTI_SWISS_CONTRACT(map);                                          \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _set)(dict_t map, const dict_t org)                         \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(map);                                          \
+    DICTI_SWISS_CONTRACT(org);                                          \
+    if (M_LIKELY (map != org)) {                                        \
+      M_C(name, _clear)(map);                                           \
+      M_C(name, _init_set)(map, org);                                   \
+    }                                                                   \
+    DICTI_SWISS_CONTRACT(map);                                          \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _init_move)(dict_t map, dict_t org)                         \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(org);                                          \
+    assert (map != org);                                                \
+    map->mask         = org->mask;                                      \
+    map->count        = org->count;                                     \
+    map->count_delete = org->count_delete;                              \
+    map->upper_limit  = org->upper_limit;                               \
+    map->lower_limit  = org->lower_limit;                               \
+    map->data         = org->data;                                      \
+    map->ctrl         = org->ctrl;                                      \
+    /* Mark org as cleared (safety) */                                  \
+    org->mask         = 0;                                              \
+    org->data         = NULL;                                           \
+    org->ctrl         = NULL;                                           \
+    DICTI_SWISS_CONTRACT(map);                                          \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _move)(dict_t map, dict_t org)                              \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(map);                                          \
+    DICTI_SWISS_CONTRACT(org);                                          \
+    if (M_LIKELY (map != org)) {                                        \
+      M_C(name, _clear)(map);                                           \
+      M_C(name, _init_move)(map, org);                                  \
+    }                                                                   \
+    DICTI_SWISS_CONTRACT(map);                                          \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _swap)(dict_t d1, dict_t d2)                                \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(d1);                                           \
+    DICTI_SWISS_CONTRACT(d2);                                           \
+    M_SWAP (size_t, d1->mask,         d2->mask);                        \
+    M_SWAP (size_t, d1->count,        d2->count);                       \
+    M_SWAP (size_t, d1->count_delete, d2->count_delete);                \
+    M_SWAP (size_t, d1->upper_limit,  d2->upper_limit);                 \
+    M_SWAP (size_t, d1->lower_limit,  d2->lower_limit);                 \
+    M_SWAP (uint8_t *, d1->ctrl, d2->ctrl);                             \
+    M_SWAP (M_C(name, _pair_t) *, d1->data, d2->data);                  \
+    DICTI_SWISS_CONTRACT(d1);                                           \
+    DICTI_SWISS_CONTRACT(d2);                                           \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _clean)(dict_t d)                                           \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(d);                                            \
+    M_C(name, _int_clear_items)(d);                                     \
+    d->count = 0;                                                       \
+    d->count_delete = 0;                                                \
+    d->mask = DICTI_SWISS_INITIAL_SIZE-1;                               \
+    M_C(name,_int_limit)(d, DICTI_SWISS_INITIAL_SIZE);                  \
+    d->data = M_CALL_REALLOC(key_oplist, M_C(name, _pair_t),            \
+                             d->data, DICTI_SWISS_INITIAL_SIZE);        \
+    d->ctrl = M_CALL_REALLOC(key_oplist, uint8_t,                       \
+                             d->ctrl, DICTI_SWISS_INITIAL_SIZE);        \
+    assert(d->data != NULL && d->ctrl != NULL);                         \
+    memset(d->ctrl, DICTI_SWISS_EMPTY, DICTI_SWISS_INITIAL_SIZE);       \
+    DICTI_SWISS_CONTRACT(d);                                            \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _it)(dict_it_t it, const dict_t d)                          \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(d);                                            \
+    assert (it != NULL);                                                \
+    it->dict = d;                                                       \
+    size_t i = 0;                                                       \
+    while (i <= d->mask && d->ctrl[i] >= DICTI_SWISS_EMPTY) {           \
+      i++;                                                              \
+    }                                                                   \
+    it->index = i;                                                      \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _it_set)(dict_it_t it, const dict_it_t ref)                 \
+  {                                                                     \
+    assert (it != NULL);                                                \
+    assert (ref != NULL);                                               \
+    it->dict = ref->dict;                                               \
+    it->index = ref->index;                                             \
+    DICTI_SWISS_CONTRACT (it->dict);                                    \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _it_last)(dict_it_t it, const dict_t d)                     \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(d);                                            \
+    assert (it != NULL);                                                \
+    it->dict = d;                                                       \
+    /* if no item, the operation will overflow, and stops the loop */   \
+    size_t i = d->mask;                                                 \
+    while (i <= d->mask && d->ctrl[i] >= DICTI_SWISS_EMPTY) {           \
+      i--;                                                              \
+    }                                                                   \
+    it->index = i;                                                      \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _it_end)(dict_it_t it, const dict_t d)                      \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(d);                                            \
+    assert (it != NULL);                                                \
+    it->dict = d;                                                       \
+    it->index = d->mask+1;                                              \
+  }                                                                     \
+                                                                        \
+  static inline bool                                                    \
+  M_C(name, _end_p)(const dict_it_t it)                                 \
+  {                                                                     \
+    assert (it != NULL);                                                \
+    DICTI_SWISS_CONTRACT (it->dict);                                    \
+    return it->index > it->dict->mask;                                  \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _next)(dict_it_t it)                                        \
+  {                                                                     \
+    assert (it != NULL);                                                \
+    DICTI_SWISS_CONTRACT (it->dict);                                    \
+    size_t i = it->index + 1;                                           \
+    while (i <= it->dict->mask && it->dict->ctrl[i] >= DICTI_SWISS_EMPTY) { \
+      i++;                                                              \
+    }                                                                   \
+    it->index = i;                                                      \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _previous)(dict_it_t it)                                    \
+  {                                                                     \
+    assert (it != NULL);                                                \
+    DICTI_SWISS_CONTRACT (it->dict);                                    \
+    /* if index was 0, the operation will overflow, and stops the loop */ \
+    size_t i = it->index - 1;                                           \
+    while (i <= it->dict->mask && it->dict->ctrl[i] >= DICTI_SWISS_EMPTY) { \
+      i--;                                                              \
+    }                                                                   \
+    it->index = i;                                                      \
+  }                                                                     \
+                                                                        \
+  static inline bool                                                    \
+  M_C(name, _last_p)(const dict_it_t it)                                \
+  {                                                                     \
+    assert (it != NULL);                                                \
+    dict_it_t it2;                                                      \
+    M_C(name,_it_set)(it2, it);                                         \
+    M_C(name, _next)(it2);                                              \
+    return M_C(name, _end_p)(it2);                                      \
+  }                                                                     \
+                                                                        \
+  static inline bool                                                    \
+  M_C(name, _it_equal_p)(const dict_it_t it1,const dict_it_t it2)       \
+  {                                                                     \
+    assert (it1 != NULL && it2 != NULL);                                \
+    DICTI_SWISS_CONTRACT (it1->dict);                                   \
+    DICTI_SWISS_CONTRACT (it2->dict);                                   \
+    return it1->dict == it2->dict && it1->index == it2->index;          \
+  }                                                                     \
+                                                                        \
+  static inline struct M_C(name, _pair_s) *                             \
+  M_C(name, _ref)(const dict_it_t it)                                   \
+  {                                                                     \
+    assert (it != NULL);                                                \
+    DICTI_SWISS_CONTRACT (it -> dict);                                  \
+    const size_t i = it->index;                                         \
+    assert (i <= it->dict->mask);                                       \
+    assert (it->dict->ctrl[i] < DICTI_SWISS_EMPTY);                     \
+    return &it->dict->data[i];                                          \
+  }                                                                     \
+                                                                        \
+  static inline const struct M_C(name, _pair_s) *                       \
+  M_C(name, _cref)(const dict_it_t it)                                  \
+  {                                                                     \
+    return M_CONST_CAST(struct M_C(name, _pair_s), M_C(name, _ref)(it)); \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name,_reserve)(dict_t dict, size_t capacity)                      \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(dict);                                         \
+    size_t size;                                                        \
+    /* Get the size which will allow to fit this capacity */            \
+    size = m_core_roundpow2 (capacity * (1.0 / coeff_up));              \
+    /* Test for overflow of the computation */                          \
+    if (M_UNLIKELY (size < capacity)) {                                 \
+      M_MEMORY_FULL((size_t)-1);                                        \
+    }                                                                   \
+    assert (M_POWEROF2_P(size));                                        \
+    if (size > dict->mask+1) {                                          \
+      dict->upper_limit = (size_t) (size * coeff_up) - 1;               \
+      M_C(name,_int_resize)(dict, size, false);                         \
+    }                                                                   \
+    DICTI_SWISS_CONTRACT(dict);                                         \
+  }                                                                     \
+                                                                        \
+  M_IF_METHOD(EQUAL, value_oplist)(                                     \
+  static inline bool                                                    \
+  M_C(name, _equal_p)(const dict_t dict1, const dict_t dict2)           \
+  {                                                                     \
+    DICTI_SWISS_CONTRACT(dict1);                                        \
+    DICTI_SWISS_CONTRACT(dict2);                                        \
+    /* NOTE: Key type has mandatory equal operator */                   \
+    /* Easy case */                                                     \
+    if (M_LIKELY (dict1->count != dict2->count))                        \
+      return false;                                                     \
+    if (M_UNLIKELY (dict1->count == 0))                                 \
+      return true;                                                      \
+    /* Otherwise this is the slow path */                               \
+    dict_it_t it;                                                       \
+    for(M_C(name, _it)(it, dict1) ;                                     \
+        !M_C(name, _end_p)(it);                                         \
+        M_C(name, _next)(it)) {                                         \
+      const struct M_C(name, _pair_s) *item = M_C(name, _cref)(it);     \
+      value_type *ptr = M_C(name, _get)(dict2, item->key);              \
+      if (ptr == NULL)                                                  \
+        return false;                                                   \
+      if (M_CALL_EQUAL(value_oplist, item->value, *ptr) == false)       \
+        return false;                                                   \
+    }                                                                   \
+    return true;                                                        \
+  }                                                                     \
+  , /* no value equal */ )                                              \
+                                                                        \
+  DICTI_FUNC_ADDITIONAL_DEF2(name, key_type, key_oplist, value_type, value_oplist, 0, dict_t, dict_it_t)
+
 
 #endif
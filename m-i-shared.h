@@ -67,6 +67,7 @@
   SUBTYPE(M_C(name, _type_t))						\
   ,M_IF_METHOD(NEW, oplist)(NEW(M_GET_NEW oplist),)                     \
   ,M_IF_METHOD(REALLOC, oplist)(REALLOC(M_GET_REALLOC oplist),)         \
+  ,M_IF_METHOD(FREE, oplist)(FREE(M_GET_FREE oplist),)                  \
   ,M_IF_METHOD(DEL, oplist)(DEL(M_GET_DEL oplist),)                     \
   )
 
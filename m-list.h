@@ -99,6 +99,7 @@
    ,M_IF_METHOD(HASH, oplist)(HASH(M_C(name, _hash)),)			\
    ,M_IF_METHOD(NEW, oplist)(NEW(M_GET_NEW oplist),)                    \
    ,M_IF_METHOD(REALLOC, oplist)(REALLOC(M_GET_REALLOC oplist),)        \
+   ,M_IF_METHOD(FREE, oplist)(FREE(M_GET_FREE oplist),)                 \
    ,M_IF_METHOD(DEL, oplist)(DEL(M_GET_DEL oplist),)                    \
    )
 
@@ -110,7 +111,7 @@
 #define LISTI_MEMPOOL_DEF(name, type, oplist, list_t, list_it_t)        \
   M_IF_METHOD(MEMPOOL, oplist)(                                         \
 			       						\
-    MEMPOOL_DEF(M_C(name, _mempool), struct M_C(name, _s))              \
+    M_MEMPOOL_DEF_SELECT(oplist)(M_C(name, _mempool), struct M_C(name, _s)) \
     M_GET_MEMPOOL_LINKAGE oplist M_C(name, _mempool_t) M_GET_MEMPOOL oplist; \
     static inline struct M_C(name, _s) *M_C(name, _int_new)(void) {	\
       return M_C(name, _mempool_alloc)(M_GET_MEMPOOL oplist);		\
@@ -724,7 +725,9 @@
     m_serial_return_code_t ret;                                         \
     m_serial_local_t local;                                             \
     bool first_done = false;                                            \
-    ret = f->interface->write_array_start(local, f, 0);                 \
+    /* Counting the elements needs a pass over the list: only if needed */ \
+    ret = f->interface->write_array_start(local, f, f->interface->need_count \
+                                          ? M_C(name, _size)(list) : 0); \
     M_C(name, _it_t) it;						\
     for (M_C(name, _it)(it, list) ;					\
          !M_C(name, _end_p)(it);					\
@@ -26,124 +26,567 @@
 #define MSTARLIB_MEMPOOL_H
 
 #include "m-core.h"
+#include "m-atomic.h"
+#include "m-mutex.h"
 
 /* Fast Fixed Size thread unsafe allocator based on memory region.
    USAGE:
-     MEMPOOL_DEF(memppol_uint, unsigned int)
+     MEMPOOL_DEF(memppol_uint, unsigned int[, max_per_segment])
      ...
      memppol_uint_t m;
      mempool_uint_init(m);
      unsigned int *ptr = mempool_uint_alloc(m);
      *ptr = 17;
      mempool_uint_free(m, ptr);
+     mempool_uint_trim(m);  // Give back the free segments to system
      mempool_uint_clear(m); // Give back memory to system
 */
-// NOTE: Can not use m-list since it may be expanded from LIST_DEF
+#define MEMPOOL_DEF(name, ...)                                          \
+  MEMPOOLI_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                           \
+                  ((name, __VA_ARGS__, MEMPOOL_MAX_PER_SEGMENT(__VA_ARGS__)), \
+                   (name, __VA_ARGS__)))
+
+/* Statistics of a mempool */
+typedef struct mempool_stats_s {
+  size_t segments;  // Number of segments
+  size_t live;      // Number of allocated objects
+  size_t free;      // Number of freed objects available for allocation
+  size_t reserved;  // Number of bytes reserved from the system
+} mempool_stats_t;
 
-#define MEMPOOL_DEF(name, type)                                         \
-  									\
-  typedef union M_C(name,_union_s) {					\
+/* User shall be able to cutomize the size of the segment and/or
+   the minimun number of elements (globally with this macro
+   or for a given mempool with the third argument of MEMPOOL_DEF).
+*/
+#ifndef MEMPOOL_MAX_PER_SEGMENT
+#define MEMPOOL_MAX_PER_SEGMENT(type)					\
+  M_MAX((16*1024-2*sizeof(unsigned int) - 2*sizeof(void*)) / sizeof (type), 256U)
+#endif
+
+/* Fast Fixed Size thread safe allocator based on memory region
+   with a per-thread cache of free objects (magazine).
+   Each thread allocates from and frees to its own magazine without
+   any synchronization. When the magazine is too big, a batch of
+   MEMPOOL_TCACHE_BATCH free objects is given back to a shared lock free
+   depot. When it is empty, the thread takes all the batches of the depot
+   (or carves new objects from its own segment).
+   Each thread has a small table of MEMPOOL_TCACHE_SLOTS caches per type
+   of mempool. A mempool is assigned to a slot of this table at its
+   initialization: if the slot is used by the cache of another mempool,
+   this cache is first given back to its mempool.
+   The API is the same as MEMPOOL_DEF except that:
+   - name_alloc and name_free can be called from any thread,
+   - name_thread_flush gives back the cache of the calling thread:
+   it shall be called by a thread before it terminates (otherwise its
+   cached objects are only reclaimed by name_clear), and by each running
+   thread which used the mempool before the mempool is cleared
+   (except by the thread calling name_clear),
+   - name_init and name_clear shall be called when no other thread
+   uses the mempool.
+   USAGE:
+     MEMPOOL_TCACHE_DEF(mempool_uint, unsigned int[, max_per_segment])
+     ...
+     mempool_uint_t m;
+     mempool_uint_init(m);
+     // In any thread:
+     unsigned int *ptr = mempool_uint_alloc(m);
+     *ptr = 17;
+     mempool_uint_free(m, ptr);
+     mempool_uint_thread_flush(m);
+     ...
+     mempool_uint_clear(m); // Give back memory to system
+*/
+#define MEMPOOL_TCACHE_DEF(name, ...)                                   \
+  MEMPOOLI_TCACHE_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                    \
+                         ((name, __VA_ARGS__, MEMPOOL_MAX_PER_SEGMENT(__VA_ARGS__)), \
+                          (name, __VA_ARGS__)))
+
+#define MEMPOOLI_TCACHE_DEF_P1(arg) MEMPOOLI_TCACHE_DEF_P2 arg
+
+#define MEMPOOLI_TCACHE_DEF_P2(name, type, max_per_segment)             \
+                                                                        \
+  typedef union M_C(name,_union_s) {                                    \
     type t;                                                             \
-    union M_C(name,_union_s) *next;					\
-  } M_C(name,_union_t);							\
-  									\
-  typedef struct M_C(name,_segment_s) {					\
-    unsigned int count;                                                 \
-    struct M_C(name,_segment_s) *next;					\
-    M_C(name,_union_t)	tab[MEMPOOL_MAX_PER_SEGMENT(type)];		\
-  } M_C(name,_segment_t);						\
-  									\
-  typedef struct M_C(name, _s) {					\
-    M_C(name,_union_t)   *free_list;					\
-    M_C(name,_segment_t) *current_segment;				\
-  } M_C(name,_t)[1];							\
-									\
+    struct {                                                            \
+      union M_C(name,_union_s) *next;       /* Next free object */      \
+      union M_C(name,_union_s) *next_batch; /* Next batch in the depot */ \
+    } s;                                                                \
+  } M_C(name,_union_t);                                                 \
+                                                                        \
+  typedef struct M_C(name,_segment_s) {                                 \
+    struct M_C(name,_segment_s) *next;                                  \
+    M_C(name,_union_t)	tab[max_per_segment];                            \
+  } M_C(name,_segment_t);                                               \
+                                                                        \
+  typedef struct M_C(name, _s) {                                        \
+    /* Lock free stack of batches of free objects */                    \
+    M_ATTR_EXTENSION _Atomic(M_C(name,_union_t) *) depot;               \
+    /* Lock free stack of the allocated segments (only pushed) */       \
+    M_ATTR_EXTENSION _Atomic(M_C(name,_segment_t) *) segments;          \
+    mempooli_tcache_id_t id;                                            \
+    unsigned int slot;  /* Slot of the caches of the threads */         \
+  } M_C(name,_t)[1];                                                    \
+                                                                        \
+  /* Cache of the thread. It is valid only for the mempool              \
+     'owner' with the identifier 'id' */                                \
+  typedef struct M_C(name,_tcache_s) {                                  \
+    struct M_C(name, _s) *owner;                                        \
+    mempooli_tcache_id_t id;                                            \
+    M_C(name,_union_t)   *magazine;                                     \
+    unsigned int         count;                                         \
+    M_C(name,_union_t)   *spare;                                        \
+    M_C(name,_segment_t) *segment;                                      \
+    unsigned int         segment_count;                                 \
+  } M_C(name,_tcache_t);                                                \
+                                                                        \
+  static M_THREAD_ATTR M_C(name,_tcache_t) M_C(name,_tcache)[MEMPOOL_TCACHE_SLOTS]; \
+                                                                        \
+  static inline void                                                    \
+  M_C(name,_init)(M_C(name,_t) mem)                                     \
+  {                                                                     \
+    assert (mem != NULL);                                               \
+    atomic_init(&mem->depot, (M_C(name,_union_t) *) NULL);              \
+    atomic_init(&mem->segments, (M_C(name,_segment_t) *) NULL);         \
+    mempooli_tcache_new_id(&mem->id);                                   \
+    mem->slot = (unsigned int) (mem->id.count % MEMPOOL_TCACHE_SLOTS);  \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name,_clear)(M_C(name,_t) mem)                                    \
+  {                                                                     \
+    assert (mem != NULL && mem->id.count != 0);                         \
+    M_C(name,_segment_t) *segment = atomic_load(&mem->segments);        \
+    while (segment != NULL) {                                           \
+      M_C(name,_segment_t) *next = segment->next;                       \
+      M_MEMORY_DEL (segment);                                           \
+      segment = next;                                                   \
+    }                                                                   \
+    /* Clean pointers to be safer. The cache of the calling thread      \
+       is dropped (the other threads have flushed theirs) */            \
+    atomic_store(&mem->depot, (M_C(name,_union_t) *) NULL);             \
+    atomic_store(&mem->segments, (M_C(name,_segment_t) *) NULL);        \
+    mem->id.count = 0;                                                  \
+    if (M_C(name,_tcache)[mem->slot].owner == mem)                      \
+      M_C(name,_tcache)[mem->slot].owner = NULL;                        \
+  }                                                                     \
+                                                                        \
+  /* Push a chain of batches (from 'first' to 'last') in the depot */   \
+  static inline void                                                    \
+  M_C(name,_int_depot_push)(M_C(name,_t) mem,                           \
+                            M_C(name,_union_t) *first,                  \
+                            M_C(name,_union_t) *last)                   \
+  {                                                                     \
+    M_C(name,_union_t) *head = atomic_load(&mem->depot);                \
+    do {                                                                \
+      last->s.next_batch = head;                                        \
+    } while (!atomic_compare_exchange_weak(&mem->depot, &head, first)); \
+  }                                                                     \
+                                                                        \
+  /* Give back a batch of MEMPOOL_TCACHE_BATCH objects of the magazine  \
+     to the depot */                                                    \
+  static inline void                                                    \
+  M_C(name,_int_release_batch)(M_C(name,_t) mem, M_C(name,_tcache_t) *cache) \
+  {                                                                     \
+    assert (cache->count >= MEMPOOL_TCACHE_BATCH);                      \
+    M_C(name,_union_t) *first = cache->magazine;                        \
+    M_C(name,_union_t) *last = first;                                   \
+    for(unsigned int i = 1; i < MEMPOOL_TCACHE_BATCH; i++)              \
+      last = last->s.next;                                              \
+    cache->magazine = last->s.next;                                     \
+    cache->count -= MEMPOOL_TCACHE_BATCH;                               \
+    last->s.next = NULL;                                                \
+    M_C(name,_int_depot_push)(mem, first, first);                       \
+  }                                                                     \
+                                                                        \
+  /* Give back all the objects of the cache to the depot of its owner   \
+     and detach the cache from its owner */                             \
+  static inline void                                                    \
+  M_C(name,_int_tcache_flush)(M_C(name,_tcache_t) *cache)               \
+  {                                                                     \
+    struct M_C(name, _s) *mem = cache->owner;                           \
+    assert (mem != NULL && mem->id.count == cache->id.count             \
+            && mem->id.origin == cache->id.origin);                     \
+    while (cache->count >= MEMPOOL_TCACHE_BATCH)                        \
+      M_C(name,_int_release_batch)(mem, cache);                         \
+    if (cache->magazine != NULL)                                        \
+      /* The last batch is not full */                                  \
+      M_C(name,_int_depot_push)(mem, cache->magazine, cache->magazine); \
+    M_C(name,_union_t) *first = cache->spare;                           \
+    if (first != NULL) {                                                \
+      M_C(name,_union_t) *last = first;                                 \
+      while (last->s.next_batch != NULL)                                \
+        last = last->s.next_batch;                                      \
+      M_C(name,_int_depot_push)(mem, first, last);                      \
+    }                                                                   \
+    /* Give back the objects not used yet of the segment of the thread  \
+       by batches */                                                    \
+    M_C(name,_segment_t) *segment = cache->segment;                     \
+    unsigned int i = cache->segment_count;                              \
+    while (segment != NULL && i < (max_per_segment)) {                  \
+      unsigned int n = M_MIN(MEMPOOL_TCACHE_BATCH, (max_per_segment) - i); \
+      for(unsigned int j = 0; j < n - 1; j++)                           \
+        segment->tab[i+j].s.next = &segment->tab[i+j+1];                \
+      segment->tab[i+n-1].s.next = NULL;                                \
+      M_C(name,_int_depot_push)(mem, &segment->tab[i], &segment->tab[i]); \
+      i += n;                                                           \
+    }                                                                   \
+    cache->owner = NULL;                                                \
+    cache->magazine = NULL;                                             \
+    cache->count = 0;                                                   \
+    cache->spare = NULL;                                                \
+    cache->segment = NULL;                                              \
+    cache->segment_count = 0;                                           \
+  }                                                                     \
+                                                                        \
+  /* Get the cache of the thread for the given mempool.                 \
+     If the slot is used by the cache of another mempool, this cache    \
+     is given back to its mempool. If it is the cache of a previous     \
+     instance of the mempool, its objects have already been released    \
+     by its clear method. */                                            \
+  static inline M_C(name,_tcache_t) *                                   \
+  M_C(name,_int_tcache)(M_C(name,_t) mem)                               \
+  {                                                                     \
+    M_C(name,_tcache_t) *cache = &M_C(name,_tcache)[mem->slot];         \
+    if (M_UNLIKELY (cache->owner != mem                                 \
+                    || cache->id.count != mem->id.count                 \
+                    || cache->id.origin != mem->id.origin)) {           \
+      if (cache->owner != NULL && cache->owner != mem)                  \
+        M_C(name,_int_tcache_flush)(cache);                             \
+      cache->owner = mem;                                               \
+      cache->id = mem->id;                                              \
+      cache->magazine = NULL;                                           \
+      cache->count = 0;                                                 \
+      cache->spare = NULL;                                              \
+      cache->segment = NULL;                                            \
+      cache->segment_count = 0;                                         \
+    }                                                                   \
+    return cache;                                                       \
+  }                                                                     \
+                                                                        \
+  static inline type *                                                  \
+  M_C(name,_int_alloc_slow)(M_C(name,_t) mem, M_C(name,_tcache_t) *cache) \
+  {                                                                     \
+    /* Take a batch from the private spare batches or from the depot.   \
+       Taking all the batches of the depot at once avoids the ABA       \
+       problem of a lock free pop. */                                   \
+    M_C(name,_union_t) *batch = cache->spare;                           \
+    if (batch == NULL && atomic_load_explicit(&mem->depot, memory_order_relaxed) != NULL) \
+      batch = atomic_exchange(&mem->depot, (M_C(name,_union_t) *) NULL); \
+    if (batch != NULL) {                                                \
+      cache->spare = batch->s.next_batch;                               \
+      cache->magazine = batch->s.next;                                  \
+      /* A batch given back by a flush may not be full */               \
+      unsigned int count = 0;                                           \
+      for(M_C(name,_union_t) *p = batch->s.next; p != NULL; p = p->s.next) \
+        count++;                                                        \
+      cache->count = count;                                             \
+      return &batch->t;                                                 \
+    }                                                                   \
+    /* Carve a new object from the segment of the thread */             \
+    M_C(name,_segment_t) *segment = cache->segment;                     \
+    if (M_UNLIKELY (segment == NULL                                     \
+                    || cache->segment_count >= (max_per_segment))) {    \
+      segment = M_MEMORY_ALLOC (M_C(name,_segment_t));                  \
+      if (M_UNLIKELY (segment == NULL)) {                               \
+        M_MEMORY_FULL(sizeof (M_C(name,_segment_t)));                   \
+        return NULL;                                                    \
+      }                                                                 \
+      segment->next = atomic_load(&mem->segments);                      \
+      while (!atomic_compare_exchange_weak(&mem->segments, &segment->next, segment)); \
+      cache->segment = segment;                                         \
+      cache->segment_count = 0;                                         \
+    }                                                                   \
+    return &segment->tab[cache->segment_count++].t;                     \
+  }                                                                     \
+                                                                        \
+  static inline type *                                                  \
+  M_C(name,_alloc)(M_C(name,_t) mem)                                    \
+  {                                                                     \
+    assert (mem != NULL && mem->id.count != 0);                         \
+    M_C(name,_tcache_t) *cache = M_C(name,_int_tcache)(mem);            \
+    M_C(name,_union_t) *ret = cache->magazine;                          \
+    if (M_LIKELY (ret != NULL)) {                                       \
+      cache->magazine = ret->s.next;                                    \
+      cache->count--;                                                   \
+      return &ret->t;                                                   \
+    }                                                                   \
+    return M_C(name,_int_alloc_slow)(mem, cache);                       \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name,_free)(M_C(name,_t) mem, type *ptr)                          \
+  {                                                                     \
+    assert (mem != NULL && mem->id.count != 0);                         \
+    M_C(name,_tcache_t) *cache = M_C(name,_int_tcache)(mem);            \
+    /* NOTE: Unsafe cast: suppose that the given pointer                \
+       was allocated by the previous alloc function. */                 \
+    M_C(name,_union_t) *ret = (M_C(name,_union_t) *)(uintptr_t)ptr;     \
+    ret->s.next = cache->magazine;                                      \
+    cache->magazine = ret;                                              \
+    if (M_UNLIKELY (++cache->count >= 2 * MEMPOOL_TCACHE_BATCH))        \
+      M_C(name,_int_release_batch)(mem, cache);                         \
+  }                                                                     \
+                                                                        \
+  /* Give back all the objects cached by the thread to the depot        \
+     and release its slot */                                            \
+  static inline void                                                    \
+  M_C(name,_thread_flush)(M_C(name,_t) mem)                             \
+  {                                                                     \
+    assert (mem != NULL && mem->id.count != 0);                         \
+    M_C(name,_tcache_t) *cache = &M_C(name,_tcache)[mem->slot];         \
+    if (cache->owner == mem && cache->id.count == mem->id.count         \
+        && cache->id.origin == mem->id.origin)                          \
+      M_C(name,_int_tcache_flush)(cache);                               \
+  }
+
+/* Number of free objects exchanged between the cache of a thread
+   and the shared depot of a MEMPOOL_TCACHE_DEF */
+#ifndef MEMPOOL_TCACHE_BATCH
+#define MEMPOOL_TCACHE_BATCH 64U
+#endif
+
+/* Number of caches of a thread for a MEMPOOL_TCACHE_DEF type */
+#ifndef MEMPOOL_TCACHE_SLOTS
+#define MEMPOOL_TCACHE_SLOTS 4U
+#endif
+
+
+/********************************** INTERNAL ************************************/
+
+/* Deferred evaluation for the mempool definition,
+   so that all arguments are evaluated before further expansion */
+#define MEMPOOLI_DEF_P1(arg) MEMPOOLI_DEF_P2 arg
+
+// NOTE: Can not use m-list since it may be expanded from LIST_DEF
+#define MEMPOOLI_DEF_P2(name, type, max_per_segment)                    \
+                                                                        \
+  typedef union M_C(name,_union_s) {                                    \
+    type t;                                                             \
+    union M_C(name,_union_s) *next;                                     \
+  } M_C(name,_union_t);                                                 \
+                                                                        \
+  typedef struct M_C(name,_segment_s) {                                 \
+    unsigned int count;       /* Number of used objects */              \
+    unsigned int free_count;  /* Number of free objects (only for trim) */ \
+    struct M_C(name,_segment_s) *next;                                  \
+    M_C(name,_union_t)	tab[max_per_segment];                           \
+  } M_C(name,_segment_t);                                               \
+                                                                        \
+  typedef struct M_C(name, _s) {                                        \
+    M_C(name,_union_t)   *free_list;                                    \
+    M_C(name,_segment_t) *current_segment;                              \
+    size_t               segment_count;                                 \
+    size_t               live_count;                                    \
+  } M_C(name,_t)[1];                                                    \
+                                                                        \
   static inline void                                                    \
   M_C(name,_init)(M_C(name,_t) mem)                                     \
   {                                                                     \
     mem->free_list = NULL;                                              \
-    mem->current_segment = M_MEMORY_ALLOC(M_C(name,_segment_t));	\
+    mem->current_segment = M_MEMORY_ALLOC(M_C(name,_segment_t));        \
     if (mem->current_segment == NULL) {                                 \
-      M_MEMORY_FULL(sizeof (M_C(name,_segment_t)));			\
+      M_MEMORY_FULL(sizeof (M_C(name,_segment_t)));                     \
       return;                                                           \
     }                                                                   \
     mem->current_segment->next = NULL;                                  \
     mem->current_segment->count = 0;                                    \
-    MEMPOOLI_CONTRACT(mem, type);                                       \
+    mem->segment_count = 1;                                             \
+    mem->live_count = 0;                                                \
+    MEMPOOLI_CONTRACT(mem, max_per_segment);                            \
   }                                                                     \
-  									\
+                                                                        \
   static inline void                                                    \
-  M_C(name,_clear)(M_C(name,_t) mem)					\
+  M_C(name,_clear)(M_C(name,_t) mem)                                    \
   {                                                                     \
-    MEMPOOLI_CONTRACT(mem, type);                                       \
-    M_C(name,_segment_t) *segment = mem->current_segment;		\
+    MEMPOOLI_CONTRACT(mem, max_per_segment);                            \
+    M_C(name,_segment_t) *segment = mem->current_segment;               \
     while (segment != NULL) {                                           \
-      M_C(name,_segment_t) *next = segment->next;			\
-      M_MEMORY_DEL (segment);						\
+      M_C(name,_segment_t) *next = segment->next;                       \
+      M_MEMORY_DEL (segment);                                           \
       segment = next;                                                   \
     }                                                                   \
-    /* Clean pointers to be safer */					\
+    /* Clean pointers to be safer */                                    \
     mem->free_list = NULL;                                              \
     mem->current_segment = NULL;                                        \
   }                                                                     \
-  									\
+                                                                        \
   static inline type *                                                  \
-  M_C(name,_alloc)(M_C(name,_t) mem)					\
+  M_C(name,_alloc)(M_C(name,_t) mem)                                    \
   {                                                                     \
-    MEMPOOLI_CONTRACT(mem, type);                                       \
-    M_C(name,_union_t) *ret = mem->free_list;				\
+    MEMPOOLI_CONTRACT(mem, max_per_segment);                            \
+    M_C(name,_union_t) *ret = mem->free_list;                           \
+    mem->live_count++;                                                  \
     if (ret != NULL) {                                                  \
       mem->free_list = ret->next;                                       \
       return &ret->t;                                                   \
     }                                                                   \
-    M_C(name,_segment_t) *segment = mem->current_segment;		\
+    M_C(name,_segment_t) *segment = mem->current_segment;               \
     assert(segment != NULL);                                            \
     unsigned int count = segment->count;                                \
-    if (M_UNLIKELY (count >= MEMPOOL_MAX_PER_SEGMENT(type))) {		\
+    if (M_UNLIKELY (count >= (max_per_segment))) {                      \
       M_C(name,_segment_t) *new_segment = M_MEMORY_ALLOC (M_C(name,_segment_t)); \
-      if (M_UNLIKELY (new_segment == NULL)) {				\
-        M_MEMORY_FULL(sizeof (M_C(name,_segment_t)));			\
+      if (M_UNLIKELY (new_segment == NULL)) {                           \
+        M_MEMORY_FULL(sizeof (M_C(name,_segment_t)));                   \
         return NULL;                                                    \
       }                                                                 \
       new_segment->next = segment;                                      \
       new_segment->count = 0;                                           \
       mem->current_segment = new_segment;                               \
+      mem->segment_count++;                                             \
       segment = new_segment;                                            \
       count = 0;                                                        \
     }                                                                   \
     ret = &segment->tab[count];                                         \
     segment->count = count + 1;                                         \
-    MEMPOOLI_CONTRACT(mem, type);                                       \
+    MEMPOOLI_CONTRACT(mem, max_per_segment);                            \
     return &ret->t;                                                     \
   }                                                                     \
-  									\
+                                                                        \
   static inline void                                                    \
-  M_C(name,_free)(M_C(name,_t) mem, type *ptr)				\
+  M_C(name,_free)(M_C(name,_t) mem, type *ptr)                          \
   {                                                                     \
-    MEMPOOLI_CONTRACT(mem, type);                                       \
+    MEMPOOLI_CONTRACT(mem, max_per_segment);                            \
     /* NOTE: Unsafe cast: suppose that the given pointer                \
        was allocated by the previous alloc function. */                 \
-    M_C(name,_union_t) *ret = (M_C(name,_union_t) *)(uintptr_t)ptr;	\
+    M_C(name,_union_t) *ret = (M_C(name,_union_t) *)(uintptr_t)ptr;     \
     ret->next = mem->free_list;                                         \
     mem->free_list = ret;                                               \
-    MEMPOOLI_CONTRACT(mem, type);                                       \
+    assert (mem->live_count > 0);                                       \
+    mem->live_count--;                                                  \
+    MEMPOOLI_CONTRACT(mem, max_per_segment);                            \
   }                                                                     \
-
-/* User shall be able to cutomize the size of the segment and/or
-   the minimun number of elements.
-*/
-#ifndef MEMPOOL_MAX_PER_SEGMENT
-#define MEMPOOL_MAX_PER_SEGMENT(type)					\
-  M_MAX((16*1024-sizeof(unsigned int) - 2*sizeof(void*)) / sizeof (type), 256U)
-#endif
-
-/********************************** INTERNAL ************************************/
+                                                                        \
+  static inline void                                                    \
+  M_C(name,_stats)(mempool_stats_t *stats, const M_C(name,_t) mem)      \
+  {                                                                     \
+    MEMPOOLI_CONTRACT(mem, max_per_segment);                            \
+    assert (stats != NULL);                                             \
+    /* All the segments but the current one are fully used */           \
+    size_t used = (mem->segment_count - 1) * (max_per_segment)          \
+      + mem->current_segment->count;                                    \
+    stats->segments = mem->segment_count;                               \
+    stats->live = mem->live_count;                                      \
+    stats->free = used - mem->live_count;                               \
+    stats->reserved = mem->segment_count * sizeof (M_C(name,_segment_t)); \
+  }                                                                     \
+                                                                        \
+  /* Return the segment of the sorted table 'tab' of 'n' segments       \
+     which owns the object 'obj' (its index) */                         \
+  static inline size_t                                                  \
+  M_C(name,_int_find_segment)(M_C(name,_segment_t) **tab, size_t n,     \
+                              const M_C(name,_union_t) *obj)            \
+  {                                                                     \
+    size_t lo = 0;                                                      \
+    size_t hi = n;                                                      \
+    while (hi - lo > 1) {                                               \
+      size_t mid = lo + (hi - lo) / 2;                                  \
+      if ((uintptr_t) obj < (uintptr_t) tab[mid])                       \
+        hi = mid;                                                       \
+      else                                                              \
+        lo = mid;                                                       \
+    }                                                                   \
+    assert ((uintptr_t) obj >= (uintptr_t) &tab[lo]->tab[0]);           \
+    assert ((uintptr_t) obj < (uintptr_t) &tab[lo]->tab[tab[lo]->count]); \
+    return lo;                                                          \
+  }                                                                     \
+                                                                        \
+  /* Give back to the system the segments which objects are all free.   \
+     The current segment is kept but can be reused from its beginning.  \
+     Return the number of segments given back. */                       \
+  static inline size_t                                                  \
+  M_C(name,_trim)(M_C(name,_t) mem)                                     \
+  {                                                                     \
+    MEMPOOLI_CONTRACT(mem, max_per_segment);                            \
+    if (mem->free_list == NULL)                                         \
+      return 0;                                                         \
+    const size_t n = mem->segment_count;                                \
+    /* Table of the segments sorted by address */                       \
+    M_C(name,_segment_t) **tab = M_MEMORY_REALLOC(M_C(name,_segment_t) *, NULL, n); \
+    if (M_UNLIKELY (tab == NULL)) {                                     \
+      /* Nothing is trimmed: it is not an error */                      \
+      return 0;                                                         \
+    }                                                                   \
+    size_t i = 0;                                                       \
+    for(M_C(name,_segment_t) *s = mem->current_segment; s != NULL; s = s->next) { \
+      s->free_count = 0;                                                \
+      tab[i++] = s;                                                     \
+    }                                                                   \
+    assert (i == n);                                                    \
+    qsort(tab, n, sizeof tab[0], mempooli_cmp_ptr);                     \
+    for(M_C(name,_union_t) *p = mem->free_list; p != NULL; p = p->next) \
+      tab[M_C(name,_int_find_segment)(tab, n, p)]->free_count++;        \
+    /* Keep in free_count only a flag: is the segment empty? */         \
+    size_t empty = 0;                                                   \
+    for(i = 0; i < n; i++) {                                            \
+      M_C(name,_segment_t) *s = tab[i];                                 \
+      assert (s->free_count <= s->count);                               \
+      s->free_count = (s->free_count == s->count && s->count != 0);     \
+      empty += s->free_count;                                           \
+    }                                                                   \
+    if (empty != 0) {                                                   \
+      /* Remove the objects of the empty segments from the free list */ \
+      M_C(name,_union_t) **ref = &mem->free_list;                       \
+      while (*ref != NULL) {                                            \
+        M_C(name,_union_t) *p = *ref;                                   \
+        if (tab[M_C(name,_int_find_segment)(tab, n, p)]->free_count)    \
+          *ref = p->next;                                               \
+        else                                                            \
+          ref = &p->next;                                               \
+      }                                                                 \
+      for(i = 0; i < n; i++)                                            \
+        if (tab[i]->free_count)                                         \
+          tab[i]->count = 0;                                            \
+      /* Give back the empty segments except the current one            \
+         which can be reused from its beginning */                      \
+      M_C(name,_segment_t) **ref_segment = &mem->current_segment->next; \
+      while (*ref_segment != NULL) {                                    \
+        M_C(name,_segment_t) *s = *ref_segment;                         \
+        if (s->count == 0) {                                            \
+          *ref_segment = s->next;                                       \
+          M_MEMORY_DEL(s);                                              \
+          mem->segment_count--;                                         \
+        } else {                                                        \
+          ref_segment = &s->next;                                       \
+        }                                                               \
+      }                                                                 \
+    }                                                                   \
+    M_MEMORY_FREE(tab);                                                 \
+    MEMPOOLI_CONTRACT(mem, max_per_segment);                            \
+    return n - mem->segment_count;                                      \
+  }
 
 
-#define MEMPOOLI_CONTRACT(mempool, type) do {                           \
+#define MEMPOOLI_CONTRACT(mempool, max_per_segment) do {                \
     assert((mempool) != NULL);                                          \
     assert((mempool)->current_segment != NULL);                         \
-    assert((mempool)->current_segment->count <= MEMPOOL_MAX_PER_SEGMENT(type)); \
+    assert((mempool)->current_segment->count <= (max_per_segment));     \
+    assert((mempool)->segment_count >= 1);                              \
   } while (0)
 
+/* Compare the addresses of two segments (for qsort) */
+static inline int
+mempooli_cmp_ptr(const void *a, const void *b)
+{
+  uintptr_t pa = (uintptr_t) *(void * const *) a;
+  uintptr_t pb = (uintptr_t) *(void * const *) b;
+  return (pa > pb) - (pa < pb);
+}
+
+/* Identifier of a MEMPOOL_TCACHE_DEF instance (used to detect obsolete
+   thread caches). As the counter is local to the translation unit,
+   the identifier includes the address of the counter so that
+   two translation units cannot create the same identifier. */
+typedef struct mempooli_tcache_id_s {
+  unsigned long long count;
+  const void        *origin;
+} mempooli_tcache_id_t;
+
+static inline void
+mempooli_tcache_new_id(mempooli_tcache_id_t *id)
+{
+  static atomic_ullong counter = ATOMIC_VAR_INIT(0ULL);
+  id->count = atomic_fetch_add(&counter, 1ULL) + 1;
+  id->origin = &counter;
+}
+
 #endif
@@ -0,0 +1,405 @@
+/*
+ * M*LIB - MMAP module
+ *
+ * Copyright (c) 2017-2019, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef MSTARLIB_MMAP_H
+#define MSTARLIB_MMAP_H
+
+#include "m-core.h"
+
+/* Allocation policy for big tables (the buffer of an ARRAY,
+   the table of an open addressing DICT, ...).
+   Blocks below MMAP_THRESHOLD bytes are allocated with the default
+   allocator. Bigger blocks are directly mapped from the system
+   so that they can be backed by huge pages (reducing the TLB misses
+   of random accesses), optionally interleaved over the NUMA nodes,
+   and grown by remapping their pages instead of copying them.
+   USAGE:
+     ARRAY_DEF(array_uint, unsigned int, MMAP_OPLIST(M_DEFAULT_OPLIST))
+     DICT_OA_DEF2(dict_ulong, unsigned long, MMAP_OPLIST(KEY_OPLIST),
+                  unsigned long, M_DEFAULT_OPLIST)
+
+   The REALLOC & FREE methods of the oplist are replaced (the nodes
+   allocated by NEW are too small to benefit from it).
+   It needs the mmap system interface (POSIX): on other systems,
+   or if it is not visible (strict ISO C mode without _DEFAULT_SOURCE,
+   _GNU_SOURCE, ...), all the blocks are allocated with the default
+   allocator. Remapping, huge pages & NUMA interleaving are Linux only.
+
+   It also provides a read-only view of a file (m_mmap_file_t) to use
+   in place the raw images of the containers of POD types:
+     FILE *f = fopen("table.dat", "wb");
+     dict_ulong_out_mmap(f, dict);
+     fclose(f);
+     ...
+     m_mmap_file_t file;
+     dict_ulong_t view;
+     if (m_mmap_file_open(file, "table.dat")) {
+       if (dict_ulong_init_mmap(view, file->data, file->size))
+         value = dict_ulong_get(view, key);
+       m_mmap_file_close(file);
+     }
+*/
+
+/* Size in bytes above which a block is mapped from the system */
+#ifndef MMAP_THRESHOLD
+#define MMAP_THRESHOLD (2*1024*1024)
+#endif
+
+/* Size of a huge page: the mapped blocks are rounded and aligned to it */
+#ifndef MMAP_HUGE_PAGE_SIZE
+#define MMAP_HUGE_PAGE_SIZE (2*1024*1024)
+#endif
+
+/* Try first to map the blocks from the pool of explicit huge pages
+   (hugetlbfs) before falling back to transparent huge pages.
+   Disabled by default as this pool is reserved by the administrator
+   for specific applications. */
+#ifndef MMAP_USE_HUGETLB
+#define MMAP_USE_HUGETLB 0
+#endif
+
+/* Flags of m_mmap_realloc */
+#define M_MMAP_DEFAULT    0U
+#define M_MMAP_INTERLEAVE 1U   // Interleave the pages over all the NUMA nodes
+
+#if (defined(__unix__) || (defined(__APPLE__) && defined(__MACH__)))
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+# define M_MMAPI_USE_FILE 1
+#else
+# define M_MMAPI_USE_FILE 0
+#endif
+
+#if defined(MAP_ANONYMOUS)
+# define M_MMAPI_USE_MMAP 1
+# define M_MMAPI_MAP_ANONYMOUS MAP_ANONYMOUS
+#elif defined(MAP_ANON)
+# define M_MMAPI_USE_MMAP 1
+# define M_MMAPI_MAP_ANONYMOUS MAP_ANON
+#else
+# define M_MMAPI_USE_MMAP 0
+#endif
+
+/* mremap & mbind are only declared in GNU mode (and by libnuma):
+   use directly the system calls. */
+#if M_MMAPI_USE_MMAP && defined(__linux__)
+#include <sys/syscall.h>
+# define M_MMAPI_USE_LINUX 1
+# define M_MMAPI_MREMAP_MAYMOVE 1
+# define M_MMAPI_MPOL_INTERLEAVE 3
+#else
+# define M_MMAPI_USE_LINUX 0
+#endif
+
+/* Header stored before each block.
+   'size' is the size requested by the user.
+   'mapped' is the size of the mapping (or 0 if allocated by the default
+   allocator). It has the maximum alignment needed by any object. */
+typedef union m_mmapi_header_u {
+  struct {
+    size_t size;
+    size_t mapped;
+  } s;
+  long long   ll;
+  long double ld;
+  void       *ptr;
+  void      (*func)(void);
+} m_mmapi_header_t;
+
+#define M_MMAPI_ROUND(size)                                             \
+  (((size) + MMAP_HUGE_PAGE_SIZE - 1) / MMAP_HUGE_PAGE_SIZE * MMAP_HUGE_PAGE_SIZE)
+
+#if M_MMAPI_USE_LINUX
+
+/* Bind the pages of [ptr, ptr+len[ to all the NUMA nodes allowed to the
+   thread in an interleaved way. It is only a hint: the errors are ignored
+   (non NUMA kernel, ...) */
+static inline void
+m_mmapi_interleave(void *ptr, size_t len)
+{
+#ifdef SYS_mbind
+  /* The kernel keeps only the allowed nodes with memory of this mask */
+  unsigned long mask = ~0UL;
+  (void) syscall(SYS_mbind, ptr, len, M_MMAPI_MPOL_INTERLEAVE,
+                 &mask, (unsigned long) (sizeof mask * CHAR_BIT), 0U);
+#else
+  (void) ptr;
+  (void) len;
+#endif
+}
+
+/* Hints the kernel to back the mapping with transparent huge pages */
+static inline void
+m_mmapi_advise(void *ptr, size_t len, unsigned flags)
+{
+#ifdef MADV_HUGEPAGE
+  (void) madvise(ptr, len, MADV_HUGEPAGE);
+#endif
+  if (flags & M_MMAP_INTERLEAVE)
+    m_mmapi_interleave(ptr, len);
+}
+
+#endif
+
+#if M_MMAPI_USE_MMAP
+
+/* Map 'len' bytes (multiple of the huge page size).
+   Return NULL in case of failure */
+static inline m_mmapi_header_t *
+m_mmapi_map(size_t len, unsigned flags)
+{
+  void *p;
+  (void) flags;
+  assert (len % MMAP_HUGE_PAGE_SIZE == 0);
+#if MMAP_USE_HUGETLB && defined(MAP_HUGETLB)
+  p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | M_MMAPI_MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (p != MAP_FAILED) {
+    if (flags & M_MMAP_INTERLEAVE)
+      m_mmapi_interleave(p, len);
+    return (m_mmapi_header_t *) p;
+  }
+#endif
+  /* Map one more huge page to align the start of the block on
+     a huge page boundary: the system can only back aligned areas
+     with huge pages. */
+  if (M_UNLIKELY (len > SIZE_MAX - MMAP_HUGE_PAGE_SIZE))
+    return NULL;
+  p = mmap(NULL, len + MMAP_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | M_MMAPI_MAP_ANONYMOUS, -1, 0);
+  if (M_UNLIKELY (p == MAP_FAILED))
+    return NULL;
+  char *base = (char *) p;
+  size_t head = (size_t) (-(uintptr_t) base % MMAP_HUGE_PAGE_SIZE);
+  if (head != 0)
+    munmap(base, head);
+  munmap(base + head + len, MMAP_HUGE_PAGE_SIZE - head);
+  base += head;
+#if M_MMAPI_USE_LINUX
+  m_mmapi_advise(base, len, flags);
+#endif
+  return (m_mmapi_header_t *) base;
+}
+
+/* Resize the mapping 'h' of 'old_len' bytes to 'len' bytes.
+   Return NULL in case of failure ('h' is still valid) */
+static inline m_mmapi_header_t *
+m_mmapi_remap(m_mmapi_header_t *h, size_t old_len, size_t len, unsigned flags)
+{
+#if M_MMAPI_USE_LINUX && defined(SYS_mremap)
+  /* The pages are moved by updating the page table: no copy */
+  long r = syscall(SYS_mremap, (void *) h, old_len, len,
+                   M_MMAPI_MREMAP_MAYMOVE, (void *) 0);
+  if (r != -1) {
+    void *p = (void *) r;
+    if (len > old_len)
+      m_mmapi_advise(p, len, flags);
+    return (m_mmapi_header_t *) p;
+  }
+  /* The mapping may not be remapped (explicit huge pages on older kernels):
+     fall back to a copy */
+#endif
+  m_mmapi_header_t *n = m_mmapi_map(len, flags);
+  if (M_UNLIKELY (n == NULL))
+    return NULL;
+  memcpy(n, h, M_MIN(old_len, len));
+  munmap(h, old_len);
+  return n;
+}
+
+#endif
+
+/* Reallocate the block 'ptr' (allocated by m_mmap_realloc or NULL)
+   to 'size' bytes, using the given flags (M_MMAP_DEFAULT or
+   M_MMAP_INTERLEAVE) if the block is mapped.
+   A block which has been mapped stays mapped even if it shrinks.
+   Return NULL in case of failure ('ptr' is still valid). */
+static inline void *
+m_mmap_realloc(void *ptr, size_t size, unsigned flags)
+{
+  (void) flags;
+  if (M_UNLIKELY (size > SIZE_MAX - 2*MMAP_HUGE_PAGE_SIZE - sizeof (m_mmapi_header_t)))
+    return NULL;
+  size_t total = sizeof (m_mmapi_header_t) + size;
+  m_mmapi_header_t *h = ptr == NULL ? NULL : (m_mmapi_header_t *) ptr - 1;
+  m_mmapi_header_t *n = NULL;
+#if M_MMAPI_USE_MMAP
+  if (total >= MMAP_THRESHOLD || (h != NULL && h->s.mapped != 0)) {
+    size_t len = M_MMAPI_ROUND(total);
+    if (h == NULL) {
+      n = m_mmapi_map(len, flags);
+    } else if (h->s.mapped == 0) {
+      /* The block becomes big enough to be mapped */
+      n = m_mmapi_map(len, flags);
+      if (n != NULL) {
+        memcpy(n + 1, h + 1, h->s.size);
+        M_MEMORY_FREE(h);
+      }
+    } else if (h->s.mapped == len) {
+      n = h;
+    } else {
+      n = m_mmapi_remap(h, h->s.mapped, len, flags);
+      if (n == NULL)
+        return NULL;
+    }
+    if (n != NULL) {
+      n->s.size = size;
+      n->s.mapped = len;
+      return n + 1;
+    }
+    /* Mapping failed: try with the default allocator */
+  }
+#endif
+  assert (h == NULL || h->s.mapped == 0);
+  n = M_MEMORY_REALLOC(m_mmapi_header_t, h,
+                       (total + sizeof (m_mmapi_header_t) - 1) / sizeof (m_mmapi_header_t));
+  if (M_UNLIKELY (n == NULL))
+    return NULL;
+  n->s.size = size;
+  n->s.mapped = 0;
+  return n + 1;
+}
+
+/* Free the block 'ptr' allocated by m_mmap_realloc (or NULL) */
+static inline void
+m_mmap_free(void *ptr)
+{
+  if (ptr == NULL)
+    return;
+  m_mmapi_header_t *h = (m_mmapi_header_t *) ptr - 1;
+#if M_MMAPI_USE_MMAP
+  if (h->s.mapped != 0) {
+    munmap(h, h->s.mapped);
+    return;
+  }
+#endif
+  assert (h->s.mapped == 0);
+  M_MEMORY_FREE(h);
+}
+
+/* Return true if the block 'ptr' has been mapped from the system */
+static inline bool
+m_mmap_mapped_p(const void *ptr)
+{
+  return ptr != NULL && ((const m_mmapi_header_t *) ptr - 1)->s.mapped != 0;
+}
+
+/* Read-only view of a whole file.
+   It is typically the raw image of a container written by its _out_mmap
+   method, to be used in place by its _init_mmap method.
+   The file is mapped in memory if possible (its pages are then shared
+   with the page cache and with the other processes mapping it),
+   otherwise it is read in memory. */
+typedef struct m_mmap_file_s {
+  void  *data;
+  size_t size;
+} m_mmap_file_t[1];
+
+/* Open the file 'filename' and map it in memory.
+   Return false in case of failure (or if the file is empty). */
+static inline bool
+m_mmap_file_open(m_mmap_file_t file, const char filename[])
+{
+  assert (file != NULL && filename != NULL);
+#if M_MMAPI_USE_FILE
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0
+      || (uintmax_t) st.st_size > SIZE_MAX) {
+    close(fd);
+    return false;
+  }
+  void *p = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  /* The mapping keeps its own reference to the file */
+  close(fd);
+  if (p == MAP_FAILED)
+    return false;
+  file->data = p;
+  file->size = (size_t) st.st_size;
+  return true;
+#else
+  FILE *f = fopen(filename, "rb");
+  if (f == NULL)
+    return false;
+  long s = fseek(f, 0, SEEK_END) != 0 ? -1 : ftell(f);
+  char *p = NULL;
+  if (s > 0 && (unsigned long) s <= SIZE_MAX && fseek(f, 0, SEEK_SET) == 0) {
+    p = M_MEMORY_REALLOC(char, NULL, (size_t) s);
+    if (p != NULL && fread(p, 1, (size_t) s, f) != (size_t) s) {
+      M_MEMORY_FREE(p);
+      p = NULL;
+    }
+  }
+  fclose(f);
+  if (p == NULL)
+    return false;
+  file->data = p;
+  file->size = (size_t) s;
+  return true;
+#endif
+}
+
+/* Close the view of the file. The containers using it become invalid. */
+static inline void
+m_mmap_file_close(m_mmap_file_t file)
+{
+  assert (file != NULL && file->data != NULL);
+#if M_MMAPI_USE_FILE
+  munmap(file->data, file->size);
+#else
+  M_MEMORY_FREE(file->data);
+#endif
+  file->data = NULL;
+  file->size = 0;
+}
+
+/* Extend the given oplist so that the big tables of the containers
+   (REALLOC & FREE methods) are allocated with m_mmap_realloc.
+   The methods are plain macros so that they remain valid when they
+   are inherited by the oplists of the containers built on top of it. */
+#define MMAP_OPLIST(oplist)                                             \
+  M_OPEXTEND(oplist, REALLOC(MMAPI_REALLOC), FREE(m_mmap_free))
+
+/* Same as MMAP_OPLIST, but the pages of the big tables are
+   interleaved over all the NUMA nodes (for tables shared by threads
+   running on different nodes). */
+#define MMAP_INTERLEAVE_OPLIST(oplist)                                  \
+  M_OPEXTEND(oplist, REALLOC(MMAPI_REALLOC_INTERLEAVE), FREE(m_mmap_free))
+
+
+/********************************** INTERNAL ************************************/
+
+#define MMAPI_REALLOC(type, ptr, n)                                     \
+  ((type *) (M_UNLIKELY ((n) > SIZE_MAX / sizeof (type)) ? NULL         \
+             : m_mmap_realloc((ptr), (n) * sizeof (type), M_MMAP_DEFAULT)))
+
+#define MMAPI_REALLOC_INTERLEAVE(type, ptr, n)                          \
+  ((type *) (M_UNLIKELY ((n) > SIZE_MAX / sizeof (type)) ? NULL         \
+             : m_mmap_realloc((ptr), (n) * sizeof (type), M_MMAP_INTERLEAVE)))
+
+#endif
@@ -359,6 +359,56 @@ static inline void m_oncei_call(m_oncei_t o, void (*func)(void))
 
 #endif
 
+/* Internal parking service based on an address (a 32 bits integer):
+   - m_futexi_wait blocks the calling thread as long as the integer
+   pointed by 'addr' is equal to 'expected' (it may return spuriously),
+   - m_futexi_wake wakes up at most 'n' threads waiting on 'addr'.
+   If M_USE_FUTEX is defined to 1 (Linux only), it is directly the futex
+   system call. The prototype of syscall shall then be visible
+   (define _GNU_SOURCE or _DEFAULT_SOURCE before including any header
+   in strict ISO C mode).
+   Otherwise (default), waiting is emulated by yielding the thread, and
+   the caller shall loop until its condition is fulfilled (as it has to
+   anyway). */
+#ifndef M_USE_FUTEX
+# define M_USE_FUTEX 0
+#endif
+
+#if M_USE_FUTEX
+#ifndef __linux__
+# error "M_USE_FUTEX is only supported on Linux."
+#endif
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#if !defined(__USE_MISC) && !defined(_GNU_SOURCE) && !defined(_BSD_SOURCE) && !defined(_DEFAULT_SOURCE)
+# error "M_USE_FUTEX needs the prototype of syscall: define _GNU_SOURCE or _DEFAULT_SOURCE before including any header."
+#endif
+
+static inline void m_futexi_wait(void *addr, unsigned int expected)
+{
+  syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, (void*) 0, (void*) 0, 0);
+}
+
+static inline void m_futexi_wake(void *addr, int n)
+{
+  syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, (void*) 0, (void*) 0, 0);
+}
+#else
+static inline void m_futexi_wait(void *addr, unsigned int expected)
+{
+  (void) addr;
+  (void) expected;
+  m_thread_yield();
+}
+
+static inline void m_futexi_wake(void *addr, int n)
+{
+  (void) addr;
+  (void) n;
+}
+#endif
+
 // TODO: m_thread_sleep doesn't yield thread during waiting, making it a poor choice for active waiting.
 // TODO: Obsolete M_LOCK macro.
 
@@ -89,6 +89,7 @@
    M_IF_METHOD(HASH, oplist)(HASH(M_C(name, _hash)),)			\
    ,M_IF_METHOD(NEW, oplist)(NEW(M_GET_NEW oplist),)                    \
    ,M_IF_METHOD(REALLOC, oplist)(REALLOC(M_GET_REALLOC oplist),)        \
+   ,M_IF_METHOD(FREE, oplist)(FREE(M_GET_FREE oplist),)                 \
    ,M_IF_METHOD(DEL, oplist)(DEL(M_GET_DEL oplist),)                    \
    )
 
@@ -168,7 +169,7 @@ typedef enum {
   typedef type M_C(name, _type_t);					\
                                                                         \
   M_IF_METHOD(MEMPOOL, oplist)(                                         \
-    MEMPOOL_DEF(M_C(name, _mempool), node_t)                            \
+    M_MEMPOOL_DEF_SELECT(oplist)(M_C(name, _mempool), node_t)           \
     M_GET_MEMPOOL_LINKAGE oplist M_C(name, _mempool_t) M_GET_MEMPOOL oplist; \
     static inline node_t *M_C(name,_int_new)(void) {			\
       return M_C(name, _mempool_alloc)(M_GET_MEMPOOL oplist);		\
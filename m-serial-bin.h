@@ -30,14 +30,239 @@
 #include "m-core.h"
 #include "m-string.h"
 
+/* The serial objects can work over:
+   - a FILE (one stdio call per field),
+   - a string_t (write only) to which the fields are appended,
+   - a memory buffer given by the user.
+   For the memory backends, the fields are simply copied in (or from)
+   the memory, so that a whole container can be serialized into memory
+   and then be written (or sent) in one block.
+
+   The stream can have two formats:
+   - native: the integers, floats & sizes are written with their size
+     in memory, the strings are null terminated,
+   - compact: the integers & sizes are written as LEB128 varints
+     (zigzag encoded for the signed values) and the strings are
+     prefixed by their length.
+   A compact stream starts with a magic header, written before the first
+   field (or at clear) so that the format can be selected just after the
+   initialization. A native stream has no header (so that the streams
+   written before the compact format can still be read).
+   The reader detects the format from this header.
+
+   The data of the serial object are:
+   - data[0]: the FILE, the string_t or the start of the memory buffer,
+   - data[1]: the current position in the memory buffer,
+   - data[2]: the end of the memory buffer,
+   - data[3]: the kind of backend and the flags of the stream. */
+#define M_SERIAL_BINI_FILE    0
+#define M_SERIAL_BINI_STRING  1
+#define M_SERIAL_BINI_BUFFER  2
+#define M_SERIAL_BINI_BACKEND 3
+#define M_SERIAL_BINI_COMPACT 4   // Compact format
+#define M_SERIAL_BINI_HEADER  8   // Header not written (or read) yet
+
+/* Magic header of a compact stream */
+#define M_SERIAL_BINI_COMPACT_MAGIC { 0x89, 0x4D, 0x4C, 0x43 }
+
+#define M_SERIAL_BINI_COMPACT_P(serial)                 \
+  (((serial)->data[3].i & M_SERIAL_BINI_COMPACT) != 0)
+
+static inline bool
+m_serial_bini_write(m_serial_write_t serial, const void *data, size_t size);
+
+/* Write the header of the stream (only for the compact format) */
+static inline bool
+m_serial_bini_write_header(m_serial_write_t serial)
+{
+  static const unsigned char magic[] = M_SERIAL_BINI_COMPACT_MAGIC;
+  serial->data[3].i &= ~M_SERIAL_BINI_HEADER;
+  return !M_SERIAL_BINI_COMPACT_P(serial)
+    || m_serial_bini_write(serial, magic, sizeof magic);
+}
+
+/* Write the 'size' bytes of 'data' into the serial stream 'serial'.
+   Return true if it succeeds, false otherwise */
+static inline bool
+m_serial_bini_write(m_serial_write_t serial, const void *data, size_t size)
+{
+  if (M_UNLIKELY (serial->data[3].i & M_SERIAL_BINI_HEADER)
+      && !m_serial_bini_write_header(serial))
+    return false;
+  const int backend = serial->data[3].i & M_SERIAL_BINI_BACKEND;
+  if (backend == M_SERIAL_BINI_FILE) {
+    FILE *f = (FILE *)serial->data[0].p;
+    return fwrite (data, size, 1, f) == 1;
+  } else if (backend == M_SERIAL_BINI_STRING) {
+    struct string_s *str = (struct string_s *)serial->data[0].p;
+    const size_t old_size = string_size(str);
+    char *ptr = stringi_fit2size(str, old_size + size + 1);
+    memcpy(&ptr[old_size], data, size);
+    ptr[old_size + size] = 0;
+    stringi_set_size(str, old_size + size);
+    return true;
+  } else {
+    assert (backend == M_SERIAL_BINI_BUFFER);
+    char *ptr = (char *)serial->data[1].p;
+    if (M_UNLIKELY (size > (size_t) ((char *)serial->data[2].p - ptr)))
+      return false;
+    memcpy(ptr, data, size);
+    serial->data[1].p = ptr + size;
+    return true;
+  }
+}
+
+/* Write the unsigned integer 'v' as a LEB128 varint:
+   7 bits per byte, the high bit being set if more bytes follow. */
+static inline bool
+m_serial_bini_write_varint(m_serial_write_t serial, unsigned long long v)
+{
+  unsigned char buffer[(sizeof v * CHAR_BIT + 6) / 7];
+  size_t n = 0;
+  while (v >= 0x80) {
+    buffer[n++] = (unsigned char) (v | 0x80);
+    v >>= 7;
+  }
+  buffer[n++] = (unsigned char) v;
+  return m_serial_bini_write(serial, buffer, n);
+}
+
+/* Zigzag encoding of a signed integer so that small negative integers
+   give small unsigned integers: 0, -1, 1, -2, ... => 0, 1, 2, 3, ... */
+static inline unsigned long long
+m_serial_bini_zigzag(long long x)
+{
+  const unsigned long long u = (unsigned long long) x << 1;
+  return x < 0 ? ~u : u;
+}
+
+static inline long long
+m_serial_bini_unzigzag(unsigned long long u)
+{
+  return (u & 1) ? (long long) ~(u >> 1) : (long long) (u >> 1);
+}
+
+static inline bool
+m_serial_bini_read(m_serial_read_t serial, void *data, size_t size);
+
+/* Read the header of the stream and set its format.
+   If there is no magic header, the stream is in native format
+   and the read bytes are given back to the stream. */
+static inline bool
+m_serial_bini_read_header(m_serial_read_t serial)
+{
+  static const unsigned char magic[] = M_SERIAL_BINI_COMPACT_MAGIC;
+  serial->data[3].i &= ~M_SERIAL_BINI_HEADER;
+  if ((serial->data[3].i & M_SERIAL_BINI_BACKEND) == M_SERIAL_BINI_BUFFER) {
+    const char *ptr = (const char *)serial->data[1].p;
+    if ((size_t) ((const char *)serial->data[2].p - ptr) >= sizeof magic
+        && memcmp(ptr, magic, sizeof magic) == 0) {
+      serial->data[1].p = (char *)serial->data[1].p + sizeof magic;
+      serial->data[3].i |= M_SERIAL_BINI_COMPACT;
+    }
+    return true;
+  }
+  FILE *f = (FILE *)serial->data[0].p;
+  size_t n = 0;
+  int c = EOF;
+  while (n < sizeof magic && (c = fgetc(f)) == magic[n])
+    n++;
+  if (n == sizeof magic) {
+    serial->data[3].i |= M_SERIAL_BINI_COMPACT;
+    return true;
+  }
+  /* Native stream: one byte can always be given back. More bytes
+     (a native stream starting like the magic header) need a seekable file */
+  if (n == 0 && (c == EOF || ungetc(c, f) != EOF))
+    return true;
+  if (n != 0 && fseek(f, -(long) (n + (c != EOF)), SEEK_CUR) == 0)
+    return true;
+  /* Make the following reads fail by reading from an empty buffer */
+  serial->data[0].p = serial->data[1].p = serial->data[2].p = NULL;
+  serial->data[3].i = M_SERIAL_BINI_BUFFER;
+  return false;
+}
+
+/* Read 'size' bytes from the serial stream 'serial' into 'data'.
+   Return true if it succeeds, false otherwise */
+static inline bool
+m_serial_bini_read(m_serial_read_t serial, void *data, size_t size)
+{
+  if (M_UNLIKELY (serial->data[3].i & M_SERIAL_BINI_HEADER)
+      && !m_serial_bini_read_header(serial))
+    return false;
+  if ((serial->data[3].i & M_SERIAL_BINI_BACKEND) == M_SERIAL_BINI_FILE) {
+    FILE *f = (FILE *)serial->data[0].p;
+    return fread (data, size, 1, f) == 1;
+  } else {
+    assert ((serial->data[3].i & M_SERIAL_BINI_BACKEND) == M_SERIAL_BINI_BUFFER);
+    const char *ptr = (const char *)serial->data[1].p;
+    if (M_UNLIKELY (size > (size_t) ((const char *)serial->data[2].p - ptr)))
+      return false;
+    memcpy(data, ptr, size);
+    serial->data[1].p = (char *)serial->data[1].p + size;
+    return true;
+  }
+}
+
+/* Read the header of the stream if it is not done yet,
+   so that its format is known. Return false in case of failure */
+static inline bool
+m_serial_bini_read_ready(m_serial_read_t serial)
+{
+  return M_LIKELY ((serial->data[3].i & M_SERIAL_BINI_HEADER) == 0)
+    || m_serial_bini_read_header(serial);
+}
+
+/* Read a LEB128 varint into 'v' */
+static inline bool
+m_serial_bini_read_varint(m_serial_read_t serial, unsigned long long *v)
+{
+  unsigned long long r = 0;
+  if (serial->data[3].i == (M_SERIAL_BINI_BUFFER | M_SERIAL_BINI_COMPACT)) {
+    /* Decode directly from the memory buffer */
+    const unsigned char *ptr = (const unsigned char *)serial->data[1].p;
+    const unsigned char *end = (const unsigned char *)serial->data[2].p;
+    for(unsigned shift = 0; ptr < end && shift < sizeof r * CHAR_BIT; shift += 7) {
+      const unsigned char c = *ptr++;
+      /* The last byte shall not have bits beyond the integer */
+      if (M_UNLIKELY (shift + 7 > sizeof r * CHAR_BIT
+                      && (c >> (sizeof r * CHAR_BIT - shift)) != 0))
+        return false;
+      r |= (unsigned long long) (c & 0x7F) << shift;
+      if ((c & 0x80) == 0) {
+        serial->data[1].p = (char *)(uintptr_t)ptr;
+        *v = r;
+        return true;
+      }
+    }
+    return false;
+  }
+  for(unsigned shift = 0; shift < sizeof r * CHAR_BIT; shift += 7) {
+    unsigned char c;
+    if (!m_serial_bini_read(serial, &c, 1))
+      return false;
+    /* The last byte shall not have bits beyond the integer */
+    if (M_UNLIKELY (shift + 7 > sizeof r * CHAR_BIT
+                    && (c >> (sizeof r * CHAR_BIT - shift)) != 0))
+      return false;
+    r |= (unsigned long long) (c & 0x7F) << shift;
+    if ((c & 0x80) == 0) {
+      *v = r;
+      return true;
+    }
+  }
+  /* Too many bytes for an integer */
+  return false;
+}
+
 /* Write the boolean 'data' into the serial stream 'serial'.
    Return M_SERIAL_OK_DONE if it succeeds, M_SERIAL_FAIL otherwise */
 static inline m_serial_return_code_t
 m_serial_bin_write_boolean(m_serial_write_t serial, const bool data)
 {
-  FILE *f = (FILE *)serial->data[0].p;
-  size_t n = fwrite (M_ASSIGN_CAST(const void*, &data), sizeof (bool), 1, f);
-  return n == 1 ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+  bool b = m_serial_bini_write(serial, &data, sizeof (bool));
+  return b ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
 }
 
 /* Write the integer 'data' of 'size_of_type' bytes into the serial stream 'serial'.
@@ -49,31 +274,34 @@ m_serial_bin_write_integer(m_serial_write_t serial,const long long data, const s
   int16_t i16;
   int32_t i32;
   int64_t i64;
-  size_t n;
-  
-  FILE *f = (FILE *)serial->data[0].p;
+  bool b = false;
+
+  if (M_SERIAL_BINI_COMPACT_P(serial)) {
+    b = m_serial_bini_write_varint(serial, m_serial_bini_zigzag(data));
+    return b ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+  }
   switch (size_of_type) {
   case 1:
     i8 = data;
-    n = fwrite (M_ASSIGN_CAST(const void*, &i8), sizeof i8, 1, f);
+    b = m_serial_bini_write(serial, &i8, sizeof i8);
     break;
   case 2:
     i16 = data;
-    n = fwrite (M_ASSIGN_CAST(const void*, &i16), sizeof i16, 1, f);
+    b = m_serial_bini_write(serial, &i16, sizeof i16);
     break;
   case 4:
     i32 = data;
-    n = fwrite (M_ASSIGN_CAST(const void*, &i32), sizeof i32, 1, f);
+    b = m_serial_bini_write(serial, &i32, sizeof i32);
     break;
   case 8:
     i64 = data;
-    n = fwrite (M_ASSIGN_CAST(const void*, &i64), sizeof i64, 1, f);
+    b = m_serial_bini_write(serial, &i64, sizeof i64);
     break;
   default:
     M_ASSERT_INIT(false, "an integer of suitable size");
     break;
   }
-  return n == 1 ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+  return b ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
 }
 
 /* Write the float 'data' of 'size_of_type' bytes into the serial stream 'serial'.
@@ -84,27 +312,26 @@ m_serial_bin_write_float(m_serial_write_t serial, const long double data, const
   float   f1;
   double  f2;
   long double f3;
-  size_t n;
+  bool b = false;
   
-  FILE *f = (FILE *)serial->data[0].p;
   switch (size_of_type) {
   case sizeof f1:
     f1 = data;
-    n = fwrite (M_ASSIGN_CAST(const void*, &f1), sizeof f1, 1, f);
+    b = m_serial_bini_write(serial, &f1, sizeof f1);
     break;
   case sizeof f2:
     f2 = data;
-    n = fwrite (M_ASSIGN_CAST(const void*, &f2), sizeof f2, 1, f);
+    b = m_serial_bini_write(serial, &f2, sizeof f2);
     break;
   case sizeof f3:
     f3 = data;
-    n = fwrite (M_ASSIGN_CAST(const void*, &f3), sizeof f3, 1, f);
+    b = m_serial_bini_write(serial, &f3, sizeof f3);
     break;
   default:
     M_ASSERT_INIT(false, "a float of suitable size");
     break;
   }
-  return n == 1 ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+  return b ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
 }
 
 /* Write the null-terminated string 'data'into the serial stream 'serial'.
@@ -112,25 +339,61 @@ m_serial_bin_write_float(m_serial_write_t serial, const long double data, const
 static inline m_serial_return_code_t
 m_serial_bin_write_string(m_serial_write_t serial, const char data[])
 {
-  FILE *f = (FILE *)serial->data[0].p;
   size_t l = strlen(data);
-  size_t n = fwrite (M_ASSIGN_CAST(const void*, data), 1, l+1, f);
-  return n == l+1 ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+  bool b;
+  if (M_SERIAL_BINI_COMPACT_P(serial)) {
+    b = m_serial_bini_write_varint(serial, l)
+      && (l == 0 || m_serial_bini_write(serial, data, l));
+  } else {
+    b = m_serial_bini_write(serial, data, l+1);
+  }
+  return b ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+}
+
+/* Write the marker 'n' of an array of unknown size
+   (one byte in compact format: 1 if an element follows, 0 at the end) */
+static inline bool
+m_serial_bini_write_marker(m_serial_write_t serial, size_t n)
+{
+  if (M_SERIAL_BINI_COMPACT_P(serial)) {
+    const unsigned char c = (n == 0xABCDEF);
+    return m_serial_bini_write(serial, &c, 1);
+  }
+  return m_serial_bini_write(serial, &n, sizeof n);
+}
+
+/* Return the number of bytes written so far by the serial object
+   (SIZE_MAX if it is not known, for a FILE which cannot tell its position) */
+static inline size_t
+m_serial_bini_write_pos(m_serial_write_t serial)
+{
+  const int backend = serial->data[3].i & M_SERIAL_BINI_BACKEND;
+  if (backend == M_SERIAL_BINI_FILE) {
+    long pos = ftell((FILE *)serial->data[0].p);
+    return pos < 0 ? SIZE_MAX : (size_t) pos;
+  } else if (backend == M_SERIAL_BINI_STRING) {
+    return string_size((const struct string_s *)serial->data[0].p);
+  }
+  return (size_t) ((char *)serial->data[1].p - (char *)serial->data[0].p);
 }
 
 /* Start writing an array of 'number_of_elements' objects into the serial stream 'serial'.
-   If 'number_of_elements' is 0, then either the array has no data,
-   or the number of elements of the array is unkown.
+   The binary format needs the number of elements: if 'number_of_elements'
+   is 0, the array shall have no data (the array is closed by an end marker
+   so that the streams of unknown size written before remain readable).
    Initialize 'local' so that it can be used to serialize the array 
    (local is an unique serialization object of the array).
    Return M_SERIAL_OK_CONTINUE if it succeeds, M_SERIAL_FAIL otherwise */
 static inline m_serial_return_code_t
 m_serial_bin_write_array_start(m_serial_local_t local, m_serial_write_t serial, const size_t number_of_elements)
 {
-  FILE *f = (FILE *)serial->data[0].p;
-  size_t n = fwrite (M_ASSIGN_CAST(const void*, &number_of_elements), sizeof number_of_elements, 1, f);
+  bool b = M_SERIAL_BINI_COMPACT_P(serial)
+    ? m_serial_bini_write_varint(serial, number_of_elements)
+    : m_serial_bini_write(serial, &number_of_elements, sizeof number_of_elements);
   local->data[0].b = (number_of_elements == 0);
-  return n == 1 ? M_SERIAL_OK_CONTINUE : M_SERIAL_FAIL;
+  // Position after the size, to check that an empty array stays empty
+  local->data[1].s = local->data[0].b ? m_serial_bini_write_pos(serial) : 0;
+  return b ? M_SERIAL_OK_CONTINUE : M_SERIAL_FAIL;
 }
 
 /* Write an array separator between elements of an array into the serial stream 'serial' if needed.
@@ -138,15 +401,10 @@ m_serial_bin_write_array_start(m_serial_local_t local, m_serial_write_t serial,
 static inline  m_serial_return_code_t
 m_serial_bin_write_array_next(m_serial_local_t local, m_serial_write_t serial)
 {
-  FILE *f = (FILE *)serial->data[0].p;
-  // Need separator if we don't know the real size 
-  if (local->data[0].b) {
-    size_t n = 0xABCDEF;
-    n = fwrite (M_ASSIGN_CAST(const void*, &n), sizeof n, 1, f);
-    return n == 1 ? M_SERIAL_OK_CONTINUE : M_SERIAL_FAIL;    
-  } else {
-    return M_SERIAL_OK_CONTINUE;
-  }
+  (void) serial; // argument not used
+  // A second element in an array announced empty: the reader could
+  // not find its elements, so refuse it.
+  return local->data[0].b ? M_SERIAL_FAIL : M_SERIAL_OK_CONTINUE;
 }
 
 /* End the writing of an array into the serial stream 'serial'.
@@ -154,12 +412,13 @@ m_serial_bin_write_array_next(m_serial_local_t local, m_serial_write_t serial)
 static inline   m_serial_return_code_t
 m_serial_bin_write_array_end(m_serial_local_t local, m_serial_write_t serial)
 {
-  FILE *f = (FILE *)serial->data[0].p;
-  // Need mark if we don't know the real size 
   if (local->data[0].b) {
-    size_t n = 0x12345678;
-    n = fwrite (M_ASSIGN_CAST(const void*, &n), sizeof n, 1, f);
-    return n == 1 ? M_SERIAL_OK_CONTINUE : M_SERIAL_FAIL;    
+    // An element has been written in an array announced empty
+    if (local->data[1].s != SIZE_MAX
+        && local->data[1].s != m_serial_bini_write_pos(serial))
+      return M_SERIAL_FAIL;
+    bool b = m_serial_bini_write_marker(serial, 0x12345678);
+    return b ? M_SERIAL_OK_CONTINUE : M_SERIAL_FAIL;    
   } else {
     return M_SERIAL_OK_CONTINUE;
   }
@@ -221,9 +480,10 @@ m_serial_bin_write_variant_start(m_serial_local_t local, m_serial_write_t serial
   (void) field_name;
   (void) max;
   (void) local;
-  FILE *f = (FILE *)serial->data[0].p;
-  size_t n = fwrite (M_ASSIGN_CAST(const void*, &index), sizeof index, 1, f);
-  return n == 1 ? ((index < 0) ? M_SERIAL_OK_DONE : M_SERIAL_OK_CONTINUE) : M_SERIAL_FAIL;
+  bool b = M_SERIAL_BINI_COMPACT_P(serial)
+    ? m_serial_bini_write_varint(serial, m_serial_bini_zigzag(index))
+    : m_serial_bini_write(serial, &index, sizeof index);
+  return b ? ((index < 0) ? M_SERIAL_OK_DONE : M_SERIAL_OK_CONTINUE) : M_SERIAL_FAIL;
 }
 
 /* End Writing a variant into the serial stream 'serial'. 
@@ -253,18 +513,63 @@ static const m_serial_write_interface_t m_serial_write_bin_interface = {
   m_serial_bin_write_tuple_id,
   m_serial_bin_write_tuple_end,
   m_serial_bin_write_variant_start,
-  m_serial_bin_write_variant_end
+  m_serial_bin_write_variant_end,
+  true
 };
 
 static inline void m_serial_bin_write_init(m_serial_write_t serial, FILE *f)
 {
   serial->interface = &m_serial_write_bin_interface;
   serial->data[0].p = M_ASSIGN_CAST(void*, f);
+  serial->data[3].i = M_SERIAL_BINI_FILE | M_SERIAL_BINI_HEADER;
+}
+
+/* Initialize the serial object so that the fields are appended to 'str'
+   (which may contain null chars afterwards). */
+static inline void m_serial_bin_write_init_str(m_serial_write_t serial, string_t str)
+{
+  STRINGI_CONTRACT(str);
+  serial->interface = &m_serial_write_bin_interface;
+  serial->data[0].p = M_ASSIGN_CAST(void*, str);
+  serial->data[3].i = M_SERIAL_BINI_STRING | M_SERIAL_BINI_HEADER;
+}
+
+/* Initialize the serial object so that the fields are written in the
+   buffer 'buffer' of 'size' bytes. The write fails if the buffer is full. */
+static inline void m_serial_bin_write_init_buffer(m_serial_write_t serial, void *buffer, size_t size)
+{
+  assert (buffer != NULL || size == 0);
+  serial->interface = &m_serial_write_bin_interface;
+  serial->data[0].p = buffer;
+  serial->data[1].p = buffer;
+  serial->data[2].p = (char *)buffer + size;
+  serial->data[3].i = M_SERIAL_BINI_BUFFER | M_SERIAL_BINI_HEADER;
+}
+
+/* Return the number of bytes written in the buffer
+   (or in the string) by the serial object. */
+static inline size_t m_serial_bin_write_size(const m_serial_write_t serial)
+{
+  const int backend = serial->data[3].i & M_SERIAL_BINI_BACKEND;
+  if (backend == M_SERIAL_BINI_STRING)
+    return string_size((const struct string_s *)serial->data[0].p);
+  assert (backend == M_SERIAL_BINI_BUFFER);
+  return (size_t) ((char *)serial->data[1].p - (char *)serial->data[0].p);
+}
+
+/* Select the compact format for the stream.
+   It shall be called just after the initialization of the serial object. */
+static inline void m_serial_bin_write_set_compact(m_serial_write_t serial)
+{
+  assert (serial->data[3].i & M_SERIAL_BINI_HEADER);
+  serial->data[3].i |= M_SERIAL_BINI_COMPACT;
 }
 
 static inline void m_serial_bin_write_clear(m_serial_write_t serial)
 {
-  (void) serial; // Nothing to do
+  /* Nothing has been written: write at least the header */
+  if (serial->data[3].i & M_SERIAL_BINI_HEADER)
+    (void) m_serial_bini_write_header(serial);
 }
 
 
@@ -273,9 +578,8 @@ static inline void m_serial_bin_write_clear(m_serial_write_t serial)
    Return M_SERIAL_OK_DONE if it succeeds, M_SERIAL_FAIL otherwise */
 static inline  m_serial_return_code_t
 m_serial_bin_read_boolean(m_serial_read_t serial, bool *b){
-  FILE *f = (FILE*) serial->data[0].p;
-  size_t n = fread (M_ASSIGN_CAST(void*, b), sizeof (bool), 1, f);
-  return n == 1 ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+  bool r = m_serial_bini_read(serial, b, sizeof (bool));
+  return r ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
 }
 
 /* Read from the stream 'serial' an integer that can be represented with 'size_of_type' bytes.
@@ -287,30 +591,37 @@ m_serial_bin_read_integer(m_serial_read_t serial, long long *i, const size_t siz
   int16_t i16;
   int32_t i32;
   int64_t i64;
-  size_t n;
-  FILE *f = (FILE *)serial->data[0].p;
+  bool b = false;
+  if (!m_serial_bini_read_ready(serial))
+    return M_SERIAL_FAIL;
+  if (M_SERIAL_BINI_COMPACT_P(serial)) {
+    unsigned long long u = 0;
+    b = m_serial_bini_read_varint(serial, &u);
+    *i = m_serial_bini_unzigzag(u);
+    return b ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+  }
   switch (size_of_type) {
   case 1:
-    n = fread (M_ASSIGN_CAST(void*, &i8), sizeof i8, 1, f);
+    b = m_serial_bini_read(serial, &i8, sizeof i8);
     *i = i8;
     break;
   case 2:
-    n = fread (M_ASSIGN_CAST(void*, &i16), sizeof i16, 1, f);
+    b = m_serial_bini_read(serial, &i16, sizeof i16);
     *i = i16;
     break;
   case 4:
-    n = fread (M_ASSIGN_CAST(void*, &i32), sizeof i32, 1, f);
+    b = m_serial_bini_read(serial, &i32, sizeof i32);
     *i = i32;
     break;
   case 8:
-    n = fread (M_ASSIGN_CAST(void*, &i64), sizeof i64, 1, f);
+    b = m_serial_bini_read(serial, &i64, sizeof i64);
     *i = i64;
     break;
   default:
     M_ASSERT_INIT(false, "an integer of suitable size");
     break;
   }
-  return n == 1 ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+  return b ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
 }
 
 /* Read from the stream 'serial' a float that can be represented with 'size_of_type' bytes.
@@ -321,26 +632,64 @@ m_serial_bin_read_float(m_serial_read_t serial, long double *r, const size_t siz
   float   f1;
   double  f2;
   long double f3;
-  size_t n;
-  FILE *f = (FILE *)serial->data[0].p;
+  bool b = false;
   switch (size_of_type) {
   case sizeof f1:
-    n = fread (M_ASSIGN_CAST(void*, &f1), sizeof f1, 1, f);
+    b = m_serial_bini_read(serial, &f1, sizeof f1);
     *r = f1;
     break;
   case sizeof f2:
-    n = fread (M_ASSIGN_CAST(void*, &f2), sizeof f2, 1, f);
+    b = m_serial_bini_read(serial, &f2, sizeof f2);
     *r = f2;
     break;
   case sizeof f3:
-    n = fread (M_ASSIGN_CAST(void*, &f3), sizeof f3, 1, f);
+    b = m_serial_bini_read(serial, &f3, sizeof f3);
     *r = f3;
     break;
   default:
     M_ASSERT_INIT(false, "a float of suitable size");
     break;
   }
-  return n == 1 ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+  return b ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+}
+
+/* Read a string prefixed by its length */
+static inline  m_serial_return_code_t
+m_serial_bini_read_string_compact(m_serial_read_t serial, struct string_s *s)
+{
+  unsigned long long n;
+  if (!m_serial_bini_read_varint(serial, &n) || n >= SIZE_MAX)
+    return M_SERIAL_FAIL;
+  size_t size = (size_t) n;
+  if ((serial->data[3].i & M_SERIAL_BINI_BACKEND) == M_SERIAL_BINI_BUFFER) {
+    const char *ptr = (const char *)serial->data[1].p;
+    if (size > (size_t) ((const char *)serial->data[2].p - ptr))
+      return M_SERIAL_FAIL;
+    /* The string is not null terminated in the buffer:
+       copy it without string_set_strn (which computes its length) */
+    char *dst = stringi_fit2size(s, size + 1);
+    memcpy(dst, ptr, size);
+    dst[size] = 0;
+    stringi_set_size(s, size);
+    serial->data[1].p = (char *)serial->data[1].p + size;
+    return M_SERIAL_OK_DONE;
+  }
+  /* Read the string by blocks so that a corrupted length
+     doesn't allocate a huge string */
+  string_clean(s);
+  size_t done = 0;
+  while (done < size) {
+    const size_t block = M_MIN(size - done, (size_t) 4096);
+    char *ptr = stringi_fit2size(s, done + block + 1);
+    if (!m_serial_bini_read(serial, &ptr[done], block)) {
+      string_clean(s);
+      return M_SERIAL_FAIL;
+    }
+    done += block;
+    ptr[done] = 0;
+    stringi_set_size(s, done);
+  }
+  return M_SERIAL_OK_DONE;
 }
 
 /* Read from the stream 'serial' a string.
@@ -348,6 +697,20 @@ m_serial_bin_read_float(m_serial_read_t serial, long double *r, const size_t siz
    Return M_SERIAL_OK_DONE if it succeeds, M_SERIAL_FAIL otherwise */
 static inline  m_serial_return_code_t
 m_serial_bin_read_string(m_serial_read_t serial, struct string_s *s){
+  if (!m_serial_bini_read_ready(serial))
+    return M_SERIAL_FAIL;
+  if (M_SERIAL_BINI_COMPACT_P(serial))
+    return m_serial_bini_read_string_compact(serial, s);
+  if ((serial->data[3].i & M_SERIAL_BINI_BACKEND) == M_SERIAL_BINI_BUFFER) {
+    /* The string is in the buffer: copy it in one step */
+    const char *ptr = (const char *)serial->data[1].p;
+    const char *end = (const char *)memchr(ptr, 0, (size_t) ((const char *)serial->data[2].p - ptr));
+    if (end == NULL)
+      return M_SERIAL_FAIL;
+    string_set_strn(s, ptr, (size_t) (end - ptr));
+    serial->data[1].p = (char *)serial->data[1].p + (end - ptr) + 1;
+    return M_SERIAL_OK_DONE;
+  }
   FILE *f = (FILE*) serial->data[0].p;
   string_clean(s);
   int c;
@@ -359,6 +722,24 @@ m_serial_bin_read_string(m_serial_read_t serial, struct string_s *s){
   return c != EOF ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
 }
 
+/* Read the marker of an array of unknown size.
+   Return M_SERIAL_OK_CONTINUE if an element follows,
+   M_SERIAL_OK_DONE if the array ends, M_SERIAL_FAIL otherwise */
+static inline  m_serial_return_code_t
+m_serial_bini_read_marker(m_serial_read_t serial)
+{
+  if (M_SERIAL_BINI_COMPACT_P(serial)) {
+    unsigned char c;
+    if (!m_serial_bini_read(serial, &c, 1))
+      return M_SERIAL_FAIL;
+    return c == 1 ? M_SERIAL_OK_CONTINUE : c == 0 ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+  }
+  size_t p;
+  if (!m_serial_bini_read(serial, &p, sizeof p))
+    return M_SERIAL_FAIL;
+  return p == 0xABCDEF ? M_SERIAL_OK_CONTINUE : p == 0x12345678 ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+}
+
 /* Start reading from the stream 'serial' an array.
    Set '*num' with the number of elements, or 0 if it is not known.
    Initialize 'local' so that it can be used to serialize the array 
@@ -369,19 +750,23 @@ m_serial_bin_read_string(m_serial_read_t serial, struct string_s *s){
 static inline  m_serial_return_code_t
 m_serial_bin_read_array_start(m_serial_local_t local, m_serial_read_t serial, size_t *num)
 {
-  FILE *f = (FILE*) serial->data[0].p;
-  size_t n = fread (M_ASSIGN_CAST(void*, num), sizeof *num, 1, f);
-  if (n != 1)
+  if (!m_serial_bini_read_ready(serial))
+    return M_SERIAL_FAIL;
+  bool b;
+  if (M_SERIAL_BINI_COMPACT_P(serial)) {
+    unsigned long long u = 0;
+    b = m_serial_bini_read_varint(serial, &u) && u <= SIZE_MAX;
+    *num = (size_t) u;
+  } else {
+    b = m_serial_bini_read(serial, num, sizeof *num);
+  }
+  if (!b)
     return M_SERIAL_FAIL;
   local->data[0].b = (*num == 0);
   local->data[1].s = *num;
   if (local->data[0].b) {
     // Size not know ==> use of marker in the stream.
-    size_t p;
-    n = fread (M_ASSIGN_CAST(void*, &p), sizeof p, 1, f);
-    if (n != 1)
-      return M_SERIAL_FAIL;
-    return p == 0xABCDEF ? M_SERIAL_OK_CONTINUE : p == 0x12345678 ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+    return m_serial_bini_read_marker(serial);
   }
   return M_SERIAL_OK_CONTINUE;
 }
@@ -393,14 +778,9 @@ m_serial_bin_read_array_start(m_serial_local_t local, m_serial_read_t serial, si
 static inline  m_serial_return_code_t
 m_serial_bin_read_array_next(m_serial_local_t local, m_serial_read_t serial)
 {
-  FILE *f = (FILE*) serial->data[0].p;
   if (local->data[0].b) {
     // Size not know ==> use of marker in the stream.
-    size_t p, n;
-    n = fread (M_ASSIGN_CAST(void*, &p), sizeof p, 1, f);
-    if (n != 1)
-      return M_SERIAL_FAIL;
-    return p == 0xABCDEF ? M_SERIAL_OK_CONTINUE : p == 0x12345678 ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+    return m_serial_bini_read_marker(serial);
   } else {
     assert(local->data[1].s > 0);
     local->data[1].s --;
@@ -460,9 +840,19 @@ m_serial_bin_read_variant_start(m_serial_local_t local, m_serial_read_t serial,
   (void) field_name;
   (void) max;
   (void) local; // argument not used
-  FILE *f = (FILE*) serial->data[0].p;
-  size_t n = fread (M_ASSIGN_CAST(void*, id), sizeof *id, 1, f);
-  return n == 1 ? ((*id < 0) ? M_SERIAL_OK_DONE : M_SERIAL_OK_CONTINUE) : M_SERIAL_FAIL;
+  if (!m_serial_bini_read_ready(serial))
+    return M_SERIAL_FAIL;
+  bool b;
+  if (M_SERIAL_BINI_COMPACT_P(serial)) {
+    unsigned long long u = 0;
+    b = m_serial_bini_read_varint(serial, &u);
+    const long long v = m_serial_bini_unzigzag(u);
+    b = b && v >= INT_MIN && v <= INT_MAX;
+    *id = (int) v;
+  } else {
+    b = m_serial_bini_read(serial, id, sizeof *id);
+  }
+  return b ? ((*id < 0) ? M_SERIAL_OK_DONE : M_SERIAL_OK_CONTINUE) : M_SERIAL_FAIL;
 }
 
 /* End reading a variant from the stream 'serial'.
@@ -496,6 +886,30 @@ static inline void m_serial_bin_read_init(m_serial_read_t serial, FILE *f)
 {
   serial->interface = &m_serial_bin_read_interface;
   serial->data[0].p = M_ASSIGN_CAST(void*, f);
+  serial->data[3].i = M_SERIAL_BINI_FILE | M_SERIAL_BINI_HEADER;
+}
+
+/* Initialize the serial object so that the fields are read from the
+   buffer 'buffer' of 'size' bytes (for example the content of a string
+   or of a file mapped in memory). The buffer is not modified. */
+static inline void m_serial_bin_read_init_buffer(m_serial_read_t serial, const void *buffer, size_t size)
+{
+  assert (buffer != NULL || size == 0);
+  /* The buffer is only read: remove the const qualifier
+     to store it in the serial object */
+  char *ptr = (char *) (uintptr_t) buffer;
+  serial->interface = &m_serial_bin_read_interface;
+  serial->data[0].p = ptr;
+  serial->data[1].p = ptr;
+  serial->data[2].p = ptr + size;
+  serial->data[3].i = M_SERIAL_BINI_BUFFER | M_SERIAL_BINI_HEADER;
+}
+
+/* Return the number of bytes read from the buffer by the serial object. */
+static inline size_t m_serial_bin_read_size(const m_serial_read_t serial)
+{
+  assert ((serial->data[3].i & M_SERIAL_BINI_BACKEND) == M_SERIAL_BINI_BUFFER);
+  return (size_t) ((char *)serial->data[1].p - (char *)serial->data[0].p);
 }
 
 static inline void m_serial_bin_read_clear(m_serial_read_t serial)
@@ -249,7 +249,8 @@ static const m_serial_write_interface_t m_serial_write_json_interface = {
   m_serial_json_write_tuple_id,
   m_serial_json_write_tuple_end,
   m_serial_json_write_variant_start,
-  m_serial_json_write_variant_end
+  m_serial_json_write_variant_end,
+  false
 };
 
 static inline void m_serial_json_write_init(m_serial_write_t serial, FILE *f)
@@ -429,6 +430,132 @@ m_serial_json_read_tuple_start(m_serial_local_t local, m_serial_read_t serial)
   return final > 0 ? M_SERIAL_OK_CONTINUE : M_SERIAL_FAIL;
 }
 
+/* Compare the field name 'field' to the name 'name' of 'n' characters
+   (which is not null terminated) like strcmp */
+static inline int
+m_serial_jsoni_field_cmp(const char field[], const char name[], size_t n)
+{
+  size_t k = 0;
+  while (k < n && field[k] == name[k] && field[k] != 0)
+    k++;
+  if (k == n)
+    return field[n] != 0;
+  if (field[k] == 0)
+    return -1;
+  return (unsigned char) field[k] < (unsigned char) name[k] ? -1 : 1;
+}
+
+/* Cache of the field name tables sorted by name, owned by a memory reader.
+   The tables of the tuples (or variants) with at least
+   M_SERIAL_JSONI_SORTED_MIN fields are sorted at their first use. */
+#ifndef M_SERIAL_JSON_FIELDS_CACHE
+#define M_SERIAL_JSON_FIELDS_CACHE 16
+#endif
+#define M_SERIAL_JSONI_SORTED_MIN 8
+
+typedef struct m_serial_jsoni_fields_s {
+  unsigned int      last;   // Last replaced entry
+  const char *const *table[M_SERIAL_JSON_FIELDS_CACHE]; // Field name tables
+  int               *order[M_SERIAL_JSON_FIELDS_CACHE]; // Their indices sorted by name
+} m_serial_jsoni_fields_t;
+
+static inline void
+m_serial_jsoni_fields_clear(void *cache)
+{
+  m_serial_jsoni_fields_t *c = (m_serial_jsoni_fields_t *)cache;
+  if (c == NULL)
+    return;
+  for(unsigned int i = 0; i < M_SERIAL_JSON_FIELDS_CACHE; i++)
+    M_MEMORY_FREE(c->order[i]);
+  M_MEMORY_DEL(c);
+}
+
+/* Return the indices of the table 'field_name[max]' sorted by name
+   from the cache '*cache' (created if needed), or NULL if it fails */
+static inline const int *
+m_serial_jsoni_fields_order(void **cache, const char *const field_name[], const int max)
+{
+  m_serial_jsoni_fields_t *c = (m_serial_jsoni_fields_t *)*cache;
+  if (M_UNLIKELY (c == NULL)) {
+    c = M_MEMORY_ALLOC(m_serial_jsoni_fields_t);
+    if (M_UNLIKELY (c == NULL)) {
+      M_MEMORY_FULL(sizeof (m_serial_jsoni_fields_t));
+      return NULL;
+    }
+    c->last = 0;
+    for(unsigned int i = 0; i < M_SERIAL_JSON_FIELDS_CACHE; i++) {
+      c->table[i] = NULL;
+      c->order[i] = NULL;
+    }
+    *cache = c;
+  }
+  for(unsigned int i = 0; i < M_SERIAL_JSON_FIELDS_CACHE; i++)
+    if (c->table[i] == field_name)
+      return c->order[i];
+  /* Sort the table in the next entry (insertion sort: done once) */
+  int *order = M_MEMORY_REALLOC(int, NULL, (size_t) max);
+  if (M_UNLIKELY (order == NULL)) {
+    M_MEMORY_FULL(sizeof (int) * (size_t) max);
+    return NULL;
+  }
+  for(int i = 0; i < max; i++) {
+    int j = i;
+    while (j > 0 && strcmp(field_name[order[j-1]], field_name[i]) > 0) {
+      order[j] = order[j-1];
+      j--;
+    }
+    order[j] = i;
+  }
+  const unsigned int e = c->last = (c->last + 1) % M_SERIAL_JSON_FIELDS_CACHE;
+  M_MEMORY_FREE(c->order[e]);
+  c->table[e] = field_name;
+  c->order[e] = order;
+  return order;
+}
+
+/* Search for the field name 'name' of 'n' characters in the table
+   'field_name[max]' and set '*id' with its index. Return false if not found.
+   '*id' is the index of the previous field of the object (or -1).
+   The fields are usually written in the order of their declaration,
+   so the field following the previous one is checked first.
+   Otherwise, the field is searched by dichotomy in the table sorted
+   by name (kept in the cache '*cache' of the reader), or linearly
+   for the small tables or if the reader has no cache ('cache' is NULL). */
+static inline bool
+m_serial_jsoni_field_id(void **cache, const char *const field_name[], const int max, const char name[], size_t n, int *id)
+{
+  int i = (*id >= -1 && *id < max - 1) ? *id + 1 : 0;
+  if (max > 0 && m_serial_jsoni_field_cmp(field_name[i], name, n) == 0) {
+    *id = i;
+    return true;
+  }
+  const int *order = cache != NULL && max >= M_SERIAL_JSONI_SORTED_MIN
+    ? m_serial_jsoni_fields_order(cache, field_name, max) : NULL;
+  if (order == NULL) {
+    for(int k = 0; k < max; k++) {
+      if (m_serial_jsoni_field_cmp(field_name[k], name, n) == 0) {
+        *id = k;
+        return true;
+      }
+    }
+    return false;
+  }
+  int lo = 0, hi = max;
+  while (lo < hi) {
+    const int mid = lo + (hi - lo) / 2;
+    const int cmp = m_serial_jsoni_field_cmp(field_name[order[mid]], name, n);
+    if (cmp == 0) {
+      *id = order[mid];
+      return true;
+    }
+    if (cmp < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return false;
+}
+
 /* Continue reading a tuple from the stream 'serial'.
    Set '*id' with the corresponding index of the table 'field_name[max]'
    associated to the parsed field in the stream.
@@ -457,13 +584,8 @@ m_serial_json_read_tuple_id(m_serial_local_t local, m_serial_read_t serial, cons
   if (c <= 0)
     return M_SERIAL_FAIL;
   /* Search for field in field_name */
-  for(int n = 0; n < max; n++) {
-    if (strcmp(field, field_name[n]) == 0) {
-      *id = n;
-      return M_SERIAL_OK_CONTINUE;
-    }
-  }
-  return M_SERIAL_FAIL;
+  return m_serial_jsoni_field_id(NULL, field_name, max, field, strlen(field), id)
+    ? M_SERIAL_OK_CONTINUE : M_SERIAL_FAIL;
 }
 
 /* Start reading a variant from the stream 'serial'.
@@ -490,13 +612,8 @@ m_serial_json_read_variant_start(m_serial_local_t local, m_serial_read_t serial,
   if (final2 <= 0) return M_SERIAL_FAIL;
 
   /* Search for field in field_name */
-  for(int n = 0; n < max; n++) {
-    if (strcmp(field, field_name[n]) == 0) {
-      *id = n;
-      return M_SERIAL_OK_CONTINUE;
-    }
-  }
-  return M_SERIAL_FAIL;
+  return m_serial_jsoni_field_id(NULL, field_name, max, field, strlen(field), id)
+    ? M_SERIAL_OK_CONTINUE : M_SERIAL_FAIL;
 }
 
 /* End reading a variant from the stream 'serial'.
@@ -532,11 +649,1128 @@ static inline void m_serial_json_read_init(m_serial_read_t serial, FILE *f)
 {
   serial->interface = &m_serial_json_read_interface;
   serial->data[0].p = M_ASSIGN_CAST(void*, f);
+  /* No cache of the sorted field names: the FILE reader owns no memory,
+     so that it doesn't need to be cleared (parsing is dominated by stdio) */
+}
+
+
+/* Memory backends.
+   The serial objects can also write into a string_t and parse
+   from a memory buffer (the content of a string, a network message,
+   a file mapped in memory, ...) without going through stdio:
+   the tokens are directly formatted into the string
+   and parsed from the buffer by a hand-written scanner.
+   The data of the serial object are:
+   - data[0]: the string_t or the start of the memory buffer,
+   - data[1]: the current position in the memory buffer,
+   - data[2]: the end of the memory buffer,
+   - data[3]: the cache of the sorted field names (for the reader). */
+
+/* Append the 'n' characters of 'data' to the string 'str' */
+static inline void
+m_serial_jsoni_cat(struct string_s *str, const char data[], size_t n)
+{
+  const size_t old_size = string_size(str);
+  char *ptr = stringi_fit2size(str, old_size + n + 1);
+  memcpy(&ptr[old_size], data, n);
+  ptr[old_size + n] = 0;
+  stringi_set_size(str, old_size + n);
+}
+
+/* Append the character 'c' to the string of the serial stream 'serial' */
+static inline m_serial_return_code_t
+m_serial_jsoni_write_char(m_serial_write_t serial, char c, m_serial_return_code_t ret)
+{
+  m_serial_jsoni_cat((struct string_s *)serial->data[0].p, &c, 1);
+  return ret;
+}
+
+static inline m_serial_return_code_t
+m_serial_json_write_str_boolean(m_serial_write_t serial, const bool data)
+{
+  struct string_s *str = (struct string_s *)serial->data[0].p;
+  if (data)
+    m_serial_jsoni_cat(str, "true", 4);
+  else
+    m_serial_jsoni_cat(str, "false", 5);
+  return M_SERIAL_OK_DONE;
+}
+
+static inline m_serial_return_code_t
+m_serial_json_write_str_integer(m_serial_write_t serial,const long long data, const size_t size_of_type)
+{
+  (void) size_of_type; // Ignored
+  /* Format the integer from the end of the buffer */
+  char buffer[sizeof (long long) * CHAR_BIT / 3 + 3];
+  char *p = &buffer[sizeof buffer];
+  unsigned long long u = data < 0 ? -(unsigned long long) data : (unsigned long long) data;
+  do {
+    *--p = (char) ('0' + u % 10);
+    u /= 10;
+  } while (u != 0);
+  if (data < 0)
+    *--p = '-';
+  m_serial_jsoni_cat((struct string_s *)serial->data[0].p, p, (size_t) (&buffer[sizeof buffer] - p));
+  return M_SERIAL_OK_DONE;
+}
+
+static inline m_serial_return_code_t
+m_serial_json_write_str_float(m_serial_write_t serial, const long double data, const size_t size_of_type)
+{
+  (void) size_of_type; // Ignored
+  int n = string_cat_printf((struct string_s *)serial->data[0].p, "%Lf", data);
+  return n > 0 ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+}
+
+/* Write the string 'data' quoted, with the same escape sequences
+   as string_out_str. The characters which don't need to be escaped
+   are copied by blocks. */
+static inline m_serial_return_code_t
+m_serial_json_write_str_string(m_serial_write_t serial, const char data[])
+{
+  struct string_s *str = (struct string_s *)serial->data[0].p;
+  m_serial_jsoni_cat(str, "\"", 1);
+  const char *start = data;
+  for(const char *p = data; *p != 0; p++) {
+    const char c = *p;
+    if (M_LIKELY (c != '"' && c != '\\' && isprint((unsigned char) c)))
+      continue;
+    m_serial_jsoni_cat(str, start, (size_t) (p - start));
+    char esc[4];
+    esc[0] = '\\';
+    if (c == '\\' || c == '"' || c == '\n' || c == '\t' || c == '\r') {
+      esc[1] = " tn\" r\\"[(c ^ (c >>5)) & 0x07];
+      m_serial_jsoni_cat(str, esc, 2);
+    } else {
+      esc[1] = (char) ('0' + ((c>>6) & 0x07));
+      esc[2] = (char) ('0' + ((c>>3) & 0x07));
+      esc[3] = (char) ('0' + (c & 0x07));
+      m_serial_jsoni_cat(str, esc, 4);
+    }
+    start = p + 1;
+  }
+  m_serial_jsoni_cat(str, start, strlen(start));
+  m_serial_jsoni_cat(str, "\"", 1);
+  return M_SERIAL_OK_DONE;
+}
+
+static inline m_serial_return_code_t
+m_serial_json_write_str_array_start(m_serial_local_t local, m_serial_write_t serial, const size_t number_of_elements)
+{
+  (void) local; // argument not used
+  (void) number_of_elements; // Ignored
+  return m_serial_jsoni_write_char(serial, '[', M_SERIAL_OK_CONTINUE);
+}
+
+static inline m_serial_return_code_t
+m_serial_json_write_str_next(m_serial_local_t local, m_serial_write_t serial)
+{
+  (void) local; // argument not used
+  return m_serial_jsoni_write_char(serial, ',', M_SERIAL_OK_CONTINUE);
+}
+
+static inline m_serial_return_code_t
+m_serial_json_write_str_array_end(m_serial_local_t local, m_serial_write_t serial)
+{
+  (void) local; // argument not used
+  return m_serial_jsoni_write_char(serial, ']', M_SERIAL_OK_DONE);
+}
+
+static inline m_serial_return_code_t
+m_serial_json_write_str_map_start(m_serial_local_t local, m_serial_write_t serial, const size_t number_of_elements)
+{
+  (void) local; // argument not used
+  (void) number_of_elements; // Ignored
+  return m_serial_jsoni_write_char(serial, '{', M_SERIAL_OK_CONTINUE);
+}
+
+static inline m_serial_return_code_t
+m_serial_json_write_str_map_value(m_serial_local_t local, m_serial_write_t serial)
+{
+  (void) local; // argument not used
+  return m_serial_jsoni_write_char(serial, ':', M_SERIAL_OK_CONTINUE);
+}
+
+static inline m_serial_return_code_t
+m_serial_json_write_str_end(m_serial_local_t local, m_serial_write_t serial)
+{
+  (void) local; // argument not used
+  return m_serial_jsoni_write_char(serial, '}', M_SERIAL_OK_DONE);
+}
+
+static inline m_serial_return_code_t
+m_serial_json_write_str_tuple_start(m_serial_local_t local, m_serial_write_t serial)
+{
+  (void) local; // argument not used
+  return m_serial_jsoni_write_char(serial, '{', M_SERIAL_OK_CONTINUE);
+}
+
+/* Write the field name with its separators */
+static inline void
+m_serial_jsoni_write_field(m_serial_write_t serial, const char *prefix, const char field[])
+{
+  struct string_s *str = (struct string_s *)serial->data[0].p;
+  m_serial_jsoni_cat(str, prefix, strlen(prefix));
+  m_serial_jsoni_cat(str, field, strlen(field));
+  m_serial_jsoni_cat(str, "\":", 2);
+}
+
+static inline m_serial_return_code_t
+m_serial_json_write_str_tuple_id(m_serial_local_t local, m_serial_write_t serial, const char *const field_name[], const int max, const int index)
+{
+  (void) local; // argument not used
+  (void) max; // Ignored
+  m_serial_jsoni_write_field(serial, index == 0 ? " \"" : ",\"", field_name[index]);
+  return M_SERIAL_OK_CONTINUE;
+}
+
+static inline m_serial_return_code_t
+m_serial_json_write_str_variant_start(m_serial_local_t local, m_serial_write_t serial, const char *const field_name[], const int max, const int index)
+{
+  (void) local; // argument not used
+  (void) max; // argument not used
+  if (index >= 0) {
+    assert (index < max);
+    m_serial_jsoni_write_field(serial, "{\"", field_name[index]);
+    return M_SERIAL_OK_CONTINUE;
+  } else {
+    m_serial_jsoni_cat((struct string_s *)serial->data[0].p, "{}", 2);
+    return M_SERIAL_OK_DONE;
+  }
+}
+
+static const m_serial_write_interface_t m_serial_write_json_str_interface = {
+  m_serial_json_write_str_boolean,
+  m_serial_json_write_str_integer,
+  m_serial_json_write_str_float,
+  m_serial_json_write_str_string,
+  m_serial_json_write_str_array_start,
+  m_serial_json_write_str_next,
+  m_serial_json_write_str_array_end,
+  m_serial_json_write_str_map_start,
+  m_serial_json_write_str_map_value,
+  m_serial_json_write_str_next,
+  m_serial_json_write_str_end,
+  m_serial_json_write_str_tuple_start,
+  m_serial_json_write_str_tuple_id,
+  m_serial_json_write_str_end,
+  m_serial_json_write_str_variant_start,
+  m_serial_json_write_str_end,
+  false
+};
+
+/* Initialize the 'serial' object to output in JSON format
+   at the end of the string 'str' */
+static inline void m_serial_json_write_init_str(m_serial_write_t serial, string_t str)
+{
+  serial->interface = &m_serial_write_json_str_interface;
+  serial->data[0].p = str;
+}
+
+/* Skip the spaces of the memory buffer and return the next character
+   (which is not consumed) or EOF at the end of the buffer */
+static inline int
+m_serial_jsoni_buffer_skip(m_serial_read_t serial)
+{
+  const char *p = (const char *)serial->data[1].p;
+  const char *end = (const char *)serial->data[2].p;
+  while (p < end && isspace((unsigned char) *p))
+    p++;
+  serial->data[1].p = (char *)(uintptr_t)p;
+  return p < end ? (unsigned char) *p : EOF;
+}
+
+/* Skip the spaces and consume the character 'c'.
+   Return true if it succeeds */
+static inline bool
+m_serial_jsoni_buffer_expect(m_serial_read_t serial, int c)
+{
+  if (m_serial_jsoni_buffer_skip(serial) != c)
+    return false;
+  serial->data[1].p = (char *)serial->data[1].p + 1;
+  return true;
+}
+
+/* Skip the spaces and consume the keyword 'word' of 'n' characters */
+static inline bool
+m_serial_jsoni_buffer_keyword(m_serial_read_t serial, const char word[], size_t n)
+{
+  m_serial_jsoni_buffer_skip(serial);
+  const char *p = (const char *)serial->data[1].p;
+  if ((size_t) ((const char *)serial->data[2].p - p) < n || memcmp(p, word, n) != 0)
+    return false;
+  serial->data[1].p = (char *)serial->data[1].p + n;
+  return true;
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_buffer_boolean(m_serial_read_t serial, bool *b){
+  int c = m_serial_jsoni_buffer_skip(serial);
+  *b = (c == 't');
+  bool r = *b ? m_serial_jsoni_buffer_keyword(serial, "true", 4)
+    : m_serial_jsoni_buffer_keyword(serial, "false", 5);
+  return r ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+}
+
+/* Parse the integer starting at 'p' (before 'end').
+   Return the end of the integer or NULL if it fails */
+static inline const char *
+m_serial_jsoni_parse_integer(long long *i, const char *p, const char *end)
+{
+  bool neg = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    neg = (*p == '-');
+    p++;
+  }
+  const char *digits = p;
+  unsigned long long u = 0;
+  const unsigned long long limit = neg ? (unsigned long long) LLONG_MAX + 1 : LLONG_MAX;
+  while (p < end && *p >= '0' && *p <= '9') {
+    const unsigned d = (unsigned) (*p - '0');
+    if (M_UNLIKELY (u > (limit - d) / 10))
+      return NULL; // Overflow
+    u = u * 10 + d;
+    p++;
+  }
+  if (p == digits)
+    return NULL;
+  *i = neg ? (u == (unsigned long long) LLONG_MAX + 1 ? LLONG_MIN : -(long long) u) : (long long) u;
+  return p;
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_buffer_integer(m_serial_read_t serial, long long *i, const size_t size_of_type){
+  (void) size_of_type; // Ignored
+  m_serial_jsoni_buffer_skip(serial);
+  const char *p = m_serial_jsoni_parse_integer(i, (const char *)serial->data[1].p,
+                                               (const char *)serial->data[2].p);
+  if (p == NULL)
+    return M_SERIAL_FAIL;
+  serial->data[1].p = (char *)(uintptr_t)p;
+  return M_SERIAL_OK_DONE;
+}
+
+/* Parse the float number of the 'n' characters of 'str'.
+   The usual numbers (no more than 15 significant digits and a small exponent)
+   are computed exactly with one multiplication or division by
+   an exact power of 10 (which is correctly rounded).
+   The other ones are given to strtold. */
+static inline bool
+m_serial_jsoni_parse_float(long double *r, const char str[], size_t n)
+{
+  static const long double pow10[] = {
+    1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L, 1e7L, 1e8L, 1e9L, 1e10L,
+    1e11L, 1e12L, 1e13L, 1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L, 1e20L,
+    1e21L, 1e22L };
+  const char *p = str, *end = str + n;
+  bool neg = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    neg = (*p == '-');
+    p++;
+  }
+  unsigned long long m = 0;
+  int digits = 0, exp10 = 0;
+  bool any = false;
+  while (p < end && *p >= '0' && *p <= '9') {
+    if (m != 0 || *p != '0')
+      digits++;
+    m = m * 10 + (unsigned) (*p++ - '0');
+    any = true;
+    if (digits > 15) goto slow;
+  }
+  if (p < end && *p == '.') {
+    p++;
+    while (p < end && *p >= '0' && *p <= '9') {
+      if (m != 0 || *p != '0')
+        digits++;
+      m = m * 10 + (unsigned) (*p++ - '0');
+      exp10--;
+      any = true;
+      if (digits > 15) goto slow;
+    }
+  }
+  if (!any) goto slow;
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    p++;
+    bool eneg = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+      eneg = (*p == '-');
+      p++;
+    }
+    int e = 0;
+    if (p == end) goto slow;
+    while (p < end && *p >= '0' && *p <= '9') {
+      e = e * 10 + (*p++ - '0');
+      if (e > 1000) goto slow;
+    }
+    exp10 += eneg ? -e : e;
+  }
+  if (p != end || exp10 < -22 || exp10 > 22) goto slow;
+  {
+    long double x = (long double) m;
+    x = exp10 < 0 ? x / pow10[-exp10] : x * pow10[exp10];
+    *r = neg ? -x : x;
+    return true;
+  }
+ slow:
+  {
+    /* strtold needs a null terminated string */
+    char tmp[64];
+    char *buffer = tmp;
+    if (n >= sizeof tmp) {
+      buffer = M_MEMORY_REALLOC(char, NULL, n + 1);
+      if (buffer == NULL) {
+        M_MEMORY_FULL(n + 1);
+        return false;
+      }
+    }
+    memcpy(buffer, str, n);
+    buffer[n] = 0;
+    char *e;
+    *r = strtold(buffer, &e);
+    const bool ok = n > 0 && e == &buffer[n];
+    if (buffer != tmp)
+      M_MEMORY_FREE(buffer);
+    return ok;
+  }
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_buffer_float(m_serial_read_t serial, long double *r, const size_t size_of_type){
+  (void) size_of_type; // Ignored
+  m_serial_jsoni_buffer_skip(serial);
+  const char *start = (const char *)serial->data[1].p;
+  const char *end = (const char *)serial->data[2].p;
+  /* Get the token of the number */
+  const char *p = start;
+  while (p < end && !isspace((unsigned char) *p)
+         && *p != ',' && *p != ']' && *p != '}' && *p != ':')
+    p++;
+  if (!m_serial_jsoni_parse_float(r, start, (size_t) (p - start)))
+    return M_SERIAL_FAIL;
+  serial->data[1].p = (char *)(uintptr_t)p;
+  return M_SERIAL_OK_DONE;
+}
+
+/* Read a quoted string (same escape sequences as string_in_str).
+   The characters which are not escaped are copied by blocks. */
+static inline  m_serial_return_code_t
+m_serial_json_read_buffer_string(m_serial_read_t serial, struct string_s *s){
+  if (!m_serial_jsoni_buffer_expect(serial, '"'))
+    return M_SERIAL_FAIL;
+  const char *p = (const char *)serial->data[1].p;
+  const char *end = (const char *)serial->data[2].p;
+  string_clean(s);
+  while (true) {
+    const char *start = p;
+    while (p < end && *p != '"' && *p != '\\')
+      p++;
+    m_serial_jsoni_cat(s, start, (size_t) (p - start));
+    if (p == end)
+      return M_SERIAL_FAIL;
+    if (*p++ == '"')
+      break;
+    /* Escape sequence */
+    if (p == end)
+      return M_SERIAL_FAIL;
+    char c = *p++;
+    switch (c) {
+    case 'n':
+    case 't':
+    case 'r':
+    case '\\':
+    case '\"':
+      c = " \r \" \n\\\t"[(c^(c>>5))& 0x07];
+      break;
+    default:
+      if (end - p < 2 || !(c >= '0' && c <= '7')
+          || !(p[0] >= '0' && p[0] <= '7') || !(p[1] >= '0' && p[1] <= '7'))
+        return M_SERIAL_FAIL;
+      c = (char) (((c - '0') << 6) + ((p[0] - '0') << 3) + (p[1] - '0'));
+      p += 2;
+      break;
+    }
+    m_serial_jsoni_cat(s, &c, 1);
+  }
+  serial->data[1].p = (char *)(uintptr_t)p;
+  return M_SERIAL_OK_DONE;
+}
+
+/* Consume the opening character 'open' of an array or a map
+   and the closing character 'close' if it follows */
+static inline  m_serial_return_code_t
+m_serial_jsoni_buffer_start(m_serial_read_t serial, int open, int close)
+{
+  if (!m_serial_jsoni_buffer_expect(serial, open))
+    return M_SERIAL_FAIL;
+  return m_serial_jsoni_buffer_expect(serial, close) ? M_SERIAL_OK_DONE : M_SERIAL_OK_CONTINUE;
+}
+
+/* Consume the separator ',' or the closing character 'close' */
+static inline  m_serial_return_code_t
+m_serial_jsoni_buffer_next(m_serial_read_t serial, int close)
+{
+  int c = m_serial_jsoni_buffer_skip(serial);
+  if (c != ',' && c != close)
+    return M_SERIAL_FAIL;
+  serial->data[1].p = (char *)serial->data[1].p + 1;
+  return c == ',' ? M_SERIAL_OK_CONTINUE : M_SERIAL_OK_DONE;
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_buffer_array_start(m_serial_local_t local, m_serial_read_t serial, size_t *num)
+{
+  (void) local; // argument not used
+  *num = 0; // don't know the size of the array.
+  return m_serial_jsoni_buffer_start(serial, '[', ']');
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_buffer_array_next(m_serial_local_t local, m_serial_read_t serial)
+{
+  (void) local; // argument not used
+  return m_serial_jsoni_buffer_next(serial, ']');
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_buffer_map_start(m_serial_local_t local, m_serial_read_t serial, size_t *num)
+{
+  (void) local; // argument not used
+  *num = 0; // don't know the size of the map.
+  return m_serial_jsoni_buffer_start(serial, '{', '}');
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_buffer_map_value(m_serial_local_t local, m_serial_read_t serial)
+{
+  (void) local; // argument not used
+  return m_serial_jsoni_buffer_expect(serial, ':') ? M_SERIAL_OK_CONTINUE : M_SERIAL_FAIL;
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_buffer_map_next(m_serial_local_t local, m_serial_read_t serial)
+{
+  (void) local; // argument not used
+  return m_serial_jsoni_buffer_next(serial, '}');
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_buffer_tuple_start(m_serial_local_t local, m_serial_read_t serial)
+{
+  (void) local; // argument not used
+  return m_serial_jsoni_buffer_expect(serial, '{') ? M_SERIAL_OK_CONTINUE : M_SERIAL_FAIL;
+}
+
+/* Read a field name followed by ':' and set '*id' with its index
+   in the table 'field_name[max]'. Return false if it fails */
+static inline bool
+m_serial_jsoni_buffer_field(m_serial_read_t serial, const char *const field_name[], const int max, int *id)
+{
+  if (!m_serial_jsoni_buffer_expect(serial, '"'))
+    return false;
+  const char *start = (const char *)serial->data[1].p;
+  const char *end = (const char *)serial->data[2].p;
+  const char *p = (const char *) memchr(start, '"', (size_t) (end - start));
+  if (p == NULL)
+    return false;
+  const size_t n = (size_t) (p - start);
+  serial->data[1].p = (char *)(uintptr_t)(p + 1);
+  if (!m_serial_jsoni_buffer_expect(serial, ':'))
+    return false;
+  return m_serial_jsoni_field_id(&serial->data[3].p, field_name, max, start, n, id);
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_buffer_tuple_id(m_serial_local_t local, m_serial_read_t serial, const char *const field_name [], const int max, int *id)
+{
+  (void) local; // argument not used
+  int c = m_serial_jsoni_buffer_skip(serial);
+  if (c == '}') {
+    serial->data[1].p = (char *)serial->data[1].p + 1;
+    return M_SERIAL_OK_DONE;
+  }
+  if (c == ',') {
+    // If first call of read_tuple_id, it is a failure
+    if (*id == -1) return M_SERIAL_FAIL;
+    serial->data[1].p = (char *)serial->data[1].p + 1;
+  }
+  return m_serial_jsoni_buffer_field(serial, field_name, max, id)
+    ? M_SERIAL_OK_CONTINUE : M_SERIAL_FAIL;
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_buffer_variant_start(m_serial_local_t local, m_serial_read_t serial, const char *const field_name[], const int max, int*id)
+{
+  (void) local; // argument not used
+  m_serial_return_code_t ret = m_serial_jsoni_buffer_start(serial, '{', '}');
+  if (ret != M_SERIAL_OK_CONTINUE)
+    return ret;
+  return m_serial_jsoni_buffer_field(serial, field_name, max, id)
+    ? M_SERIAL_OK_CONTINUE : M_SERIAL_FAIL;
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_buffer_variant_end(m_serial_local_t local, m_serial_read_t serial)
+{
+  (void) local; // argument not used
+  return m_serial_jsoni_buffer_expect(serial, '}') ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+}
+
+static const m_serial_read_interface_t m_serial_json_read_buffer_interface = {
+  m_serial_json_read_buffer_boolean,
+  m_serial_json_read_buffer_integer,
+  m_serial_json_read_buffer_float,
+  m_serial_json_read_buffer_string,
+  m_serial_json_read_buffer_array_start,
+  m_serial_json_read_buffer_array_next,
+  m_serial_json_read_buffer_map_start,
+  m_serial_json_read_buffer_map_value,
+  m_serial_json_read_buffer_map_next,
+  m_serial_json_read_buffer_tuple_start,
+  m_serial_json_read_buffer_tuple_id,
+  m_serial_json_read_buffer_variant_start,
+  m_serial_json_read_buffer_variant_end
+};
+
+/* Initialize the 'serial' object to parse in JSON format
+   the memory buffer 'buffer' of 'size' bytes */
+static inline void m_serial_json_read_init_buffer(m_serial_read_t serial, const void *buffer, size_t size)
+{
+  char *ptr = (char *)(uintptr_t) buffer;
+  serial->interface = &m_serial_json_read_buffer_interface;
+  serial->data[0].p = ptr;
+  serial->data[1].p = ptr;
+  serial->data[2].p = ptr + size;
+  serial->data[3].p = NULL; // Cache of the sorted field names
+}
+
+/* Structural index.
+   The reader initialized by m_serial_json_read_init_index parses
+   the memory buffer in two stages (like simdjson):
+   - the buffer is classified per chunk of 64 bytes (using SIMD
+     instructions if available) into bitmasks of quotes, backslashes,
+     spaces & operators. The escaped characters and the strings are
+     computed from these masks, giving the positions of the structural
+     characters ({}[]:, and the quotes outside the strings) and
+     of the first character of the other tokens (numbers, true & false),
+   - the interface callbacks walk these positions instead of scanning
+     the characters of the buffer.
+   The index is built per block of M_SERIAL_JSON_INDEX_BLOCK bytes
+   so that its memory is bounded whatever the size of the buffer.
+   The position of the closing quote of a string is flagged with
+   M_SERIAL_JSONI_ESCAPE if the string has a backslash, so that the
+   strings without escape sequences are copied without being scanned.
+   The data of the serial object are the same as for the buffer reader,
+   with data[3] the index. */
+#ifndef M_SERIAL_JSON_INDEX_BLOCK
+#define M_SERIAL_JSON_INDEX_BLOCK (64*1024)
+#endif
+#if M_SERIAL_JSON_INDEX_BLOCK > 0x7FFFFFFF
+# error "M_SERIAL_JSON_INDEX_BLOCK is too big."
+#endif
+
+#define M_SERIAL_JSONI_ESCAPE 0x80000000U
+
+typedef struct m_serial_jsoni_index_s {
+  const char *base;           // Start of the indexed block
+  const char *next;           // Start of the next block to index
+  const char *end;            // End of the buffer
+  size_t      count;          // Number of positions in the index
+  size_t      cur;            // Current position in the index
+  uint64_t    in_string;      // All ones if the next block starts within a string
+  uint64_t    escaped;        // 1 if the first character of the next block is escaped
+  uint64_t    scalar;         // 1 if the next block starts within a token
+  uint64_t    string_escape;  // 1 if the string the next block starts within has a backslash
+  void       *fields;         // Cache of the sorted field names
+  uint32_t    pos[M_SERIAL_JSON_INDEX_BLOCK+4]; // Offsets from base
+} m_serial_jsoni_index_t;
+
+/* Bitmasks of a chunk of 64 characters (bit i for the i-th character) */
+typedef struct m_serial_jsoni_class_s {
+  uint64_t quote, backslash, space, op;
+} m_serial_jsoni_class_t;
+
+#if M_USE_SIMD && defined(__AVX2__)
+#include <immintrin.h>
+
+static inline void
+m_serial_jsoni_classify(m_serial_jsoni_class_t *c, const char *p)
+{
+  c->quote = c->backslash = c->space = c->op = 0;
+  for(unsigned i = 0; i < 64; i += 32) {
+    const __m256i v = _mm256_loadu_si256((const __m256i *)(const void *)(p + i));
+    /* '[' & ']' are '{' & '}' without the 0x20 bit */
+    const __m256i l = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    const __m256i op = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(l, _mm256_set1_epi8('{')),
+                                                       _mm256_cmpeq_epi8(l, _mm256_set1_epi8('}'))),
+                                       _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')),
+                                                       _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))));
+    /* Spaces are the characters <= ' ' */
+    const __m256i sp = _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(' ')), _mm256_set1_epi8(' '));
+    c->quote |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))) << i;
+    c->backslash |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))) << i;
+    c->space |= (uint64_t) (uint32_t) _mm256_movemask_epi8(sp) << i;
+    c->op |= (uint64_t) (uint32_t) _mm256_movemask_epi8(op) << i;
+  }
+}
+
+#elif M_USE_SIMD && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+
+static inline void
+m_serial_jsoni_classify(m_serial_jsoni_class_t *c, const char *p)
+{
+  c->quote = c->backslash = c->space = c->op = 0;
+  for(unsigned i = 0; i < 64; i += 16) {
+    const __m128i v = _mm_loadu_si128((const __m128i *)(const void *)(p + i));
+    /* '[' & ']' are '{' & '}' without the 0x20 bit */
+    const __m128i l = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    const __m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(l, _mm_set1_epi8('{')),
+                                                 _mm_cmpeq_epi8(l, _mm_set1_epi8('}'))),
+                                    _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')),
+                                                 _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+    /* Spaces are the characters <= ' ' */
+    const __m128i sp = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(' ')), _mm_set1_epi8(' '));
+    c->quote |= (uint64_t) (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))) << i;
+    c->backslash |= (uint64_t) (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))) << i;
+    c->space |= (uint64_t) (uint32_t) _mm_movemask_epi8(sp) << i;
+    c->op |= (uint64_t) (uint32_t) _mm_movemask_epi8(op) << i;
+  }
+}
+
+#else
+/* Portable version */
+static inline void
+m_serial_jsoni_classify(m_serial_jsoni_class_t *c, const char *p)
+{
+  c->quote = c->backslash = c->space = c->op = 0;
+  for(unsigned i = 0; i < 64; i++) {
+    const unsigned char x = (unsigned char) p[i];
+    const uint64_t bit = 1ULL << i;
+    c->quote |= x == '"' ? bit : 0;
+    c->backslash |= x == '\\' ? bit : 0;
+    c->space |= x <= ' ' ? bit : 0;
+    c->op |= ((x | 0x20) == '{' || (x | 0x20) == '}' || x == ':' || x == ',') ? bit : 0;
+  }
+}
+#endif
+
+/* Return the number of bits set in 'x' */
+static inline unsigned int
+m_serial_jsoni_popcount64(uint64_t x)
+{
+#if defined(__GNUC__)
+  return (unsigned int) __builtin_popcountll(x);
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return (unsigned int) ((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/* Index the chunk of 64 characters 'p' at offset 'offset' of the block */
+static inline void
+m_serial_jsoni_index_chunk(m_serial_jsoni_index_t *ix, const char *p, uint32_t offset)
+{
+  m_serial_jsoni_class_t c;
+  m_serial_jsoni_classify(&c, p);
+  /* Escaped characters: a backslash which is not escaped escapes
+     the next character (backslashes are rare, so they are handled
+     one by one) */
+  uint64_t escaped = ix->escaped;
+  uint64_t bs = c.backslash & ~escaped;
+  ix->escaped = 0;
+  while (M_UNLIKELY (bs != 0)) {
+    const uint64_t bit = bs & (~bs + 1);
+    if (bit == (1ULL << 63))
+      ix->escaped = 1;
+    escaped |= bit << 1;
+    bs &= ~(bit | (bit << 1));
+  }
+  const uint64_t quote = c.quote & ~escaped;
+  /* Prefix xor of the quotes: the characters within the strings
+     (including the opening quote) */
+  uint64_t in_string = quote;
+  in_string ^= in_string << 1;
+  in_string ^= in_string << 2;
+  in_string ^= in_string << 4;
+  in_string ^= in_string << 8;
+  in_string ^= in_string << 16;
+  in_string ^= in_string << 32;
+  in_string ^= ix->in_string;
+  ix->in_string = (in_string >> 63) ? ~0ULL : 0ULL;
+  /* Tokens are sequences of characters which are neither spaces, operators,
+     nor part of a string */
+  const uint64_t scalar = ~(c.op | c.space | quote | in_string);
+  const uint64_t scalar_start = scalar & ~((scalar << 1) | ix->scalar);
+  ix->scalar = scalar >> 63;
+  uint64_t bits = (c.op & ~in_string) | quote | scalar_start;
+  /* Backslashes within the strings */
+  uint64_t string_bs = c.backslash & in_string;
+  if (M_LIKELY ((string_bs | ix->string_escape) == 0)) {
+    /* Write the positions by groups of 4 (less mispredicted branches):
+       the positions written after the last one are ignored */
+    uint32_t *out = &ix->pos[ix->count];
+    ix->count += m_serial_jsoni_popcount64(bits);
+    while (bits != 0) {
+      out[0] = offset + m_core_ctz64(bits);
+      bits &= bits - 1;
+      out[1] = offset + m_core_ctz64(bits);
+      bits &= bits - 1;
+      out[2] = offset + m_core_ctz64(bits);
+      bits &= bits - 1;
+      out[3] = offset + m_core_ctz64(bits);
+      bits &= bits - 1;
+      out += 4;
+    }
+    return;
+  }
+  /* Flag the closing quotes of the strings which have a backslash
+     (the closing quotes are the quotes outside of in_string) */
+  const uint64_t close = quote & ~in_string;
+  while (bits != 0) {
+    const uint64_t bit = bits & (~bits + 1);
+    uint32_t v = offset + m_core_ctz64(bits);
+    if (bit & close) {
+      if (ix->string_escape || (string_bs & (bit - 1)) != 0)
+        v |= M_SERIAL_JSONI_ESCAPE;
+      ix->string_escape = 0;
+      string_bs &= ~(bit - 1);
+    }
+    ix->pos[ix->count++] = v;
+    bits &= bits - 1;
+  }
+  ix->string_escape = ix->in_string && (ix->string_escape || string_bs != 0);
+}
+
+/* Build the index of the next block of the buffer */
+static inline void
+m_serial_jsoni_index_fill(m_serial_jsoni_index_t *ix)
+{
+  const char *p = ix->next;
+  const size_t n = M_MIN((size_t) (ix->end - p), (size_t) M_SERIAL_JSON_INDEX_BLOCK);
+  ix->base = p;
+  ix->count = ix->cur = 0;
+  uint32_t offset = 0;
+  for( ; offset + 64 <= n; offset += 64)
+    m_serial_jsoni_index_chunk(ix, p + offset, offset);
+  if (offset < n) {
+    /* Last chunk of the buffer: pad it with spaces */
+    char tmp[64];
+    memset(tmp, ' ', sizeof tmp);
+    memcpy(tmp, p + offset, n - offset);
+    m_serial_jsoni_index_chunk(ix, tmp, offset);
+  }
+  ix->next = p + n;
+}
+
+/* Return the position of the next structural character or token
+   (which is not consumed), or NULL at the end of the buffer */
+static inline const char *
+m_serial_jsoni_index_peek(m_serial_read_t serial)
+{
+  m_serial_jsoni_index_t *ix = (m_serial_jsoni_index_t *)serial->data[3].p;
+  while (M_UNLIKELY (ix->cur == ix->count)) {
+    if (ix->next == ix->end)
+      return NULL;
+    m_serial_jsoni_index_fill(ix);
+  }
+  return ix->base + (ix->pos[ix->cur] & ~M_SERIAL_JSONI_ESCAPE);
+}
+
+/* Consume the position 'p' returned by m_serial_jsoni_index_peek */
+static inline void
+m_serial_jsoni_index_pop(m_serial_read_t serial, const char *p)
+{
+  m_serial_jsoni_index_t *ix = (m_serial_jsoni_index_t *)serial->data[3].p;
+  ix->cur++;
+  serial->data[1].p = (char *)(uintptr_t)(p + 1);
+}
+
+/* Consume the structural character 'c'. Return true if it succeeds */
+static inline bool
+m_serial_jsoni_index_expect(m_serial_read_t serial, int c)
+{
+  const char *p = m_serial_jsoni_index_peek(serial);
+  if (p == NULL || *p != c)
+    return false;
+  m_serial_jsoni_index_pop(serial, p);
+  return true;
+}
+
+/* Consume the next token (a number, true or false).
+   Return its first character and set '*q' to its end,
+   or return NULL if there is no token */
+static inline const char *
+m_serial_jsoni_index_token(m_serial_read_t serial, const char **q)
+{
+  const char *p = m_serial_jsoni_index_peek(serial);
+  if (p == NULL || *p == '"' || ((*p | 0x20) == '{' || (*p | 0x20) == '}' || *p == ':' || *p == ','))
+    return NULL;
+  m_serial_jsoni_index_pop(serial, p);
+  const char *e = m_serial_jsoni_index_peek(serial);
+  if (e == NULL)
+    e = (const char *)serial->data[2].p;
+  while ((unsigned char) e[-1] <= ' ')
+    e--;
+  serial->data[1].p = (char *)(uintptr_t)e;
+  *q = e;
+  return p;
+}
+
+/* Check that the token has been fully parsed and restore the buffer */
+static inline m_serial_return_code_t
+m_serial_jsoni_index_token_end(m_serial_read_t serial, const char *end, m_serial_return_code_t ret)
+{
+  if (serial->data[1].p != serial->data[2].p)
+    ret = M_SERIAL_FAIL;
+  serial->data[2].p = (char *)(uintptr_t)end;
+  return ret;
+}
+
+/* The tokens are parsed in place: their end is given by the index */
+static inline  m_serial_return_code_t
+m_serial_json_read_index_boolean(m_serial_read_t serial, bool *b){
+  const char *q;
+  const char *p = m_serial_jsoni_index_token(serial, &q);
+  if (p == NULL)
+    return M_SERIAL_FAIL;
+  *b = (*p == 't');
+  bool r = *b ? (q - p == 4 && memcmp(p, "true", 4) == 0)
+    : (q - p == 5 && memcmp(p, "false", 5) == 0);
+  return r ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_index_integer(m_serial_read_t serial, long long *i, const size_t size_of_type){
+  (void) size_of_type; // Ignored
+  const char *q;
+  const char *p = m_serial_jsoni_index_token(serial, &q);
+  if (p == NULL)
+    return M_SERIAL_FAIL;
+  return m_serial_jsoni_parse_integer(i, p, q) == q ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_index_float(m_serial_read_t serial, long double *r, const size_t size_of_type){
+  (void) size_of_type; // Ignored
+  const char *q;
+  const char *p = m_serial_jsoni_index_token(serial, &q);
+  if (p == NULL)
+    return M_SERIAL_FAIL;
+  return m_serial_jsoni_parse_float(r, p, (size_t) (q - p)) ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+}
+
+/* Consume a string and return its opening quote (its closing quote
+   is the current position of the serial object) or NULL if it fails.
+   Set '*escape' to true if the string has a backslash */
+static inline const char *
+m_serial_jsoni_index_string(m_serial_read_t serial, bool *escape)
+{
+  const char *p = m_serial_jsoni_index_peek(serial);
+  if (p == NULL || *p != '"')
+    return NULL;
+  m_serial_jsoni_index_pop(serial, p);
+  const char *q = m_serial_jsoni_index_peek(serial);
+  if (q == NULL || *q != '"')
+    return NULL;
+  const m_serial_jsoni_index_t *ix = (const m_serial_jsoni_index_t *)serial->data[3].p;
+  *escape = (ix->pos[ix->cur] & M_SERIAL_JSONI_ESCAPE) != 0;
+  m_serial_jsoni_index_pop(serial, q);
+  return p;
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_index_string(m_serial_read_t serial, struct string_s *s){
+  bool escape;
+  const char *p = m_serial_jsoni_index_string(serial, &escape);
+  if (p == NULL)
+    return M_SERIAL_FAIL;
+  const char *q = (const char *)serial->data[1].p;
+  const size_t n = (size_t) (q - p - 2);
+  if (M_LIKELY (!escape)) {
+    string_clean(s);
+    m_serial_jsoni_cat(s, p + 1, n);
+    return M_SERIAL_OK_DONE;
+  }
+  /* Escape sequences: let the buffer reader decode the string */
+  const char *end = (const char *)serial->data[2].p;
+  serial->data[1].p = (char *)(uintptr_t)p;
+  serial->data[2].p = (char *)(uintptr_t)q;
+  return m_serial_jsoni_index_token_end(serial, end, m_serial_json_read_buffer_string(serial, s));
+}
+
+static inline  m_serial_return_code_t
+m_serial_jsoni_index_start(m_serial_read_t serial, int open, int close)
+{
+  if (!m_serial_jsoni_index_expect(serial, open))
+    return M_SERIAL_FAIL;
+  return m_serial_jsoni_index_expect(serial, close) ? M_SERIAL_OK_DONE : M_SERIAL_OK_CONTINUE;
+}
+
+static inline  m_serial_return_code_t
+m_serial_jsoni_index_next(m_serial_read_t serial, int close)
+{
+  const char *p = m_serial_jsoni_index_peek(serial);
+  if (p == NULL || (*p != ',' && *p != close))
+    return M_SERIAL_FAIL;
+  m_serial_jsoni_index_pop(serial, p);
+  return *p == ',' ? M_SERIAL_OK_CONTINUE : M_SERIAL_OK_DONE;
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_index_array_start(m_serial_local_t local, m_serial_read_t serial, size_t *num)
+{
+  (void) local; // argument not used
+  *num = 0; // don't know the size of the array.
+  return m_serial_jsoni_index_start(serial, '[', ']');
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_index_array_next(m_serial_local_t local, m_serial_read_t serial)
+{
+  (void) local; // argument not used
+  return m_serial_jsoni_index_next(serial, ']');
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_index_map_start(m_serial_local_t local, m_serial_read_t serial, size_t *num)
+{
+  (void) local; // argument not used
+  *num = 0; // don't know the size of the map.
+  return m_serial_jsoni_index_start(serial, '{', '}');
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_index_map_value(m_serial_local_t local, m_serial_read_t serial)
+{
+  (void) local; // argument not used
+  return m_serial_jsoni_index_expect(serial, ':') ? M_SERIAL_OK_CONTINUE : M_SERIAL_FAIL;
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_index_map_next(m_serial_local_t local, m_serial_read_t serial)
+{
+  (void) local; // argument not used
+  return m_serial_jsoni_index_next(serial, '}');
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_index_tuple_start(m_serial_local_t local, m_serial_read_t serial)
+{
+  (void) local; // argument not used
+  return m_serial_jsoni_index_expect(serial, '{') ? M_SERIAL_OK_CONTINUE : M_SERIAL_FAIL;
+}
+
+/* Read a field name followed by ':' and set '*id' with its index
+   in the table 'field_name[max]'. Return false if it fails */
+static inline bool
+m_serial_jsoni_index_field(m_serial_read_t serial, const char *const field_name[], const int max, int *id)
+{
+  bool escape;
+  const char *p = m_serial_jsoni_index_string(serial, &escape);
+  if (p == NULL)
+    return false;
+  const size_t n = (size_t) ((const char *)serial->data[1].p - p - 2);
+  if (!m_serial_jsoni_index_expect(serial, ':'))
+    return false;
+  m_serial_jsoni_index_t *ix = (m_serial_jsoni_index_t *)serial->data[3].p;
+  return m_serial_jsoni_field_id(&ix->fields, field_name, max, p + 1, n, id);
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_index_tuple_id(m_serial_local_t local, m_serial_read_t serial, const char *const field_name [], const int max, int *id)
+{
+  (void) local; // argument not used
+  const char *p = m_serial_jsoni_index_peek(serial);
+  if (p == NULL)
+    return M_SERIAL_FAIL;
+  if (*p == '}') {
+    m_serial_jsoni_index_pop(serial, p);
+    return M_SERIAL_OK_DONE;
+  }
+  if (*p == ',') {
+    // If first call of read_tuple_id, it is a failure
+    if (*id == -1) return M_SERIAL_FAIL;
+    m_serial_jsoni_index_pop(serial, p);
+  }
+  return m_serial_jsoni_index_field(serial, field_name, max, id)
+    ? M_SERIAL_OK_CONTINUE : M_SERIAL_FAIL;
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_index_variant_start(m_serial_local_t local, m_serial_read_t serial, const char *const field_name[], const int max, int*id)
+{
+  (void) local; // argument not used
+  m_serial_return_code_t ret = m_serial_jsoni_index_start(serial, '{', '}');
+  if (ret != M_SERIAL_OK_CONTINUE)
+    return ret;
+  return m_serial_jsoni_index_field(serial, field_name, max, id)
+    ? M_SERIAL_OK_CONTINUE : M_SERIAL_FAIL;
+}
+
+static inline  m_serial_return_code_t
+m_serial_json_read_index_variant_end(m_serial_local_t local, m_serial_read_t serial)
+{
+  (void) local; // argument not used
+  return m_serial_jsoni_index_expect(serial, '}') ? M_SERIAL_OK_DONE : M_SERIAL_FAIL;
+}
+
+static const m_serial_read_interface_t m_serial_json_read_index_interface = {
+  m_serial_json_read_index_boolean,
+  m_serial_json_read_index_integer,
+  m_serial_json_read_index_float,
+  m_serial_json_read_index_string,
+  m_serial_json_read_index_array_start,
+  m_serial_json_read_index_array_next,
+  m_serial_json_read_index_map_start,
+  m_serial_json_read_index_map_value,
+  m_serial_json_read_index_map_next,
+  m_serial_json_read_index_tuple_start,
+  m_serial_json_read_index_tuple_id,
+  m_serial_json_read_index_variant_start,
+  m_serial_json_read_index_variant_end
+};
+
+/* Initialize the 'serial' object to parse in JSON format
+   the memory buffer 'buffer' of 'size' bytes using a structural index.
+   If the index cannot be allocated, the plain buffer reader is used. */
+static inline void m_serial_json_read_init_index(m_serial_read_t serial, const void *buffer, size_t size)
+{
+  m_serial_json_read_init_buffer(serial, buffer, size);
+  m_serial_jsoni_index_t *ix = M_MEMORY_ALLOC(m_serial_jsoni_index_t);
+  if (M_UNLIKELY (ix == NULL)) {
+    M_MEMORY_FULL(sizeof (m_serial_jsoni_index_t));
+    return;
+  }
+  ix->base = ix->next = (const char *)buffer;
+  ix->end = ix->next + size;
+  ix->count = ix->cur = 0;
+  ix->in_string = ix->escaped = ix->scalar = ix->string_escape = 0;
+  ix->fields = NULL;
+  serial->interface = &m_serial_json_read_index_interface;
+  serial->data[3].p = ix;
+}
+
+/* Return the number of bytes parsed by the 'serial' object
+   initialized by m_serial_json_read_init_buffer (or m_serial_json_read_init_index) */
+static inline size_t m_serial_json_read_size(const m_serial_read_t serial)
+{
+  assert (serial->interface == &m_serial_json_read_buffer_interface
+          || serial->interface == &m_serial_json_read_index_interface);
+  return (size_t) ((const char *)serial->data[1].p - (const char *)serial->data[0].p);
 }
 
 static inline void m_serial_json_read_clear(m_serial_read_t serial)
 {
-  (void) serial; // Nothing to do
+  if (serial->interface == &m_serial_json_read_index_interface) {
+    m_serial_jsoni_index_t *ix = (m_serial_jsoni_index_t *)serial->data[3].p;
+    m_serial_jsoni_fields_clear(ix->fields);
+    M_MEMORY_DEL(ix);
+  } else if (serial->interface == &m_serial_json_read_buffer_interface) {
+    m_serial_jsoni_fields_clear(serial->data[3].p);
+  }
 }
 
 #endif
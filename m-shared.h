@@ -76,6 +76,7 @@
   SWAP(M_C(name, _swap))                                                \
   ,M_IF_METHOD(NEW, oplist)(NEW(M_GET_NEW oplist),)                     \
   ,M_IF_METHOD(REALLOC, oplist)(REALLOC(M_GET_REALLOC oplist),)         \
+  ,M_IF_METHOD(FREE, oplist)(FREE(M_GET_FREE oplist),)                  \
   ,M_IF_METHOD(DEL, oplist)(DEL(M_GET_DEL oplist),)                     \
   )
 
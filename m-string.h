@@ -502,13 +502,98 @@ string_cmpi(const string_t v1, const string_t v2)
   return string_cmpi_str(v1, string_get_cstr(v2));
 }
 
+/* Size of the blocks of the search of a string by SIMD (if any) */
+#if M_USE_SIMD && defined(__AVX2__)
+#include <immintrin.h>
+#define STRINGI_SEARCH_BLOCK 32
+#elif M_USE_SIMD && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define STRINGI_SEARCH_BLOCK 16
+#endif
+
+/* Return the index of the first occurrence of 'str' of 'n' characters
+   in 'p[start..size)' (or STRING_FAILURE). 'p' & 'str' are null
+   terminated strings without null char before their end.
+   The candidates are first found with memchr on the first character
+   of 'str' (which is fast if this character is rare). If there are too
+   many false candidates, the search continues by blocks, checking
+   both the first & the last characters of 'str' at once with AVX2
+   or SSE2 (or with the C library otherwise) */
+static inline size_t
+stringi_search_mem(const char p[], size_t start, size_t size, const char str[], size_t n)
+{
+  if (n == 0)
+    return start;
+  if (n > size - start)
+    return STRING_FAILURE;
+  const size_t last = size - n; // Last possible position of 'str'
+  size_t i = start;
+  unsigned miss = 0;
+  while (i <= last) {
+    const char *q = (const char *) memchr(p + i, str[0], last - i + 1);
+    if (q == NULL)
+      return STRING_FAILURE;
+    if (memcmp(q + 1, str + 1, n - 1) == 0)
+      return (size_t) (q - p);
+    i = (size_t) (q - p) + 1;
+    /* Less than 256 characters between the false candidates on average:
+       the cost of the calls to memchr is too high */
+    if (M_UNLIKELY (++miss * 256 > i - start + 256))
+      break;
+  }
+  if (i > last)
+    return STRING_FAILURE;
+#if M_USE_SIMD && defined(__AVX2__)
+  const __m256i first = _mm256_set1_epi8(str[0]);
+  const __m256i final = _mm256_set1_epi8(str[n-1]);
+  for( ; i + 32 <= last + 1; i += 32) {
+    const __m256i a = _mm256_loadu_si256((const __m256i *)(const void *) (p + i));
+    const __m256i b = _mm256_loadu_si256((const __m256i *)(const void *) (p + i + n - 1));
+    uint32_t m = (uint32_t) _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first),
+                                                                  _mm256_cmpeq_epi8(b, final)));
+    while (m != 0) {
+      const size_t k = i + m_core_ctz64(m);
+      if (n <= 2 || memcmp(p + k + 1, str + 1, n - 2) == 0)
+        return k;
+      m &= m - 1;
+    }
+  }
+#elif defined(STRINGI_SEARCH_BLOCK)
+  const __m128i first = _mm_set1_epi8(str[0]);
+  const __m128i final = _mm_set1_epi8(str[n-1]);
+  for( ; i + 16 <= last + 1; i += 16) {
+    const __m128i a = _mm_loadu_si128((const __m128i *)(const void *) (p + i));
+    const __m128i b = _mm_loadu_si128((const __m128i *)(const void *) (p + i + n - 1));
+    uint32_t m = (uint32_t) _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first),
+                                                            _mm_cmpeq_epi8(b, final)));
+    while (m != 0) {
+      const size_t k = i + m_core_ctz64(m);
+      if (n <= 2 || memcmp(p + k + 1, str + 1, n - 2) == 0)
+        return k;
+      m &= m - 1;
+    }
+  }
+#endif
+#ifdef STRINGI_SEARCH_BLOCK
+  for( ; i <= last; i++)
+    if (p[i] == str[0] && memcmp(p + i + 1, str + 1, n - 1) == 0)
+      return i;
+  return STRING_FAILURE;
+#else
+  const char *q = strstr(p + i, str);
+  return q == NULL ? STRING_FAILURE : (size_t) (q - p);
+#endif
+}
+
 static inline size_t
 string_search_char (const string_t v, char c, size_t start)
 {
   STRINGI_CONTRACT (v);
   assert (start <= string_size(v));
+  // The size is known: memchr doesn't look for the final null char
+  // (which is found if c is 0, like strchr)
   const char *p = M_ASSIGN_CAST(const char*,
-				strchr(string_get_cstr(v)+start, c));
+				memchr(string_get_cstr(v)+start, c, string_size(v)+1-start));
   return p == NULL ? STRING_FAILURE : (size_t) (p-string_get_cstr(v));
 }
 
@@ -531,17 +616,17 @@ string_search_str (const string_t v, const char str[], size_t start)
   STRINGI_CONTRACT (v);
   assert (start <= string_size(v));
   M_ASSUME (str != NULL);
-  const char *p = M_ASSIGN_CAST(const char*,
-				strstr(string_get_cstr(v)+start, str));
-  return p == NULL ? STRING_FAILURE : (size_t) (p-string_get_cstr(v));
+  return stringi_search_mem(string_get_cstr(v), start, string_size(v), str, strlen(str));
 }
 
 static inline size_t
 string_search (const string_t v1, const string_t v2, size_t start)
 {
+  STRINGI_CONTRACT (v1);
   STRINGI_CONTRACT (v2);
   assert (start <= string_size(v1));
-  return string_search_str(v1, string_get_cstr(v2), start);
+  return stringi_search_mem(string_get_cstr(v1), start, string_size(v1),
+                            string_get_cstr(v2), string_size(v2));
 }
 
 static inline size_t
@@ -1325,6 +1410,7 @@ string_utf8_p(string_t str)
 
 
 /* Define the split & the join functions 
+   (and the radix sort for random access containers)
    in case of usage with the algorithm module */
 #define STRING_SPLIT(name, oplist, type_oplist)                         \
   static inline void M_C(name, _split)(M_GET_TYPE oplist cont,          \
@@ -1370,6 +1456,92 @@ string_utf8_p(string_t str)
         init_done = true;                                               \
     }                                                                   \
   }                                                                     \
+                                                                        \
+  M_IF_METHOD2(GET_KEY, GET_SIZE, oplist)(                              \
+  M_IF_METHOD(IT_PREVIOUS, oplist)(                                     \
+  STRINGI_RADIX_SORT_DEF(name, oplist)                                  \
+  , ), )                                                                \
+
+/* Parameters of the MSD radix sort of strings:
+   - size of a bucket below which an insertion sort is used,
+   - bucket of the string 's' for the character at 'depth' (0 if finished) */
+#define STRINGI_RADIX_INSERTION_THRESHOLD 32
+#define STRINGI_RADIX_BYTE(s, depth)                                    \
+  ((depth) < string_size(s) ? 1 + (unsigned char) string_get_cstr(s)[depth] : 0)
+
+/* Define a MSD radix sort for random access containers of strings */
+#define STRINGI_RADIX_SORT_DEF(name, oplist)                            \
+  static inline void                                                    \
+  M_C(name, _radix_sort_rec)(string_t *tab, string_t *tmp, size_t n, size_t depth) \
+  {                                                                     \
+    while (n >= STRINGI_RADIX_INSERTION_THRESHOLD) {                    \
+      size_t count[257] = { 0 };                                        \
+      for(size_t i = 0; i < n; i++)                                     \
+        count[STRINGI_RADIX_BYTE(tab[i], depth)] ++;                    \
+      size_t offset[257];                                               \
+      size_t sum = 0;                                                   \
+      size_t max = 1;                                                   \
+      for(size_t b = 0; b < 257; b++) {                                 \
+        offset[b] = sum;                                                \
+        sum += count[b];                                                \
+        if (b > 0 && count[b] > count[max])                             \
+          max = b;                                                      \
+      }                                                                 \
+      if (count[0] == n)                                                \
+        return;   /* All the strings are equal */                       \
+      if (count[max] != n) {                                            \
+        for(size_t i = 0; i < n; i++)                                   \
+          memcpy(&tmp[offset[STRINGI_RADIX_BYTE(tab[i], depth)]++],     \
+                 &tab[i], sizeof (string_t));                           \
+        memcpy(tab, tmp, n * sizeof (string_t));                        \
+        /* The strings of the bucket 0 are finished (and equal).        \
+           Recurse on the other buckets but the biggest one */          \
+        for(size_t b = 1; b < 257; b++) {                               \
+          size_t start = offset[b] - count[b];                          \
+          if (b != max && count[b] > 1)                                 \
+            M_C(name, _radix_sort_rec)(tab + start, tmp + start, count[b], depth + 1); \
+        }                                                               \
+        /* Loop on the biggest bucket */                                \
+        tab += offset[max] - count[max];                                \
+        tmp += offset[max] - count[max];                                \
+        n = count[max];                                                 \
+      }                                                                 \
+      depth++;                                                          \
+    }                                                                   \
+    /* Insertion sort of the suffixes */                                \
+    for(size_t i = 1; i < n; i++) {                                     \
+      string_t x;                                                       \
+      size_t j = i;                                                     \
+      memcpy(&x, &tab[i], sizeof (string_t));                           \
+      while (j > 0 && strcmp(string_get_cstr(tab[j-1]) + depth,         \
+                             string_get_cstr(x) + depth) > 0) {         \
+        memcpy(&tab[j], &tab[j-1], sizeof (string_t));                  \
+        j--;                                                            \
+      }                                                                 \
+      memcpy(&tab[j], &x, sizeof (string_t));                           \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  static inline void                                                    \
+  M_C(name, _radix_sort)(M_GET_TYPE oplist cont)                        \
+  {                                                                     \
+    size_t n = M_CALL_GET_SIZE(oplist, cont);                           \
+    if (n < 2)                                                          \
+      return;                                                           \
+    string_t *tab = M_CALL_GET_KEY(oplist, cont, 0);                    \
+    if (M_UNLIKELY (M_CALL_GET_KEY(oplist, cont, n-1) != tab + n - 1)) { \
+      /* Not a contiguous storage: use the comparison sort */           \
+      M_C(name, _sort)(cont);                                           \
+      return;                                                           \
+    }                                                                   \
+    string_t *tmp = M_MEMORY_REALLOC(string_t, NULL, n);                \
+    if (tmp == NULL) {                                                  \
+      M_MEMORY_FULL(sizeof (string_t) * n);                             \
+      return;                                                           \
+    }                                                                   \
+    M_C(name, _radix_sort_rec)(tab, tmp, n, 0);                         \
+    M_MEMORY_FREE(tmp);                                                 \
+  }
 
 
 /* Use of Compound Literals to init a constant string.
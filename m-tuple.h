@@ -430,8 +430,8 @@ namespace m_tuple {
     return ret & M_SERIAL_FAIL;                                         \
   }
 #define TUPLE_DEFINE_OUT_SERIAL_FUNC(a)                                 \
-  f->interface->write_tuple_id(local, f, field_name, field_max, index); \
-  TUPLE_CALL_OUT_SERIAL(a, f, el -> TUPLE_GET_FIELD a);                 \
+  ret |= f->interface->write_tuple_id(local, f, field_name, field_max, index); \
+  ret |= TUPLE_CALL_OUT_SERIAL(a, f, el -> TUPLE_GET_FIELD a);          \
   index++;                                                              \
 
 #define TUPLE_DEFINE_IN_SERIAL(name, ...)                               \
@@ -530,6 +530,7 @@ namespace m_tuple {
    M_IF_METHOD_ALL(CLEAN, __VA_ARGS__)(CLEAN(M_C(name, _clean)),),      \
    M_IF_METHOD(NEW, M_RET_ARG1(__VA_ARGS__,))(NEW(M_DELAY2(M_GET_NEW) M_RET_ARG1(__VA_ARGS__,)),), \
    M_IF_METHOD(REALLOC, M_RET_ARG1(__VA_ARGS__,))(REALLOC(M_DELAY2(M_GET_REALLOC) M_RET_ARG1(__VA_ARGS__,)),), \
+   M_IF_METHOD(FREE, M_RET_ARG1(__VA_ARGS__,))(FREE(M_DELAY2(M_GET_FREE) M_RET_ARG1(__VA_ARGS__,)),), \
    M_IF_METHOD(DEL, M_RET_ARG1(__VA_ARGS__,))(DEL(M_DELAY2(M_GET_DEL) M_RET_ARG1(__VA_ARGS__,)),), \
    )
 
@@ -86,6 +86,24 @@
 # define M_USE_WORKER_CPP_FUNCTION 0
 #endif
 
+/* The User Code can define M_USE_WORKER_STEALING to 0 to disable the work
+   stealing scheduler. All work orders are then sent through the common
+   queue of work orders.
+   Otherwise each worker thread owns a deque of work orders in which it pushes
+   the work orders it spawns, and the idle workers steal the work orders
+   of the others. Only the work orders spawned by a thread which is not
+   a worker thread go through the common queue.
+*/
+#ifndef M_USE_WORKER_STEALING
+# define M_USE_WORKER_STEALING 1
+#endif
+
+/* Maximum number of work orders in the deque of a worker thread
+   (shall be a power of 2) */
+#ifndef M_WORKER_DEQUE_SIZE
+# define M_WORKER_DEQUE_SIZE 256
+#endif
+
 /* Control that not both options are selected at the same time.
    Note: there are not really incompatible, but if we use C++ we shall go to
    lambda directly (there is no need to support blocks). */
@@ -117,6 +135,11 @@ typedef struct work_order_s {
 # define WORKER_EMPTY_ORDER { NULL, NULL, NULL }
 # define WORKER_EXTRA_ORDER
 #endif
+#if M_USE_WORKER_CLANG_BLOCK
+# define WORKERI_EXTRA_TASK , NULL
+#else
+# define WORKERI_EXTRA_TASK
+#endif
 
 /* As in C++, it uses std::function, M_POD_OPLIST
    is not sufficient for initilization of the structure.
@@ -132,9 +155,41 @@ typedef struct work_order_s {
 # define WORKER_OPLIST M_POD_OPLIST
 #endif
 
+#if M_USE_WORKER_STEALING
+/* This type defines a work order stored in the deque of a worker.
+   It only contains plain pointers so that it can be copied by a thief
+   while the owner of the deque may overwrite it (in which case the steal
+   fails and the copy is discarded). C++ function are sent through the
+   common queue instead. */
+typedef struct workeri_task_s {
+  struct worker_sync_s *block;
+  void * data;
+  void (*func) (void *data);
+#if M_USE_WORKER_CLANG_BLOCK
+  void (^blockFunc)(void *data);
+#endif
+} workeri_task_t;
+
+/* This type defines a Chase-Lev deque of work orders:
+   the owner thread pushes and takes work orders at the bottom,
+   the other threads steal work orders at the top. */
+typedef struct workeri_deque_s {
+  atomic_llong top;
+  char         align1[M_ALIGN_FOR_CACHELINE_EXCLUSION];
+  atomic_llong bottom;
+  char         align2[M_ALIGN_FOR_CACHELINE_EXCLUSION];
+  workeri_task_t tab[M_WORKER_DEQUE_SIZE];
+} workeri_deque_t;
+#endif
+
 /* This type defines a worker represented as a thread */
 typedef struct worker_thread_s {
   m_thread_t id;
+#if M_USE_WORKER_STEALING
+  struct worker_s *pool;        /* The workers the thread belongs to */
+  unsigned int seed;            /* Seed for the choice of the victims */
+  workeri_deque_t deque;        /* The work orders spawned by the thread */
+#endif
 } worker_thread_t;
 
 /* Let's define the queue which will manage all work orders */
@@ -158,6 +213,15 @@ typedef struct worker_s {
   m_mutex_t lock;
   m_cond_t  a_thread_ends;
 
+#if M_USE_WORKER_STEALING
+  /* Condition raised when some work order is available for idle workers */
+  m_cond_t  there_is_work;
+  /* Number of workers waiting for a work order */
+  atomic_int idle_count;
+  /* Number of threads waiting in worker_sync */
+  atomic_int sync_count;
+#endif
+
 } worker_t[1];
 
 /* This type defines a synchronization point for workers */
@@ -214,6 +278,202 @@ workeri_exec(worker_order_t *w)
 }
 
 
+#if M_USE_WORKER_STEALING
+
+/* The worker thread structure of the current thread (NULL if none) */
+static M_THREAD_ATTR struct worker_thread_s *workeri_self;
+
+/* Push a work order at the bottom of the deque.
+   Only the owner of the deque can push. Return false if it is full. */
+static inline bool
+workeri_deque_push(workeri_deque_t *d, const workeri_task_t *t)
+{
+  const long long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+  const long long top = atomic_load(&d->top);
+  if (b - top >= M_WORKER_DEQUE_SIZE)
+    return false;
+  d->tab[b & (M_WORKER_DEQUE_SIZE - 1)] = *t;
+  /* Publish the work order to the thieves */
+  atomic_store(&d->bottom, b + 1);
+  return true;
+}
+
+/* Take the last pushed work order from the bottom of the deque.
+   Only the owner of the deque can take. Return false if it is empty. */
+static inline bool
+workeri_deque_take(workeri_deque_t *d, workeri_task_t *t)
+{
+  const long long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+  /* Reserve the last work order before looking at the thieves */
+  atomic_store(&d->bottom, b);
+  long long top = atomic_load(&d->top);
+  bool ret = false;
+  if (top <= b) {
+    *t = d->tab[b & (M_WORKER_DEQUE_SIZE - 1)];
+    ret = true;
+    if (top != b)
+      return true;
+    /* Last work order: race against the thieves */
+    ret = atomic_compare_exchange_strong(&d->top, &top, top + 1);
+  }
+  atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+  return ret;
+}
+
+/* Steal the first pushed work order from the top of the deque.
+   Any thread can steal. Return false if it is empty or in case
+   of conflict with another thread. */
+static inline bool
+workeri_deque_steal(workeri_deque_t *d, workeri_task_t *t)
+{
+  long long top = atomic_load(&d->top);
+  const long long b = atomic_load(&d->bottom);
+  if (top >= b)
+    return false;
+  /* The copy may be overwritten by the owner, in which case
+     the top has already been moved and the CAS fails */
+  *t = d->tab[top & (M_WORKER_DEQUE_SIZE - 1)];
+  return atomic_compare_exchange_strong(&d->top, &top, top + 1);
+}
+
+/* Test if the deque is empty */
+static inline bool
+workeri_deque_empty_p(workeri_deque_t *d)
+{
+  return atomic_load(&d->top) >= atomic_load(&d->bottom);
+}
+
+/* Execute the taken or stolen work order synchronously */
+static inline void
+workeri_exec_task(const workeri_task_t *t)
+{
+  assert (t != NULL && t->block != NULL);
+#if M_USE_WORKER_CLANG_BLOCK
+  if (t->func == NULL)
+    t->blockFunc(t->data);
+  else
+#endif
+    t->func(t->data);
+  /* Increment the number of terminated work order for the synchronous point */
+  atomic_fetch_add (&t->block->num_terminated_spawn, 1);
+}
+
+/* Return the worker thread structure of the current thread
+   if it is a worker thread of 'g', NULL otherwise */
+static inline struct worker_thread_s *
+workeri_get_self(struct worker_s *g)
+{
+  struct worker_thread_s *self = workeri_self;
+  return (self != NULL && self->pool == g) ? self : NULL;
+}
+
+/* Get a work order from the deque of the current thread,
+   or steal one from the deque of a random worker */
+static inline bool
+workeri_get_task(struct worker_s *g, struct worker_thread_s *self,
+                 unsigned int *seed, workeri_task_t *t)
+{
+  if (self != NULL && workeri_deque_take(&self->deque, t))
+    return true;
+  const unsigned int n = g->numWorker_g;
+  if (n == 0)
+    return false;
+  /* Cheap but fast pseudo random */
+  *seed = *seed * 1103515245U + 12345U;
+  const unsigned int start = (*seed >> 8) % n;
+  for(unsigned int i = 0; i < n; i++) {
+    struct worker_thread_s *victim = &g->worker[(start + i) % n];
+    if (victim != self && workeri_deque_steal(&victim->deque, t))
+      return true;
+  }
+  return false;
+}
+
+/* Test if some work order may be available for an idle thread */
+static inline bool
+workeri_work_available_p(struct worker_s *g)
+{
+  if (!worker_queue_empty_p(g->queue_g))
+    return true;
+  for(unsigned int i = 0; i < g->numWorker_g; i++) {
+    if (!workeri_deque_empty_p(&g->worker[i].deque))
+      return true;
+  }
+  return false;
+}
+
+/* Wake up an idle worker as a new work order is available */
+static inline void
+workeri_wake_idle(struct worker_s *g)
+{
+  /* The work order has been published before reading the number of
+     idle workers, and an idle worker increments this number before
+     looking for a work order: one of them sees the other. */
+  if (atomic_load(&g->idle_count) > 0) {
+    m_mutex_lock(g->lock);
+    m_cond_signal(g->there_is_work);
+    m_mutex_unlock(g->lock);
+  }
+}
+
+/* Wait for a new work order to be available */
+static inline void
+workeri_wait_work(struct worker_s *g)
+{
+  m_mutex_lock(g->lock);
+  atomic_fetch_add(&g->idle_count, 1);
+  if (!workeri_work_available_p(g))
+    m_cond_wait(g->there_is_work, g->lock);
+  atomic_fetch_sub(&g->idle_count, 1);
+  m_mutex_unlock(g->lock);
+}
+
+/* Signal the end of a work order to the threads waiting in worker_sync */
+static inline void
+workeri_notify_end(struct worker_s *g)
+{
+  if (atomic_load(&g->sync_count) > 0) {
+    m_mutex_lock(g->lock);
+    m_cond_broadcast(g->a_thread_ends);
+    m_mutex_unlock(g->lock);
+  }
+}
+
+/* The worker thread */
+static inline void
+workeri_thread(void *arg)
+{
+  struct worker_thread_s *self = M_ASSIGN_CAST(struct worker_thread_s *, arg);
+  struct worker_s *g = self->pool;
+  workeri_self = self;
+  while (true) {
+    workeri_task_t t;
+    worker_order_t w;
+    if (workeri_get_task(g, self, &self->seed, &t)) {
+      if (g->resetFunc_g != NULL)
+        g->resetFunc_g();
+      workeri_exec_task(&t);
+      workeri_notify_end(g);
+    } else if (worker_queue_pop_blocking(&w, g->queue_g, false)) {
+      if (w.block == NULL) break;
+      if (g->resetFunc_g != NULL)
+        g->resetFunc_g();
+      workeri_exec(&w);
+      worker_queue_pop_release(g->queue_g);
+      workeri_notify_end(g);
+    } else {
+      workeri_wait_work(g);
+    }
+  }
+  workeri_self = NULL;
+  if (g->clearFunc_g != NULL)
+    g->clearFunc_g();
+}
+
+#define WORKERI_WAKE_IDLE(g) workeri_wake_idle(g)
+
+#else
+
 /* The worker thread */
 static inline void
 workeri_thread(void *arg)
@@ -236,6 +496,10 @@ workeri_thread(void *arg)
     g->clearFunc_g();
 }
 
+#define WORKERI_WAKE_IDLE(g) (void) 0
+
+#endif
+
 /* Initialization of the worker module 
    Input:
    @numWorker: number of worker to create (0=autodetect, -1=2*autodetect)
@@ -263,9 +527,25 @@ worker_init(worker_t g, int numWorker, unsigned int extraQueue, void (*resetFunc
   m_mutex_init(g->lock);
   m_cond_init(g->a_thread_ends);
   
+#if M_USE_WORKER_STEALING
+  m_cond_init(g->there_is_work);
+  atomic_init(&g->idle_count, 0);
+  atomic_init(&g->sync_count, 0);
+  /* All deques shall be initialized before any thief starts */
+  for(size_t i = 0; i < numWorker_st; i++) {
+    g->worker[i].pool = g;
+    g->worker[i].seed = (unsigned int) i + 1;
+    atomic_init(&g->worker[i].deque.top, 0LL);
+    atomic_init(&g->worker[i].deque.bottom, 0LL);
+  }
+  for(size_t i = 0; i < numWorker_st; i++) {
+    m_thread_create(g->worker[i].id, workeri_thread, M_ASSIGN_CAST(void*, &g->worker[i]));
+  }
+#else
   for(size_t i = 0; i < numWorker_st; i++) {
     m_thread_create(g->worker[i].id, workeri_thread, M_ASSIGN_CAST(void*, g));
   }
+#endif
 }
 // Define function with default values.
 #define worker_init(...) worker_init(M_DEFAULT_ARGS(5, (0, 0, NULL, NULL), __VA_ARGS__))
@@ -282,6 +562,11 @@ worker_clear(worker_t g)
     // But for robustness, let's wait.
     worker_queue_push_blocking (g->queue_g, w, true);
   }
+#if M_USE_WORKER_STEALING
+  m_mutex_lock(g->lock);
+  m_cond_broadcast(g->there_is_work);
+  m_mutex_unlock(g->lock);
+#endif
   
   for(unsigned int i = 0; i < g->numWorker_g; i++) {
     m_thread_join(g->worker[i].id);
@@ -290,6 +575,9 @@ worker_clear(worker_t g)
 
   m_mutex_clear(g->lock);
   m_cond_clear(g->a_thread_ends);
+#if M_USE_WORKER_STEALING
+  m_cond_clear(g->there_is_work);
+#endif
   worker_queue_clear(g->queue_g);
 }
 
@@ -308,11 +596,27 @@ worker_start(worker_sync_t block, worker_t g)
 static inline void
 worker_spawn(worker_sync_t block, void (*func)(void *data), void *data)
 {
+#if M_USE_WORKER_STEALING
+  /* Inside a worker thread, push the work order in its own deque */
+  struct worker_thread_s *self = workeri_get_self(block->worker);
+  if (self != NULL) {
+    const workeri_task_t t = { block, data, func WORKERI_EXTRA_TASK };
+    atomic_fetch_add (&block->num_spawn, 1);
+    if (M_LIKELY (workeri_deque_push(&self->deque, &t))) {
+      workeri_wake_idle(block->worker);
+      return;
+    }
+    atomic_fetch_sub (&block->num_spawn, 1);
+    (*func) (data);
+    return;
+  }
+#endif
   const worker_order_t w = {  block, data, func WORKER_EXTRA_ORDER };
   if (M_UNLIKELY (!worker_queue_full_p(block->worker->queue_g))
       && worker_queue_push (block->worker->queue_g, w) == true) {
     //printf ("Sending data to thread: %p (block: %d / %d)\n", data, block->num_spawn, block->num_terminated_spawn);
     atomic_fetch_add (&block->num_spawn, 1);
+    WORKERI_WAKE_IDLE(block->worker);
     return;
   }
   //printf ("Running data ourself: %p\n", data);
@@ -326,11 +630,27 @@ worker_spawn(worker_sync_t block, void (*func)(void *data), void *data)
 static inline void
 worker_spawn_block(worker_sync_t block, void (^func)(void *data), void *data)
 {
+#if M_USE_WORKER_STEALING
+  /* Inside a worker thread, push the work order in its own deque */
+  struct worker_thread_s *self = workeri_get_self(block->worker);
+  if (self != NULL) {
+    const workeri_task_t t = { block, data, NULL, func };
+    atomic_fetch_add (&block->num_spawn, 1);
+    if (M_LIKELY (workeri_deque_push(&self->deque, &t))) {
+      workeri_wake_idle(block->worker);
+      return;
+    }
+    atomic_fetch_sub (&block->num_spawn, 1);
+    func (data);
+    return;
+  }
+#endif
   const worker_order_t w = {  block, data, NULL, func };
   if (M_UNLIKELY (!worker_queue_full_p(block->worker->queue_g))
       && worker_queue_push (block->worker->queue_g, w) == true) {
     //printf ("Sending data to thread as block: %p (block: %d / %d)\n", data, block->num_spawn, block->num_terminated_spawn);
     atomic_fetch_add (&block->num_spawn, 1);
+    WORKERI_WAKE_IDLE(block->worker);
     return;
   }
   //printf ("Running data ourself as block: %p\n", data);
@@ -350,6 +670,7 @@ worker_spawn_function(worker_sync_t block, std::function<void(void *data)> func,
       && worker_queue_push (block->worker->queue_g, w) == true) {
     //printf ("Sending data to thread as block: %p (block: %d / %d)\n", data, block->num_spawn, block->num_terminated_spawn);
     atomic_fetch_add (&block->num_spawn, 1);
+    WORKERI_WAKE_IDLE(block->worker);
     return;
   }
   //printf ("Running data ourself as block: %p\n", data);
@@ -374,11 +695,40 @@ worker_sync(worker_sync_t block)
 {
   //printf ("Waiting for thread terminasion.\n");
   if (worker_sync_p(block)) return;
+#if M_USE_WORKER_STEALING
+  /* Help executing the pending work orders instead of only waiting */
+  struct worker_s *g = block->worker;
+  struct worker_thread_s *self = workeri_get_self(g);
+  unsigned int local_seed = (unsigned int) atomic_load(&block->num_spawn);
+  unsigned int *seed = (self != NULL) ? &self->seed : &local_seed;
+  while (!worker_sync_p(block)) {
+    workeri_task_t t;
+    worker_order_t w;
+    if (workeri_get_task(g, self, seed, &t)) {
+      workeri_exec_task(&t);
+      workeri_notify_end(g);
+    } else if (worker_queue_pop_blocking(&w, g->queue_g, false)) {
+      assert (w.block != NULL);
+      workeri_exec(&w);
+      worker_queue_pop_release(g->queue_g);
+      workeri_notify_end(g);
+    } else {
+      /* Nothing to help with: the remaining work orders are running */
+      m_mutex_lock(g->lock);
+      atomic_fetch_add(&g->sync_count, 1);
+      if (!worker_sync_p(block) && !workeri_work_available_p(g))
+        m_cond_wait(g->a_thread_ends, g->lock);
+      atomic_fetch_sub(&g->sync_count, 1);
+      m_mutex_unlock(g->lock);
+    }
+  }
+#else
   m_mutex_lock(block->worker->lock);
   while (!worker_sync_p(block)) {
     m_cond_wait(block->worker->a_thread_ends, block->worker->lock);
   }
   m_mutex_unlock(block->worker->lock);
+#endif
 }
 
 /* Flush any work order in the queue if some remains.*/
@@ -390,6 +740,15 @@ worker_flush(worker_t g)
     workeri_exec(&w);
     worker_queue_pop_release(g->queue_g);
   }
+#if M_USE_WORKER_STEALING
+  struct worker_thread_s *self = workeri_get_self(g);
+  unsigned int seed = 1;
+  workeri_task_t t;
+  while (workeri_get_task(g, self, self != NULL ? &self->seed : &seed, &t)) {
+    workeri_exec_task(&t);
+    workeri_notify_end(g);
+  }
+#endif
 }
 
 
@@ -27,6 +27,7 @@
 #include "m-deque.h"
 #include "m-dict.h"
 #include "m-algo.h"
+#include "m-worker.h"
 
 #include "test-obj.h"
 
@@ -45,11 +46,29 @@ LIST_DEF(list_string, string_t, STRING_OPLIST)
 DEQUE_DEF(deque_obj, testobj_t, TESTOBJ_CMP_OPLIST)
 #define M_OPL_deque_obj_t() DEQUE_OPLIST(deque_obj, TESTOBJ_CMP_OPLIST)
 DICT_DEF2(dict_obj, string_t, STRING_OPLIST, testobj_t, TESTOBJ_OPLIST)
+ARRAY_DEF(array_u64, uint64_t, M_OPEXTEND(M_DEFAULT_OPLIST, RADIX_KEY(m_radix_key_u64)))
+ARRAY_DEF(array_i32, int32_t, M_OPEXTEND(M_DEFAULT_OPLIST, RADIX_KEY(m_radix_key_i32)))
+ARRAY_DEF(array_double, double, M_OPEXTEND(M_DEFAULT_OPLIST, RADIX_KEY(m_radix_key_double)))
+ARRAY_DEF(array_string, string_t)
+/* Random access containers without a contiguous storage */
+DEQUE_DEF(deque_u64, uint64_t, M_OPEXTEND(M_DEFAULT_OPLIST, RADIX_KEY(m_radix_key_u64)))
+#define DEQUE_U64_OPLIST M_OPEXTEND(DEQUE_OPLIST(deque_u64, M_OPEXTEND(M_DEFAULT_OPLIST, RADIX_KEY(m_radix_key_u64))), GET_KEY(deque_u64_get))
+DEQUE_DEF(deque_string, string_t)
+#define DEQUE_STRING_OPLIST M_OPEXTEND(DEQUE_OPLIST(deque_string, STRING_OPLIST), GET_KEY(deque_string_get))
+
+/* Key & original position, for checking the stability */
+typedef struct { int key; int pos; } kpos_t;
+static inline int kpos_cmp(const kpos_t a, const kpos_t b)
+{
+  return (a.key > b.key) - (a.key < b.key);
+}
+ARRAY_DEF(array_kpos, kpos_t, M_OPEXTEND(M_POD_OPLIST, CMP(kpos_cmp)))
 LIST_DUAL_PUSH_DEF(dlist_int, int)
 
 #include "coverage.h"
 START_COVERAGE
 ALGO_DEF(algo_array, array_int_t)
+ALGO_PARALLEL_DEF(algo_array, array_int_t)
 ALGO_DEF(algo_list,  LIST_OPLIST(list_int))
 ALGO_DEF(algo_over,  ILIST_OPLIST(ilist_over, M_POD_OPLIST))
 ALGO_DEF(algo_string, LIST_OPLIST(list_string, STRING_OPLIST))
@@ -57,6 +76,15 @@ ALGO_DEF(algo_deque, deque_obj_t)
 ALGO_DEF(algo_dict, DICT_OPLIST(dict_obj, STRING_OPLIST, TESTOBJ_OPLIST))
 END_COVERAGE
 ALGO_DEF(algo_dlist, LIST_OPLIST(list_int))
+ALGO_DEF(algo_u64, ARRAY_OPLIST(array_u64, M_OPEXTEND(M_DEFAULT_OPLIST, RADIX_KEY(m_radix_key_u64))))
+ALGO_PARALLEL_DEF(algo_u64, ARRAY_OPLIST(array_u64, M_OPEXTEND(M_DEFAULT_OPLIST, RADIX_KEY(m_radix_key_u64))))
+ALGO_DEF(algo_i32, ARRAY_OPLIST(array_i32, M_OPEXTEND(M_DEFAULT_OPLIST, RADIX_KEY(m_radix_key_i32))))
+ALGO_DEF(algo_double, ARRAY_OPLIST(array_double, M_OPEXTEND(M_DEFAULT_OPLIST, RADIX_KEY(m_radix_key_double))))
+ALGO_PARALLEL_DEF(algo_double, ARRAY_OPLIST(array_double, M_OPEXTEND(M_DEFAULT_OPLIST, RADIX_KEY(m_radix_key_double))))
+ALGO_DEF(algo_astring, ARRAY_OPLIST(array_string, STRING_OPLIST))
+ALGO_DEF(algo_du64, DEQUE_U64_OPLIST)
+ALGO_PARALLEL_DEF(algo_du64, DEQUE_U64_OPLIST)
+ALGO_DEF(algo_dstring, DEQUE_STRING_OPLIST)
 
 /* Helper functions */
 int g_min, g_max, g_count;
@@ -79,6 +107,19 @@ static void func_reduce(int *d, int n)
   *d += n;
 }
 
+static atomic_int g_pcount;
+
+static void g_pf(int n)
+{
+  assert (0 <= n && n < 100);
+  atomic_fetch_add(&g_pcount, 1);
+}
+
+static void func_pmap(int *d, int n)
+{
+  *d = n * n;
+}
+
 static bool func_test_42(int d)
 {
   return d == 42;
@@ -434,6 +475,249 @@ static void test_insert(void)
   }
 }
 
+static int sort_cmp_int(const void *a, const void *b)
+{
+  int x = *(const int *) a;
+  int y = *(const int *) b;
+  return (x > y) - (x < y);
+}
+
+static int sort_pattern(int pattern, int i, int n)
+{
+  switch (pattern) {
+  case 0: return rand();
+  case 1: return i;
+  case 2: return n - i;
+  case 3: return 17;
+  case 4: return i % 16;
+  case 5: return i < n / 2 ? i : n - i;
+  case 6: return (i % 100 == 0) ? rand() : i;
+  default: return rand() % 4;
+  }
+}
+
+static void test_sort_patterns(void)
+{
+  static const int sizes[] = { 0, 1, 2, 3, 10, 24, 25, 100, 129, 1000, 50000 };
+  array_int_t a, b;
+  array_int_init(a);
+  array_int_init(b);
+  for(unsigned s = 0; s < sizeof sizes / sizeof sizes[0]; s++) {
+    int n = sizes[s];
+    for(int pattern = 0; pattern < 8; pattern++) {
+      array_int_clean(a);
+      for(int i = 0; i < n; i++)
+        array_int_push_back(a, sort_pattern(pattern, i, n));
+      array_int_set(b, a);
+      algo_array_sort(a);
+      assert (algo_array_sort_p(a));
+      array_int_set(b, a);
+      array_int_special_stable_sort(b);
+      assert (array_int_equal_p(a, b));
+      /* Same result than the C library */
+      if (n > 0)
+        qsort(array_int_get(b, 0), (size_t) n, sizeof (int), sort_cmp_int);
+      assert (array_int_equal_p(a, b));
+      algo_array_sort_dsc(a);
+      assert (algo_array_sort_dsc_p(a));
+    }
+  }
+  array_int_clear(a);
+  array_int_clear(b);
+}
+
+static void test_stable_sort(void)
+{
+  static const int sizes[] = { 0, 1, 2, 3, 10, 31, 32, 33, 64, 65, 100, 1000, 5000, 50000 };
+  array_kpos_t a;
+  array_kpos_init(a);
+  for(unsigned s = 0; s < sizeof sizes / sizeof sizes[0]; s++) {
+    int n = sizes[s];
+    for(int pattern = 0; pattern < 8; pattern++) {
+      array_kpos_clean(a);
+      for(int i = 0; i < n; i++) {
+        kpos_t x = { sort_pattern(pattern, i, n) % 1000, i };
+        array_kpos_push_back(a, x);
+      }
+      array_kpos_special_stable_sort(a);
+      for(int i = 1; i < n; i++) {
+        const kpos_t *p = array_kpos_cget(a, i-1);
+        const kpos_t *q = array_kpos_cget(a, i);
+        assert (p->key < q->key || (p->key == q->key && p->pos < q->pos));
+      }
+    }
+  }
+  array_kpos_clear(a);
+}
+
+static void test_radix(void)
+{
+  worker_t w;
+  worker_init(w, 4, 0, NULL, NULL);
+  array_u64_t a, b;
+  array_u64_init(a);
+  array_u64_init(b);
+  for(int s = 0; s < 3; s++) {
+    array_u64_clean(a);
+    for(int i = 0; i < 100000; i++) {
+      uint64_t r = (uint64_t) rand() << 40 | (uint64_t) rand() << 20 | (uint64_t) rand();
+      /* Some 32 bits keys, and some keys with only the top bits */
+      array_u64_push_back(a, s == 0 ? r : s == 1 ? r & 0xFFFFFFFF : r << 40);
+    }
+    array_u64_set(b, a);
+    if (s == 1)
+      algo_u64_parallel_radix_sort(a, w);
+    else
+      algo_u64_radix_sort(a);
+    algo_u64_sort(b);
+    assert (array_u64_equal_p(a, b));
+  }
+  array_u64_clear(a);
+  array_u64_clear(b);
+
+  array_i32_t ai;
+  array_i32_init(ai);
+  algo_i32_radix_sort(ai);
+  for(int i = 0; i < 1000; i++)
+    array_i32_push_back(ai, rand() - RAND_MAX / 2);
+  array_i32_push_back(ai, INT32_MIN);
+  array_i32_push_back(ai, INT32_MAX);
+  algo_i32_radix_sort(ai);
+  assert (algo_i32_sort_p(ai));
+  assert (*array_i32_get(ai, 0) == INT32_MIN);
+  array_i32_clear(ai);
+
+  array_double_t ad;
+  array_double_init(ad);
+  for(int i = 0; i < 20000; i++)
+    array_double_push_back(ad, (rand() - RAND_MAX / 2) / 1000.0);
+  array_double_push_back(ad, -1e300);
+  array_double_push_back(ad, 1e300);
+  array_double_push_back(ad, 0.0);
+  algo_double_parallel_radix_sort(ad, w);
+  assert (algo_double_sort_p(ad));
+  assert (*array_double_get(ad, 0) == -1e300);
+  array_double_clear(ad);
+
+  array_string_t as, bs;
+  array_string_init(as);
+  array_string_init(bs);
+  string_t str;
+  string_init(str);
+  algo_astring_radix_sort(as);
+  for(int i = 0; i < 5000; i++) {
+    /* Common prefixes, empty strings and duplicates */
+    string_printf(str, "%s%d", (i % 3) == 0 ? "prefix-" : "", rand() % 2000);
+    if (i % 101 == 0)
+      string_clean(str);
+    array_string_push_back(as, str);
+  }
+  for(int i = 0; i < 100; i++) {
+    string_set_str(str, "same");
+    array_string_push_back(as, str);
+  }
+  array_string_set(bs, as);
+  algo_astring_radix_sort(as);
+  algo_astring_sort(bs);
+  assert (array_string_equal_p(as, bs));
+  array_string_clear(as);
+  array_string_clear(bs);
+
+  /* The storage of a deque is not contiguous: comparison sort is used */
+  deque_u64_t d;
+  deque_u64_init(d);
+  for(int i = 0; i < 20000; i++)
+    deque_u64_push_back(d, (uint64_t) rand() << 20 | (uint64_t) rand());
+  assert (deque_u64_get(d, 19999) != deque_u64_get(d, 0) + 19999);
+  algo_du64_radix_sort(d);
+  assert (algo_du64_sort_p(d));
+  for(int i = 0; i < 20000; i++)
+    deque_u64_push_front(d, (uint64_t) rand());
+  algo_du64_parallel_radix_sort(d, w);
+  assert (algo_du64_sort_p(d));
+  assert (deque_u64_size(d) == 40000);
+  deque_u64_clear(d);
+
+  deque_string_t ds;
+  deque_string_init(ds);
+  for(int i = 0; i < 2000; i++) {
+    string_printf(str, "%d", rand() % 500);
+    deque_string_push_front(ds, str);
+  }
+  algo_dstring_radix_sort(ds);
+  assert (algo_dstring_sort_p(ds));
+  deque_string_clear(ds);
+  string_clear(str);
+  worker_clear(w);
+}
+
+static void test_parallel(void)
+{
+  worker_t w;
+  worker_init(w, 4, 0, NULL, NULL);
+  array_int_t a, b;
+  array_int_init(a);
+  array_int_init(b);
+
+  /* Below the threshold: sequential fallback */
+  for(int i = 0; i < 100; i++)
+    array_int_push_back(a, 99 - i);
+  algo_array_parallel_sort(a, w);
+  assert (algo_array_sort_p(a));
+
+  /* A permutation of [0..N[ */
+  const int n = 100000;
+  array_int_clean(a);
+  for(int i = 0; i < n; i++)
+    array_int_push_back(a, (int) ((i * 7919L) % n));
+  algo_array_parallel_sort(a, w);
+  for(int i = 0; i < n; i++)
+    assert (*array_int_get(a, i) == i);
+
+  /* Many duplicates, compared to the sequential sort */
+  array_int_clean(a);
+  for(int i = 0; i < n; i++)
+    array_int_push_back(a, (int) ((i * 7919L) % 100));
+  array_int_set(b, a);
+  algo_array_parallel_sort(a, w);
+  algo_array_sort(b);
+  assert (array_int_equal_p(a, b));
+
+  /* Reverse sorted */
+  array_int_clean(a);
+  for(int i = 0; i < n; i++)
+    array_int_push_back(a, n - i);
+  algo_array_parallel_sort(a, w);
+  assert (algo_array_sort_p(a));
+  assert (*array_int_get(a, 0) == 1);
+
+  array_int_clean(a);
+  for(int i = 0; i < n; i++)
+    array_int_push_back(a, i % 100);
+  atomic_init(&g_pcount, 0);
+  algo_array_parallel_for_each(a, g_pf, w);
+  assert (atomic_load(&g_pcount) == n);
+
+  int d = 0;
+  algo_array_parallel_map_reduce(&d, a, func_reduce, func_pmap, w);
+  assert (d == (n / 100) * 328350);
+  d = 0;
+  algo_array_map_reduce(&d, a, func_reduce, func_pmap);
+  assert (d == (n / 100) * 328350);
+
+  /* Empty container: dest is not modified */
+  array_int_clean(a);
+  d = -1;
+  algo_array_parallel_map_reduce(&d, a, func_reduce, func_pmap, w);
+  assert (d == -1);
+  algo_array_parallel_for_each(a, g_pf, w);
+  algo_array_parallel_sort(a, w);
+
+  array_int_clear(a);
+  array_int_clear(b);
+  worker_clear(w);
+}
+
 int main(void)
 {
   test_list();
@@ -441,5 +725,9 @@ int main(void)
   test_string();
   test_extract();
   test_insert();
+  test_sort_patterns();
+  test_stable_sort();
+  test_radix();
+  test_parallel();
   exit(0);
 }
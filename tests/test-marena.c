@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2017-2019, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Allocator which can fail on demand, and error handler which returns */
+static int g_fail_alloc = 0;
+static int g_memory_full = 0;
+#define M_MEMORY_REALLOC(type, ptr, n)                                  \
+  (g_fail_alloc ? (type *) NULL : (type *) realloc((ptr), (n)*sizeof (type)))
+#define M_MEMORY_FREE(ptr) free(ptr)
+#define M_MEMORY_FULL(size) ((void) (size), g_memory_full++)
+
+#include "m-arena.h"
+#include "m-list.h"
+#include "m-array.h"
+#include "m-dict.h"
+
+
+M_ARENA_DEF_CURRENT()
+
+#include "coverage.h"
+START_COVERAGE
+LIST_DEF(list_uint, unsigned int, ARENA_OPLIST(M_DEFAULT_OPLIST))
+ARRAY_DEF(array_uint, unsigned int, ARENA_OPLIST(M_DEFAULT_OPLIST))
+END_COVERAGE
+DICT_DEF2(dict_uint, unsigned int, ARENA_OPLIST(M_DEFAULT_OPLIST), unsigned int, M_DEFAULT_OPLIST)
+
+static void test_alloc(void)
+{
+  arena_t a;
+  arena_init(a);
+  assert (arena_capacity(a) == 0);
+
+  unsigned int *tab[100000];
+  for(unsigned int i = 0; i < 100000; i++) {
+    tab[i] = (unsigned int *) arena_alloc(a, sizeof (unsigned int));
+    assert (((uintptr_t) tab[i]) % sizeof (long long) == 0);
+    *tab[i] = i;
+  }
+  for(unsigned int i = 0; i < 100000; i++) {
+    assert (*tab[i] == i);
+  }
+  size_t capa = arena_capacity(a);
+  assert (capa >= 100000 * sizeof (unsigned int));
+
+  /* Reset keeps only the last chunk */
+  arena_reset(a);
+  assert (arena_capacity(a) <= capa);
+  assert (arena_capacity(a) > 0);
+
+  /* Big allocation: bigger than any chunk */
+  char *big = (char *) arena_alloc(a, 4*ARENA_MAX_CHUNK_SIZE);
+  memset(big, 1, 4*ARENA_MAX_CHUNK_SIZE);
+  char *empty1 = (char *) arena_alloc(a, 0);
+  char *empty2 = (char *) arena_alloc(a, 0);
+  assert (empty1 != empty2);
+  arena_clear(a);
+  assert (arena_capacity(a) == 0);
+  arena_clear(a);
+}
+
+static void test_realloc(void)
+{
+  arena_t a;
+  arena_init(a);
+
+  /* Last block: grow in place */
+  unsigned int *p = (unsigned int *) arena_realloc(a, NULL, 10 * sizeof (unsigned int));
+  for(unsigned int i = 0; i < 10; i++)
+    p[i] = i;
+  unsigned int *q = (unsigned int *) arena_realloc(a, p, 100 * sizeof (unsigned int));
+  assert (q == p);
+  for(unsigned int i = 10; i < 100; i++)
+    q[i] = i;
+  /* Not the last block anymore: copy */
+  void *other = (unsigned int *) arena_alloc(a, 1);
+  p = (unsigned int *) arena_realloc(a, q, 200 * sizeof (unsigned int));
+  assert (p != q);
+  for(unsigned int i = 0; i < 100; i++)
+    assert (p[i] == i);
+  /* Shrink */
+  q = (unsigned int *) arena_realloc(a, p, 50 * sizeof (unsigned int));
+  assert (q == p);
+  for(unsigned int i = 0; i < 50; i++)
+    assert (q[i] == i);
+  /* Free of the last block gives back the memory */
+  arena_free(a, q);
+  p = (unsigned int *) arena_realloc(a, NULL, 10 * sizeof (unsigned int));
+  assert (p == q);
+  arena_free(a, other);
+  arena_free(a, NULL);
+
+  /* Growth across chunks */
+  p = NULL;
+  for(unsigned int n = 1; n < 1000000; n *= 2) {
+    p = (unsigned int *) arena_realloc(a, p, n * sizeof (unsigned int));
+    for(unsigned int i = n/2; i < n; i++)
+      p[i] = i;
+  }
+  for(unsigned int i = 0; i < 1000000 / 2; i++)
+    assert (p[i] == i);
+  arena_clear(a);
+
+  /* Out of memory: NULL is returned and the block is kept */
+  p = (unsigned int *) arena_realloc(a, NULL, 10 * sizeof (unsigned int));
+  for(unsigned int i = 0; i < 10; i++)
+    p[i] = i;
+  g_fail_alloc = 1;
+  q = (unsigned int *) arena_realloc(a, p, 4*ARENA_MAX_CHUNK_SIZE);
+  assert (q == NULL);
+  assert (g_memory_full == 1);
+  for(unsigned int i = 0; i < 10; i++)
+    assert (p[i] == i);
+  arena_clear(a);
+  assert (arena_realloc(a, NULL, 1) == NULL);
+  assert (g_memory_full == 2);
+  g_fail_alloc = 0;
+  arena_clear(a);
+}
+
+static void test_oplist(void)
+{
+  arena_t a;
+  arena_init(a);
+  assert (arena_set_current(a) == NULL);
+  assert (arena_get_current() == a);
+
+  for(int iter = 0; iter < 4; iter++) {
+    list_uint_t l;
+    array_uint_t v;
+    dict_uint_t d;
+    list_uint_init(l);
+    array_uint_init(v);
+    dict_uint_init(d);
+    for(unsigned int i = 0; i < 10000; i++) {
+      list_uint_push_back(l, i);
+      array_uint_push_back(v, i);
+      dict_uint_set_at(d, i, i * i);
+    }
+    assert (list_uint_size(l) == 10000);
+    assert (array_uint_size(v) == 10000);
+    assert (dict_uint_size(d) == 10000);
+    for(unsigned int i = 0; i < 10000; i++) {
+      assert (*array_uint_get(v, i) == i);
+      assert (*dict_uint_get(d, i) == i * i);
+    }
+    unsigned int s = 0;
+    for M_EACH(item, l, LIST_OPLIST(list_uint)) {
+      s += *item;
+    }
+    assert (s == 10000 * 9999 / 2);
+    dict_uint_erase(d, 17);
+    list_uint_pop_back(NULL, l);
+    array_uint_clear(v);
+    if (iter & 1) {
+      /* Free the containers (DEL is a no-op) */
+      list_uint_clear(l);
+      dict_uint_clear(d);
+    }
+    /* Free everything at once */
+    arena_reset(a);
+  }
+
+  arena_t b;
+  arena_init(b);
+  assert (arena_set_current(b) == a);
+  list_uint_t l;
+  list_uint_init(l);
+  list_uint_push_back(l, 42);
+  assert (arena_capacity(b) > 0);
+  assert (arena_capacity(a) > 0);
+  arena_clear(b);
+  /* Clearing an arena doesn't change the current arena */
+  assert (arena_get_current() == b);
+  assert (arena_set_current(a) == b);
+  assert (arena_set_current(NULL) == a);
+  arena_clear(a);
+}
+
+int main(void)
+{
+  test_alloc();
+  test_realloc();
+  test_oplist();
+  exit(0);
+}
@@ -20,6 +20,11 @@
  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
+#if defined(__linux__) && !defined(M_USE_FUTEX)
+/* Test the futex based waiting of the BUFFER_FUTEX_WAIT policy */
+# define _DEFAULT_SOURCE
+# define M_USE_FUTEX 1
+#endif
 #include "m-buffer.h"
 
 #include "test-obj.h"
@@ -40,6 +45,11 @@ BUFFER_DEF(buffer_char, char, 10, BUFFER_STACK|BUFFER_UNBLOCKING)
 // Define a fixed queue of long long
 BUFFER_DEF(buffer_llong, long long, 16, BUFFER_QUEUE|BUFFER_THREAD_UNSAFE|BUFFER_UNBLOCKING)
 
+// Define a small fixed queue of unsigned int parking on futex
+BUFFER_DEF(buffer_ufx, unsigned int, 4, BUFFER_QUEUE|BUFFER_BLOCKING|BUFFER_FUTEX_WAIT)
+// Same queue waiting on condition variables (to compare their size)
+BUFFER_DEF(buffer_ucv, unsigned int, 4, BUFFER_QUEUE|BUFFER_BLOCKING)
+
 // Define a buffer of complex structure.
 BUFFER_DEF(buffer_mpz, testobj_t, 32, BUFFER_QUEUE, TESTOBJ_OPLIST)
 QUEUE_MPMC_DEF(queue_z, testobj_t, BUFFER_QUEUE, TESTOBJ_OPLIST)
@@ -47,6 +57,7 @@ QUEUE_SPSC_DEF(squeue_a, testobj_t, BUFFER_QUEUE, TESTOBJ_OPLIST)
 
 buffer_uint_t g_buff;
 buffer_uint_t g_buffB;
+buffer_ufx_t g_buff_fx;
 
 // Number of thread created by the test (twice this amount).
 #define MAX_TEST_THREAD  100
@@ -151,6 +162,91 @@ static void test_global(void)
   buffer_uint_clear(g_buff);
 }
 
+static void conso_fx(void *arg)
+{
+  unsigned long long *p = (unsigned long long *) arg;
+  unsigned int j;
+  for(int i = 0; i < 1000;i++) {
+    buffer_ufx_pop(&j, g_buff_fx);
+    assert (j < 1000);
+    *p += j;
+  }
+}
+
+static void prod_fx(void *arg)
+{
+  assert (arg == NULL);
+  for(unsigned int i = 0; i < 1000;i++)
+    buffer_ufx_push(g_buff_fx, i);
+}
+
+/* Slow producer: the consumers are parked when each item is pushed */
+static void prod_fx_slow(void *arg)
+{
+  assert (arg == NULL);
+  for(unsigned int i = 0; i < 100;i++) {
+    m_thread_sleep(100);
+    buffer_ufx_push(g_buff_fx, i);
+  }
+}
+
+static void conso_fx_slow(void *arg)
+{
+  unsigned long long *p = (unsigned long long *) arg;
+  unsigned int j;
+  for(int i = 0; i < 50;i++) {
+    buffer_ufx_pop(&j, g_buff_fx);
+    *p += j;
+  }
+}
+
+static void test_futex(void)
+{
+  m_thread_t idx_p[MAX_TEST_THREAD2];
+  m_thread_t idx_c[MAX_TEST_THREAD2];
+  unsigned long long sum[MAX_TEST_THREAD2];
+
+  buffer_ufx_init(g_buff_fx, 4);
+  for(int i = 0; i < MAX_TEST_THREAD2; i++) {
+    sum[i] = 0;
+    m_thread_create (idx_c[i], conso_fx, &sum[i]);
+    m_thread_create (idx_p[i], prod_fx, NULL);
+  }
+  unsigned long long s = 0;
+  for(int i = 0; i < MAX_TEST_THREAD2;i++) {
+    m_thread_join(idx_p[i]);
+    m_thread_join(idx_c[i]);
+    s += sum[i];
+  }
+  assert (s == 999ULL * 1000ULL / 2ULL * MAX_TEST_THREAD2);
+  assert (buffer_ufx_empty_p(g_buff_fx));
+
+  // No wake up shall be lost when the consumers are already parked
+  sum[0] = sum[1] = 0;
+  m_thread_create (idx_c[0], conso_fx_slow, &sum[0]);
+  m_thread_create (idx_c[1], conso_fx_slow, &sum[1]);
+  m_thread_create (idx_p[0], prod_fx_slow, NULL);
+  m_thread_join(idx_p[0]);
+  m_thread_join(idx_c[0]);
+  m_thread_join(idx_c[1]);
+  assert (sum[0] + sum[1] == 99ULL * 100ULL / 2ULL);
+  assert (buffer_ufx_empty_p(g_buff_fx));
+
+  // The futex share the place of the condition variables
+  assert (sizeof (buffer_ufx_t) == sizeof (buffer_ucv_t));
+
+  // Not blocking calls shall not wait
+  unsigned int j;
+  assert (buffer_ufx_pop_blocking(&j, g_buff_fx, false) == false);
+  for(unsigned int i = 0; i < 4;i++)
+    buffer_ufx_push(g_buff_fx, i);
+  assert (buffer_ufx_full_p(g_buff_fx));
+  assert (buffer_ufx_push_blocking(g_buff_fx, 4, false) == false);
+  buffer_ufx_clean(g_buff_fx);
+  assert (buffer_ufx_empty_p(g_buff_fx));
+  buffer_ufx_clear(g_buff_fx);
+}
+
 static void test_stack(void)
 {
   buffer_floats_t buff;
@@ -407,6 +503,114 @@ static void test_queue(size_t n, int cpu_count, unsigned long long ref)
   queue_uint_clear(g_buff2);
 }
 
+#define BULK_SIZE 20
+
+static void conso2_bulk(void *arg)
+{
+  size_t *p_n = M_ASSIGN_CAST(size_t *, arg);
+  size_t n = *p_n;
+  unsigned long long s = 0;
+  unsigned tab[BULK_SIZE];
+  for(unsigned int i = 0; i < n;i += BULK_SIZE) {
+    unsigned k = 0;
+    while (k != BULK_SIZE) {
+      unsigned l = queue_uint_pop_bulk(BULK_SIZE-k, tab+k, g_buff2);
+      if (l == 0) m_thread_yield();
+      k += l;
+    }
+    for(k = 0; k < BULK_SIZE;k++)
+      s += tab[k];
+  }
+  while (!queue_ull_push(g_final2, s));
+}
+
+static void prod2_bulk(void *arg)
+{
+  size_t *p_n = M_ASSIGN_CAST(size_t *, arg);
+  size_t n = *p_n;
+  assert ((n % BULK_SIZE) == 0);
+  size_t r = n;
+  unsigned tab[BULK_SIZE];
+  for(unsigned int i = 0; i < n;i += BULK_SIZE) {
+    for(unsigned k = 0; k < BULK_SIZE; k++) {
+      tab[k] = r;
+      r = r * 31421U + 6927U;
+    }
+    unsigned k = 0;
+    while (k != BULK_SIZE) {
+      unsigned l = queue_uint_push_bulk(g_buff2, BULK_SIZE-k, tab+k);
+      if (l == 0) m_thread_yield();
+      k += l;
+    }
+  }
+}
+
+static void test_queue_bulk(size_t n, int cpu_count, unsigned long long ref)
+{
+  const int prod_count  = cpu_count / 2;
+  const int conso_count = cpu_count - prod_count;
+  assert (prod_count == conso_count && cpu_count <= 64);
+
+  // Single thread behavior
+  unsigned tab[16], j;
+  queue_uint_init(g_buff2, 64);
+  for(unsigned i = 0; i < 16; i++)
+    tab[i] = i * i;
+  for(unsigned i = 0; i < 3; i++) {
+    j = queue_uint_push_bulk(g_buff2, 16, tab);
+    assert(j == 16);
+  }
+  bool b = queue_uint_push(g_buff2, 1024);
+  assert(b);
+  j = queue_uint_push_bulk(g_buff2, 16, tab);
+  assert(j == 15);
+  assert(queue_uint_full_p(g_buff2));
+  assert(queue_uint_push_bulk(g_buff2, 16, tab) == 0);
+  for(unsigned k = 0; k < 3; k++) {
+    for(unsigned i = 0; i < 16; i++)
+      tab[i] = 0;
+    j = queue_uint_pop_bulk(16, tab, g_buff2);
+    assert(j == 16);
+    for(unsigned i = 0; i < 16; i++)
+      assert(tab[i] == i * i);
+  }
+  b = queue_uint_pop(&j, g_buff2);
+  assert(b && j == 1024);
+  j = queue_uint_pop_bulk(16, tab, g_buff2);
+  assert(j == 15);
+  assert(queue_uint_empty_p(g_buff2));
+  assert(queue_uint_pop_bulk(16, tab, g_buff2) == 0);
+  queue_uint_clear(g_buff2);
+
+  // Multiple producers / consumers
+  queue_uint_init(g_buff2, 64*2);
+  queue_ull_init (g_final2, 64*2);
+  m_thread_t idx_p[32];
+  m_thread_t idx_c[32];
+  m_thread_t idx_final;
+  for(int i = 0; i < prod_count; i++) {
+    m_thread_create (idx_p[i], prod2_bulk, &n);
+  }
+  for(int i = 0; i < conso_count; i++) {
+    m_thread_create (idx_c[i], conso2_bulk, &n);
+  }
+  size_t n2 = conso_count;
+  m_thread_create(idx_final, final2, &n2);
+  for(int i = 0; i < prod_count; i++) {
+    m_thread_join(idx_p[i]);
+  }
+  for(int i = 0; i < conso_count; i++) {
+    m_thread_join(idx_c[i]);
+  }
+  m_thread_join(idx_final);
+
+  // All the producers generate the same sequence
+  assert(g_result == ref * (unsigned) prod_count);
+
+  queue_ull_clear(g_final2);
+  queue_uint_clear(g_buff2);
+}
+
 /********************************************************************************************/
 
 static void test_spsc(void)
@@ -513,11 +717,13 @@ int main(void)
   buffer_uint_clear(v);
 
   test_global();
+  test_futex();
   test_stack();
   test_stack2();
   test_no_thread();
   test_global_ishared();
   test_queue(1000000, 2, 2148371710223136ULL);
+  test_queue_bulk(100000, 4, 214249840719440ULL);
   test_spsc();
   exit(0);
 }
@@ -0,0 +1,150 @@
+/*
+ * M*LIB - Test for Concurrent memory pool allocator
+ *
+ * Copyright (c) 2017-2019, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "m-c-dict.h"
+#include "m-mutex.h"
+
+C_DICT_DEF2(lf_dict, int, unsigned)
+
+m_gc_t gc;
+lf_dict_t g;
+
+#define MAX_THREAD 4
+#define MAX_KEY    1000
+
+static void test_basic(void)
+{
+  m_gc_init(gc, 2);
+  lf_dict_init(g, gc, 64);
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  m_gc_awake(gc, id);
+
+  assert (lf_dict_empty_p(g));
+  for(int i = 0; i < MAX_KEY; i++)
+    lf_dict_set_at(g, i, 3*i, id);
+  assert (lf_dict_size(g) == MAX_KEY);
+  for(int i = 0; i < MAX_KEY; i++) {
+    unsigned *p = lf_dict_get(g, i);
+    assert (p != NULL);
+    assert (*p == 3U*i);
+  }
+  assert (lf_dict_get(g, MAX_KEY) == NULL);
+
+  /* An updated value doesn't modify the previous node:
+     it remains readable until the thread goes to sleep */
+  unsigned *p = lf_dict_get(g, 17);
+  lf_dict_set_at(g, 17, 4, id);
+  assert (*p == 51);
+  assert (*lf_dict_get(g, 17) == 4);
+  assert (lf_dict_size(g) == MAX_KEY);
+
+  for(int i = 0; i < MAX_KEY; i += 2)
+    assert (lf_dict_erase(g, i, id));
+  assert (!lf_dict_erase(g, 0, id));
+  assert (lf_dict_size(g) == MAX_KEY/2);
+  unsigned v = 0;
+  for(int i = 0; i < MAX_KEY; i++) {
+    bool b = lf_dict_get_copy(&v, g, i);
+    assert (b == (i % 2 == 1));
+    assert (!b || v == (i == 17 ? 4U : 3U*i));
+  }
+
+  m_gc_sleep(gc, id);
+  m_gc_detach_thread(gc, id);
+  lf_dict_clear(g);
+  m_gc_clear(gc);
+}
+
+/* Each writer owns the keys congruent to its index */
+static void writer(void *arg)
+{
+  int w = *(int*)arg;
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  for(int n = 0; n < 99; n++) {
+    m_gc_awake(gc, id);
+    for(int i = w; i < MAX_KEY; i += 2) {
+      if (n % 4 == 3)
+        lf_dict_erase(g, i, id);
+      else
+        lf_dict_set_at(g, i, (unsigned)(i * 8 + n % 4), id);
+    }
+    m_gc_sleep(gc, id);
+  }
+  m_gc_detach_thread(gc, id);
+}
+
+static void reader(void *arg)
+{
+  (void) arg;
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  for(int n = 0; n < 100; n++) {
+    m_gc_awake(gc, id);
+    for(int i = 0; i < MAX_KEY; i++) {
+      unsigned *p = lf_dict_get(g, i);
+      /* A value is always consistent with its key */
+      assert (p == NULL || *p / 8 == (unsigned) i);
+    }
+    m_gc_sleep(gc, id);
+  }
+  m_gc_detach_thread(gc, id);
+}
+
+static void test_thread(void)
+{
+  m_gc_init(gc, MAX_THREAD);
+  /* Few buckets to get collisions between the writers */
+  lf_dict_init(g, gc, 16);
+  m_thread_t idx[MAX_THREAD];
+  int arg[2] = { 0, 1 };
+  m_thread_create(idx[0], writer, &arg[0]);
+  m_thread_create(idx[1], writer, &arg[1]);
+  m_thread_create(idx[2], reader, NULL);
+  m_thread_create(idx[3], reader, NULL);
+  for(int i = 0; i < MAX_THREAD; i++) {
+    m_thread_join(idx[i]);
+  }
+  /* Last operation of each writer is a set */
+  assert (lf_dict_size(g) == MAX_KEY);
+  for(int i = 0; i < MAX_KEY; i++) {
+    unsigned v;
+    bool b = lf_dict_get_copy(&v, g, i);
+    assert (b);
+    assert (v == (unsigned) (i * 8 + 2));
+  }
+  /* Let the GC reclaim all the retired nodes */
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  m_gc_awake(gc, id);
+  m_gc_sleep(gc, id);
+  m_gc_detach_thread(gc, id);
+  lf_dict_clear(g);
+  m_gc_clear(gc);
+}
+
+int main(void)
+{
+  test_basic();
+  test_thread();
+  exit(0);
+}
@@ -109,6 +109,10 @@ static inline void int_oor_set(int *s, unsigned char n)
 DICT_OA_DEF2(dict3, int, INT_OA_OPLIST, int, M_DEFAULT_OPLIST)
 CONCURRENT_DEF(pdict3, dict3_t, DICT_OPLIST(dict3))
 
+CONCURRENT_DICT_SHARDED_DEF(sdict1, dict1_t, 7, DICT_OPLIST(dict1))
+CONCURRENT_DICT_SHARDED_DEF(sdict3, dict3_t, 16, DICT_OPLIST(dict3))
+CONCURRENT_DICT_SHARDED_DEF(string_pool_sh, string_pool_t, 4)
+
 /********************************/
 parray1_t arr;
 
@@ -208,11 +212,98 @@ static void test_rp_basic(void)
   rpdict1_clear(dict);
 }
 
+static void test_sharded_basic(void)
+{
+  sdict1_t dict;
+  sdict1_init(dict);
+  assert (sdict1_empty_p(dict));
+  for(int i = 0; i < 1000; i++)
+    sdict1_set_at(dict, i, 2*i);
+  assert (sdict1_size(dict) == 1000);
+  for(int i = 0; i < 1000; i++) {
+    int z = -1;
+    bool b = sdict1_get_copy(&z, dict, i);
+    assert (b);
+    assert (z == 2*i);
+  }
+  int z = 0;
+  assert (!sdict1_get_copy(&z, dict, 1000));
+  assert (!sdict1_get_blocking(&z, dict, 1000, false));
+  sdict1_get_at_copy(&z, dict, 1000);
+  assert (z == 0);
+  assert (sdict1_size(dict) == 1001);
+  for(int i = 0; i < 1000; i += 2)
+    assert (sdict1_erase(dict, i));
+  assert (!sdict1_erase(dict, 0));
+  assert (sdict1_size(dict) == 501);
+  assert (sdict1_get_blocking(&z, dict, 1, false));
+  assert (z == 2);
+  sdict1_clean(dict);
+  assert (sdict1_empty_p(dict));
+  sdict1_clear(dict);
+
+  sdict3_t dict3;
+  sdict3_init(dict3);
+  /* 0 & -1 are reserved keys of dict3 */
+  for(int i = 1; i <= 1000; i++)
+    sdict3_set_at(dict3, i, i+1);
+  for(int i = 1; i <= 1000; i++) {
+    bool b = sdict3_get_copy(&z, dict3, i);
+    assert (b);
+    assert (z == i+1);
+  }
+  assert (sdict3_erase(dict3, 17));
+  assert (!sdict3_get_copy(&z, dict3, 17));
+  assert (sdict3_size(dict3) == 999);
+  assert (!sdict3_empty_p(dict3));
+  sdict3_clear(dict3);
+
+  M_LET(str, string_t) {
+    string_pool_sh_t pool;
+    string_pool_sh_init(pool);
+    string_pool_sh_set_at (pool, STRING_CTE("A"), STRING_CTE("B"));
+    bool b = string_pool_sh_get_copy (&str, pool, STRING_CTE("A"));
+    assert (b);
+    assert (string_equal_str_p (str, "B"));
+    string_pool_sh_clear(pool);
+  }
+}
+
+sdict1_t sdict;
+
+static void conso_sharded(void *p)
+{
+  assert (p == NULL);
+  for(int i = 0; i < 1000; i++) {
+    int j;
+    bool b = sdict1_get_blocking(&j, sdict, i, true);
+    assert (b);
+    assert (j == -i);
+  }
+}
+
+static void test_sharded_thread(void)
+{
+  m_thread_t idx[2];
+  sdict1_init(sdict);
+  m_thread_create (idx[0], conso_sharded, NULL);
+  m_thread_create (idx[1], conso_sharded, NULL);
+  for(int i = 0; i < 1000; i++) {
+    sdict1_set_at (sdict, i, -i);
+  }
+  m_thread_join(idx[0]);
+  m_thread_join(idx[1]);
+  assert (sdict1_size(sdict) == 1000);
+  sdict1_clear(sdict);
+}
+
 int main(void)
 {
   test_basic();
   test_rp_basic();
+  test_sharded_basic();
   test_thread();
   test_rp_thread();
+  test_sharded_thread();
   exit(0);
 }
@@ -0,0 +1,169 @@
+/*
+ * M*LIB - Test for Concurrent memory pool allocator
+ *
+ * Copyright (c) 2017-2019, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "m-c-queue.h"
+#include "m-string.h"
+#include "m-mutex.h"
+
+C_QUEUE_DEF(lf_queue, unsigned, 16)
+C_QUEUE_DEF(lf_squeue, string_t, 4, STRING_OPLIST)
+
+m_gc_t gc;
+lf_queue_t g;
+
+#define MAX_THREAD 4
+#define MAX_VALUE  100000
+
+static void test_basic(void)
+{
+  m_gc_init(gc, 2);
+  lf_queue_init(g, gc);
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  m_gc_awake(gc, id);
+
+  unsigned j;
+  assert (lf_queue_empty_p(g));
+  assert (!lf_queue_pop(&j, g, id));
+  assert (lf_queue_segment_count(g) == 1);
+  for(unsigned i = 0; i < 100; i++)
+    lf_queue_push(g, i, id);
+  assert (!lf_queue_empty_p(g));
+  /* 100 elements need 7 segments of 16 elements */
+  assert (lf_queue_segment_count(g) == 7);
+  assert (lf_queue_segment_max(g) == 7);
+  for(unsigned i = 0; i < 100; i++) {
+    bool b = lf_queue_pop(&j, g, id);
+    assert (b);
+    assert (j == i);
+  }
+  assert (!lf_queue_pop(&j, g, id));
+  assert (lf_queue_empty_p(g));
+  assert (lf_queue_segment_count(g) == 1);
+  assert (lf_queue_segment_max(g) == 7);
+  /* Leave some elements in the queue */
+  for(unsigned i = 0; i < 20; i++)
+    lf_queue_push(g, i, id);
+
+  m_gc_sleep(gc, id);
+  m_gc_detach_thread(gc, id);
+  lf_queue_clear(g);
+  m_gc_clear(gc);
+}
+
+static void test_string(void)
+{
+  lf_squeue_t q;
+  m_gc_init(gc, 1);
+  lf_squeue_init(q, gc);
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  m_gc_awake(gc, id);
+  M_LET(s, string_t) {
+    for(int i = 0; i < 10; i++) {
+      string_printf(s, "%d", i);
+      lf_squeue_push(q, s, id);
+    }
+    for(int i = 0; i < 5; i++) {
+      bool b = lf_squeue_pop(&s, q, id);
+      assert (b);
+      assert (atoi(string_get_cstr(s)) == i);
+    }
+  }
+  m_gc_sleep(gc, id);
+  m_gc_detach_thread(gc, id);
+  /* The remaining strings are cleared too */
+  lf_squeue_clear(q);
+  m_gc_clear(gc);
+}
+
+unsigned long long g_sum[MAX_THREAD];
+
+static void prod(void *arg)
+{
+  (void) arg;
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  for(unsigned i = 0; i < MAX_VALUE; i += 100) {
+    m_gc_awake(gc, id);
+    for(unsigned k = i; k < i + 100; k++)
+      lf_queue_push(g, k, id);
+    m_gc_sleep(gc, id);
+  }
+  m_gc_detach_thread(gc, id);
+}
+
+static void conso(void *arg)
+{
+  unsigned long long *s = (unsigned long long *) arg;
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  unsigned j, n = 0;
+  while (n < MAX_VALUE) {
+    m_gc_awake(gc, id);
+    for(unsigned k = 0; k < 100 && n < MAX_VALUE; k++) {
+      if (lf_queue_pop(&j, g, id)) {
+        *s += j;
+        n++;
+      }
+    }
+    m_gc_sleep(gc, id);
+    if (n < MAX_VALUE)
+      m_thread_yield();
+  }
+  m_gc_detach_thread(gc, id);
+}
+
+static void test_thread(void)
+{
+  m_gc_init(gc, MAX_THREAD);
+  lf_queue_init(g, gc);
+  m_thread_t idx[MAX_THREAD];
+  for(int i = 0; i < MAX_THREAD; i += 2) {
+    g_sum[i/2] = 0;
+    m_thread_create(idx[i], prod, NULL);
+    m_thread_create(idx[i+1], conso, &g_sum[i/2]);
+  }
+  for(int i = 0; i < MAX_THREAD; i++) {
+    m_thread_join(idx[i]);
+  }
+  unsigned long long s = 0;
+  for(int i = 0; i < MAX_THREAD/2; i++)
+    s += g_sum[i];
+  assert (s == (unsigned long long) MAX_VALUE * (MAX_VALUE-1) / 2 * (MAX_THREAD/2));
+  assert (lf_queue_empty_p(g));
+  assert (lf_queue_segment_max(g) >= lf_queue_segment_count(g));
+  /* Let the GC reclaim all the retired segments */
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  m_gc_awake(gc, id);
+  m_gc_sleep(gc, id);
+  m_gc_detach_thread(gc, id);
+  lf_queue_clear(g);
+  m_gc_clear(gc);
+}
+
+int main(void)
+{
+  test_basic();
+  test_string();
+  test_thread();
+  exit(0);
+}
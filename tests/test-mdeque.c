@@ -154,10 +154,13 @@ static void test_it(void)
     assert (deque_last_p(it));
     assert (deque_end_p(it));
     deque_it_last(it, d);
+    s = 1997+1996;
     while (!deque_end_p(it)) {
+      assert (*deque_cref(it) == s--);
       deque_previous(it);
       assert (deque_end_p(it) || !deque_last_p(it));
     }
+    assert (s == -1);
     deque_previous(it);
     assert (deque_end_p(it));
     deque_it_end(it, d);
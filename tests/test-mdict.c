@@ -46,6 +46,9 @@ DICT_OA_DEF2(dict_oa_str, symbol_t, BOUNDED_STRING_OPLIST(symbol), int, M_DEFAUL
 
 DICT_OA_DEF2(dict_oa_bstr, string_t, STRING_OPLIST, int, M_DEFAULT_OPLIST)
 
+DICT_SWISS_DEF2(dict_sw_int, int, M_DEFAULT_OPLIST, int, M_DEFAULT_OPLIST)
+DICT_SWISS_DEF2(dict_sw_str, string_t, STRING_OPLIST, string_t, STRING_OPLIST)
+
 /* Helper structure */
 ARRAY_DEF(array_string, string_t, STRING_OPLIST)
 array_string_t v_str;
@@ -326,6 +329,56 @@ static void test1(void)
   clear_data();
 }
 
+static void test_incremental(void)
+{
+  M_LET(str1, str2, string_t)
+  M_LET(d, DICT_OPLIST(dict_str, STRING_OPLIST, STRING_OPLIST)) {
+    dict_str_incremental_rehash(d, 1);
+    for(size_t i = 0; i < 10000; i++) {
+      string_printf(str1, "%zu", i);
+      string_printf(str2, "%zu", 2*i);
+      dict_str_set_at(d, str1, str2);
+      // All the items shall be reachable during the rehash
+      string_printf(str1, "%zu", i/2);
+      string_printf(str2, "%zu", 2*(i/2));
+      assert (string_equal_p(*dict_str_get(d, str1), str2));
+    }
+    assert (dict_str_size(d) == 10000);
+    size_t s = 0;
+    for M_EACH(item, d, DICT_OPLIST(dict_str)) {
+      assert (!string_empty_p(item->key));
+      s++;
+    }
+    assert (s == 10000);
+    for(size_t i = 0; i < 10000; i += 2) {
+      string_printf(str1, "%zu", i);
+      assert (dict_str_erase(d, str1));
+      string_printf(str1, "%zu", i+1);
+      string_printf(str2, "%zu", 2*i+2);
+      assert (string_equal_p(*dict_str_get_at(d, str1), str2));
+    }
+    assert (dict_str_size(d) == 5000);
+    while (!dict_str_rehash_step(d, 10));
+    assert (dict_str_rehash_step(d, 1));
+    dict_str_t d2;
+    dict_str_init_set(d2, d);
+    assert (dict_str_equal_p(d, d2));
+    dict_str_clear(d2);
+    // Back to the default mode during a rehash
+    for(size_t i = 10000; i < 20000; i++) {
+      string_printf(str1, "%zu", i);
+      dict_str_set_at(d, str1, str1);
+    }
+    dict_str_incremental_rehash(d, 0);
+    assert (dict_str_rehash_step(d, 0));
+    assert (dict_str_size(d) == 15000);
+    for(size_t i = 10000; i < 20000; i++) {
+      string_printf(str1, "%zu", i);
+      assert (string_equal_p(*dict_str_get(d, str1), str1));
+    }
+  }
+}
+
 static void test_oa(void)
 {
   dict_oa_int_t d;
@@ -468,6 +521,79 @@ static void test_it_oa(void)
   }
 }
 
+/* Random insertion / deletion in 'd' compared with a reference dictionary */
+#define TEST_CHURN(name, d, ref, seed, range) do {                      \
+    uint32_t x = (seed);                                                \
+    for(int i = 0; i < 200000; i++) {                                   \
+      x = 1664525L * x + 1013904223L;                                   \
+      int k = (int) ((x >> 8) % (range));                               \
+      if ((x >> 4) & 1) {                                               \
+        M_C(name, _set_at)(d, k, i);                                    \
+        dict_int_set_at(ref, k, i);                                     \
+      } else {                                                          \
+        bool b1 = M_C(name, _erase)(d, k);                              \
+        bool b2 = dict_int_erase(ref, k);                               \
+        assert (b1 == b2);                                              \
+      }                                                                 \
+      assert (M_C(name, _size)(d) == dict_int_size(ref));               \
+    }                                                                   \
+    for M_EACH(item, ref, DICT_OPLIST(dict_int)) {                      \
+      int *p = M_C(name, _get)(d, item->key);                           \
+      assert (p != NULL && *p == item->value);                          \
+    }                                                                   \
+  } while (0)
+
+/* Check that there is no hole between the home slot of an item
+   and its slot, and return the sum of the probe lengths */
+static size_t oa_probe_total(const dict_oa_int_t d)
+{
+  size_t histo[64];
+  size_t max = dict_oa_int_probe_histogram(d, 64, histo);
+  assert (max < 63);
+  size_t total = 0, count = 0;
+  for(size_t i = 0; i < 64; i++) {
+    total += i * histo[i];
+    count += histo[i];
+  }
+  assert (count == dict_oa_int_size(d));
+  for(size_t i = 0; i <= d->mask; i++) {
+    if (oor_equal_p(d->data[i].key, DICTI_OA_EMPTY))
+      continue;
+    for(size_t j = M_HASH_DEFAULT(d->data[i].key) & d->mask; j != i; j = (j + 1) & d->mask)
+      assert (!oor_equal_p(d->data[j].key, DICTI_OA_EMPTY));
+  }
+  return total;
+}
+
+static void test_oa_churn(void)
+{
+  M_LET(d, fresh, DICT_OPLIST(dict_oa_int, M_DEFAULT_OPLIST, M_DEFAULT_OPLIST))
+    M_LET(ref, DICT_OPLIST(dict_int, M_DEFAULT_OPLIST, M_DEFAULT_OPLIST)) {
+    TEST_CHURN(dict_oa_int, d, ref, 42, 3000);
+
+    /* Rebuild a table of the same size from the remaining keys.
+       With linear probing, the sum of the probe lengths doesn't depend
+       on the insertion order: the deletions shall leave the table
+       as good as a freshly built one (no tombstone, no extra length). */
+    for(size_t c = 1; fresh->mask < d->mask; c *= 2)
+      dict_oa_int_reserve(fresh, c);
+    assert (fresh->mask == d->mask);
+    for M_EACH(item, ref, DICT_OPLIST(dict_int)) {
+      dict_oa_int_set_at(fresh, item->key, item->value);
+    }
+    assert (fresh->mask == d->mask);
+    assert (oa_probe_total(d) == oa_probe_total(fresh));
+
+    /* Erase everything: the table is empty again */
+    for M_EACH(item, ref, DICT_OPLIST(dict_int)) {
+      bool b = dict_oa_int_erase(d, item->key);
+      assert (b);
+    }
+    assert (dict_oa_int_size(d) == 0);
+    assert (oa_probe_total(d) == 0);
+  }
+}
+
 static void
 test_oa_str1(void)
 {
@@ -509,16 +635,117 @@ test_oa_str2(void)
   dict_oa_bstr_clear(dict);
 }
 
+static void test_swiss(void)
+{
+  M_LET(d1, d2, DICT_OPLIST(dict_sw_int, M_DEFAULT_OPLIST, M_DEFAULT_OPLIST)){
+    for(size_t i = 0; i < 100; i++) {
+      dict_sw_int_set_at (d1, 2*i, 2*i+1);
+    }
+    assert (dict_sw_int_size (d1) == 100);
+    dict_sw_int_set_at (d1, 17, 42);
+    dict_sw_int_erase (d1, 17);
+    dict_sw_int_t d3;
+    dict_sw_int_init_set (d3, d1);
+    assert (dict_sw_int_equal_p (d3, d1));
+    dict_sw_int_set (d2, d1);
+
+    assert (dict_sw_int_get (d2, -10) == NULL);
+    assert (*dict_sw_int_get (d2, 10) == 11);
+    assert (dict_sw_int_equal_p (d2, d3));
+    dict_sw_int_clear (d3);
+
+    dict_sw_int_set_at (d1, -10, -20);
+    assert (dict_sw_int_size (d1) == 101);
+    dict_sw_int_set_at (d1, -10, -22);
+    assert (dict_sw_int_size (d1) == 101);
+    assert (*dict_sw_int_get (d1, -10) == -22);
+    assert (!dict_sw_int_equal_p (d2, d1));
+
+    for(size_t i = 0; i < 100; i++) {
+      bool b = dict_sw_int_erase (d1, 2*i);
+      assert (b);
+    }
+    assert (!dict_sw_int_erase (d1, 0));
+    assert (dict_sw_int_size (d1) == 1);
+    dict_sw_int_swap (d1, d2);
+    assert (dict_sw_int_size (d1) == 100);
+    assert (dict_sw_int_size (d2) == 1);
+
+    dict_sw_int_init_move (d3, d1);
+    dict_sw_int_init (d1);
+    size_t s = 0;
+    for M_EACH(item, d3, DICT_OPLIST(dict_sw_int)) {
+      assert (item->value == item->key + 1);
+      s++;
+    }
+    assert (s == 100);
+    dict_sw_int_it_t it;
+    s = 0;
+    for(dict_sw_int_it_last(it, d3); !dict_sw_int_end_p(it); dict_sw_int_previous(it)) {
+      s++;
+    }
+    assert (s == 100);
+    dict_sw_int_move (d2, d3);
+    assert (dict_sw_int_size (d2) == 100);
+    dict_sw_int_clean (d2);
+    assert (dict_sw_int_size (d2) == 0);
+    dict_sw_int_reserve (d2, 1000);
+    assert (d2->mask + 1 >= 1024);
+  }
+
+  // Random insertion / deletion compared with a reference dictionary
+  M_LET(d, DICT_OPLIST(dict_sw_int, M_DEFAULT_OPLIST, M_DEFAULT_OPLIST))
+    M_LET(ref, DICT_OPLIST(dict_int, M_DEFAULT_OPLIST, M_DEFAULT_OPLIST)) {
+    TEST_CHURN(dict_sw_int, d, ref, 17, 5000);
+  }
+}
+
+static void test_swiss_str(void)
+{
+  M_LET(str1, str2, string_t)
+  M_LET(d1, d2, DICT_OPLIST(dict_sw_str, STRING_OPLIST, STRING_OPLIST)) {
+    for(size_t i = 0; i < 1000; i++) {
+      string_printf(str1, "%zu", i);
+      string_printf(str2, "%zu", 3*i);
+      dict_sw_str_set_at(d1, str1, str2);
+    }
+    assert (dict_sw_str_size(d1) == 1000);
+    for(size_t i = 0; i < 1000; i+=2) {
+      string_printf(str1, "%zu", i);
+      assert (dict_sw_str_erase(d1, str1));
+    }
+    assert (dict_sw_str_size(d1) == 500);
+    for(size_t i = 0; i < 1000; i++) {
+      string_printf(str1, "%zu", i);
+      string_printf(str2, "%zu", 3*i);
+      const string_t *p = dict_sw_str_cget(d1, str1);
+      if (i % 2 == 0) {
+        assert (p == NULL);
+      } else {
+        assert (p != NULL && string_equal_p(*p, str2));
+      }
+    }
+    dict_sw_str_set(d2, d1);
+    assert (dict_sw_str_equal_p(d1, d2));
+    string_set_str(*dict_sw_str_get_at(d2, STRING_CTE("x")), "y");
+    assert (!dict_sw_str_equal_p(d1, d2));
+  }
+}
+
 int main(void)
 {
   test1();
   test_set();
   test_init();
   test_equal();
+  test_incremental();
   test_oa();
   test_init_oa();
   test_it_oa();
+  test_oa_churn();
   test_oa_str1();
   test_oa_str2();
+  test_swiss();
+  test_swiss_str();
   exit(0);
 }
@@ -25,12 +25,22 @@
 #include <stdlib.h>
 
 #include "m-mempool.h"
+#include "m-list.h"
+#include "m-rbtree.h"
+#include "m-bptree.h"
+#include "m-mutex.h"
 
 #include "coverage.h"
 START_COVERAGE
 MEMPOOL_DEF(mempool_uint, unsigned int)
+MEMPOOL_TCACHE_DEF(tcache_uint, unsigned int)
+MEMPOOL_DEF(mempool_small, unsigned int, 100)
 END_COVERAGE
 
+LIST_DEF(list_uint, unsigned int, M_OPEXTEND(M_DEFAULT_OPLIST, MEMPOOL(list_mpool), MEMPOOL_LINKAGE(static), MEMPOOL_TCACHE(1)))
+RBTREE_DEF(rbtree_uint, unsigned int, M_OPEXTEND(M_DEFAULT_OPLIST, MEMPOOL(rbtree_mpool), MEMPOOL_LINKAGE(static)))
+BPTREE_DEF(bptree_uint, 5, unsigned int, M_OPEXTEND(M_DEFAULT_OPLIST, MEMPOOL(bptree_mpool), MEMPOOL_LINKAGE(static), MEMPOOL_TCACHE(1)))
+
 static void test(void)
 {
   mempool_uint_t m;
@@ -65,8 +75,239 @@ static void test(void)
   mempool_uint_clear(m);
 }
 
+static void test_trim(void)
+{
+  mempool_small_t m;
+  mempool_stats_t st;
+  mempool_small_init(m);
+  mempool_small_stats(&st, m);
+  assert (st.segments == 1);
+  assert (st.live == 0);
+  assert (st.free == 0);
+  assert (st.reserved == sizeof (mempool_small_segment_t));
+  assert (mempool_small_trim(m) == 0);
+
+  static unsigned int *tab[10000];
+  for(unsigned int i = 0; i < 10000; i++) {
+    tab[i] = mempool_small_alloc(m);
+    *tab[i] = i;
+  }
+  mempool_small_stats(&st, m);
+  assert (st.segments == 100);
+  assert (st.live == 10000);
+  assert (st.free == 0);
+  assert (st.reserved == 100 * sizeof (mempool_small_segment_t));
+  assert (mempool_small_trim(m) == 0);
+
+  /* Free one object over 2: no segment is empty */
+  for(unsigned int i = 0; i < 10000; i+=2) {
+    mempool_small_free(m, tab[i]);
+    tab[i] = NULL;
+  }
+  mempool_small_stats(&st, m);
+  assert (st.live == 5000);
+  assert (st.free == 5000);
+  assert (mempool_small_trim(m) == 0);
+  assert (st.segments == 100);
+
+  /* Free all the objects of the first half: 50 segments are empty */
+  for(unsigned int i = 1; i < 5000; i+=2) {
+    mempool_small_free(m, tab[i]);
+    tab[i] = NULL;
+  }
+  assert (mempool_small_trim(m) == 50);
+  mempool_small_stats(&st, m);
+  assert (st.segments == 50);
+  assert (st.live == 2500);
+  assert (st.free == 2500);
+  for(unsigned int i = 5001; i < 10000; i+=2) {
+    assert (*tab[i] == i);
+  }
+  /* The free objects are still usable */
+  for(unsigned int i = 0; i < 5000; i++) {
+    tab[i] = mempool_small_alloc(m);
+    *tab[i] = i;
+  }
+  mempool_small_stats(&st, m);
+  assert (st.live == 7500);
+  assert (st.free == 0);
+  assert (st.segments == 75);
+  for(unsigned int i = 0; i < 10000; i++) {
+    assert (tab[i] == NULL || *tab[i] == i);
+    if (tab[i] != NULL)
+      mempool_small_free(m, tab[i]);
+  }
+  /* Everything is free: only the current segment remains */
+  assert (mempool_small_trim(m) == 74);
+  mempool_small_stats(&st, m);
+  assert (st.segments == 1);
+  assert (st.live == 0);
+  assert (st.free == 0);
+  unsigned int *p = mempool_small_alloc(m);
+  *p = 1;
+  mempool_small_clear(m);
+}
+
+static void test_tcache(void)
+{
+  tcache_uint_t m;
+  tcache_uint_init(m);
+
+  static unsigned int *tab[100000];
+  for(unsigned int i = 0; i < 100000; i++) {
+    tab[i] = tcache_uint_alloc(m);
+    *tab[i] = i;
+  }
+  for(unsigned int i = 0; i < 100000; i+=2) {
+    tcache_uint_free(m, tab[i]);
+    tab[i] =  NULL;
+  }
+  for(unsigned int i = 1; i < 100000; i+=2) {
+    assert (*tab[i] == i);
+  }
+  for(unsigned int i = 0; i < 100000; i+=2) {
+    tab[i] = tcache_uint_alloc(m);
+    *tab[i] = i;
+  }
+  for(unsigned int i = 0; i < 100000; i++) {
+    assert (*tab[i] == i);
+    for(unsigned int j = 1; j < 4 && i+j < 100000; j++)
+      assert (tab[i] != tab[i+j]);
+  }
+  for(unsigned int i = 0; i < 100000; i++) {
+    tcache_uint_free(m, tab[i]);
+  }
+  tcache_uint_thread_flush(m);
+  tcache_uint_clear(m);
+
+  /* A new instance shall not reuse the cache of the previous one */
+  tcache_uint_init(m);
+  unsigned int *p = tcache_uint_alloc(m);
+  *p = 1;
+  tcache_uint_free(m, p);
+  tcache_uint_clear(m);
+
+  /* More mempools than slots: the caches of the mempools sharing
+     a slot shall be given back, not forgotten */
+  tcache_uint_t tm[2*MEMPOOL_TCACHE_SLOTS+1];
+  for(unsigned int j = 0; j < 2*MEMPOOL_TCACHE_SLOTS+1; j++)
+    tcache_uint_init(tm[j]);
+  for(unsigned int i = 0; i < 1000; i++) {
+    for(unsigned int j = 0; j < 2*MEMPOOL_TCACHE_SLOTS+1; j++) {
+      p = tcache_uint_alloc(tm[j]);
+      *p = i;
+      tcache_uint_free(tm[j], p);
+    }
+  }
+  for(unsigned int j = 0; j < 2*MEMPOOL_TCACHE_SLOTS+1; j++) {
+    unsigned int n = 0;
+    for(tcache_uint_segment_t *s = atomic_load(&tm[j]->segments); s != NULL; s = s->next)
+      n++;
+    assert (n == 1);
+    tcache_uint_thread_flush(tm[j]);
+    tcache_uint_clear(tm[j]);
+  }
+}
+
+#define NUM_THREAD 4
+#define NUM_OBJ    20000
+
+static tcache_uint_t g_tcache;
+static unsigned int *g_exchange[NUM_THREAD][NUM_OBJ];
+
+/* Each thread allocates objects, then frees the ones allocated
+   by the next thread */
+static void thread_alloc(void *arg)
+{
+  unsigned int *id = (unsigned int *) arg;
+  for(unsigned int i = 0; i < NUM_OBJ; i++) {
+    g_exchange[*id][i] = tcache_uint_alloc(g_tcache);
+    *g_exchange[*id][i] = *id * NUM_OBJ + i;
+  }
+}
+
+static void thread_free(void *arg)
+{
+  unsigned int *id = (unsigned int *) arg;
+  unsigned int other = (*id + 1) % NUM_THREAD;
+  for(unsigned int i = 0; i < NUM_OBJ; i++) {
+    assert (*g_exchange[other][i] == other * NUM_OBJ + i);
+    tcache_uint_free(g_tcache, g_exchange[other][i]);
+  }
+  /* Reuse the objects given back by the other threads */
+  for(unsigned int i = 0; i < NUM_OBJ; i++) {
+    g_exchange[other][i] = tcache_uint_alloc(g_tcache);
+    *g_exchange[other][i] = i;
+  }
+  for(unsigned int i = 0; i < NUM_OBJ; i++) {
+    assert (*g_exchange[other][i] == i);
+    tcache_uint_free(g_tcache, g_exchange[other][i]);
+  }
+  tcache_uint_thread_flush(g_tcache);
+}
+
+static void test_tcache_thread(void)
+{
+  m_thread_t idx[NUM_THREAD];
+  unsigned int num[NUM_THREAD];
+  tcache_uint_init(g_tcache);
+  for(unsigned int i = 0; i < NUM_THREAD; i++) {
+    num[i] = i;
+    m_thread_create(idx[i], thread_alloc, &num[i]);
+  }
+  for(unsigned int i = 0; i < NUM_THREAD; i++) {
+    m_thread_join(idx[i]);
+  }
+  for(unsigned int i = 0; i < NUM_THREAD; i++) {
+    m_thread_create(idx[i], thread_free, &num[i]);
+  }
+  for(unsigned int i = 0; i < NUM_THREAD; i++) {
+    m_thread_join(idx[i]);
+  }
+  tcache_uint_clear(g_tcache);
+}
+
+static void test_containers(void)
+{
+  list_uint_mempool_init(list_mpool);
+  rbtree_uint_mempool_init(rbtree_mpool);
+  bptree_uint_mempool_init(bptree_mpool);
+  list_uint_t l;
+  rbtree_uint_t r;
+  bptree_uint_t b;
+  list_uint_init(l);
+  rbtree_uint_init(r);
+  bptree_uint_init(b);
+  for(unsigned int i = 0; i < 10000; i++) {
+    list_uint_push_back(l, i);
+    rbtree_uint_push(r, i);
+    bptree_uint_push(b, i);
+  }
+  assert (list_uint_size(l) == 10000);
+  assert (rbtree_uint_size(r) == 10000);
+  assert (bptree_uint_size(b) == 10000);
+  for(unsigned int i = 0; i < 10000; i+=2) {
+    assert (rbtree_uint_pop_at(NULL, r, i));
+    assert (bptree_uint_erase(b, i));
+  }
+  for(unsigned int i = 0; i < 10000; i++) {
+    assert ((rbtree_uint_get(r, i) != NULL) == (i % 2 == 1));
+    assert ((bptree_uint_get(b, i) != NULL) == (i % 2 == 1));
+  }
+  list_uint_clear(l);
+  rbtree_uint_clear(r);
+  bptree_uint_clear(b);
+  list_uint_mempool_clear(list_mpool);
+  rbtree_uint_mempool_clear(rbtree_mpool);
+  bptree_uint_mempool_clear(bptree_mpool);
+}
+
 int main(void)
 {
   test();
+  test_trim();
+  test_tcache();
+  test_tcache_thread();
+  test_containers();
   exit(0);
 }
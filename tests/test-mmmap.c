@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2017-2019, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Make the mmap interface visible in strict ISO C mode */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "m-mmap.h"
+#include "m-array.h"
+#include "m-dict.h"
+
+#include "coverage.h"
+START_COVERAGE
+ARRAY_DEF(array_uint, unsigned int, MMAP_OPLIST(M_DEFAULT_OPLIST))
+END_COVERAGE
+
+static inline bool oor_equal_p(unsigned long k, unsigned char n)
+{
+  return k == (unsigned long)n;
+}
+static inline void oor_set(unsigned long *k, unsigned char n)
+{
+  *k = (unsigned long)n;
+}
+DICT_OA_DEF2(dict_ulong,
+	     unsigned long, MMAP_INTERLEAVE_OPLIST(M_OPEXTEND(M_DEFAULT_OPLIST, OOR_EQUAL(oor_equal_p), OOR_SET(oor_set M_IPTR))),
+	     unsigned long, M_DEFAULT_OPLIST)
+
+static void test_realloc(unsigned flags)
+{
+  unsigned int *p = (unsigned int *) m_mmap_realloc(NULL, 100 * sizeof (unsigned int), flags);
+  assert (p != NULL);
+  assert (((uintptr_t) p) % sizeof (long long) == 0);
+  assert (!m_mmap_mapped_p(p));
+  for(unsigned int i = 0; i < 100; i++)
+    p[i] = i;
+
+  /* Cross the threshold: the block is mapped */
+  size_t n = 2 * MMAP_THRESHOLD / sizeof (unsigned int);
+  p = (unsigned int *) m_mmap_realloc(p, n * sizeof (unsigned int), flags);
+  assert (p != NULL);
+#if M_MMAPI_USE_MMAP
+  assert (m_mmap_mapped_p(p));
+#endif
+  for(unsigned int i = 0; i < 100; i++)
+    assert (p[i] == i);
+  for(size_t i = 100; i < n; i++)
+    p[i] = (unsigned int) i;
+
+  /* Grow the mapping */
+  p = (unsigned int *) m_mmap_realloc(p, 8 * n * sizeof (unsigned int), flags);
+  assert (p != NULL);
+  for(size_t i = 0; i < n; i++)
+    assert (p[i] == i);
+  for(size_t i = n; i < 8 * n; i++)
+    p[i] = (unsigned int) i;
+
+  /* Shrink it: it stays mapped */
+  p = (unsigned int *) m_mmap_realloc(p, 10 * sizeof (unsigned int), flags);
+  assert (p != NULL);
+#if M_MMAPI_USE_MMAP
+  assert (m_mmap_mapped_p(p));
+#endif
+  for(unsigned int i = 0; i < 10; i++)
+    assert (p[i] == i);
+  m_mmap_free(p);
+
+  m_mmap_free(NULL);
+  assert (m_mmap_realloc(NULL, SIZE_MAX, flags) == NULL);
+}
+
+static void test_oplist(void)
+{
+  M_LET(a, ARRAY_OPLIST(array_uint)) {
+    for(unsigned int i = 0; i < 2000000; i++)
+      array_uint_push_back(a, i);
+    for(unsigned int i = 0; i < 2000000; i++)
+      assert (*array_uint_cget(a, i) == i);
+    array_uint_clean(a);
+    array_uint_push_back(a, 17);
+    array_uint_reserve(a, 0);
+    assert (array_uint_size(a) == 1);
+    assert (*array_uint_back(a) == 17);
+  }
+
+  M_LET(d, DICT_OPLIST(dict_ulong)) {
+    for(unsigned long i = 0; i < 500000; i++)
+      dict_ulong_set_at(d, i * 7 + 1000, i);
+    assert (dict_ulong_size(d) == 500000);
+    for(unsigned long i = 0; i < 500000; i++) {
+      unsigned long *p = dict_ulong_get(d, i * 7 + 1000);
+      assert (p != NULL && *p == i);
+    }
+    for(unsigned long i = 0; i < 500000; i += 2)
+      dict_ulong_erase(d, i * 7 + 1000);
+    assert (dict_ulong_size(d) == 250000);
+    assert (dict_ulong_get(d, 1000) == NULL);
+  }
+}
+
+static void test_image(void)
+{
+  M_LET(a, ARRAY_OPLIST(array_uint))
+    M_LET(d, DICT_OPLIST(dict_ulong)) {
+    for(unsigned int i = 0; i < 10000; i++)
+      array_uint_push_back(a, i * i);
+    for(unsigned long i = 0; i < 10000; i++)
+      dict_ulong_set_at(d, i * 3 + 17, i);
+    FILE *f = fopen("a-mmmap-array.dat", "wb");
+    assert (f != NULL);
+    assert (array_uint_out_mmap(f, a));
+    fclose(f);
+    f = fopen("a-mmmap-dict.dat", "wb");
+    assert (f != NULL);
+    assert (dict_ulong_out_mmap(f, d));
+    fclose(f);
+  }
+
+  m_mmap_file_t file;
+  assert (m_mmap_file_open(file, "a-mmmap-array.dat"));
+  array_uint_t a;
+  assert (array_uint_init_mmap(a, file->data, file->size));
+  assert (array_uint_size(a) == 10000);
+  for(unsigned int i = 0; i < 10000; i++)
+    assert (*array_uint_cget(a, i) == i * i);
+  /* Truncated image or image of another container are rejected */
+  dict_ulong_t d;
+  assert (!array_uint_init_mmap(a, file->data, file->size - 1));
+  assert (!dict_ulong_init_mmap(d, file->data, file->size));
+  m_mmap_file_close(file);
+
+  assert (m_mmap_file_open(file, "a-mmmap-dict.dat"));
+  assert (dict_ulong_init_mmap(d, file->data, file->size));
+  assert (dict_ulong_size(d) == 10000);
+  for(unsigned long i = 0; i < 10000; i++) {
+    const unsigned long *p = dict_ulong_get(d, i * 3 + 17);
+    assert (p != NULL && *p == i);
+    assert (dict_ulong_get(d, i * 3 + 18) == NULL);
+  }
+  size_t n = 0;
+  for M_EACH(item, d, DICT_OPLIST(dict_ulong)) {
+    assert (item->key == item->value * 3 + 17);
+    n++;
+  }
+  assert (n == 10000);
+  assert (!array_uint_init_mmap(a, file->data, file->size));
+  m_mmap_file_close(file);
+
+  assert (!m_mmap_file_open(file, "a-mmmap-no-file.dat"));
+}
+
+int main(void)
+{
+  test_realloc(M_MMAP_DEFAULT);
+  test_realloc(M_MMAP_INTERLEAVE);
+  test_oplist();
+  test_image();
+  exit(0);
+}
@@ -36,6 +36,9 @@ ARRAY_DEF(a2, int)
 ARRAY_DEF(l2, int)
 #define M_OPL_l2_t() ARRAY_OPLIST(l2, M_DEFAULT_OPLIST)
 
+LIST_DEF(li, int)
+#define M_OPL_li_t() LIST_OPLIST(li, M_DEFAULT_OPLIST)
+
 DICT_DEF2(d2, string_t, STRING_OPLIST, int, M_DEFAULT_OPLIST )
 #define M_OPL_d2_t() DICT_OPLIST(d2, STRING_OPLIST, M_DEFAULT_OPLIST)
 
@@ -140,10 +143,373 @@ static void test_out_fill(void)
   my2_clear(el2);
 }
 
+static void test_out_memory(void)
+{
+  m_serial_read_t  in;
+  m_serial_write_t out;
+  m_serial_return_code_t ret;
+  my2_init(el1);
+  my2_init(el2);
+
+  el2->activated = true;
+  el2->data->vala = -42;
+  el2->data->valb = 2.5;
+  string_set_str(el2->data->vald, "Memory");
+  for(int i = 0; i < 1000; i++)
+    a2_push_back(el2->data->vale, i);
+  v2_set_is_bool(el2->data->valf, true);
+  d2_set_at(el2->data->valh, STRING_CTE("Paul"), 1);
+
+  /* Into a string */
+  string_t str;
+  string_init(str);
+  m_serial_bin_write_init_str(out, str);
+  ret = my2_out_serial(out, el2);
+  assert (ret == M_SERIAL_OK_DONE);
+  size_t size = m_serial_bin_write_size(out);
+  assert (size == string_size(str));
+  m_serial_bin_write_clear(out);
+
+  m_serial_bin_read_init_buffer(in, string_get_cstr(str), string_size(str));
+  ret = my2_in_serial(el1, in);
+  assert (ret == M_SERIAL_OK_DONE);
+  assert (m_serial_bin_read_size(in) == size);
+  m_serial_bin_read_clear(in);
+  assert (my2_equal_p (el1, el2));
+
+  /* A truncated buffer is an error */
+  m_serial_bin_read_init_buffer(in, string_get_cstr(str), size - 1);
+  ret = my2_in_serial(el1, in);
+  assert (ret == M_SERIAL_FAIL);
+  m_serial_bin_read_clear(in);
+
+  /* Into a user buffer */
+  char *buffer = (char *) malloc(size);
+  m_serial_bin_write_init_buffer(out, buffer, size);
+  ret = my2_out_serial(out, el2);
+  assert (ret == M_SERIAL_OK_DONE);
+  assert (m_serial_bin_write_size(out) == size);
+  m_serial_bin_write_clear(out);
+  assert (memcmp(buffer, string_get_cstr(str), size) == 0);
+
+  /* Which is too small */
+  m_serial_bin_write_init_buffer(out, buffer, size / 2);
+  ret = my2_out_serial(out, el2);
+  assert (ret == M_SERIAL_FAIL);
+  m_serial_bin_write_clear(out);
+
+  free(buffer);
+  string_clear(str);
+  my2_clear(el1);
+  my2_clear(el2);
+}
+
+static void test_out_compact(void)
+{
+  m_serial_read_t  in;
+  m_serial_write_t out;
+  m_serial_return_code_t ret;
+  my2_init(el1);
+  my2_init(el2);
+
+  el2->activated = true;
+  el2->data->vala = -145788;
+  el2->data->valb = 0.25;
+  string_set_str(el2->data->vald, "Compact");
+  for(int i = -500; i < 500; i++)
+    a2_push_back(el2->data->vale, i);
+  v2_set_is_int(el2->data->valf, -1);
+  l2_push_back(el2->data->valg, 1345);
+  l2_push_back(el2->data->valg, -5678);
+  d2_set_at(el2->data->valh, STRING_CTE("Paul"), 1);
+  d2_set_at(el2->data->valh, STRING_CTE(""), -2);
+
+  /* Native format for reference */
+  string_t native;
+  string_init(native);
+  m_serial_bin_write_init_str(out, native);
+  ret = my2_out_serial(out, el2);
+  assert (ret == M_SERIAL_OK_DONE);
+  m_serial_bin_write_clear(out);
+
+  /* Compact format into a string */
+  string_t str;
+  string_init(str);
+  m_serial_bin_write_init_str(out, str);
+  m_serial_bin_write_set_compact(out);
+  ret = my2_out_serial(out, el2);
+  assert (ret == M_SERIAL_OK_DONE);
+  m_serial_bin_write_clear(out);
+  assert (string_size(str) < string_size(native) / 2);
+
+  /* The reader detects the format */
+  m_serial_bin_read_init_buffer(in, string_get_cstr(str), string_size(str));
+  ret = my2_in_serial(el1, in);
+  assert (ret == M_SERIAL_OK_DONE);
+  assert (m_serial_bin_read_size(in) == string_size(str));
+  m_serial_bin_read_clear(in);
+  assert (my2_equal_p (el1, el2));
+
+  m_serial_bin_read_init_buffer(in, string_get_cstr(str), string_size(str) - 1);
+  ret = my2_in_serial(el1, in);
+  assert (ret == M_SERIAL_FAIL);
+  m_serial_bin_read_clear(in);
+
+  /* Compact format into a FILE */
+  FILE *f = fopen ("a-mbin.dat", "wb");
+  if (!f) abort();
+  m_serial_bin_write_init(out, f);
+  m_serial_bin_write_set_compact(out);
+  ret = my2_out_serial(out, el2);
+  assert (ret == M_SERIAL_OK_DONE);
+  m_serial_bin_write_clear(out);
+  fclose(f);
+
+  my2_clear(el1);
+  my2_init(el1);
+  f = fopen ("a-mbin.dat", "rb");
+  if (!f) abort();
+  m_serial_bin_read_init(in, f);
+  ret = my2_in_serial(el1, in);
+  assert (ret == M_SERIAL_OK_DONE);
+  m_serial_bin_read_clear(in);
+  fclose(f);
+  assert (my2_equal_p (el1, el2));
+
+  /* A native stream has no header: the streams written before
+     the compact format are still readable */
+  assert (string_get_char(native, 0) != (char) 0x89);
+  m_serial_bin_read_init_buffer(in, string_get_cstr(native), string_size(native));
+  ret = my2_in_serial(el1, in);
+  assert (ret == M_SERIAL_OK_DONE);
+  assert (m_serial_bin_read_size(in) == string_size(native));
+  m_serial_bin_read_clear(in);
+  assert (my2_equal_p (el1, el2));
+
+  /* A native stream starting like the magic header */
+  long long v;
+  f = fopen ("a-mbin.dat", "wb");
+  if (!f) abort();
+  m_serial_bin_write_init(out, f);
+  ret = m_serial_bin_write_integer(out, 0x004C4D89, 4);
+  assert (ret == M_SERIAL_OK_DONE);
+  ret = m_serial_bin_write_integer(out, -17, 4);
+  assert (ret == M_SERIAL_OK_DONE);
+  m_serial_bin_write_clear(out);
+  fclose(f);
+  f = fopen ("a-mbin.dat", "rb");
+  if (!f) abort();
+  m_serial_bin_read_init(in, f);
+  ret = m_serial_bin_read_integer(in, &v, 4);
+  assert (ret == M_SERIAL_OK_DONE && v == 0x004C4D89);
+  ret = m_serial_bin_read_integer(in, &v, 4);
+  assert (ret == M_SERIAL_OK_DONE && v == -17);
+  m_serial_bin_read_clear(in);
+  fclose(f);
+
+  /* The 10th byte of a varint has only one significant bit */
+  const unsigned char varint[] = { 0x89, 0x4D, 0x4C, 0x43,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01 };
+  unsigned char bad[sizeof varint];
+  memcpy(bad, varint, sizeof varint);
+  bad[sizeof varint - 1] = 0x03;
+  for(int file = 0; file < 2; file++) {
+    for(int k = 0; k < 2; k++) {
+      const unsigned char *data = k == 0 ? varint : bad;
+      if (file) {
+        f = fopen ("a-mbin.dat", "wb");
+        if (!f) abort();
+        fwrite(data, sizeof varint, 1, f);
+        fclose(f);
+        f = fopen ("a-mbin.dat", "rb");
+        if (!f) abort();
+        m_serial_bin_read_init(in, f);
+      } else {
+        m_serial_bin_read_init_buffer(in, data, sizeof varint);
+      }
+      ret = m_serial_bin_read_integer(in, &v, 8);
+      if (k == 0)
+        assert (ret == M_SERIAL_OK_DONE && v == LLONG_MIN);
+      else
+        assert (ret == M_SERIAL_FAIL);
+      m_serial_bin_read_clear(in);
+      if (file)
+        fclose(f);
+    }
+  }
+
+  string_clear(str);
+  string_clear(native);
+  my2_clear(el1);
+  my2_clear(el2);
+}
+
+/* A list writes its number of elements like the other containers */
+static void test_list(void)
+{
+  m_serial_read_t  in;
+  m_serial_write_t out;
+  m_serial_return_code_t ret;
+  li_t l1, l2;
+  li_init(l1);
+  li_init(l2);
+  string_t str;
+  string_init(str);
+
+  for(int n = 0; n < 3; n++) {
+    for(int compact = 0; compact < 2; compact++) {
+      string_clean(str);
+      m_serial_bin_write_init_str(out, str);
+      if (compact)
+        m_serial_bin_write_set_compact(out);
+      ret = li_out_serial(out, l1);
+      assert (ret == M_SERIAL_OK_DONE);
+      m_serial_bin_write_clear(out);
+      m_serial_bin_read_init_buffer(in, string_get_cstr(str), string_size(str));
+      li_push_back(l2, -1);
+      ret = li_in_serial(l2, in);
+      assert (ret == M_SERIAL_OK_DONE);
+      m_serial_bin_read_clear(in);
+      assert (li_equal_p(l1, l2));
+    }
+    for(int i = 0; i < 100; i++)
+      li_push_back(l1, i * (n + 1));
+  }
+
+  li_clear(l1);
+  li_clear(l2);
+  string_clear(str);
+}
+
+/* Stream the content of a dictionary a few pairs at a time, as if they
+   were produced on the fly, and read them back one at a time */
+static void test_stream(void)
+{
+  m_serial_read_t  in;
+  m_serial_write_t out;
+  m_serial_stream_t stream;
+  m_serial_return_code_t ret;
+  d2_t d1, d2;
+  d2_init(d1);
+  d2_init(d2);
+  string_t key, str;
+  string_init(key);
+  string_init(str);
+  int value = 0;
+
+  for(int i = 0; i < 1000; i++) {
+    string_printf(key, "key %d", i);
+    d2_set_at(d1, key, i * i);
+  }
+
+  for(int compact = 0; compact < 2; compact++) {
+    string_clean(str);
+    m_serial_bin_write_init_str(out, str);
+    if (compact)
+      m_serial_bin_write_set_compact(out);
+    ret = m_serial_stream_write_start(stream, out, d2_size(d1), true);
+    assert (ret == M_SERIAL_OK_CONTINUE);
+    /* The iterator is the cursor of the writer: 64 pairs per step */
+    d2_it_t it;
+    d2_it(it, d1);
+    while (!d2_end_p(it)) {
+      for(int n = 0; n < 64 && !d2_end_p(it); n++, d2_next(it)) {
+        const d2_type_t *item = d2_cref(it);
+        ret = M_SERIAL_STREAM_WRITE_PAIR(stream, out, STRING_OPLIST, item->key, M_DEFAULT_OPLIST, item->value);
+        assert (ret == M_SERIAL_OK_CONTINUE);
+      }
+    }
+    ret = m_serial_stream_write_end(stream, out);
+    assert (ret == M_SERIAL_OK_DONE);
+    m_serial_bin_write_clear(out);
+
+    /* Read it back one pair at a time */
+    m_serial_bin_read_init_buffer(in, string_get_cstr(str), string_size(str));
+    ret = m_serial_stream_read_start(stream, in, true);
+    assert (ret == M_SERIAL_OK_CONTINUE);
+    assert (stream->size == 1000);
+    long long sum = 0;
+    while (ret == M_SERIAL_OK_CONTINUE) {
+      ret = M_SERIAL_STREAM_READ_PAIR(stream, in, STRING_OPLIST, key, M_DEFAULT_OPLIST, value);
+      assert (ret != M_SERIAL_FAIL);
+      assert (*d2_get(d1, key) == value);
+      sum += value;
+    }
+    assert (stream->count == 1000);
+    assert (sum == 332833500);
+    m_serial_bin_read_clear(in);
+
+    /* The stream is also a valid serialized dictionary */
+    m_serial_bin_read_init_buffer(in, string_get_cstr(str), string_size(str));
+    ret = d2_in_serial(d2, in);
+    assert (ret == M_SERIAL_OK_DONE);
+    m_serial_bin_read_clear(in);
+    assert (d2_equal_p(d1, d2));
+  }
+
+  /* Empty stream */
+  string_clean(str);
+  m_serial_bin_write_init_str(out, str);
+  ret = m_serial_stream_write_start(stream, out, 0, false);
+  assert (ret == M_SERIAL_OK_CONTINUE);
+  ret = m_serial_stream_write_end(stream, out);
+  assert (ret == M_SERIAL_OK_DONE);
+  m_serial_bin_write_clear(out);
+  m_serial_bin_read_init_buffer(in, string_get_cstr(str), string_size(str));
+  ret = m_serial_stream_read_start(stream, in, false);
+  assert (ret == M_SERIAL_OK_DONE);
+  m_serial_bin_read_clear(in);
+
+  /* A non empty stream of unknown size cannot be read back:
+     the binary format refuses to write it */
+  for(int compact = 0; compact < 2; compact++) {
+    for(int n = 1; n < 3; n++) {
+      string_clean(str);
+      m_serial_bin_write_init_str(out, str);
+      if (compact)
+        m_serial_bin_write_set_compact(out);
+      ret = m_serial_stream_write_start(stream, out, 0, false);
+      assert (ret == M_SERIAL_OK_CONTINUE);
+      ret = M_SERIAL_STREAM_WRITE(stream, out, M_DEFAULT_OPLIST, 17);
+      assert (ret == M_SERIAL_OK_CONTINUE);
+      if (n == 2) {
+        ret = M_SERIAL_STREAM_WRITE(stream, out, M_DEFAULT_OPLIST, 42);
+        assert (ret == M_SERIAL_FAIL);
+      } else {
+        ret = m_serial_stream_write_end(stream, out);
+        assert (ret == M_SERIAL_FAIL);
+      }
+      m_serial_bin_write_clear(out);
+    }
+  }
+
+  /* Same over a FILE */
+  FILE *f = fopen ("a-mbin.dat", "wb");
+  assert (f != NULL);
+  m_serial_bin_write_init(out, f);
+  ret = m_serial_stream_write_start(stream, out, 0, false);
+  assert (ret == M_SERIAL_OK_CONTINUE);
+  ret = M_SERIAL_STREAM_WRITE(stream, out, M_DEFAULT_OPLIST, 17);
+  assert (ret == M_SERIAL_OK_CONTINUE);
+  ret = m_serial_stream_write_end(stream, out);
+  assert (ret == M_SERIAL_FAIL);
+  m_serial_bin_write_clear(out);
+  fclose(f);
+
+  string_clear(key);
+  string_clear(str);
+  d2_clear(d1);
+  d2_clear(d2);
+}
+
 int main(void)
 {
   //test_out_empty();
   test_out_fill();
+  test_out_memory();
+  test_out_compact();
+  test_list();
+  test_stream();
   exit(0);    
 }
 
@@ -163,10 +163,422 @@ static void test_out_fill(void)
   my2_clear(el2);
 }
 
+static void test_out_memory(void)
+{
+  m_serial_read_t  in;
+  m_serial_write_t out;
+  m_serial_return_code_t ret;
+  my2_t el1, el2;
+  my2_init(el1);
+  my2_init(el2);
+
+  static const char input[] =
+          "{\n"
+          " \"activated\":false,\n"
+          "\"data\":   {\n"
+          "       \"valb\":  -2.300000 , \n"
+          "\"vale\": [1,2,-3],\n"
+          "\"valg\": [],\n"
+          "\"valh\": { \"jane\": 3, \"ste\\\"eve\": -4 },\n"
+          "\"valf\": { \"is_bool\": true },\n"
+          "              \"vala\":1742,\n"
+          " \"vald\": \"This is\\ta \\001test\",\n"
+          "    \"valc\": true   } }\n";
+  /* Parse from a buffer without null char */
+  char *buffer = (char *) malloc(sizeof input - 1);
+  memcpy(buffer, input, sizeof input - 1);
+  m_serial_json_read_init_buffer(in, buffer, sizeof input - 1);
+  ret = my2_in_serial(el2, in);
+  assert (ret == M_SERIAL_OK_DONE);
+  assert (m_serial_json_read_size(in) == sizeof input - 2);
+  m_serial_json_read_clear(in);
+  assert (el2->activated == false);
+  assert (el2->data->vala == 1742);
+  assert (el2->data->valb == -2.3f);
+  assert (string_equal_str_p(el2->data->vald, "This is\ta \001test"));
+  assert (*d2_get(el2->data->valh, STRING_CTE("ste\"eve")) == -4);
+
+  /* Same with the structural index */
+  m_serial_json_read_init_index(in, buffer, sizeof input - 1);
+  ret = my2_in_serial(el1, in);
+  assert (ret == M_SERIAL_OK_DONE);
+  m_serial_json_read_clear(in);
+  assert (my2_equal_p (el1, el2));
+
+  /* A truncated buffer is an error */
+  m_serial_json_read_init_buffer(in, buffer, sizeof input - 10);
+  ret = my2_in_serial(el1, in);
+  assert (ret == M_SERIAL_FAIL);
+  m_serial_json_read_clear(in);
+  m_serial_json_read_init_index(in, buffer, sizeof input - 10);
+  ret = my2_in_serial(el1, in);
+  assert (ret == M_SERIAL_FAIL);
+  m_serial_json_read_clear(in);
+  free(buffer);
+
+  /* The string output is the same as the FILE output */
+  string_t str;
+  string_init(str);
+  m_serial_json_write_init_str(out, str);
+  ret = my2_out_serial(out, el2);
+  assert (ret == M_SERIAL_OK_DONE);
+  m_serial_json_write_clear(out);
+
+  FILE *f = fopen("a-mjson.dat", "wt");
+  if (!f) abort();
+  m_serial_json_write_init(out, f);
+  ret = my2_out_serial(out, el2);
+  assert (ret == M_SERIAL_OK_DONE);
+  m_serial_json_write_clear(out);
+  fclose(f);
+  f = fopen("a-mjson.dat", "rt");
+  if (!f) abort();
+  string_t str2;
+  string_init(str2);
+  string_fgets(str2, f, STRING_READ_FILE);
+  fclose(f);
+  assert (string_equal_p(str, str2));
+
+  m_serial_json_read_init_buffer(in, string_get_cstr(str), string_size(str));
+  ret = my2_in_serial(el1, in);
+  assert (ret == M_SERIAL_OK_DONE);
+  assert (m_serial_json_read_size(in) == string_size(str));
+  m_serial_json_read_clear(in);
+  assert (my2_equal_p (el1, el2));
+
+  /* Integers and floats */
+  el2->data->vala = INT_MIN;
+  el2->data->valb = 1e30f;
+  string_clean(str);
+  m_serial_json_write_init_str(out, str);
+  ret = my2_out_serial(out, el2);
+  assert (ret == M_SERIAL_OK_DONE);
+  m_serial_json_write_clear(out);
+  m_serial_json_read_init_buffer(in, string_get_cstr(str), string_size(str));
+  ret = my2_in_serial(el1, in);
+  assert (ret == M_SERIAL_OK_DONE);
+  m_serial_json_read_clear(in);
+  assert (my2_equal_p (el1, el2));
+
+  string_clear(str);
+  string_clear(str2);
+  my2_clear(el1);
+  my2_clear(el2);
+}
+
+ARRAY_DEF(as2, string_t)
+#define M_OPL_as2_t() ARRAY_OPLIST(as2, STRING_OPLIST)
+TUPLE_DEF2(rec,
+           (id, int),
+           (name, string_t),
+           (tags, as2_t),
+           (ok, bool))
+#define M_OPL_rec_t() TUPLE_OPLIST(rec, M_DEFAULT_OPLIST, STRING_OPLIST, M_OPL_as2_t(), M_DEFAULT_OPLIST)
+ARRAY_DEF(ar, rec_t)
+
+static void test_index(void)
+{
+  m_serial_read_t  in;
+  m_serial_write_t out;
+  m_serial_return_code_t ret;
+  ar_t a1, a2;
+  ar_init(a1);
+  ar_init(a2);
+  rec_t r;
+  rec_init(r);
+  string_t str;
+  string_init(str);
+
+  /* Big enough to span several blocks of the index, with strings
+     crossing the chunks and escape sequences (including backslashes
+     at the end of a chunk) */
+  for(int i = 0; i < 20000; i++) {
+    r->id = i * (i & 1 ? -7 : 13);
+    string_printf(r->name, "name %d \"%s\" %s", i, i % 3 ? "a\\" : "b\\\\", i % 5 ? "[x]" : "{y},:");
+    if (i % 7 == 0)
+      /* A string without escape sequence between strings with ones */
+      string_printf(r->name, "plain %*d", i % 90, i);
+    as2_clean(r->tags);
+    for(int j = 0; j < i % 4; j++) {
+      string_printf(str, "%*d\\", (i + j) % 70, j);
+      as2_push_back(r->tags, str);
+    }
+    r->ok = i & 1;
+    ar_push_back(a1, r);
+  }
+  string_clean(str);
+  m_serial_json_write_init_str(out, str);
+  ret = ar_out_serial(out, a1);
+  assert (ret == M_SERIAL_OK_DONE);
+  m_serial_json_write_clear(out);
+  assert (string_size(str) > 4 * M_SERIAL_JSON_INDEX_BLOCK);
+
+  m_serial_json_read_init_index(in, string_get_cstr(str), string_size(str));
+  ret = ar_in_serial(a2, in);
+  assert (ret == M_SERIAL_OK_DONE);
+  assert (m_serial_json_read_size(in) == string_size(str));
+  m_serial_json_read_clear(in);
+  assert (ar_equal_p(a1, a2));
+
+  /* Errors are detected */
+  static const char *const bad[] = {
+    "[{\"id\":1 2}]", "[{\"id\":12a}]", "[{\"id\":1,\"name\":\"x}]",
+    "[{\"id\":1,\"oops\":2}]", "[{\"id\":1,\"ok\":tru}]", "[{\"id\":1}", "[{\"id\":1}}"
+  };
+  for(size_t i = 0; i < sizeof bad / sizeof bad[0]; i++) {
+    m_serial_json_read_init_index(in, bad[i], strlen(bad[i]));
+    ret = ar_in_serial(a2, in);
+    assert (ret == M_SERIAL_FAIL);
+    m_serial_json_read_clear(in);
+  }
+
+  string_clear(str);
+  rec_clear(r);
+  ar_clear(a1);
+  ar_clear(a2);
+}
+
+/* The fields of a tuple can be in any order */
+static void test_field_order(void)
+{
+  m_serial_read_t  in;
+  m_serial_return_code_t ret;
+  rec_t r;
+  rec_init(r);
+
+  static const char *const good[] = {
+    "{\"id\":-4,\"name\":\"n\",\"tags\":[\"t\"],\"ok\":true}",
+    "{\"ok\":true,\"tags\":[\"t\"],\"name\":\"n\",\"id\":-4}",
+    "{\"name\":\"n\",\"ok\":true,\"id\":-4,\"tags\":[\"t\"]}",
+    "{\"tags\":[\"t\"],\"id\":-4,\"ok\":true,\"name\":\"n\"}"
+  };
+  for(size_t i = 0; i < sizeof good / sizeof good[0]; i++) {
+    for(int mode = 0; mode < 3; mode++) {
+      FILE *f = NULL;
+      rec_clear(r);
+      rec_init(r);
+      if (mode == 0) {
+        f = fopen ("a-mjson.dat", "wt");
+        if (!f) abort();
+        fputs(good[i], f);
+        fclose(f);
+        f = fopen ("a-mjson.dat", "rt");
+        if (!f) abort();
+        m_serial_json_read_init(in, f);
+      } else if (mode == 1) {
+        m_serial_json_read_init_buffer(in, good[i], strlen(good[i]));
+      } else {
+        m_serial_json_read_init_index(in, good[i], strlen(good[i]));
+      }
+      ret = rec_in_serial(r, in);
+      assert (ret == M_SERIAL_OK_DONE);
+      m_serial_json_read_clear(in);
+      if (f != NULL) fclose(f);
+      assert (r->id == -4);
+      assert (string_equal_str_p(r->name, "n"));
+      assert (as2_size(r->tags) == 1);
+      assert (r->ok == true);
+    }
+  }
+
+  /* Unknown fields or prefix of a field are rejected */
+  static const char *const bad[] = {
+    "{\"i\":1}", "{\"idd\":1}", "{\"id\":1,\"nam\":\"n\"}", "{\"ok\":true,\"\":1}"
+  };
+  for(size_t i = 0; i < sizeof bad / sizeof bad[0]; i++) {
+    m_serial_json_read_init_buffer(in, bad[i], strlen(bad[i]));
+    ret = rec_in_serial(r, in);
+    assert (ret == M_SERIAL_FAIL);
+    m_serial_json_read_clear(in);
+    m_serial_json_read_init_index(in, bad[i], strlen(bad[i]));
+    ret = rec_in_serial(r, in);
+    assert (ret == M_SERIAL_FAIL);
+    m_serial_json_read_clear(in);
+  }
+
+  rec_clear(r);
+}
+
+TUPLE_DEF2(wide, (kilo, int), (bravo, int), (juliett, int), (alpha, int), (india, int),
+           (echo, int), (hotel, int), (charlie, int), (golf, int), (delta, int))
+VARIANT_DEF2(vwide, (kilo, int), (bravo, bool), (juliett, int), (alpha, bool),
+             (india, int), (echo, bool), (hotel, int), (charlie, bool))
+
+/* The fields of a wide tuple (or variant) in another order than their
+   declaration (sorted by name or reversed) are searched by dichotomy */
+static void test_field_sorted(void)
+{
+  m_serial_read_t  in;
+  m_serial_return_code_t ret;
+  wide_t w;
+  vwide_t v;
+  wide_init(w);
+  vwide_init(v);
+
+  static const char *const good[] = {
+    "{\"alpha\":4,\"bravo\":2,\"charlie\":8,\"delta\":10,\"echo\":6,"
+    "\"golf\":9,\"hotel\":7,\"india\":5,\"juliett\":3,\"kilo\":1}",
+    "{\"delta\":10,\"golf\":9,\"charlie\":8,\"hotel\":7,\"echo\":6,"
+    "\"india\":5,\"alpha\":4,\"juliett\":3,\"bravo\":2,\"kilo\":1}"
+  };
+  for(size_t i = 0; i < sizeof good / sizeof good[0]; i++) {
+    for(int mode = 0; mode < 3; mode++) {
+      FILE *f = NULL;
+      if (mode == 0) {
+        f = fopen ("a-mjson.dat", "wt");
+        if (!f) abort();
+        fputs(good[i], f);
+        fclose(f);
+        f = fopen ("a-mjson.dat", "rt");
+        if (!f) abort();
+        m_serial_json_read_init(in, f);
+      } else if (mode == 1) {
+        m_serial_json_read_init_buffer(in, good[i], strlen(good[i]));
+      } else {
+        m_serial_json_read_init_index(in, good[i], strlen(good[i]));
+      }
+      /* Twice with the same reader: the sorted table is reused */
+      for(int k = 0; k < 2 && (k == 0 || f == NULL); k++) {
+        if (k == 1) {
+          m_serial_json_read_clear(in);
+          if (mode == 1)
+            m_serial_json_read_init_buffer(in, good[i], strlen(good[i]));
+          else
+            m_serial_json_read_init_index(in, good[i], strlen(good[i]));
+        }
+        wide_clear(w);
+        wide_init(w);
+        ret = wide_in_serial(w, in);
+        assert (ret == M_SERIAL_OK_DONE);
+        assert (w->kilo == 1 && w->bravo == 2 && w->juliett == 3 && w->alpha == 4);
+        assert (w->india == 5 && w->echo == 6 && w->hotel == 7 && w->charlie == 8);
+        assert (w->golf == 9 && w->delta == 10);
+      }
+      /* The FILE reader owns no memory: it may not be cleared */
+      if (f == NULL)
+        m_serial_json_read_clear(in);
+      else
+        fclose(f);
+    }
+  }
+
+  static const char *const variant[] = {
+    "{\"alpha\":true}", "{\"kilo\":-3}", "{\"echo\":false}", "{\"hotel\":7}"
+  };
+  for(size_t i = 0; i < sizeof variant / sizeof variant[0]; i++) {
+    m_serial_json_read_init_buffer(in, variant[i], strlen(variant[i]));
+    ret = vwide_in_serial(v, in);
+    assert (ret == M_SERIAL_OK_DONE);
+    m_serial_json_read_clear(in);
+  }
+  assert (vwide_hotel_p(v) && *vwide_get_hotel(v) == 7);
+
+  /* Unknown fields, prefix or extension of a field are rejected */
+  static const char *const bad[] = {
+    "{\"alpha\":1,\"a\":1}", "{\"alph\":1}", "{\"alphaa\":1}", "{\"zulu\":1}",
+    "{\"\":1}", "{\"india\":1,\"indiana\":1}", "{\"aaa\":1}"
+  };
+  for(size_t i = 0; i < sizeof bad / sizeof bad[0]; i++) {
+    m_serial_json_read_init_buffer(in, bad[i], strlen(bad[i]));
+    ret = wide_in_serial(w, in);
+    assert (ret == M_SERIAL_FAIL);
+    m_serial_json_read_clear(in);
+    m_serial_json_read_init_index(in, bad[i], strlen(bad[i]));
+    ret = wide_in_serial(w, in);
+    assert (ret == M_SERIAL_FAIL);
+    m_serial_json_read_clear(in);
+    m_serial_json_read_init_buffer(in, bad[i], strlen(bad[i]));
+    ret = vwide_in_serial(v, in);
+    assert (ret == M_SERIAL_FAIL);
+    m_serial_json_read_clear(in);
+  }
+
+  vwide_clear(v);
+  wide_clear(w);
+}
+
+/* Stream records of unknown number through a file,
+   one record at a time, and read them back one at a time */
+static void test_stream(void)
+{
+  m_serial_read_t  in;
+  m_serial_write_t out;
+  m_serial_stream_t stream;
+  m_serial_return_code_t ret;
+  rec_t r;
+  rec_init(r);
+  ar_t a;
+  ar_init(a);
+
+  FILE *f = fopen ("a-mjson.dat", "wt");
+  if (!f) abort();
+  m_serial_json_write_init(out, f);
+  ret = m_serial_stream_write_start(stream, out, 0, false);
+  assert (ret == M_SERIAL_OK_CONTINUE);
+  for(int i = 0; i < 100; i++) {
+    r->id = i;
+    string_printf(r->name, "rec%d", i);
+    r->ok = i % 3 == 0;
+    ret = M_SERIAL_STREAM_WRITE(stream, out, M_OPL_rec_t(), r);
+    assert (ret == M_SERIAL_OK_CONTINUE);
+  }
+  ret = m_serial_stream_write_end(stream, out);
+  assert (ret == M_SERIAL_OK_DONE);
+  m_serial_json_write_clear(out);
+  fclose(f);
+
+  f = fopen ("a-mjson.dat", "rt");
+  if (!f) abort();
+  m_serial_json_read_init(in, f);
+  ret = m_serial_stream_read_start(stream, in, false);
+  int i = 0;
+  while (ret == M_SERIAL_OK_CONTINUE) {
+    ret = M_SERIAL_STREAM_READ(stream, in, M_OPL_rec_t(), r);
+    assert (ret != M_SERIAL_FAIL);
+    assert (r->id == i);
+    assert (string_get_char(r->name, 0) == 'r' && atoi(string_get_cstr(r->name) + 3) == i);
+    assert (r->ok == (i % 3 == 0));
+    i++;
+  }
+  assert (ret == M_SERIAL_OK_DONE);
+  assert (i == 100 && stream->count == 100);
+  m_serial_json_read_clear(in);
+  fclose(f);
+
+  /* The stream is also a valid serialized array */
+  f = fopen ("a-mjson.dat", "rt");
+  if (!f) abort();
+  m_serial_json_read_init(in, f);
+  ret = ar_in_serial(a, in);
+  assert (ret == M_SERIAL_OK_DONE);
+  assert (ar_size(a) == 100);
+  m_serial_json_read_clear(in);
+  fclose(f);
+
+  /* Truncated stream */
+  static const char bad[] = "[{\"id\":1},{\"id\":2}";
+  m_serial_json_read_init_buffer(in, bad, sizeof bad - 1);
+  ret = m_serial_stream_read_start(stream, in, false);
+  assert (ret == M_SERIAL_OK_CONTINUE);
+  ret = M_SERIAL_STREAM_READ(stream, in, M_OPL_rec_t(), r);
+  assert (ret == M_SERIAL_OK_CONTINUE);
+  ret = M_SERIAL_STREAM_READ(stream, in, M_OPL_rec_t(), r);
+  assert (ret == M_SERIAL_FAIL);
+  m_serial_json_read_clear(in);
+
+  ar_clear(a);
+  rec_clear(r);
+}
+
 int main(void)
 {
   test_out_empty();
   test_out_fill();
+  test_out_memory();
+  test_index();
+  test_field_order();
+  test_field_sorted();
+  test_stream();
   exit(0);    
 }
 
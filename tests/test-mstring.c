@@ -566,6 +566,59 @@ static void test_bounded_io(void)
   string16_clear(d);
 }
 
+/* Compare the search functions to the C library on random strings
+   of various sizes (so that both the blocks & the tails are scanned) */
+static void test_search(void)
+{
+  static const char *const sets[] = {
+    "", "a", "ab", "xyz", "abcdefgh", "abcdefghi", " \t\n,;:()[]{}", "\x80\xfe\x7f", "bcdefghijklmnopqrstuvwxyz"
+  };
+  string_t s;
+  string_init(s);
+  char needle[8];
+  unsigned seed = 1;
+  for(int n = 0; n < 3000; n++) {
+    string_clean(s);
+    const size_t size = (size_t) (n % 150);
+    for(size_t i = 0; i < size; i++) {
+      seed = seed * 1103515245U + 12345U;
+      /* Small alphabet to have many partial matches, and some high characters */
+      char c = (char) ('a' + (seed >> 16) % 4);
+      if ((seed >> 8) % 64 == 0) c = (char) 0xfe;
+      string_push_back(s, c);
+    }
+    const char *cstr = string_get_cstr(s);
+    for(size_t k = 0; k < sizeof sets / sizeof sets[0]; k++) {
+      const char *set = sets[k];
+      assert (string_spn(s, set) == strspn(cstr, set));
+      assert (string_cspn(s, set) == strcspn(cstr, set));
+      for(size_t start = 0; start <= size; start += 7) {
+        const char *p = strpbrk(cstr + start, set);
+        assert (string_search_pbrk(s, set, start) == (p == NULL ? STRING_FAILURE : (size_t) (p - cstr)));
+      }
+    }
+    for(int c = 0; c < 256; c += 17) {
+      const char *p = strchr(cstr, (char) c);
+      assert (string_search_char(s, (char) c) == (p == NULL ? STRING_FAILURE : (size_t) (p - cstr)));
+    }
+    for(size_t len = 0; len < sizeof needle; len++) {
+      /* Needle taken from the string (found) or random (often not found) */
+      for(size_t i = 0; i < len; i++) {
+        seed = seed * 1103515245U + 12345U;
+        needle[i] = (char) ('a' + (seed >> 16) % 4);
+      }
+      if (len <= size && n % 2 == 0)
+        memcpy(needle, cstr + (seed >> 8) % (size - len + 1), len);
+      needle[len] = 0;
+      for(size_t start = 0; start <= size; start += 5) {
+        const char *p = strstr(cstr + start, needle);
+        assert (string_search_str(s, needle, start) == (p == NULL ? STRING_FAILURE : (size_t) (p - cstr)));
+      }
+    }
+  }
+  string_clear(s);
+}
+
 int main(void)
 {
   test0();
@@ -574,5 +627,6 @@ int main(void)
   test_utf8_it();
   test_bounded1();
   test_bounded_io();
+  test_search();
   exit(0);
 }
@@ -76,6 +76,20 @@ static void test1bis(void)
   assert (atomic_load(&resetFunc_called) == true || workeri_get_cpu_count() == 1);
 }
 
+/* Force the creation of worker threads (even on a single core system)
+   so that work orders are spawned from within worker threads */
+static void test_many(void)
+{
+  worker_init(w_g, 4, 0, NULL);
+  assert (worker_count(w_g) == 5);
+  int result = fib(28);
+  assert (result == 317811);
+  result = fib(20);
+  assert (result == 6765);
+  worker_flush(w_g);
+  worker_clear(w_g);
+}
+
 #if defined(__GNUC__) && (!defined(__clang__) || (defined(WORKER_USE_CLANG_BLOCK) && WORKER_USE_CLANG_BLOCK) || (defined(WORKER_USE_CPP_FUNCTION) && WORKER_USE_CPP_FUNCTION))
 
 /* The macro version will generate warnings about shadow variables.
@@ -114,6 +128,7 @@ int main(void)
 {
   test1();
   test1bis();
+  test_many();
   test2();
   exit(0);
 }